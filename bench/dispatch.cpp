@@ -0,0 +1,152 @@
+// 栈式p-code虚拟机(逐条分派/超级指令融合)与寄存器字节码解释器的对比: 分派次数与耗时
+// 用法: bench_dispatch [循环次数]
+
+#include "../include/Compiler.h"
+#include "../include/VM.h"
+#include "../include/RegisterVM.h"
+#include "../include/RegisterGenerator.h"
+
+#include <cstdio>
+#include <string>
+#include <cstdlib>
+
+using namespace pl0;
+
+namespace
+{
+    // resources/pl.pl0中的三个过程，由主程序循环调用
+    constexpr const char *PROCEDURES = R"(
+procedure multiply;
+var a, b;
+begin
+  a := x;
+  b := y;
+  z := 0;
+  while b > 0 do
+  begin
+    if odd b then z := z + a;
+    a := 2 * a;
+    b := b / 2
+  end
+end;
+
+procedure divide;
+var w;
+begin
+  r := x;
+  q := 0;
+  w := y;
+  while w <= r do
+  begin
+    q := q + 1;
+    w := 2 * w
+  end;
+  while q > 0 do
+  begin
+    w := y * 2 ^ (q - 1);
+    if w <= r then
+    begin
+      r := r - w;
+      z := z + 2 ^ (q - 1)
+    end;
+    q := q - 1
+  end
+end;
+
+procedure gcd;
+var f, g;
+begin
+  f := x;
+  g := y;
+  while f # g do
+  begin
+    if f < g then g := g - f;
+    if g < f then f := f - g
+  end;
+  z := f
+end;
+)";
+
+    std::string procedureProgram(long iterations)
+    {
+        return "var x, y, z, q, r, i, acc;\n" + std::string(PROCEDURES) +
+               "begin\n"
+               "  acc := 0;\n"
+               "  i := 1;\n"
+               "  while i <= " + std::to_string(iterations) + " do\n"
+               "  begin\n"
+               "    x := i; y := 37; call multiply; acc := acc + z;\n"
+               "    x := i * 7 + 3; y := i / 3 + 1; z := 0; call divide; acc := acc + z + r;\n"
+               "    x := i + 17; y := 3 * i + 5; call gcd; acc := acc + z;\n"
+               "    i := i + 1\n"
+               "  end\n"
+               "end.\n";
+    }
+
+    std::string loopProgram(long iterations)
+    {
+        return "var i, s;\n"
+               "begin\n"
+               "  i := 0; s := 0;\n"
+               "  while i < " + std::to_string(iterations * 100) + " do\n"
+               "  begin\n"
+               "    s := s + i * 3 - i / 7;\n"
+               "    i := i + 1\n"
+               "  end\n"
+               "end.\n";
+    }
+
+    bool compare(const char *name, const std::string &source)
+    {
+        auto compiled = Compiler::compileString(source);
+        if (!compiled.success)
+        {
+            std::fprintf(stderr, "%s: 编译失败: %s\n", name, compiled.errors.front().c_str());
+            return false;
+        }
+
+        RegisterGenerator generator;
+        auto registers = generator.generate(*compiled.ast);
+
+        VM plain(compiled.code);
+        plain.setFusion(false);
+        auto plain_run = plain.run();
+        auto stack_run = VM(compiled.code).run();
+        auto register_run = RegisterVM(registers).run();
+        if (!plain_run.success || !stack_run.success || !register_run.success ||
+            stack_run.globals != register_run.globals || plain_run.globals != stack_run.globals)
+        {
+            std::fprintf(stderr, "%s: 解释器的执行结果不一致\n", name);
+            return false;
+        }
+
+        auto report = [](const char *engine, size_t code_size, const ExecutionResult &run)
+        {
+            std::printf("  %-9s %6zu 条指令 %12llu 次分派 %9.2f ms %6.2f ns/分派\n", engine, code_size,
+                        static_cast<unsigned long long>(run.instructions), run.seconds * 1000.0,
+                        run.seconds * 1e9 / static_cast<double>(run.instructions));
+        };
+
+        std::printf("%s:\n", name);
+        report("stack", compiled.code.code.size(), plain_run);
+        report("stack+si", compiled.code.code.size(), stack_run);
+        report("register", registers.code.size(), register_run);
+        std::printf("  超级指令: 分派次数减少 %.1f%%, 耗时 %.2fx\n",
+                    100.0 * (1.0 - static_cast<double>(stack_run.instructions) /
+                                       static_cast<double>(plain_run.instructions)),
+                    plain_run.seconds / stack_run.seconds);
+        std::printf("  stack+si对register: 分派次数 %.2fx, 耗时 %.2fx\n",
+                    static_cast<double>(stack_run.instructions) / static_cast<double>(register_run.instructions),
+                    stack_run.seconds / register_run.seconds);
+        return true;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    long iterations = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 20000;
+
+    bool ok = compare("multiply/divide/gcd", procedureProgram(iterations));
+    ok = compare("tight loop", loopProgram(iterations)) && ok;
+    return ok ? 0 : 1;
+}
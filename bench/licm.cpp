@@ -0,0 +1,155 @@
+// 循环不变量外提(--licm)前后的对比: 各执行方式的分派次数与耗时
+// 用法: bench_licm [循环次数]
+
+#include "../include/Compiler.h"
+#include "../include/VM.h"
+#include "../include/Jit.h"
+#include "../include/JitCompiler.h"
+#include "../include/RegisterVM.h"
+#include "../include/RegisterGenerator.h"
+
+#include <cstdio>
+#include <string>
+#include <cstdlib>
+
+using namespace pl0;
+
+namespace
+{
+    // resources/pl.pl0中的divide: 两个循环里的表达式都读q、w或r，没有可以外提的
+    std::string shiftDivide(long iterations)
+    {
+        return "var x, y, z, q, r, i, acc;\n"
+               "procedure divide;\n"
+               "var w;\n"
+               "begin\n"
+               "  r := x;\n"
+               "  q := 0;\n"
+               "  w := y;\n"
+               "  while w <= r do\n"
+               "  begin\n"
+               "    q := q + 1;\n"
+               "    w := 2 * w\n"
+               "  end;\n"
+               "  while q > 0 do\n"
+               "  begin\n"
+               "    w := y * 2 ^ (q - 1);\n"
+               "    if w <= r then\n"
+               "    begin\n"
+               "      r := r - w;\n"
+               "      z := z + 2 ^ (q - 1)\n"
+               "    end;\n"
+               "    q := q - 1\n"
+               "  end\n"
+               "end;\n"
+               "begin\n"
+               "  acc := 0;\n"
+               "  i := 1;\n"
+               "  while i <= " + std::to_string(iterations * 15) + " do\n"
+               "  begin\n"
+               "    x := i * 7 + 3; y := i / 3 + 1; z := 0; call divide; acc := acc + z + r;\n"
+               "    i := i + 1\n"
+               "  end\n"
+               "end.\n";
+    }
+
+    // 反复相减的除法，除数y * 2 ^ 3在循环中不变
+    std::string subtractDivide(long iterations)
+    {
+        return "var x, y, q, r, i, acc;\n"
+               "procedure divide;\n"
+               "begin\n"
+               "  r := x;\n"
+               "  q := 0;\n"
+               "  while r >= y * 2 ^ 3 do\n"
+               "  begin\n"
+               "    r := r - y * 2 ^ 3;\n"
+               "    q := q + 1\n"
+               "  end\n"
+               "end;\n"
+               "begin\n"
+               "  acc := 0;\n"
+               "  i := 1;\n"
+               "  while i <= " + std::to_string(iterations) + " do\n"
+               "  begin\n"
+               "    x := i * 5 + 1000; y := 3; call divide; acc := acc + q + r;\n"
+               "    i := i + 1\n"
+               "  end\n"
+               "end.\n";
+    }
+
+    struct Runs
+    {
+        ExecutionResult stack;
+        ExecutionResult registers;
+        ExecutionResult native;
+    };
+
+    bool execute(const char *name, const std::string &source, const Compiler::Options &options, Runs &runs)
+    {
+        auto compiled = Compiler::compileString(source, options);
+        if (!compiled.success)
+        {
+            std::fprintf(stderr, "%s: 编译失败: %s\n", name, compiled.errors.front().c_str());
+            return false;
+        }
+
+        RegisterGenerator generator;
+        auto registers = generator.generate(*compiled.ast);
+        JitCompiler jit;
+        auto native = jit.compile(*compiled.ast);
+
+        runs.stack = VM(compiled.code).run();
+        runs.registers = RegisterVM(registers).run();
+        runs.native = Jit(native).run();
+        if (!runs.stack.success || !runs.registers.success || !runs.native.success ||
+            runs.stack.globals != runs.registers.globals || runs.stack.globals != runs.native.globals)
+        {
+            std::fprintf(stderr, "%s: 各执行方式的结果不一致\n", name);
+            return false;
+        }
+        return true;
+    }
+
+    bool compare(const char *name, const std::string &source, bool folding)
+    {
+        Compiler::Options before{.folding = folding};
+        Compiler::Options after{.folding = folding, .hoisting = true};
+        Runs plain;
+        Runs hoisted;
+        if (!execute(name, source, before, plain) || !execute(name, source, after, hoisted))
+        {
+            return false;
+        }
+        if (plain.stack.globals != hoisted.stack.globals)
+        {
+            std::fprintf(stderr, "%s: 外提前后的结果不一致\n", name);
+            return false;
+        }
+
+        auto report = [](const char *engine, const ExecutionResult &before, const ExecutionResult &after)
+        {
+            std::printf("  %-9s %12llu -> %12llu 次分派 %9.2f -> %9.2f ms\n", engine,
+                        static_cast<unsigned long long>(before.instructions),
+                        static_cast<unsigned long long>(after.instructions), before.seconds * 1000.0,
+                        after.seconds * 1000.0);
+        };
+
+        std::printf("%s%s:\n", name, folding ? " (--fold)" : "");
+        report("stack", plain.stack, hoisted.stack);
+        report("register", plain.registers, hoisted.registers);
+        std::printf("  %-9s %45.2f -> %9.2f ms\n", "native", plain.native.seconds * 1000.0,
+                    hoisted.native.seconds * 1000.0);
+        return true;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    long iterations = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 20000;
+
+    bool ok = compare("shift divide", shiftDivide(iterations), false);
+    ok = compare("subtract divide", subtractDivide(iterations), false) && ok;
+    ok = compare("subtract divide", subtractDivide(iterations), true) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+// 本地代码、分层执行与解释器的对比，并以同样语义的C++循环作为参照
+// 用法: bench_native [循环次数]
+
+#include "../include/Compiler.h"
+#include "../include/VM.h"
+#include "../include/Jit.h"
+#include "../include/JitCompiler.h"
+#include "../include/TieredEngine.h"
+#include "../include/RegisterVM.h"
+#include "../include/RegisterGenerator.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <cstdlib>
+#include <cstdint>
+
+using namespace pl0;
+
+namespace
+{
+    std::string loopProgram(long iterations)
+    {
+        return "var i, s;\n"
+               "begin\n"
+               "  i := 0; s := 0;\n"
+               "  while i < " + std::to_string(iterations) + " do\n"
+               "  begin\n"
+               "    s := s + i * 3 - i / 7;\n"
+               "    i := i + 1\n"
+               "  end\n"
+               "end.\n";
+    }
+
+    // 与loopProgram相同的计算，编译器可以充分优化
+    [[gnu::noinline]] int64_t reference(long iterations)
+    {
+        int64_t limit = iterations;
+        int64_t s = 0;
+        for (int64_t i = 0; i < limit; ++i)
+        {
+            s = s + i * 3 - i / 7;
+        }
+        return s;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    long iterations = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 100000000;
+
+    auto compiled = Compiler::compileString(loopProgram(iterations));
+    if (!compiled.success)
+    {
+        std::fprintf(stderr, "编译失败: %s\n", compiled.errors.front().c_str());
+        return 1;
+    }
+
+    RegisterGenerator generator;
+    auto registers = generator.generate(*compiled.ast);
+    JitCompiler jit;
+    auto native = jit.compile(*compiled.ast);
+
+    auto stack_run = VM(compiled.code).run();
+    auto register_run = RegisterVM(registers).run();
+    auto native_run = Jit(native).run();
+    TieredEngine tiered(*compiled.ast, compiled.code);
+    auto tiered_run = tiered.run();
+
+    auto start = std::chrono::steady_clock::now();
+    int64_t expected = reference(iterations);
+    double reference_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (const auto *run : {&stack_run, &register_run, &native_run, &tiered_run})
+    {
+        if (!run->success || run->globals.size() != 2 || run->globals[1] != expected)
+        {
+            std::fprintf(stderr, "执行结果与参照不一致\n");
+            return 1;
+        }
+    }
+
+    auto report = [reference_seconds](const char *engine, double seconds)
+    {
+        std::printf("  %-9s %9.2f ms  %6.2fx C++\n", engine, seconds * 1000.0, seconds / reference_seconds);
+    };
+
+    std::printf("tight loop, %ld 次迭代, 机器码 %zu 字节:\n", iterations, native.bytes.size());
+    report("stack", stack_run.seconds);
+    report("register", register_run.seconds);
+    report("native", native_run.seconds);
+    report("tiered", tiered_run.seconds);
+    report("C++", reference_seconds);
+    return 0;
+}
@@ -0,0 +1,134 @@
+// 源码加载方式的对比: ifstream+stringstream复制(SourceBuffer之前的做法)与SourceBuffer的mmap
+// 每种方式在单独的子进程中运行，峰值RSS互不影响；mmap在首次访问时才读入，因此另计一遍逐字节读取的时间
+// 用法: bench_source_load <输入文件> [轮数]
+
+#include "../include/SourceBuffer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <cstdlib>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string_view>
+
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+using namespace pl0;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double millisecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // 词法分析同样要读过每个字节
+    uint64_t checksum(std::string_view data)
+    {
+        uint64_t sum = 0;
+        for (char c : data)
+        {
+            sum += static_cast<unsigned char>(c);
+        }
+        return sum;
+    }
+
+    // /proc/self/status中的一项，单位kB
+    long statusKb(std::string_view key)
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+        {
+            if (line.starts_with(key) && line.size() > key.size() && line[key.size()] == ':')
+            {
+                return std::atol(line.c_str() + key.size() + 1);
+            }
+        }
+        return 0;
+    }
+
+    template <typename Load>
+    void measure(const char *name, Load load)
+    {
+        auto start = Clock::now();
+        auto source = load();
+        double load_ms = millisecondsSince(start);
+        uint64_t sum = checksum(std::string_view{source});
+        double total_ms = millisecondsSince(start);
+
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        // 映射的页面属于页缓存(RssFile)，干净且可回收；复制出的副本是进程私有的匿名内存(RssAnon)
+        std::printf("%-7s 加载 %8.2f ms, 加载并读完 %8.2f ms, 峰值RSS %7.1f MB, RssAnon %7.1f MB, RssFile %7.1f MB (校验和 %llu)\n",
+                    name, load_ms, total_ms, usage.ru_maxrss / 1024.0, statusKb("RssAnon") / 1024.0,
+                    statusKb("RssFile") / 1024.0, static_cast<unsigned long long>(sum));
+    }
+
+    void streamCopy(const char *path)
+    {
+        measure("stream", [path]
+                {
+                    std::ifstream file(path);
+                    std::stringstream buffer;
+                    buffer << file.rdbuf();
+                    return buffer.str(); });
+    }
+
+    void mapped(const char *path)
+    {
+        std::optional<SourceBuffer> buffer;
+        measure("mmap", [path, &buffer]
+                {
+                    buffer = SourceBuffer::open(path);
+                    return buffer->view(); });
+    }
+
+    template <typename Run>
+    bool inChild(Run run, const char *path)
+    {
+        std::fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            run(path);
+            std::fflush(stdout);
+            _exit(0);
+        }
+        int status = 0;
+        return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "用法: %s <输入文件> [轮数]\n", argv[0]);
+        return 1;
+    }
+    const char *path = argv[1];
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 3;
+
+    if (!SourceBuffer::open(path))
+    {
+        std::fprintf(stderr, "无法打开文件: %s\n", path);
+        return 1;
+    }
+
+    for (int round = 0; round < rounds; ++round)
+    {
+        if (!inChild(streamCopy, path) || !inChild(mapped, path))
+        {
+            std::fprintf(stderr, "子进程失败\n");
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,284 @@
+// AST遍历开销对比: accept/ASTVisitor虚分派 vs ASTWalker静态分派
+// 用法: bench_traversal [过程数] [重复次数]
+
+#include "../include/Parser.h"
+#include "../include/ASTVisitor.h"
+#include "../include/ASTWalker.h"
+#include "../include/TokenInterpreter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <cstdlib>
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+
+using namespace pl0;
+
+namespace
+{
+    // 生成包含大量语句和深层表达式的程序
+    std::string makeProgram(size_t procedures)
+    {
+        std::string source = "const k = 7;\nvar a, b, c;\n";
+        for (size_t i = 0; i < procedures; ++i)
+        {
+            std::string name = "p" + std::to_string(i);
+            source += "procedure " + name + ";\nvar x, y;\nbegin\n";
+            source += "  x := a * (b + 3) - c / k + (x - y) * (a + b * c);\n";
+            source += "  while x > 0 do\n  begin\n";
+            source += "    if odd x then y := y + x ^ 2 - (a + 1) * (b - 1);\n";
+            source += "    x := x - 1\n  end;\n";
+            source += "  if y # 0 then a := a + y / 2 * (c + k)\n";
+            source += "end;\n";
+        }
+        source += "begin\n";
+        for (size_t i = 0; i < procedures; ++i)
+        {
+            source += "  call p" + std::to_string(i) + ";\n";
+        }
+        source += "  a := 1\nend.\n";
+        return source;
+    }
+
+    // 两种遍历做完全相同的工作: 统计节点数并累加一个校验值
+    struct Tally
+    {
+        uint64_t nodes = 0;
+        uint64_t checksum = 0;
+    };
+
+    class VirtualCounter : public ASTVisitor
+    {
+    public:
+        Tally tally;
+
+        void visit(const Program &node) override
+        {
+            ++tally.nodes;
+            node.block().accept(*this);
+        }
+        void visit(const Block &node) override
+        {
+            ++tally.nodes;
+            for (const auto *decl : node.consts())
+                decl->accept(*this);
+            for (const auto *decl : node.vars())
+                decl->accept(*this);
+            for (const auto *decl : node.procedures())
+                decl->accept(*this);
+            node.statement().accept(*this);
+        }
+        void visit(const ConstDeclaration &node) override
+        {
+            ++tally.nodes;
+            tally.checksum += static_cast<uint64_t>(node.value());
+        }
+        void visit(const VarDeclaration &node) override
+        {
+            ++tally.nodes;
+            tally.checksum += node.symbol();
+        }
+        void visit(const ProcedureDeclaration &node) override
+        {
+            ++tally.nodes;
+            node.block().accept(*this);
+        }
+        void visit(const AssignStatement &node) override
+        {
+            ++tally.nodes;
+            tally.checksum += node.symbol();
+            node.expression().accept(*this);
+        }
+        void visit(const CallStatement &node) override
+        {
+            ++tally.nodes;
+            tally.checksum += node.symbol();
+        }
+        void visit(const BeginStatement &node) override
+        {
+            ++tally.nodes;
+            for (const auto *stmt : node.statements())
+                stmt->accept(*this);
+        }
+        void visit(const IfStatement &node) override
+        {
+            ++tally.nodes;
+            node.condition().accept(*this);
+            node.thenStmt().accept(*this);
+        }
+        void visit(const WhileStatement &node) override
+        {
+            ++tally.nodes;
+            node.condition().accept(*this);
+            node.body().accept(*this);
+        }
+        void visit(const BinaryExpression &node) override
+        {
+            ++tally.nodes;
+            tally.checksum += static_cast<uint64_t>(node.op());
+            node.left().accept(*this);
+            node.right().accept(*this);
+        }
+        void visit(const UnaryExpression &node) override
+        {
+            ++tally.nodes;
+            node.operand().accept(*this);
+        }
+        void visit(const NumberExpression &node) override
+        {
+            ++tally.nodes;
+            tally.checksum += static_cast<uint64_t>(node.value());
+        }
+        void visit(const IdentifierExpression &node) override
+        {
+            ++tally.nodes;
+            tally.checksum += node.symbol();
+        }
+    };
+
+    class StaticCounter : public ASTWalker<StaticCounter>
+    {
+    public:
+        Tally tally;
+
+        void visit(const Program &node)
+        {
+            ++tally.nodes;
+            walk(node.block());
+        }
+        void visit(const Block &node)
+        {
+            ++tally.nodes;
+            for (const auto *decl : node.consts())
+                walk(*decl);
+            for (const auto *decl : node.vars())
+                walk(*decl);
+            for (const auto *decl : node.procedures())
+                walk(*decl);
+            walk(node.statement());
+        }
+        void visit(const ConstDeclaration &node)
+        {
+            ++tally.nodes;
+            tally.checksum += static_cast<uint64_t>(node.value());
+        }
+        void visit(const VarDeclaration &node)
+        {
+            ++tally.nodes;
+            tally.checksum += node.symbol();
+        }
+        void visit(const ProcedureDeclaration &node)
+        {
+            ++tally.nodes;
+            walk(node.block());
+        }
+        void visit(const AssignStatement &node)
+        {
+            ++tally.nodes;
+            tally.checksum += node.symbol();
+            walk(node.expression());
+        }
+        void visit(const CallStatement &node)
+        {
+            ++tally.nodes;
+            tally.checksum += node.symbol();
+        }
+        void visit(const BeginStatement &node)
+        {
+            ++tally.nodes;
+            for (const auto *stmt : node.statements())
+                walk(*stmt);
+        }
+        void visit(const IfStatement &node)
+        {
+            ++tally.nodes;
+            walk(node.condition());
+            walk(node.thenStmt());
+        }
+        void visit(const WhileStatement &node)
+        {
+            ++tally.nodes;
+            walk(node.condition());
+            walk(node.body());
+        }
+        void visit(const BinaryExpression &node)
+        {
+            ++tally.nodes;
+            tally.checksum += static_cast<uint64_t>(node.op());
+            walk(node.left());
+            walk(node.right());
+        }
+        void visit(const UnaryExpression &node)
+        {
+            ++tally.nodes;
+            walk(node.operand());
+        }
+        void visit(const NumberExpression &node)
+        {
+            ++tally.nodes;
+            tally.checksum += static_cast<uint64_t>(node.value());
+        }
+        void visit(const IdentifierExpression &node)
+        {
+            ++tally.nodes;
+            tally.checksum += node.symbol();
+        }
+    };
+
+    // 重复遍历rounds次，返回(最后一次的统计, 总耗时秒)
+    template <typename Counter>
+    std::pair<Tally, double> run(const Program &program, size_t rounds)
+    {
+        using Clock = std::chrono::steady_clock;
+        Tally last;
+        auto start = Clock::now();
+        for (size_t i = 0; i < rounds; ++i)
+        {
+            Counter counter;
+            if constexpr (std::is_base_of_v<ASTVisitor, Counter>)
+            {
+                program.accept(counter);
+            }
+            else
+            {
+                counter.walk(program);
+            }
+            last = counter.tally;
+        }
+        return {last, std::chrono::duration<double>(Clock::now() - start).count()};
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t procedures = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200;
+    size_t rounds = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 500;
+
+    std::string source = makeProgram(procedures);
+    Interner symbols;
+    TokenBuffer tokens = TokenInterpreter(source, symbols).tokenize();
+    Parser parser(tokens);
+    auto program = parser.parse();
+
+    // 先各跑一轮预热缓存
+    run<VirtualCounter>(*program, 1);
+    run<StaticCounter>(*program, 1);
+
+    auto [virtual_tally, virtual_seconds] = run<VirtualCounter>(*program, rounds);
+    auto [static_tally, static_seconds] = run<StaticCounter>(*program, rounds);
+
+    if (virtual_tally.nodes != static_tally.nodes || virtual_tally.checksum != static_tally.checksum)
+    {
+        std::fprintf(stderr, "遍历结果不一致\n");
+        return 1;
+    }
+
+    double visits = static_cast<double>(virtual_tally.nodes) * static_cast<double>(rounds);
+    std::printf("节点数: %llu, 重复: %zu\n", static_cast<unsigned long long>(virtual_tally.nodes), rounds);
+    std::printf("virtual (accept/ASTVisitor): %.2f ns/node\n", virtual_seconds * 1e9 / visits);
+    std::printf("static  (ASTWalker):         %.2f ns/node\n", static_seconds * 1e9 / visits);
+    std::printf("加速比: %.2fx\n", virtual_seconds / static_seconds);
+    return 0;
+}
@@ -1,9 +1,9 @@
 #pragma once
 #include "Token.h"
+#include "Interner.h"
+#include "AstArena.h"
 
-#include <memory>
-#include <vector>
-#include <variant>
+#include <span>
 #include <optional>
 #include <string_view>
 
@@ -28,7 +28,27 @@ namespace pl0
     class IdentifierExpression;
     class UnaryExpression;
 
+    // 节点类型标签，供ASTWalker用switch静态分派
+    enum class NodeKind : uint8_t
+    {
+        Program,
+        Block,
+        ConstDeclaration,
+        VarDeclaration,
+        ProcedureDeclaration,
+        AssignStatement,
+        CallStatement,
+        BeginStatement,
+        IfStatement,
+        WhileStatement,
+        BinaryExpression,
+        NumberExpression,
+        IdentifierExpression,
+        UnaryExpression
+    };
+
     // 基类
+    // 除Program外，所有节点都分配在Program持有的AstArena中，子节点以arena内的指针相连
     template <typename Derived>
     class ASTNode
     {
@@ -36,21 +56,35 @@ namespace pl0
         virtual void accept(ASTVisitor &visitor) const = 0;
         virtual ~ASTNode() = default;
 
+        [[nodiscard]] constexpr NodeKind kind() const noexcept { return kind_; }
         [[nodiscard]] constexpr size_t line() const noexcept { return line_; }
         [[nodiscard]] constexpr size_t column() const noexcept { return column_; }
 
+        // 由Parser在构造节点后设置，目前只记录语句和过程声明的起始位置
+        constexpr void setPosition(size_t line, size_t column) noexcept
+        {
+            line_ = line;
+            column_ = column;
+        }
+
     protected:
+        explicit constexpr ASTNode(NodeKind kind) noexcept : kind_(kind) {}
+
         size_t line_ = 0;
         size_t column_ = 0;
+
+    private:
+        NodeKind kind_;
     };
 
     // 表达式基类
     class Expression : public ASTNode<Expression>
     {
     public:
-        [[nodiscard]] virtual bool isConstant() const noexcept = 0;
-        [[nodiscard]] virtual std::optional<int64_t> evaluateConstant() const = 0;
         ~Expression() override = default;
+
+    protected:
+        explicit Expression(NodeKind kind) noexcept : ASTNode(kind) {}
     };
 
     // 语句基类
@@ -58,64 +92,77 @@ namespace pl0
     {
     public:
         ~Statement() override = default;
+
+    protected:
+        explicit Statement(NodeKind kind) noexcept : ASTNode(kind) {}
     };
 
     // 常量声明
     class ConstDeclaration : public ASTNode<ConstDeclaration>
     {
     public:
-        ConstDeclaration(std::string_view name, int64_t value)
-            : name_(name), value_(value) {}
+        ConstDeclaration(std::string_view name, SymbolId symbol, int64_t value)
+            : ASTNode(NodeKind::ConstDeclaration), name_(name), symbol_(symbol), value_(value) {}
 
         void accept(ASTVisitor &visitor) const override;
 
         [[nodiscard]] std::string_view name() const noexcept { return name_; }
+        [[nodiscard]] SymbolId symbol() const noexcept { return symbol_; }
         [[nodiscard]] int64_t value() const noexcept { return value_; }
 
     private:
         std::string_view name_;
+        SymbolId symbol_;
         int64_t value_;
     };
 
     // 变量声明
+    // hidden的变量由优化生成(如内联过程的局部变量)，排在块内用户变量之后，不作为程序的输出
     class VarDeclaration : public ASTNode<VarDeclaration>
     {
     public:
-        explicit VarDeclaration(std::string_view name) : name_(name) {}
+        VarDeclaration(std::string_view name, SymbolId symbol, bool hidden = false)
+            : ASTNode(NodeKind::VarDeclaration), name_(name), symbol_(symbol), hidden_(hidden) {}
 
         void accept(ASTVisitor &visitor) const override;
         [[nodiscard]] std::string_view name() const noexcept { return name_; }
+        [[nodiscard]] SymbolId symbol() const noexcept { return symbol_; }
+        [[nodiscard]] bool hidden() const noexcept { return hidden_; }
 
     private:
         std::string_view name_;
+        SymbolId symbol_;
+        bool hidden_;
     };
 
     // 过程声明
     class ProcedureDeclaration : public ASTNode<ProcedureDeclaration>
     {
     public:
-        ProcedureDeclaration(std::string_view name, std::unique_ptr<Block> block)
-            : name_(name), block_(std::move(block)) {}
+        ProcedureDeclaration(std::string_view name, SymbolId symbol, const Block *block)
+            : ASTNode(NodeKind::ProcedureDeclaration), name_(name), symbol_(symbol), block_(block) {}
 
         void accept(ASTVisitor &visitor) const override;
 
         [[nodiscard]] std::string_view name() const noexcept { return name_; }
+        [[nodiscard]] SymbolId symbol() const noexcept { return symbol_; }
         [[nodiscard]] const Block &block() const noexcept { return *block_; }
 
     private:
         std::string_view name_;
-        std::unique_ptr<Block> block_;
+        SymbolId symbol_;
+        const Block *block_;
     };
 
     // 块节点
     class Block : public ASTNode<Block>
     {
     public:
-        Block(std::vector<std::unique_ptr<ConstDeclaration>> consts,
-              std::vector<std::unique_ptr<VarDeclaration>> vars,
-              std::vector<std::unique_ptr<ProcedureDeclaration>> procs,
-              std::unique_ptr<Statement> statement)
-            : consts_(std::move(consts)), vars_(std::move(vars)), procedures_(std::move(procs)), statement_(std::move(statement)) {}
+        Block(std::span<const ConstDeclaration *const> consts,
+              std::span<const VarDeclaration *const> vars,
+              std::span<const ProcedureDeclaration *const> procs,
+              const Statement *statement)
+            : ASTNode(NodeKind::Block), consts_(consts), vars_(vars), procedures_(procs), statement_(statement) {}
 
         void accept(ASTVisitor &visitor) const override;
 
@@ -125,78 +172,86 @@ namespace pl0
         [[nodiscard]] const auto &statement() const noexcept { return *statement_; }
 
     private:
-        std::vector<std::unique_ptr<ConstDeclaration>> consts_;
-        std::vector<std::unique_ptr<VarDeclaration>> vars_;
-        std::vector<std::unique_ptr<ProcedureDeclaration>> procedures_;
-        std::unique_ptr<Statement> statement_;
+        std::span<const ConstDeclaration *const> consts_;
+        std::span<const VarDeclaration *const> vars_;
+        std::span<const ProcedureDeclaration *const> procedures_;
+        const Statement *statement_;
     };
 
-    // 程序节点
+    // 程序节点，持有整棵树的arena
     class Program : public ASTNode<Program>
     {
     public:
-        explicit Program(std::unique_ptr<Block> block)
-            : block_(std::move(block)) {}
+        Program(AstArena arena, const Block *block)
+            : ASTNode(NodeKind::Program), arena_(std::move(arena)), block_(block) {}
 
         void accept(ASTVisitor &visitor) const override;
         [[nodiscard]] const Block &block() const noexcept { return *block_; }
+        [[nodiscard]] const AstArena &arena() const noexcept { return arena_; }
+
+        // 把arena移交给变换后的新树；arena的页不移动，节点在新树中保持有效
+        [[nodiscard]] AstArena releaseArena() noexcept { return std::move(arena_); }
 
     private:
-        std::unique_ptr<Block> block_;
+        AstArena arena_;
+        const Block *block_;
     };
 
     // 具体语句类型
     class AssignStatement : public Statement
     {
     public:
-        AssignStatement(std::string_view name, std::unique_ptr<Expression> expr)
-            : name_(name), expr_(std::move(expr)) {}
+        AssignStatement(std::string_view name, SymbolId symbol, const Expression *expr)
+            : Statement(NodeKind::AssignStatement), name_(name), symbol_(symbol), expr_(expr) {}
 
         void accept(ASTVisitor &visitor) const override;
 
         [[nodiscard]] std::string_view name() const noexcept { return name_; }
+        [[nodiscard]] SymbolId symbol() const noexcept { return symbol_; }
         [[nodiscard]] const Expression &expression() const noexcept { return *expr_; }
 
     private:
         std::string_view name_;
-        std::unique_ptr<Expression> expr_;
+        SymbolId symbol_;
+        const Expression *expr_;
     };
 
     // 调用语句
     class CallStatement : public Statement
     {
     public:
-        explicit CallStatement(std::string_view proc_name)
-            : proc_name_(proc_name) {}
+        CallStatement(std::string_view proc_name, SymbolId symbol)
+            : Statement(NodeKind::CallStatement), proc_name_(proc_name), symbol_(symbol) {}
 
         void accept(ASTVisitor &visitor) const override;
         [[nodiscard]] std::string_view procName() const noexcept { return proc_name_; }
+        [[nodiscard]] SymbolId symbol() const noexcept { return symbol_; }
 
     private:
         std::string_view proc_name_;
+        SymbolId symbol_;
     };
 
     // Begin语句
     class BeginStatement : public Statement
     {
     public:
-        explicit BeginStatement(std::vector<std::unique_ptr<Statement>> statements)
-            : statements_(std::move(statements)) {}
+        explicit BeginStatement(std::span<const Statement *const> statements)
+            : Statement(NodeKind::BeginStatement), statements_(statements) {}
 
         void accept(ASTVisitor &visitor) const override;
         [[nodiscard]] const auto &statements() const noexcept { return statements_; }
 
     private:
-        std::vector<std::unique_ptr<Statement>> statements_;
+        std::span<const Statement *const> statements_;
     };
 
     // If语句
     class IfStatement : public Statement
     {
     public:
-        IfStatement(std::unique_ptr<Expression> condition,
-                    std::unique_ptr<Statement> then_stmt)
-            : condition_(std::move(condition)), then_stmt_(std::move(then_stmt)) {}
+        IfStatement(const Expression *condition, const Statement *then_stmt)
+            : Statement(NodeKind::IfStatement), condition_(condition), then_stmt_(then_stmt) {}
 
         void accept(ASTVisitor &visitor) const override;
 
@@ -204,17 +259,16 @@ namespace pl0
         [[nodiscard]] const Statement &thenStmt() const noexcept { return *then_stmt_; }
 
     private:
-        std::unique_ptr<Expression> condition_;
-        std::unique_ptr<Statement> then_stmt_;
+        const Expression *condition_;
+        const Statement *then_stmt_;
     };
 
     // While语句
     class WhileStatement : public Statement
     {
     public:
-        WhileStatement(std::unique_ptr<Expression> condition,
-                       std::unique_ptr<Statement> body)
-            : condition_(std::move(condition)), body_(std::move(body)) {}
+        WhileStatement(const Expression *condition, const Statement *body)
+            : Statement(NodeKind::WhileStatement), condition_(condition), body_(body) {}
 
         void accept(ASTVisitor &visitor) const override;
 
@@ -222,52 +276,44 @@ namespace pl0
         [[nodiscard]] const Statement &body() const noexcept { return *body_; }
 
     private:
-        std::unique_ptr<Expression> condition_;
-        std::unique_ptr<Statement> body_;
+        const Expression *condition_;
+        const Statement *body_;
     };
 
     // 具体表达式类型
     class BinaryExpression : public Expression
     {
     public:
+        // Shl不出现在源码中，由强度削弱从乘方得到: left * 2^right，right为负时与乘方一样报错
         enum class Op {
-            Add, Sub, Mul, Div, Pow,
+            Add, Sub, Mul, Div, Pow, Shl,
             Eq, Neq, Lt, Lte, Gt, Gte
         };
 
-        BinaryExpression(std::unique_ptr<Expression> left, Op op,
-                         std::unique_ptr<Expression> right)
-            : left_(std::move(left)), op_(op), right_(std::move(right)) {}
+        BinaryExpression(const Expression *left, Op op, const Expression *right)
+            : Expression(NodeKind::BinaryExpression), left_(left), op_(op), right_(right) {}
 
         void accept(ASTVisitor &visitor) const override;
 
-        [[nodiscard]] bool isConstant() const noexcept override;
-        [[nodiscard]] std::optional<int64_t> evaluateConstant() const override;
-
         [[nodiscard]] const Expression &left() const noexcept { return *left_; }
         [[nodiscard]] const Expression &right() const noexcept { return *right_; }
         [[nodiscard]] Op op() const noexcept { return op_; }
 
     private:
-        std::unique_ptr<Expression> left_;
+        const Expression *left_;
         Op op_;
-        std::unique_ptr<Expression> right_;
+        const Expression *right_;
     };
 
     // 数字表达式
     class NumberExpression : public Expression
     {
     public:
-        explicit NumberExpression(int64_t value) : value_(value) {}
+        explicit NumberExpression(int64_t value)
+            : Expression(NodeKind::NumberExpression), value_(value) {}
 
         void accept(ASTVisitor &visitor) const override;
 
-        [[nodiscard]] bool isConstant() const noexcept override { return true; }
-        [[nodiscard]] std::optional<int64_t> evaluateConstant() const override
-        {
-            return value_;
-        }
-
         [[nodiscard]] int64_t value() const noexcept { return value_; }
 
     private:
@@ -278,20 +324,17 @@ namespace pl0
     class IdentifierExpression : public Expression
     {
     public:
-        explicit IdentifierExpression(std::string_view name) : name_(name) {}
+        IdentifierExpression(std::string_view name, SymbolId symbol)
+            : Expression(NodeKind::IdentifierExpression), name_(name), symbol_(symbol) {}
 
         void accept(ASTVisitor &visitor) const override;
 
-        [[nodiscard]] bool isConstant() const noexcept override { return false; }
-        [[nodiscard]] std::optional<int64_t> evaluateConstant() const override
-        {
-            return std::nullopt;
-        }
-
         [[nodiscard]] std::string_view name() const noexcept { return name_; }
+        [[nodiscard]] SymbolId symbol() const noexcept { return symbol_; }
 
     private:
         std::string_view name_;
+        SymbolId symbol_;
     };
 
     // 一元表达式
@@ -301,41 +344,26 @@ namespace pl0
         enum class Op
         {
             Neg,
-            Not
-        }; // 负号和逻辑非
+            Not,
+            Odd
+        }; // 负号、逻辑非和奇偶判断
 
-        UnaryExpression(Op op, std::unique_ptr<Expression> operand)
-            : op_(op), operand_(std::move(operand)) {}
+        UnaryExpression(Op op, const Expression *operand)
+            : Expression(NodeKind::UnaryExpression), op_(op), operand_(operand) {}
 
         void accept(ASTVisitor &visitor) const override;
 
-        [[nodiscard]] bool isConstant() const noexcept override
-        {
-            return operand_->isConstant();
-        }
-
-        [[nodiscard]] std::optional<int64_t> evaluateConstant() const override
-        {
-            auto val = operand_->evaluateConstant();
-            if (!val)
-                return std::nullopt;
-
-            switch (op_)
-            {
-            case Op::Neg:
-                return -(*val);
-            case Op::Not:
-                return !(*val);
-            }
-            return std::nullopt;
-        }
-
         [[nodiscard]] const Expression &operand() const noexcept { return *operand_; }
         [[nodiscard]] Op op() const noexcept { return op_; }
 
     private:
         Op op_;
-        std::unique_ptr<Expression> operand_;
+        const Expression *operand_;
     };
 
+    // 过程体中处在尾位置的调用语句，没有时为nullptr。尾位置是过程体本身、尾位置上begin的最后一条语句
+    // 和尾位置上if的then分支；if没有else，所以至多一处。尾调用返回后过程随即返回，
+    // 被调用者不以当前帧为静态链时可以直接复用当前帧
+    [[nodiscard]] const CallStatement *tailCall(const Statement &body) noexcept;
+
 } // namespace pl0
\ No newline at end of file
@@ -1,30 +1,30 @@
 #pragma once
-#include "ASTVisitor.h"
+#include "ASTWalker.h"
 
 #include <string>
 #include <ostream>
 
 namespace pl0
 {
-    class ASTPrinter : public ASTVisitor
+    class ASTPrinter : public ASTWalker<ASTPrinter>
     {
     public:
         explicit ASTPrinter(std::ostream &out) : out_(out) {}
 
-        void visit(const Program &node) override;
-        void visit(const Block &node) override;
-        void visit(const ConstDeclaration &node) override;
-        void visit(const VarDeclaration &node) override;
-        void visit(const ProcedureDeclaration &node) override;
-        void visit(const AssignStatement &node) override;
-        void visit(const CallStatement &node) override;
-        void visit(const BeginStatement &node) override;
-        void visit(const IfStatement &node) override;
-        void visit(const WhileStatement &node) override;
-        void visit(const BinaryExpression &node) override;
-        void visit(const UnaryExpression &node) override;
-        void visit(const NumberExpression &node) override;
-        void visit(const IdentifierExpression &node) override;
+        void visit(const Program &node);
+        void visit(const Block &node);
+        void visit(const ConstDeclaration &node);
+        void visit(const VarDeclaration &node);
+        void visit(const ProcedureDeclaration &node);
+        void visit(const AssignStatement &node);
+        void visit(const CallStatement &node);
+        void visit(const BeginStatement &node);
+        void visit(const IfStatement &node);
+        void visit(const WhileStatement &node);
+        void visit(const BinaryExpression &node);
+        void visit(const UnaryExpression &node);
+        void visit(const NumberExpression &node);
+        void visit(const IdentifierExpression &node);
 
     private:
         void indent() { out_ << std::string(level_ * 2, ' '); }
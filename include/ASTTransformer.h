@@ -0,0 +1,171 @@
+#pragma once
+#include "AST.h"
+
+#include <memory>
+#include <vector>
+#include <utility>
+
+namespace pl0
+{
+    // 重写AST的遍历基类(CRTP)，供优化遍使用
+    //
+    // 节点不可变，变换返回新节点的指针；子节点都未改变时直接返回原节点，因此未受影响的子树被原样共享。
+    // 新节点分配在原树的arena中，变换结束后arena移交给新的Program。
+    // Impl提供需要改写的transform(const X &)重载并以using引入其余默认实现，
+    // 在其中通过rewrite(child)继续变换子节点
+    template <typename Impl>
+    class ASTTransformer
+    {
+    public:
+        [[nodiscard]] std::unique_ptr<Program> transform(std::unique_ptr<Program> program)
+        {
+            arena_ = program->releaseArena();
+            const Block *block = self().transform(program->block());
+            return std::make_unique<Program>(std::move(arena_), block);
+        }
+
+        [[nodiscard]] const Block *transform(const Block &node)
+        {
+            std::vector<const ProcedureDeclaration *> procedures;
+            bool changed = false;
+            for (const auto *decl : node.procedures())
+            {
+                procedures.push_back(self().transform(*decl));
+                changed |= procedures.back() != decl;
+            }
+            const Statement *statement = rewrite(node.statement());
+            if (!changed && statement == &node.statement())
+            {
+                return &node;
+            }
+            return make<Block>(node, node.consts(), node.vars(), changed ? arena_.list(procedures) : node.procedures(),
+                               statement);
+        }
+
+        [[nodiscard]] const ProcedureDeclaration *transform(const ProcedureDeclaration &node)
+        {
+            const Block *block = self().transform(node.block());
+            return block == &node.block() ? &node : make<ProcedureDeclaration>(node, node.name(), node.symbol(), block);
+        }
+
+        [[nodiscard]] const Statement *transform(const AssignStatement &node)
+        {
+            const Expression *expr = rewrite(node.expression());
+            return expr == &node.expression() ? &node : make<AssignStatement>(node, node.name(), node.symbol(), expr);
+        }
+
+        [[nodiscard]] const Statement *transform(const CallStatement &node) { return &node; }
+
+        [[nodiscard]] const Statement *transform(const BeginStatement &node)
+        {
+            std::vector<const Statement *> statements;
+            bool changed = false;
+            for (const auto *stmt : node.statements())
+            {
+                statements.push_back(rewrite(*stmt));
+                changed |= statements.back() != stmt;
+            }
+            return changed ? make<BeginStatement>(node, arena_.list(statements)) : &node;
+        }
+
+        [[nodiscard]] const Statement *transform(const IfStatement &node)
+        {
+            const Expression *condition = rewrite(node.condition());
+            const Statement *then_stmt = rewrite(node.thenStmt());
+            if (condition == &node.condition() && then_stmt == &node.thenStmt())
+            {
+                return &node;
+            }
+            return make<IfStatement>(node, condition, then_stmt);
+        }
+
+        [[nodiscard]] const Statement *transform(const WhileStatement &node)
+        {
+            const Expression *condition = rewrite(node.condition());
+            const Statement *body = rewrite(node.body());
+            if (condition == &node.condition() && body == &node.body())
+            {
+                return &node;
+            }
+            return make<WhileStatement>(node, condition, body);
+        }
+
+        [[nodiscard]] const Expression *transform(const BinaryExpression &node)
+        {
+            const Expression *left = rewrite(node.left());
+            const Expression *right = rewrite(node.right());
+            if (left == &node.left() && right == &node.right())
+            {
+                return &node;
+            }
+            return make<BinaryExpression>(node, left, node.op(), right);
+        }
+
+        [[nodiscard]] const Expression *transform(const UnaryExpression &node)
+        {
+            const Expression *operand = rewrite(node.operand());
+            return operand == &node.operand() ? &node : make<UnaryExpression>(node, node.op(), operand);
+        }
+
+        [[nodiscard]] const Expression *transform(const NumberExpression &node) { return &node; }
+        [[nodiscard]] const Expression *transform(const IdentifierExpression &node) { return &node; }
+
+    protected:
+        ASTTransformer() = default;
+        ~ASTTransformer() = default;
+
+        // 按节点类型标签分派到Impl的transform
+        [[nodiscard]] const Statement *rewrite(const Statement &node)
+        {
+            switch (node.kind())
+            {
+            case NodeKind::AssignStatement:
+                return self().transform(static_cast<const AssignStatement &>(node));
+            case NodeKind::CallStatement:
+                return self().transform(static_cast<const CallStatement &>(node));
+            case NodeKind::BeginStatement:
+                return self().transform(static_cast<const BeginStatement &>(node));
+            case NodeKind::IfStatement:
+                return self().transform(static_cast<const IfStatement &>(node));
+            case NodeKind::WhileStatement:
+                return self().transform(static_cast<const WhileStatement &>(node));
+            default:
+                __builtin_unreachable();
+            }
+        }
+
+        [[nodiscard]] const Expression *rewrite(const Expression &node)
+        {
+            switch (node.kind())
+            {
+            case NodeKind::BinaryExpression:
+                return self().transform(static_cast<const BinaryExpression &>(node));
+            case NodeKind::NumberExpression:
+                return self().transform(static_cast<const NumberExpression &>(node));
+            case NodeKind::IdentifierExpression:
+                return self().transform(static_cast<const IdentifierExpression &>(node));
+            case NodeKind::UnaryExpression:
+                return self().transform(static_cast<const UnaryExpression &>(node));
+            default:
+                __builtin_unreachable();
+            }
+        }
+
+        // 在arena中构造替换origin的节点，沿用origin的源码位置
+        template <typename T, typename Origin, typename... Args>
+        [[nodiscard]] T *make(const Origin &origin, Args &&...args)
+        {
+            T *node = arena_.make<T>(std::forward<Args>(args)...);
+            node->setPosition(origin.line(), origin.column());
+            return node;
+        }
+
+        [[nodiscard]] AstArena &arena() noexcept { return arena_; }
+
+    private:
+        Impl &self() noexcept { return static_cast<Impl &>(*this); }
+
+        AstArena arena_;
+    };
+
+} // namespace pl0
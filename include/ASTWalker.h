@@ -0,0 +1,105 @@
+#pragma once
+#include "AST.h"
+
+#include <utility>
+
+namespace pl0
+{
+    // 按节点类型标签用switch分派到具体类型，f的所有重载可被内联
+    // 与accept/ASTVisitor相比，每个节点省去两次间接调用
+    template <typename F>
+    decltype(auto) visit(const Statement &node, F &&f)
+    {
+        switch (node.kind())
+        {
+        case NodeKind::AssignStatement:
+            return std::forward<F>(f)(static_cast<const AssignStatement &>(node));
+        case NodeKind::CallStatement:
+            return std::forward<F>(f)(static_cast<const CallStatement &>(node));
+        case NodeKind::BeginStatement:
+            return std::forward<F>(f)(static_cast<const BeginStatement &>(node));
+        case NodeKind::IfStatement:
+            return std::forward<F>(f)(static_cast<const IfStatement &>(node));
+        case NodeKind::WhileStatement:
+            return std::forward<F>(f)(static_cast<const WhileStatement &>(node));
+        default:
+            __builtin_unreachable();
+        }
+    }
+
+    template <typename F>
+    decltype(auto) visit(const Expression &node, F &&f)
+    {
+        switch (node.kind())
+        {
+        case NodeKind::BinaryExpression:
+            return std::forward<F>(f)(static_cast<const BinaryExpression &>(node));
+        case NodeKind::NumberExpression:
+            return std::forward<F>(f)(static_cast<const NumberExpression &>(node));
+        case NodeKind::IdentifierExpression:
+            return std::forward<F>(f)(static_cast<const IdentifierExpression &>(node));
+        case NodeKind::UnaryExpression:
+            return std::forward<F>(f)(static_cast<const UnaryExpression &>(node));
+        default:
+            __builtin_unreachable();
+        }
+    }
+
+    // 静态分派的遍历基类(CRTP)，Impl为每种具体节点提供visit(const X &)
+    // Impl在visit中通过walk(child)继续遍历子节点
+    template <typename Impl>
+    class ASTWalker
+    {
+    public:
+        void walk(const Program &node) { self().visit(node); }
+        void walk(const Block &node) { self().visit(node); }
+        void walk(const ConstDeclaration &node) { self().visit(node); }
+        void walk(const VarDeclaration &node) { self().visit(node); }
+        void walk(const ProcedureDeclaration &node) { self().visit(node); }
+
+        // 与pl0::visit相同的switch，直接写在成员函数里，递归时只传this和节点
+        void walk(const Statement &node)
+        {
+            switch (node.kind())
+            {
+            case NodeKind::AssignStatement:
+                return self().visit(static_cast<const AssignStatement &>(node));
+            case NodeKind::CallStatement:
+                return self().visit(static_cast<const CallStatement &>(node));
+            case NodeKind::BeginStatement:
+                return self().visit(static_cast<const BeginStatement &>(node));
+            case NodeKind::IfStatement:
+                return self().visit(static_cast<const IfStatement &>(node));
+            case NodeKind::WhileStatement:
+                return self().visit(static_cast<const WhileStatement &>(node));
+            default:
+                __builtin_unreachable();
+            }
+        }
+
+        void walk(const Expression &node)
+        {
+            switch (node.kind())
+            {
+            case NodeKind::BinaryExpression:
+                return self().visit(static_cast<const BinaryExpression &>(node));
+            case NodeKind::NumberExpression:
+                return self().visit(static_cast<const NumberExpression &>(node));
+            case NodeKind::IdentifierExpression:
+                return self().visit(static_cast<const IdentifierExpression &>(node));
+            case NodeKind::UnaryExpression:
+                return self().visit(static_cast<const UnaryExpression &>(node));
+            default:
+                __builtin_unreachable();
+            }
+        }
+
+    protected:
+        ASTWalker() = default;
+        ~ASTWalker() = default;
+
+    private:
+        Impl &self() noexcept { return static_cast<Impl &>(*this); }
+    };
+
+} // namespace pl0
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+
+namespace pl0::arith
+{
+    // 各执行引擎共用的整数运算：按64位补码回绕，避免有符号溢出的未定义行为
+
+    [[nodiscard]] inline int64_t add(int64_t a, int64_t b) noexcept
+    {
+        return static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+    }
+
+    [[nodiscard]] inline int64_t sub(int64_t a, int64_t b) noexcept
+    {
+        return static_cast<int64_t>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b));
+    }
+
+    [[nodiscard]] inline int64_t mul(int64_t a, int64_t b) noexcept
+    {
+        return static_cast<int64_t>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b));
+    }
+
+    // 与add/sub/mul的结果相同(写入result)，返回是否发生了有符号溢出，供编译期求值时报告
+    [[nodiscard]] inline bool addOverflow(int64_t a, int64_t b, int64_t &result) noexcept
+    {
+        return __builtin_add_overflow(a, b, &result);
+    }
+
+    [[nodiscard]] inline bool subOverflow(int64_t a, int64_t b, int64_t &result) noexcept
+    {
+        return __builtin_sub_overflow(a, b, &result);
+    }
+
+    [[nodiscard]] inline bool mulOverflow(int64_t a, int64_t b, int64_t &result) noexcept
+    {
+        return __builtin_mul_overflow(a, b, &result);
+    }
+
+    // 调用方保证b != 0；INT64_MIN / -1 按回绕结果处理
+    [[nodiscard]] inline int64_t div(int64_t a, int64_t b) noexcept
+    {
+        return b == -1 ? sub(0, a) : a / b;
+    }
+
+    // 调用方保证exponent >= 0。平方求幂，乘积按模2^64计算，与逐次相乘的回绕结果相同
+    [[nodiscard]] inline int64_t pow(int64_t base, int64_t exponent) noexcept
+    {
+        uint64_t result = 1;
+        uint64_t factor = static_cast<uint64_t>(base);
+        for (auto rest = static_cast<uint64_t>(exponent); rest > 0; rest >>= 1)
+        {
+            if (rest & 1)
+            {
+                result *= factor;
+            }
+            factor *= factor;
+        }
+        return static_cast<int64_t>(result);
+    }
+
+    // 与pow的结果相同(写入result)，返回是否发生了有符号溢出。
+    // 只在还有剩余位时平方，因此中间的溢出必然意味着结果溢出
+    [[nodiscard]] inline bool powOverflow(int64_t base, int64_t exponent, int64_t &result) noexcept
+    {
+        bool overflow = false;
+        int64_t factor = base;
+        result = 1;
+        for (auto rest = static_cast<uint64_t>(exponent); rest > 0;)
+        {
+            if (rest & 1)
+            {
+                overflow |= mulOverflow(result, factor, result);
+            }
+            rest >>= 1;
+            if (rest > 0)
+            {
+                overflow |= mulOverflow(factor, factor, factor);
+            }
+        }
+        return overflow;
+    }
+
+    // 调用方保证amount >= 0。等于value * 2^amount的回绕结果，移出64位时为0
+    [[nodiscard]] inline int64_t shl(int64_t value, int64_t amount) noexcept
+    {
+        return amount >= 64 ? 0 : static_cast<int64_t>(static_cast<uint64_t>(value) << amount);
+    }
+
+    // 与shl的结果相同(写入result)，返回是否发生了有符号溢出
+    [[nodiscard]] inline bool shlOverflow(int64_t value, int64_t amount, int64_t &result) noexcept
+    {
+        result = shl(value, amount);
+        return value != 0 && (amount >= 64 || (result >> amount) != value);
+    }
+
+} // namespace pl0::arith
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <span>
+#include <memory>
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+namespace pl0
+{
+    // AST节点的碰撞指针分配器，按64KB分页
+    // 节点只持有string_view、整数和指向同一arena的指针，不拥有任何资源，
+    // 因此arena释放时不逐个调用析构函数，整棵树的销毁只是释放若干页
+    class AstArena
+    {
+    public:
+        AstArena() = default;
+        AstArena(AstArena &&) noexcept = default;
+        AstArena &operator=(AstArena &&) noexcept = default;
+        AstArena(const AstArena &) = delete;
+        AstArena &operator=(const AstArena &) = delete;
+
+        template <typename T, typename... Args>
+        [[nodiscard]] T *make(Args &&...args)
+        {
+            void *memory = allocate(sizeof(T), alignof(T));
+            return ::new (memory) T(std::forward<Args>(args)...);
+        }
+
+        // 把临时收集的子节点列表复制进arena
+        template <typename T>
+        [[nodiscard]] std::span<T *const> list(const std::vector<T *> &items)
+        {
+            if (items.empty())
+            {
+                return {};
+            }
+            auto **memory = static_cast<T **>(allocate(sizeof(T *) * items.size(), alignof(T *)));
+            std::copy(items.begin(), items.end(), memory);
+            return {memory, items.size()};
+        }
+
+        [[nodiscard]] void *allocate(size_t bytes, size_t align);
+
+        // 已分配给节点的字节数 / 向系统申请的字节数
+        [[nodiscard]] size_t bytesUsed() const noexcept { return bytes_used_; }
+        [[nodiscard]] size_t bytesReserved() const noexcept { return bytes_reserved_; }
+
+    private:
+        static constexpr size_t PAGE_SIZE = 64 * 1024;
+
+        std::vector<std::unique_ptr<std::byte[]>> pages_;
+        std::byte *cursor_ = nullptr;
+        std::byte *end_ = nullptr;
+        size_t bytes_used_ = 0;
+        size_t bytes_reserved_ = 0;
+    };
+
+} // namespace pl0
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Compiler.h"
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+namespace pl0
+{
+    // 批量编译：在工作窃取线程池上对每个文件执行compileFile + outputResults
+    // 每个文件的结果写入输出目录下与输入相对路径对应的子目录(重名时改名)，另汇总到summary.txt
+    class BatchCompiler
+    {
+    public:
+        struct FileResult
+        {
+            std::filesystem::path input;
+            std::filesystem::path outputDir;
+            bool renamed = false; // 输出目录与其他输入的重名，改用了带扩展名或序号的名字
+            bool success = false;
+            std::vector<std::string> errors;
+            Compiler::Stats stats;
+            double seconds = 0.0; // 编译和写出结果的总耗时
+        };
+
+        struct Summary
+        {
+            std::vector<FileResult> files; // 与输入顺序一致
+            size_t threads = 0;
+            size_t steals = 0;
+            double wallSeconds = 0.0;
+
+            [[nodiscard]] size_t failures() const noexcept;
+            [[nodiscard]] double busySeconds() const noexcept;
+        };
+
+        // input为目录(递归收集*.pl0)或列表文件(每行一个路径，空行和#开头的行忽略)
+        // threads为0时使用硬件线程数；无法读取input时抛出std::runtime_error
+        [[nodiscard]] static Summary run(const std::filesystem::path &input,
+                                         const std::filesystem::path &outputDir,
+                                         size_t threads = 0);
+
+        static void outputSummary(const Summary &summary, const std::filesystem::path &path);
+
+    private:
+        [[nodiscard]] static std::vector<std::filesystem::path> collectInputs(const std::filesystem::path &input);
+        [[nodiscard]] static std::filesystem::path outputDirFor(const std::filesystem::path &input,
+                                                                const std::filesystem::path &file,
+                                                                const std::filesystem::path &outputDir);
+        static void disambiguateOutputDirs(std::vector<FileResult> &files);
+    };
+
+} // namespace pl0
@@ -0,0 +1,65 @@
+#pragma once
+#include "ASTWalker.h"
+#include "SymbolTable.h"
+
+#include <string>
+#include <vector>
+#include <string_view>
+
+namespace pl0
+{
+    // 把通过语义分析的AST翻译为一个独立的C翻译单元(C99)
+    //
+    // 每个块对应一个帧结构体struct f_N，过程内以局部变量f持有本帧，f.sl指向静态外层的帧，
+    // 外层变量经f.sl->sl->...访问；过程翻译为接收外层帧指针的static函数。
+    // 整数运算通过内联辅助函数保持PL/0语义: 64位补码回绕、向零取整的除法、整数乘方，
+    // 除零、负指数和栈溢出(按虚拟机的槽位计数)在运行时报错。
+    // 过程体尾位置上对自身的调用翻译为重置帧后跳回函数开头，尾递归的循环不占用C栈；
+    // 其余调用保持C函数调用，深度受PL0_STACK_SIZE的槽位检查限制。
+    // 生成的main执行程序并按"名字 = 值"逐行输出主程序变量，与PL0 --run的输出格式相同
+    class CEmitter : public ASTWalker<CEmitter>
+    {
+    public:
+        [[nodiscard]] std::string emit(const Program &program);
+
+        void visit(const Program &node);
+        void visit(const Block &node);
+        void visit(const ConstDeclaration &node);
+        void visit(const VarDeclaration &node);
+        void visit(const ProcedureDeclaration &node);
+        void visit(const AssignStatement &node);
+        void visit(const CallStatement &node);
+        void visit(const BeginStatement &node);
+        void visit(const IfStatement &node);
+        void visit(const WhileStatement &node);
+
+    private:
+        void condition(const Expression &expr);
+        void expression(const Expression &expr);
+        void variable(const Symbol &symbol, std::string_view name);
+        void frameAt(size_t distance);
+        void open();
+        void close();
+        // 按当前缩进开始新的一行，返回body_以便追加
+        std::string &line();
+
+        [[nodiscard]] const Symbol &resolve(SymbolId name) const;
+
+        SymbolTable symbols_;
+        std::string structs_;    // 帧结构体定义
+        std::string prototypes_; // 过程的前置声明
+        std::string functions_;  // 过程和主程序块的定义
+        std::string body_;       // 正在生成的函数体
+        std::vector<std::string_view> globals_;
+        std::vector<std::string> functions_by_frame_; // 帧结构体编号 -> 对应的C函数名
+        size_t level_ = 0;
+        size_t frame_id_ = 0;   // 当前块的帧结构体编号
+        size_t next_frame_ = 0;
+        size_t var_count_ = 0;
+        size_t temp_count_ = 0; // 当前函数需要的求值顺序临时变量t0..tN-1
+        size_t temp_depth_ = 0; // 正在生成的表达式中仍在使用的临时变量数
+        size_t indent_ = 0;
+        bool tail_ = false; // 正在生成的语句处在过程体的尾位置
+    };
+
+} // namespace pl0
@@ -0,0 +1,43 @@
+#pragma once
+#include "ASTWalker.h"
+#include "SymbolTable.h"
+
+#include <vector>
+#include <unordered_map>
+
+namespace pl0
+{
+    // 找出被嵌套过程访问的变量: 引用解析到外层变量时标记它所在块的那一项
+    // 这些变量可能在调用中被读写，其余变量只在声明它的过程体内可见
+    class CaptureAnalysis : public ASTWalker<CaptureAnalysis>
+    {
+    public:
+        // 每个块一项，下标为块内变量的序号
+        [[nodiscard]] std::unordered_map<const Block *, std::vector<bool>> run(const Program &program);
+
+        void visit(const Program &node);
+        void visit(const Block &node);
+        void visit(const ConstDeclaration &node);
+        void visit(const VarDeclaration &node);
+        void visit(const ProcedureDeclaration &node);
+        void visit(const AssignStatement &node);
+        void visit(const CallStatement &) {}
+        void visit(const BeginStatement &node);
+        void visit(const IfStatement &node);
+        void visit(const WhileStatement &node);
+        void visit(const BinaryExpression &node);
+        void visit(const UnaryExpression &node) { walk(node.operand()); }
+        void visit(const NumberExpression &) {}
+        void visit(const IdentifierExpression &node) { reference(node.symbol()); }
+
+    private:
+        void reference(SymbolId name);
+
+        SymbolTable symbols_;
+        std::vector<std::vector<bool>> frames_; // 外层各块的标记，下标为层
+        std::unordered_map<const Block *, std::vector<bool>> captured_;
+        size_t level_ = 0;
+        size_t var_count_ = 0;
+    };
+
+} // namespace pl0
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+namespace pl0::scan
+{
+    // 字符类别位
+    enum CharClass : uint8_t
+    {
+        SPACE = 1 << 0,   // ' ' \t \n \v \f \r
+        NEWLINE = 1 << 1, // \n
+        ALPHA = 1 << 2,   // a-z A-Z
+        DIGIT = 1 << 3,   // 0-9
+    };
+
+    // 编译期生成的256项字符类别表，标量路径和向量路径的尾部处理共用
+    inline constexpr std::array<uint8_t, 256> CHAR_CLASS = []
+    {
+        std::array<uint8_t, 256> table{};
+        for (int c = 0; c < 256; ++c)
+        {
+            uint8_t cls = 0;
+            if (c == ' ' || (c >= '\t' && c <= '\r'))
+                cls |= SPACE;
+            if (c == '\n')
+                cls |= NEWLINE;
+            if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+                cls |= ALPHA;
+            if (c >= '0' && c <= '9')
+                cls |= DIGIT;
+            table[c] = cls;
+        }
+        return table;
+    }();
+
+    [[nodiscard]] constexpr bool is(char c, uint8_t mask) noexcept
+    {
+        return (CHAR_CLASS[static_cast<unsigned char>(c)] & mask) != 0;
+    }
+
+    // 跳过空白的结果
+    struct WhitespaceRun
+    {
+        size_t end;          // 第一个非空白字符的位置
+        size_t newlines;     // 跳过的换行数
+        size_t line_start;   // 最后一个换行之后的位置，没有换行时为npos
+    };
+
+    // 以下函数从pos开始扫描，按运行时检测到的指令集(AVX2/SSE2/标量)分派
+    [[nodiscard]] WhitespaceRun skipWhitespace(std::string_view source, size_t pos) noexcept;
+    // 返回[A-Za-z0-9]*游程的结束位置
+    [[nodiscard]] size_t scanIdentifier(std::string_view source, size_t pos) noexcept;
+    // 返回[0-9]*游程的结束位置
+    [[nodiscard]] size_t scanDigits(std::string_view source, size_t pos) noexcept;
+
+    // 当前使用的实现名称: "avx2" / "sse2" / "scalar"
+    [[nodiscard]] std::string_view backendName() noexcept;
+
+} // namespace pl0::scan
@@ -0,0 +1,53 @@
+#pragma once
+#include "ASTWalker.h"
+#include "PCode.h"
+#include "SymbolTable.h"
+
+namespace pl0
+{
+    // 把通过语义分析的AST翻译为p-code
+    // 符号的level为声明所在块的嵌套层(主程序为0)，变量的index为帧内变量序号，
+    // 过程符号的value为其入口地址，因此递归调用时入口已知
+    // 同时生成过程表、具名常量表和源码位置表，供预编译文件和运行时错误定位使用
+    class CodeGenerator : public ASTWalker<CodeGenerator>
+    {
+    public:
+        [[nodiscard]] PCode generate(const Program &program);
+
+        void visit(const Program &node);
+        void visit(const Block &node);
+        void visit(const ConstDeclaration &node);
+        void visit(const VarDeclaration &node);
+        void visit(const ProcedureDeclaration &node);
+        void visit(const AssignStatement &node);
+        void visit(const CallStatement &node);
+        void visit(const BeginStatement &node);
+        void visit(const IfStatement &node);
+        void visit(const WhileStatement &node);
+        void visit(const BinaryExpression &node);
+        void visit(const UnaryExpression &node);
+        void visit(const NumberExpression &node);
+        void visit(const IdentifierExpression &node);
+
+    private:
+        size_t emit(OpCode op, uint8_t level, int64_t argument);
+        size_t emit(Opr opr) { return emit(OpCode::OPR, 0, static_cast<int64_t>(opr)); }
+        void patch(size_t at, size_t target);
+        // 记录语句首条指令的源码位置
+        void mark(const Statement &node) { mark(node.line(), node.column()); }
+        void mark(size_t line, size_t column);
+        [[nodiscard]] size_t here() const noexcept { return program_.code.size(); }
+
+        // 语义分析已保证符号存在且种类正确
+        [[nodiscard]] const Symbol &resolve(SymbolId name) const;
+        [[nodiscard]] uint8_t levelDistance(const Symbol &symbol) const;
+
+        SymbolTable symbols_;
+        PCode program_;
+        size_t level_ = 0;
+        size_t var_count_ = 0;
+        size_t procedure_ = 0; // 当前块在过程表中的下标
+        const ProcedureDeclaration *declaration_ = nullptr; // 当前块所属的过程声明，主程序为空
+    };
+
+} // namespace pl0
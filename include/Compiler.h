@@ -1,8 +1,16 @@
 #pragma once
 
+#include "PCode.h"
+#include "PCodeImage.h"
 #include "Parser.h"
 #include "ASTPrinter.h"
 #include "SemanticAnalyzer.h"
+#include "CodeGenerator.h"
+#include "Inliner.h"
+#include "ConstantFolder.h"
+#include "DeadCodeEliminator.h"
+#include "LoopInvariantHoister.h"
+#include "SourceBuffer.h"
 #include "TokenInterpreter.h"
 
 #include <string>
@@ -14,25 +22,81 @@ namespace pl0
     class Compiler
     {
     public:
+        // 各阶段耗时与规模统计
+        struct Stats
+        {
+            size_t sourceBytes = 0;
+            bool sourceMapped = false;
+            double loadSeconds = 0.0;
+            size_t tokenCount = 0;
+            size_t tokenBytes = 0;
+            double lexSeconds = 0.0;
+            double parseSeconds = 0.0;
+            size_t astBytes = 0;
+            size_t astReservedBytes = 0;
+            double semanticSeconds = 0.0;
+            double optimizeSeconds = 0.0;
+            size_t instructionCount = 0;
+            double codegenSeconds = 0.0;
+            long peakRssKB = 0;
+
+            [[nodiscard]] double lexThroughputMBps() const noexcept
+            {
+                return lexSeconds > 0.0 ? static_cast<double>(sourceBytes) / (1024.0 * 1024.0) / lexSeconds : 0.0;
+            }
+        };
+
+        // 语义分析之后、代码生成之前在AST上进行的优化，默认都关闭
+        struct Options
+        {
+            bool inlining = false; // 内联非递归的小过程
+            size_t inlineBudget = Inliner::DEFAULT_BUDGET;
+            bool folding = false; // 折叠常量表达式，在内联之后进行
+            bool deadCode = false; // 删除死代码和不可达的过程，在折叠之后进行
+            bool hoisting = false; // 把循环不变的计算移到循环之前，在死代码删除之后进行
+        };
+
         struct Result
         {
             bool success;
             std::vector<std::string> errors;
-            std::vector<Token> tokens;
+            TokenBuffer tokens;
             std::unique_ptr<Program> ast;
             std::vector<std::string> semanticInfo;
+            // 开启内联时每个调用点的决定
+            std::vector<Inliner::Decision> inlining;
+            // 开启常量折叠时的诊断
+            std::vector<ConstantFolder::Diagnostic> folding;
+            // 开启死代码删除时每个过程删除的内容
+            std::vector<DeadCodeEliminator::Report> deadCode;
+            // 开启循环不变量外提时每个循环外提的表达式数
+            std::vector<LoopInvariantHoister::Report> hoisting;
+            // 语义分析通过后生成的p-code
+            PCode code;
+            Stats stats;
+            // compileFile读入的源码，tokens和ast中的string_view都指向这里
+            SourceBuffer source;
+            // 本次编译的标识符驻留表，tokens和ast中的SymbolId都指向这里
+            Interner symbols;
         };
 
         [[nodiscard]] static Result compileFile(const std::filesystem::path &path);
+        [[nodiscard]] static Result compileFile(const std::filesystem::path &path, const Options &options);
 
         [[nodiscard]] static Result compileString(std::string_view source);
+        [[nodiscard]] static Result compileString(std::string_view source, const Options &options);
 
         static void outputResults(const Result &result, const std::filesystem::path &outputDir);
 
+        // 把compileFile(source)成功的结果写成预编译文件(.pl0c)；失败时抛出std::runtime_error
+        static void writeImage(const Result &result, const std::filesystem::path &source,
+                               const std::filesystem::path &image);
+
     private:
-        static void outputTokens(const std::vector<Token> &tokens,
+        static void outputTokens(const TokenBuffer &tokens,
                                  const std::filesystem::path &path);
         static void outputAST(const Program &ast, const std::filesystem::path &path);
+        static void outputStats(const Stats &stats, const std::filesystem::path &path);
         static void outputSemanticInfo(const std::vector<std::string> &info,
                                        const std::filesystem::path &path);
     };
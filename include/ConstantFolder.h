@@ -0,0 +1,77 @@
+#pragma once
+#include "ASTTransformer.h"
+#include "SymbolTable.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+
+namespace pl0
+{
+    // 自底向上折叠常量表达式: const标识符经符号表替换为数值，运算数都是数值的运算替换为结果；
+    // 同时对乘方做强度削弱(见reduce)
+    //
+    // 每个节点只变换一次，结果按原节点缓存，内联等变换共享的子树不会重复折叠。
+    // 求值与运行时一致(64位补码回绕)，发生溢出的折叠仍按回绕结果替换并记入诊断；
+    // 除零和负指数是运行时错误，保留原表达式。表达式节点没有源码位置，诊断使用所在语句的位置
+    class ConstantFolder : public ASTTransformer<ConstantFolder>
+    {
+    public:
+        // 编译期求得的值，overflow表示计算中发生了有符号溢出
+        struct Value
+        {
+            int64_t value;
+            bool overflow;
+        };
+
+        struct Diagnostic
+        {
+            enum class Kind
+            {
+                Folded,          // 折叠为value
+                Overflow,        // 折叠为按回绕得到的value
+                NegativeExponent // 指数为负，不折叠
+            } kind;
+            size_t line;
+            size_t column;
+            int64_t value;
+        };
+
+        [[nodiscard]] std::unique_ptr<Program> run(std::unique_ptr<Program> program);
+
+        // 每个折叠到最外层的表达式一项，内层的折叠并入其中
+        [[nodiscard]] const std::vector<Diagnostic> &diagnostics() const noexcept { return diagnostics_; }
+
+        // 形如"行3列5 常量表达式折叠为 42"
+        [[nodiscard]] static std::string describe(const Diagnostic &diagnostic);
+
+        // 按运行时语义求值；除数为零或指数为负时运行时报错，返回std::nullopt
+        [[nodiscard]] static std::optional<Value> evaluate(BinaryExpression::Op op, int64_t lhs, int64_t rhs) noexcept;
+        [[nodiscard]] static Value evaluate(UnaryExpression::Op op, int64_t operand) noexcept;
+
+        using ASTTransformer<ConstantFolder>::transform;
+        [[nodiscard]] const Block *transform(const Block &node);
+        [[nodiscard]] const Statement *transform(const AssignStatement &node);
+        [[nodiscard]] const Statement *transform(const IfStatement &node);
+        [[nodiscard]] const Statement *transform(const WhileStatement &node);
+        [[nodiscard]] const Expression *transform(const BinaryExpression &node);
+        [[nodiscard]] const Expression *transform(const UnaryExpression &node);
+        [[nodiscard]] const Expression *transform(const IdentifierExpression &node);
+
+    private:
+        // 子表达式都已折叠为数值时记录折叠，mark之后的内层诊断并入这一项
+        [[nodiscard]] const Expression *fold(const Expression &origin, Value value, size_t mark);
+        // 乘方的强度削弱: 2^e改为1 << e，y * 2^e改为y << e，x^2(x为叶子)改为x * x；不适用时返回nullptr
+        [[nodiscard]] const Expression *reduce(const BinaryExpression &node, const Expression *left,
+                                               const Expression *right);
+
+        SymbolTable scope_;
+        std::unordered_map<const Expression *, const Expression *> folded_;
+        std::vector<Diagnostic> diagnostics_;
+        size_t line_ = 0;
+        size_t column_ = 0;
+    };
+
+} // namespace pl0
@@ -0,0 +1,81 @@
+#pragma once
+#include "ASTTransformer.h"
+#include "SymbolTable.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+namespace pl0
+{
+    // 删除不影响程序结果的代码，让后面的阶段处理更小的树
+    //
+    // 条件恒为假的if和while整句删除，恒为真的if换成分支本身；条件求值会报错时不算常量。
+    // 赋值给本过程的局部变量(不被嵌套过程访问)时按活跃性判断: 在此后的每条路径上都先被覆盖或
+    // 过程结束，就删除这条赋值；右边可能报错(除数、指数不是合法的常量)时保留。
+    // 主程序的用户变量是程序的输出，在结尾活跃。
+    // 最后从主程序出发沿调用语句求可达的过程，删掉其余的过程声明
+    class DeadCodeEliminator : public ASTTransformer<DeadCodeEliminator>
+    {
+    public:
+        // 主程序和每个过程各一项(没有删除的也列出)，按声明的先序
+        struct Report
+        {
+            std::string_view procedure; // 主程序为空
+            bool unreachable = false;   // 从未被调用，整个声明已删除
+            size_t deadStores = 0;
+            size_t falseBranches = 0; // 删除的条件恒假的if/while
+            size_t trueBranches = 0;  // 换成分支本身的条件恒真的if
+        };
+
+        [[nodiscard]] std::unique_ptr<Program> run(std::unique_ptr<Program> program);
+
+        [[nodiscard]] const std::vector<Report> &reports() const noexcept { return reports_; }
+
+        // 形如"过程divide: 删除 2 条无用赋值, 1 个条件恒假的语句"，没有删除时为"过程divide: 无删除"
+        [[nodiscard]] static std::string describe(const Report &report);
+
+        using ASTTransformer<DeadCodeEliminator>::transform;
+        [[nodiscard]] const Block *transform(const Block &node);
+        [[nodiscard]] const ProcedureDeclaration *transform(const ProcedureDeclaration &node);
+        [[nodiscard]] const Statement *transform(const BeginStatement &node);
+        [[nodiscard]] const Statement *transform(const IfStatement &node);
+        [[nodiscard]] const Statement *transform(const WhileStatement &node);
+
+    private:
+        // 本过程局部变量是否活跃，下标为变量序号
+        using Liveness = std::vector<bool>;
+
+        // 倒序求活跃性并删除无用赋值；apply为false时只更新live，供循环求不动点
+        [[nodiscard]] const Statement *sweep(const Statement &node, Liveness &live, bool apply);
+        void use(const Expression &expr, Liveness &live) const;
+        [[nodiscard]] std::optional<size_t> local(SymbolId name) const;
+        [[nodiscard]] std::optional<int64_t> constant(const Expression &expr) const;
+        [[nodiscard]] bool trapFree(const Expression &expr) const;
+        [[nodiscard]] const Statement *empty(const Statement &origin);
+
+        // 第二遍: 调用图上不可达的过程
+        void analyze(const Block &block, size_t id);
+        void analyze(const Statement &node, size_t id);
+        void markReachable();
+        [[nodiscard]] const Block *prune(const Block &node);
+
+        SymbolTable scope_;
+        std::unordered_map<const Block *, std::vector<bool>> captured_;
+        std::vector<bool> candidates_; // 当前过程中可以删除赋值的变量
+        size_t level_ = 0;
+        Report current_;
+        std::unordered_map<const ProcedureDeclaration *, Report> stats_; // 主程序的键为nullptr
+
+        bool pruning_ = false;
+        std::vector<const ProcedureDeclaration *> procedures_; // 下标0为主程序
+        std::vector<std::vector<size_t>> callees_;
+        std::unordered_map<const ProcedureDeclaration *, size_t> ids_;
+        std::vector<bool> reachable_;
+        std::vector<Report> reports_;
+    };
+
+} // namespace pl0
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "JitCompiler.h"
+
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+
+namespace pl0
+{
+    // 把JitCompiler生成的机器码包装为静态的x86-64 Linux ELF可执行文件
+    //
+    // 文件只有一个只读可执行段(ELF头、字符串常量、机器码和启动代码)，数据栈、调用栈和
+    // NativeContext都放在不占文件空间的bss段中，由内核按需清零映射。启动代码直接填好
+    // NativeContext并调用入口，不依赖libc和动态链接器，只使用write和exit两个系统调用
+    class ElfWriter
+    {
+    public:
+        // 启动代码以32位立即数寻址bss，数据栈和调用栈(每槽位共24字节)须让整个映像留在4GB以下
+        static constexpr size_t MAX_STACK_SIZE = size_t{1} << 26;
+
+        struct Options
+        {
+            size_t stack_size;  // 数据栈槽位数，与虚拟机的栈容量含义相同
+            bool print_globals; // 结束时按"名字 = 值"输出主程序变量
+        };
+
+        // stack_size超过MAX_STACK_SIZE时抛出std::runtime_error
+        [[nodiscard]] static std::vector<uint8_t> build(const NativeCode &code, const Options &options);
+
+        // 写出文件并加上可执行权限；失败时抛出std::runtime_error
+        static void write(const NativeCode &code, const std::filesystem::path &path, const Options &options);
+    };
+
+} // namespace pl0
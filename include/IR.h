@@ -0,0 +1,133 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+namespace pl0
+{
+    // SSA形式的中间表示，供优化和后端共用
+    //
+    // 每个过程和主程序各是一个IrFunction: 基本块构成控制流图，每个值由唯一一条指令定义。
+    // 本层变量不被嵌套过程访问时提升为SSA值，控制流交汇处用phi合并；外层变量和被嵌套过程访问的
+    // 本层变量留在帧中，用load/store按(层差, 变量序号)显式读写，call可能改写它们。
+    // 变量的初值为0，未赋值就读的变量为const 0；主程序变量是程序的输出，ret之前把提升了的用户变量写回帧
+    enum class IrOp : uint8_t
+    {
+        Const, // imm
+
+        // a op b，语义与p-code相同
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Pow,
+        Shl,
+        Eq,
+        Neq,
+        Lt,
+        Lte,
+        Gt,
+        Gte,
+
+        // op a
+        Neg,
+        Not,
+        Odd,
+
+        Phi,   // 操作数与所在块的前驱一一对应，只出现在块的开头
+        Load,  // 读层差level的帧中的变量index
+        Store, // 把操作数写入层差level的帧中的变量index
+        Call,  // 调用函数index，level为调用处到被调过程声明所在层的层差
+
+        // 终结指令，每块恰好一条且在最后
+        Jump,   // 跳到targets[0]
+        Branch, // 操作数非0时跳到targets[0]，否则跳到targets[1]
+        Return
+    };
+
+    using IrValue = uint32_t; // 指令在IrFunction::values中的下标，有结果的指令即以它命名结果
+    using IrBlockId = uint32_t;
+
+    inline constexpr IrBlockId NO_BLOCK = std::numeric_limits<IrBlockId>::max();
+
+    struct IrInstruction
+    {
+        IrOp op;
+        uint8_t level = 0;
+        size_t index = 0;
+        int64_t imm = 0;
+        std::string_view name; // load/store的变量名、call的过程名，只用于输出
+        std::vector<IrValue> operands;
+        std::vector<IrBlockId> targets;
+        IrBlockId block = NO_BLOCK; // 所在的块，删除后为NO_BLOCK
+    };
+
+    struct IrBlock
+    {
+        std::vector<IrValue> instructions;
+        std::vector<IrBlockId> preds; // 顺序即phi操作数的顺序
+    };
+
+    struct IrFunction
+    {
+        std::string_view name; // 主程序为空
+        size_t level = 0;      // 函数体所在的嵌套层，主程序为0
+        size_t parent = 0;     // 静态外层函数的下标，主程序为0
+        std::vector<std::string_view> variables; // 本层变量，下标即变量序号
+        std::vector<bool> promoted;              // 变量是否提升为SSA值
+        std::vector<IrInstruction> values;
+        std::vector<IrBlock> blocks; // blocks[0]为入口
+
+        [[nodiscard]] const IrInstruction &terminator(IrBlockId block) const
+        {
+            return values[blocks[block].instructions.back()];
+        }
+        [[nodiscard]] const std::vector<IrBlockId> &successors(IrBlockId block) const
+        {
+            return terminator(block).targets;
+        }
+    };
+
+    struct IrModule
+    {
+        std::vector<IrFunction> functions; // functions[0]为主程序，其余按声明的先序
+    };
+
+    [[nodiscard]] std::string_view irOpName(IrOp op) noexcept;
+    [[nodiscard]] bool isTerminator(IrOp op) noexcept;
+    [[nodiscard]] bool hasResult(IrOp op) noexcept;
+
+    // 支配树，按Cooper、Harvey、Kennedy的迭代算法("A Simple, Fast Dominance Algorithm")计算:
+    // 以逆后序反复用前驱已知的idom求交，直到不再变化。从入口不可达的块不在树中
+    class DominatorTree
+    {
+    public:
+        explicit DominatorTree(const IrFunction &function);
+
+        [[nodiscard]] bool reachable(IrBlockId block) const noexcept { return order_[block] != NO_BLOCK; }
+        // 入口的idom是它自己；不可达的块为NO_BLOCK
+        [[nodiscard]] IrBlockId idom(IrBlockId block) const noexcept { return idom_[block]; }
+        [[nodiscard]] const std::vector<IrBlockId> &children(IrBlockId block) const noexcept { return children_[block]; }
+        [[nodiscard]] const std::vector<IrBlockId> &reversePostorder() const noexcept { return rpo_; }
+
+        // a支配b(包括a == b)；任一不可达时为false
+        [[nodiscard]] bool dominates(IrBlockId a, IrBlockId b) const noexcept;
+
+    private:
+        [[nodiscard]] IrBlockId intersect(IrBlockId a, IrBlockId b) const noexcept;
+
+        std::vector<IrBlockId> rpo_;
+        std::vector<IrBlockId> order_; // 块在逆后序中的位置
+        std::vector<IrBlockId> idom_;
+        std::vector<std::vector<IrBlockId>> children_;
+        std::vector<uint32_t> enter_; // 支配树先序遍历的进入和离开序号
+        std::vector<uint32_t> leave_;
+    };
+
+    // 文本形式，每块前注明前驱和直接支配者
+    void print(const IrModule &module, std::ostream &out);
+
+} // namespace pl0
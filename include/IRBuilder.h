@@ -0,0 +1,78 @@
+#pragma once
+#include "ASTWalker.h"
+#include "IR.h"
+#include "SymbolTable.h"
+
+#include <vector>
+#include <unordered_map>
+
+namespace pl0
+{
+    // 把通过语义分析的AST降低为SSA形式的IR
+    //
+    // 按Braun等人的方法("Simple and Efficient Construction of Static Single Assignment Form")
+    // 在翻译的同时构造SSA: 每块记录各变量的当前定义，读不到时向前驱查找，必要时在块首放置phi；
+    // 前驱尚未全部确定的块(循环头)先放不完整的phi，封闭时再补齐操作数。
+    // 只有一个不同操作数的phi转发给该操作数，最后统一改写引用并删掉不被使用的phi。
+    // 哪些本层变量被嵌套过程访问由翻译前的CaptureAnalysis确定，这些变量和外层变量一样留在帧中
+    class IRBuilder : public ASTWalker<IRBuilder>
+    {
+    public:
+        [[nodiscard]] IrModule build(const Program &program);
+
+        void visit(const Program &node);
+        void visit(const Block &node);
+        void visit(const ConstDeclaration &node);
+        void visit(const VarDeclaration &node);
+        void visit(const ProcedureDeclaration &node);
+        void visit(const AssignStatement &node);
+        void visit(const CallStatement &node);
+        void visit(const BeginStatement &node);
+        void visit(const IfStatement &node);
+        void visit(const WhileStatement &node);
+
+    private:
+        // 正在构造的函数的SSA状态
+        struct FunctionState
+        {
+            size_t function = 0;
+            IrBlockId current = 0;
+            std::vector<bool> hidden;                 // 本层变量是否为优化生成的隐藏变量
+            std::unordered_map<uint64_t, IrValue> definitions; // (块, 变量) -> 当前定义
+            std::vector<bool> sealed;
+            std::unordered_map<IrBlockId, std::vector<std::pair<size_t, IrValue>>> incomplete;
+            std::vector<IrValue> forward; // 被删掉的平凡phi转发到的值，未转发的是自身
+        };
+
+        [[nodiscard]] IrFunction &function() noexcept { return module_.functions[state_.function]; }
+
+        IrValue lower(const Expression &expr);
+        IrValue append(IrInstruction inst);
+        IrBlockId newBlock();
+        void addEdge(IrBlockId from, IrBlockId to);
+        void jump(IrBlockId target);
+        void finish(); // 给当前函数补上ret并整理phi
+
+        void writeVariable(size_t variable, IrBlockId block, IrValue value);
+        IrValue readVariable(size_t variable, IrBlockId block);
+        IrValue readVariableRecursive(size_t variable, IrBlockId block);
+        IrValue newPhi(IrBlockId block);
+        IrValue addPhiOperands(size_t variable, IrValue phi);
+        IrValue tryRemoveTrivialPhi(IrValue phi);
+        IrValue initialValue();
+        void seal(IrBlockId block);
+        IrValue resolve(IrValue value);
+        void removeDeadPhis();
+
+        [[nodiscard]] const Symbol &lookup(SymbolId name) const;
+        [[nodiscard]] uint8_t levelDistance(const Symbol &symbol) const;
+
+        SymbolTable symbols_;
+        IrModule module_;
+        FunctionState state_;
+        std::unordered_map<const Block *, std::vector<bool>> captured_; // 块的变量是否被嵌套过程访问
+        size_t level_ = 0;
+        size_t var_count_ = 0;
+    };
+
+} // namespace pl0
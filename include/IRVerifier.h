@@ -0,0 +1,35 @@
+#pragma once
+#include "IR.h"
+
+#include <string>
+#include <vector>
+
+namespace pl0
+{
+    // 检查IR的结构和SSA性质，供构造和各个变换之后使用
+    //
+    // 块: 非空，恰好以一条终结指令结尾，phi只在开头；前驱表与终结指令的跳转目标一致，入口没有前驱，
+    // 所有块从入口可达。指令: 操作数个数符合操作码，引用的值已放在某块中且有结果，
+    // 定义支配每个使用(phi的操作数只需支配对应前驱的末尾)；load/store的变量、call的被调函数
+    // 在按层差沿静态外层找到的函数中存在
+    class IRVerifier
+    {
+    public:
+        [[nodiscard]] bool verify(const IrModule &module);
+        [[nodiscard]] const std::vector<std::string> &getErrors() const noexcept { return errors_; }
+
+    private:
+        // 结构正确时才检查支配关系
+        [[nodiscard]] bool verifyStructure(size_t function);
+        void verifyInstruction(size_t function, IrBlockId block, IrValue id);
+        void verifyDominance(size_t function);
+        // 从function沿静态外层走distance步到达的函数，超出主程序时为nullptr
+        [[nodiscard]] const IrFunction *ancestor(size_t function, size_t distance) const noexcept;
+
+        void addError(size_t function, std::string message);
+
+        const IrModule *module_ = nullptr;
+        std::vector<std::string> errors_;
+    };
+
+} // namespace pl0
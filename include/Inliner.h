@@ -0,0 +1,120 @@
+#pragma once
+#include "ASTTransformer.h"
+#include "SymbolTable.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+namespace pl0
+{
+    // 在AST上内联非递归的小过程，减少运行时创建的帧
+    //
+    // 先按调用语句建立调用图，处在环上的过程(包括直接递归)不内联。内联时用过程体替换调用语句:
+    // 被调过程的变量改为调用处所在块的隐藏变量，同一块内对同一过程的多次内联共用一组，非递归保证
+    // 它们的生存期不重叠；常量(包括外层的)替换为数值。过程体内其余的名字必须在调用处解析到同一个声明，
+    // 即同为变量且Symbol::level/index相同，或为同一个过程，否则不内联。
+    // 含嵌套过程的过程需要自己的帧供内层访问，也不内联。
+    // 变量的初值为0: 隐藏变量在宿主的帧中只清零一次，所以每次展开之前为可能先读后写的变量补一条"隐藏变量 := 0"
+    class Inliner : public ASTTransformer<Inliner>
+    {
+    public:
+        static constexpr size_t DEFAULT_BUDGET = 64; // 过程体(含其中可内联的调用)展开后的节点数上限
+
+        // 每个调用点的决定
+        struct Decision
+        {
+            std::string_view caller; // 调用语句所在的过程，主程序为空
+            std::string_view host;   // 代码最终所在的过程，与caller不同时调用语句来自被内联的过程体
+            std::string_view callee;
+            size_t line;
+            size_t column;
+            bool inlined;
+            std::string reason;
+        };
+
+        // 隐藏变量的名字驻留到symbols中
+        explicit Inliner(Interner &symbols, size_t budget = DEFAULT_BUDGET) : symbols_(symbols), budget_(budget) {}
+
+        [[nodiscard]] std::unique_ptr<Program> run(std::unique_ptr<Program> program);
+
+        [[nodiscard]] const std::vector<Decision> &decisions() const noexcept { return decisions_; }
+        [[nodiscard]] size_t inlinedCount() const noexcept;
+
+        // 形如"行3列5 主程序 -> multiply: 已内联 (节点数 31)"
+        [[nodiscard]] static std::string describe(const Decision &decision);
+
+        using ASTTransformer<Inliner>::transform;
+        [[nodiscard]] const Block *transform(const Block &node);
+        [[nodiscard]] const ProcedureDeclaration *transform(const ProcedureDeclaration &node);
+        [[nodiscard]] const Statement *transform(const AssignStatement &node);
+        [[nodiscard]] const Statement *transform(const CallStatement &node);
+        [[nodiscard]] const Expression *transform(const IdentifierExpression &node);
+
+    private:
+        // 调用图的结点，下标0为主程序
+        struct Procedure
+        {
+            const ProcedureDeclaration *decl = nullptr;
+            size_t level = 0;    // 过程体的嵌套层
+            size_t size = 0;     // 过程体语句的节点数
+            size_t expanded = 0; // 展开其中可内联的调用后的节点数，0为尚未计算
+            bool nested = false;
+            bool recursive = false;
+            std::vector<size_t> callees;                  // 每条调用语句一项
+            std::vector<bool> readsFirst;                 // 按变量序号: 可能在赋值之前被读取
+            std::unordered_map<SymbolId, Symbol> outside; // 体内引用的外层变量和过程
+            std::unordered_map<SymbolId, int64_t> constants; // 体内引用的外层常量的值
+        };
+
+        // 正在展开的过程体: 其变量对应的隐藏变量，自己的和外层的常量值
+        struct Expansion
+        {
+            size_t callee;
+            std::unordered_map<SymbolId, const VarDeclaration *> vars;
+            std::unordered_map<SymbolId, int64_t> consts;
+        };
+
+        // 正在变换的块所收集的隐藏变量，键为(过程, 变量序号)
+        struct Host
+        {
+            std::vector<const VarDeclaration *> hidden;
+            std::unordered_map<uint64_t, const VarDeclaration *> slots;
+            std::unordered_map<std::string, uint64_t> names;
+        };
+
+        void analyze(const Block &block, size_t id);
+        void analyze(const Statement &node, size_t id);
+        void analyze(const Expression &node, size_t id);
+        void reference(SymbolId name, size_t id);
+        [[nodiscard]] std::optional<size_t> local(SymbolId name, size_t id) const;
+        void markRecursive();
+        size_t expandedSize(size_t id);
+        [[nodiscard]] bool inlinable(size_t id);
+
+        // 返回不内联的原因
+        [[nodiscard]] std::optional<std::string> refuse(size_t callee);
+        [[nodiscard]] Expansion expand(size_t callee);
+        [[nodiscard]] const VarDeclaration *hiddenVariable(size_t callee, size_t index, const VarDeclaration &origin);
+        [[nodiscard]] std::string_view procedureName(size_t id) const noexcept;
+
+        Interner &symbols_;
+        size_t budget_;
+
+        std::vector<Procedure> procedures_;
+        std::vector<bool> assigned_; // 分析过程体时，按变量序号: 在当前位置之前一定已赋值
+        std::unordered_map<const ProcedureDeclaration *, size_t> ids_;
+
+        // 分析与变换时的作用域，过程符号的value为其在procedures_中的下标
+        SymbolTable scope_;
+        size_t level_ = 0;
+        size_t procedure_ = 0;
+        std::vector<Host> hosts_;
+        std::vector<Expansion> expansions_;
+        std::vector<Decision> decisions_;
+    };
+
+} // namespace pl0
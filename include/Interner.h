@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace pl0
+{
+    // 标识符的稠密编号，从0开始连续分配
+    using SymbolId = uint32_t;
+    inline constexpr SymbolId INVALID_SYMBOL = UINT32_MAX;
+
+    // 标识符驻留表：每个不同的拼写对应一个稠密的SymbolId
+    // 拼写被复制到内部的分块存储中，不依赖源码缓冲区的生命周期
+    // 实例本身不加锁；Compiler为每次编译创建独立的实例(Result::symbols)，
+    // 因此SymbolId只在同一次编译内有意义，多个编译可在不同线程上并行
+    // 拼写存放在堆上的分块中，移动实例不会使已返回的string_view失效
+    // 查找用开放寻址的线性探测表，槽中缓存哈希值，绝大多数探测不需要比较拼写
+    class Interner
+    {
+    public:
+        Interner() = default;
+        Interner(Interner &&) noexcept = default;
+        Interner &operator=(Interner &&) noexcept = default;
+        Interner(const Interner &) = delete;
+        Interner &operator=(const Interner &) = delete;
+
+        [[nodiscard]] SymbolId intern(std::string_view spelling);
+        [[nodiscard]] std::optional<SymbolId> find(std::string_view spelling) const;
+        [[nodiscard]] std::string_view spelling(SymbolId id) const noexcept { return spellings_[id]; }
+        [[nodiscard]] size_t size() const noexcept { return spellings_.size(); }
+
+    private:
+        struct Slot
+        {
+            uint32_t hash = 0;
+            SymbolId id = INVALID_SYMBOL;
+        };
+
+        [[nodiscard]] static uint32_t hash(std::string_view spelling) noexcept;
+        // 拼写所在槽的下标，不存在时为应插入的空槽
+        [[nodiscard]] size_t probe(std::string_view spelling, uint32_t hash) const noexcept;
+        void grow();
+        std::string_view store(std::string_view spelling);
+
+        static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+        std::vector<std::unique_ptr<char[]>> chunks_;
+        char *chunk_ = nullptr;
+        size_t chunk_used_ = 0;
+        std::vector<std::string_view> spellings_;
+        std::vector<Slot> slots_; // 大小为2的幂，装载率不超过1/2
+    };
+
+} // namespace pl0
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "VM.h"
+#include "JitCompiler.h"
+
+#include <string>
+
+namespace pl0
+{
+    // 载入可执行内存的本地代码及其独立的调用栈
+    // 机器码先拷入mmap得到的可写内存，再改为只读可执行(W^X)；调用栈大小随数据栈按比例分配，
+    // 深递归不会耗尽宿主线程的栈
+    class NativeImage
+    {
+    public:
+        NativeImage(const NativeCode &code, size_t stack_size);
+        ~NativeImage();
+
+        NativeImage(const NativeImage &) = delete;
+        NativeImage &operator=(const NativeImage &) = delete;
+
+        // 载入失败时为空，error()给出原因
+        [[nodiscard]] bool valid() const noexcept { return error_.empty(); }
+        [[nodiscard]] const std::string &error() const noexcept { return error_; }
+
+        // 以stack为数据栈(stack_size个槽位)从主程序开始执行，返回NativeCode::Status
+        int64_t run(int64_t *stack) const;
+        // 以frame为当前帧从target偏移处执行到该过程返回，返回NativeCode::Status
+        int64_t enter(int64_t *stack, int64_t *frame, size_t target) const;
+
+        // 状态码对应的运行时错误信息，与虚拟机的措辞相同
+        [[nodiscard]] static const char *message(int64_t status) noexcept;
+
+    private:
+        [[nodiscard]] NativeContext context(int64_t *stack) const noexcept;
+
+        const NativeCode &code_;
+        size_t stack_size_;
+        uint8_t *text_ = nullptr;
+        size_t text_size_ = 0;
+        uint8_t *native_stack_ = nullptr;
+        size_t native_stack_size_ = 0;
+        std::string error_;
+    };
+
+    // 执行JitCompiler生成的本地代码
+    class Jit
+    {
+    public:
+        explicit Jit(const NativeCode &code, size_t stack_size = VM::DEFAULT_STACK_SIZE)
+            : code_(code), stack_size_(stack_size) {}
+
+        [[nodiscard]] ExecutionResult run();
+
+    private:
+        const NativeCode &code_;
+        size_t stack_size_;
+    };
+
+} // namespace pl0
@@ -0,0 +1,147 @@
+#pragma once
+#include "ASTWalker.h"
+#include "SymbolTable.h"
+#include "X86Assembler.h"
+
+#include <array>
+#include <utility>
+#include <vector>
+#include <string_view>
+
+namespace pl0
+{
+    // 本地代码的运行时上下文，生成的代码通过r15按固定偏移访问
+    struct NativeContext
+    {
+        int64_t *stack_base;  // 数据栈(帧布局与虚拟机相同)
+        int64_t *stack_limit; // 帧不得越过的地址
+        void *saved_rsp;      // 入口处的宿主栈指针，出错时据此直接返回
+        void *native_stack;   // 本地代码使用的调用栈栈顶
+    };
+
+    // 与加载地址无关的机器码
+    // 入口遵循System V调用约定: int64_t entry(NativeContext *)，返回NativeCode::Status；
+    // 分层执行的入口int64_t enter(NativeContext *, int64_t *frame, const void *target)以frame为当前帧
+    // 从target(过程入口或循环的OSR入口)开始执行，该过程返回时结束
+    struct NativeCode
+    {
+        enum Status : int64_t
+        {
+            Ok = 0,
+            DivisionByZero = 1,
+            NegativeExponent = 2,
+            StackOverflow = 3
+        };
+
+        std::vector<uint8_t> bytes;
+        size_t entry = 0;
+        size_t enter = 0;
+        std::vector<std::string_view> globals; // 主程序变量，依次位于主帧FRAME_HEADER之后
+        // 以下按AST先序排列(嵌套过程先于所在块的语句)，与PCode::procedures[1..]和PCode::loops一一对应
+        std::vector<size_t> procedures; // 过程入口的偏移
+        std::vector<size_t> loops;      // while循环的OSR入口偏移: 从帧中重新载入常驻寄存器后跳到条件判断
+
+        [[nodiscard]] bool empty() const noexcept { return bytes.empty(); }
+    };
+
+    // 把通过语义分析的AST直接翻译为x86-64机器码，每个过程和主程序块各生成一个本地函数
+    //
+    // 帧布局与虚拟机一致: [SL, DL, RA, 变量...]，SL/DL是数据栈下标；rbx指向当前帧，
+    // r14为数据栈基址，r15为NativeContext。外层变量沿静态链访问，使用频繁的外层帧地址
+    // 在过程入口求出并常驻寄存器(display)。没有嵌套过程的块，其变量不会被别的过程访问，
+    // 使用最频繁的几个直接分配到寄存器中。表达式的中间结果使用调用者保存的寄存器，语句之间不存活。
+    // 过程体尾位置上的调用(被调用者的静态链不是当前帧时)复用当前帧并以jmp转入，不再增长两个栈
+    class JitCompiler : public ASTWalker<JitCompiler>
+    {
+    public:
+        [[nodiscard]] NativeCode compile(const Program &program);
+
+        void visit(const Program &node);
+        void visit(const Block &node);
+        void visit(const ConstDeclaration &node);
+        void visit(const VarDeclaration &node);
+        void visit(const ProcedureDeclaration &node);
+        void visit(const AssignStatement &node);
+        void visit(const CallStatement &node);
+        void visit(const BeginStatement &node);
+        void visit(const IfStatement &node);
+        void visit(const WhileStatement &node);
+
+    private:
+        static constexpr size_t TEMP_COUNT = 6;
+        static constexpr size_t HOME_COUNT = 3;
+
+        // 表达式的右操作数: 立即数、寄存器或内存
+        struct Operand
+        {
+            enum class Kind
+            {
+                Imm,
+                Reg,
+                Mem
+            } kind;
+            int64_t imm = 0;
+            x86::Reg reg = x86::Reg::RAX;
+            x86::Mem mem{x86::Reg::RAX};
+            bool owned = false; // reg是需要释放的临时寄存器
+        };
+
+        // 当前块的寄存器分配
+        struct Frame
+        {
+            size_t var_count = 0;
+            size_t size = 0;
+            std::vector<int> var_homes;   // 变量下标 -> 常驻寄存器在HOMES中的下标，-1表示在内存中
+            std::vector<int> display;     // 层差 -> 常驻寄存器在HOMES中的下标
+            std::vector<uint64_t> var_uses;
+            std::vector<uint64_t> display_uses;
+            size_t homes_used = 0;
+            std::vector<std::pair<x86::Label, x86::Label>> osr; // 本块循环的(OSR入口, 条件判断)
+            bool tail = false;                                  // 正在生成的语句处在过程体的尾位置
+        };
+
+        void countUses(const Statement &stmt, uint64_t weight);
+        void countUses(const Expression &expr, uint64_t weight);
+        void assignHomes(bool locals_allowed);
+        // 过程入口和OSR入口共用: 保存用到的常驻寄存器并求出display
+        void saveHomes();
+        void loadDisplay();
+
+        // 计算表达式，结果放在新分配的临时寄存器中
+        x86::Reg evaluate(const Expression &expr);
+        x86::Reg evaluateBinary(const BinaryExpression &expr);
+        // 叶子表达式(常数、变量)不经临时寄存器，直接作为操作数
+        [[nodiscard]] bool isLeaf(const Expression &expr) const;
+        Operand leaf(const Expression &expr);
+        Operand rightOperand(const Expression &expr, x86::Reg &left);
+        void apply(BinaryExpression::Op op, x86::Reg dst, const Operand &right);
+        void compare(x86::Reg left, const Operand &right);
+        // 条件的真假等于when时跳转到target
+        void branch(const Expression &cond, bool when, x86::Label target);
+
+        [[nodiscard]] x86::Mem variable(const Symbol &symbol);
+        void loadFrameIndex(x86::Reg dst, size_t distance);
+        void release(const Operand &operand);
+
+        x86::Reg allocate();
+        void free(x86::Reg reg);
+
+        [[nodiscard]] const Symbol &resolve(SymbolId name) const;
+        [[nodiscard]] size_t distance(const Symbol &symbol) const noexcept { return level_ - symbol.level; }
+        [[nodiscard]] static int32_t slotOffset(size_t slot);
+
+        SymbolTable symbols_;
+        x86::Assembler as_;
+        NativeCode code_;
+        std::vector<x86::Label> procedures_; // Symbol::value为此处的下标
+        std::vector<x86::Label> loops_;      // 各循环的OSR入口
+        Frame frame_;
+        size_t level_ = 0;
+        x86::Label pending_entry_{}; // 下一个块的入口标签
+        std::array<bool, TEMP_COUNT> temp_busy_{};
+        x86::Label div_zero_{};
+        x86::Label negative_exponent_{};
+        x86::Label stack_overflow_{};
+    };
+
+} // namespace pl0
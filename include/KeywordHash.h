@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <optional>
+#include <string_view>
+
+namespace pl0
+{
+    // 编译期生成的关键字完美哈希
+    // 哈希函数以(长度, 首字符, 尾字符)为键: (first * seed + last + length) mod TableSize
+    // 构造时在编译期搜索一个不产生冲突的seed，找不到时seed为0
+    template <typename Value, size_t N, size_t TableSize>
+    class KeywordHash
+    {
+        static_assert((TableSize & (TableSize - 1)) == 0, "TableSize必须是2的幂");
+        static_assert(TableSize >= N, "TableSize不能小于关键字数量");
+
+    public:
+        using Entries = std::array<std::pair<const char *, Value>, N>;
+
+        constexpr explicit KeywordHash(const Entries &entries) noexcept
+        {
+            for (const auto &[key, value] : entries)
+            {
+                std::string_view k{key};
+                min_length_ = std::min(min_length_, k.size());
+                max_length_ = std::max(max_length_, k.size());
+            }
+
+            seed_ = findSeed(entries);
+            if (seed_ == 0)
+            {
+                return;
+            }
+
+            for (const auto &[key, value] : entries)
+            {
+                std::string_view k{key};
+                slots_[hash(k, seed_)] = Slot{k, value};
+            }
+        }
+
+        [[nodiscard]] constexpr bool collisionFree() const noexcept { return seed_ != 0; }
+        [[nodiscard]] constexpr uint32_t seed() const noexcept { return seed_; }
+
+        // 一次查表 + 一次比较
+        [[nodiscard]] constexpr std::optional<Value> find(std::string_view word) const noexcept
+        {
+            if (word.size() < min_length_ || word.size() > max_length_)
+            {
+                return std::nullopt;
+            }
+            const Slot &slot = slots_[hash(word, seed_)];
+            if (slot.key == word)
+            {
+                return slot.value;
+            }
+            return std::nullopt;
+        }
+
+    private:
+        struct Slot
+        {
+            std::string_view key;
+            Value value{};
+        };
+
+        [[nodiscard]] static constexpr size_t hash(std::string_view word, uint32_t seed) noexcept
+        {
+            auto first = static_cast<unsigned char>(word.front());
+            auto last = static_cast<unsigned char>(word.back());
+            return (first * seed + last + word.size()) & (TableSize - 1);
+        }
+
+        [[nodiscard]] static constexpr uint32_t findSeed(const Entries &entries) noexcept
+        {
+            for (uint32_t seed = 1; seed < 1024; ++seed)
+            {
+                std::array<bool, TableSize> used{};
+                bool ok = true;
+                for (const auto &[key, value] : entries)
+                {
+                    size_t h = hash(std::string_view{key}, seed);
+                    if (used[h])
+                    {
+                        ok = false;
+                        break;
+                    }
+                    used[h] = true;
+                }
+                if (ok)
+                {
+                    return seed;
+                }
+            }
+            return 0;
+        }
+
+        std::array<Slot, TableSize> slots_{};
+        uint32_t seed_ = 0;
+        size_t min_length_ = SIZE_MAX;
+        size_t max_length_ = 0;
+    };
+
+    template <size_t TableSize, typename Value, size_t N>
+    [[nodiscard]] constexpr auto makeKeywordHash(const std::array<std::pair<const char *, Value>, N> &entries) noexcept
+    {
+        return KeywordHash<Value, N, TableSize>{entries};
+    }
+
+} // namespace pl0
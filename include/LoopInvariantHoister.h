@@ -0,0 +1,110 @@
+#pragma once
+#include "ASTTransformer.h"
+#include "SymbolTable.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace pl0
+{
+    // 把while循环中不变的计算移到循环之前
+    //
+    // 结构化的while就是自然循环: 条件是唯一的入口(循环头)，循环之前的位置就是前置块。
+    // 循环修改的变量包括循环内直接赋值的变量，以及调用的过程(沿调用图传递)赋值的外层变量；
+    // 过程自己的变量在每次调用时是新的帧，不算调用者看到的修改。
+    // 只读常量和未被修改的变量的算术表达式在每次迭代中的值相同，取其中最大的子表达式，
+    // 在循环之前赋给块的隐藏变量，循环中改读隐藏变量；同一循环中相同的表达式共用一个。
+    // 循环可能一次也不执行，提前求值不能引入原来没有的错误，所以除数、指数不是合法的常量时不外提。
+    // 常量表达式留给常量折叠。内层循环先处理，它的前置块成为外层循环体的一部分，可以继续外提
+    class LoopInvariantHoister : public ASTTransformer<LoopInvariantHoister>
+    {
+    public:
+        // 每个分析过的循环一项(没有外提的也列出)，内层循环在外层之前
+        struct Report
+        {
+            std::string_view procedure; // 主程序为空
+            size_t line;
+            size_t column;
+            size_t hoisted;
+        };
+
+        // 隐藏变量的名字驻留到symbols中
+        explicit LoopInvariantHoister(Interner &symbols) : symbols_(symbols) {}
+
+        [[nodiscard]] std::unique_ptr<Program> run(std::unique_ptr<Program> program);
+
+        [[nodiscard]] const std::vector<Report> &reports() const noexcept { return reports_; }
+
+        // 形如"行24列3 过程divide: 外提 2 个不变表达式"
+        [[nodiscard]] static std::string describe(const Report &report);
+
+        using ASTTransformer<LoopInvariantHoister>::transform;
+        [[nodiscard]] const Block *transform(const Block &node);
+        [[nodiscard]] const ProcedureDeclaration *transform(const ProcedureDeclaration &node);
+        [[nodiscard]] const Statement *transform(const WhileStatement &node);
+
+    private:
+        // 调用图的结点，下标0为主程序
+        struct Procedure
+        {
+            const ProcedureDeclaration *decl = nullptr;
+            size_t firstVariable = 0; // 自己的变量的编号为[firstVariable, firstVariable + variableCount)
+            size_t variableCount = 0;
+            std::vector<size_t> writes; // 过程体直接赋值的变量
+            std::vector<size_t> callees;
+            std::vector<size_t> effects; // 调用它会修改的调用者可见的变量，有序
+        };
+
+        // 表达式自底向上的性质
+        struct Fact
+        {
+            const Expression *expr;
+            bool invariant;
+            bool trapFree;
+            std::optional<int64_t> value;
+        };
+
+        // 正在处理的循环
+        struct Loop
+        {
+            const WhileStatement *origin; // 外提的赋值和隐藏变量沿用它的位置
+            std::unordered_set<size_t> modified;
+            std::unordered_map<std::string, const VarDeclaration *> temporaries; // 键为表达式的结构
+            std::vector<const Statement *> preheader;
+        };
+
+        void declare(const Block &block);
+        void analyze(const Block &block, size_t id);
+        void analyze(const Statement &node, size_t id);
+        void summarize();
+
+        void modified(const Statement &node, Loop &loop) const;
+        [[nodiscard]] const Statement *hoist(const Statement &node, Loop &loop);
+        [[nodiscard]] const Expression *hoist(const Expression &expr, Loop &loop);
+        [[nodiscard]] Fact inspect(const Expression &expr, Loop &loop);
+        [[nodiscard]] const Expression *materialize(const Fact &fact, Loop &loop);
+        [[nodiscard]] const VarDeclaration *temporary(const Expression &expr, Loop &loop);
+        [[nodiscard]] static std::string key(const Expression &expr);
+        [[nodiscard]] std::string_view procedureName() const noexcept;
+
+        Interner &symbols_;
+
+        std::vector<Procedure> procedures_;
+        std::unordered_map<const ProcedureDeclaration *, size_t> ids_;
+        std::unordered_map<const VarDeclaration *, size_t> variables_; // 变量的全局编号
+        size_t variableCount_ = 0;
+
+        // 分析与变换时的作用域，变量和过程符号的value为其全局编号
+        SymbolTable scope_;
+        size_t procedure_ = 0;
+        std::vector<std::vector<const VarDeclaration *>> hidden_; // 正在变换的各块新增的隐藏变量
+        size_t temporaryCount_ = 0;
+        std::vector<Report> reports_;
+    };
+
+} // namespace pl0
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "PCode.h"
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <unordered_map>
+
+namespace pl0
+{
+    // 操作码序列(n元组)的动态频度，用于挑选超级指令
+    //
+    // 虚拟机在剖析模式下只统计每条指令的执行次数。基本块内的指令顺序连续执行，从地址a开始、
+    // 不越过块尾的序列恰好执行了counts[a]次，因此按块切分后即可由逐条计数得到各长度序列的频度。
+    // 序列以空格分隔的原语名表示，OPR记为子操作名，例如"LOD LIT ADD STO"
+    class OpcodeProfile
+    {
+    public:
+        static constexpr size_t MAX_LENGTH = 4;
+
+        // 累加一个程序的剖析结果，counts为虚拟机按地址统计的执行次数
+        void record(std::span<const Instruction> code, std::span<const uint64_t> counts);
+
+        // 按次数降序输出"次数 序列"，每行一个；#开头的行为注释
+        void write(std::ostream &out) const;
+
+        [[nodiscard]] uint64_t instructions() const noexcept { return instructions_; }
+        [[nodiscard]] size_t programs() const noexcept { return programs_; }
+        [[nodiscard]] const std::unordered_map<std::string, uint64_t> &sequences() const noexcept
+        {
+            return sequences_;
+        }
+
+        // 原语名: OPR为子操作名，其余为操作码名
+        [[nodiscard]] static std::string_view primitiveName(const Instruction &inst) noexcept;
+
+    private:
+        std::unordered_map<std::string, uint64_t> sequences_;
+        uint64_t instructions_ = 0;
+        size_t programs_ = 0;
+    };
+
+} // namespace pl0
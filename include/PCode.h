@@ -0,0 +1,108 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+#include <optional>
+#include <string_view>
+
+namespace pl0
+{
+    // 经典PL/0 p-code指令
+    enum class OpCode : uint8_t
+    {
+        LIT, // 常数a入栈
+        OPR, // 运算，a为Opr
+        LOD, // 层差level、偏移a的变量入栈
+        STO, // 栈顶存入层差level、偏移a的变量
+        CAL, // 调用层差level、地址a的过程
+        INT, // 栈顶指针增加a
+        JMP, // 无条件跳转到a
+        JPC  // 栈顶为0时跳转到a
+    };
+
+    // OPR的子操作，编号沿用Wirth的PL/0，14以后为扩展
+    enum class Opr : uint8_t
+    {
+        RET = 0,
+        NEG = 1,
+        ADD = 2,
+        SUB = 3,
+        MUL = 4,
+        DIV = 5,
+        ODD = 6,
+        EQ = 8,
+        NEQ = 9,
+        LT = 10,
+        GTE = 11,
+        GT = 12,
+        LTE = 13,
+        POW = 14,
+        NOT = 15,
+        SHL = 16 // 次栈顶乘以2的栈顶次幂，由乘方的强度削弱生成
+    };
+
+    struct Instruction
+    {
+        OpCode op;
+        uint8_t level;
+        int64_t argument;
+    };
+
+    // 栈帧布局: [静态链SL, 动态链DL, 返回地址RA, 变量...]
+    // SL/DL保存的是帧基址在栈中的下标，变量偏移从FRAME_HEADER开始
+    inline constexpr int64_t FRAME_HEADER = 3;
+
+    // 过程表项，主程序为第0项(名字为空)
+    struct ProcedureInfo
+    {
+        std::string_view name;
+        uint32_t entry;     // CAL的目标地址
+        uint32_t level;     // 过程体的嵌套层，主程序为0
+        int64_t frame_size; // 过程体INT的参数: 帧头加变量数
+    };
+
+    struct ConstantInfo
+    {
+        std::string_view name;
+        int64_t value;
+    };
+
+    // 源码位置表项: 从address开始的指令属于line行column列的语句(过程序言的INT对应过程声明)，按address递增
+    struct SourceLine
+    {
+        uint32_t address;
+        uint32_t line;
+        uint32_t column;
+    };
+
+    // 一个程序的p-code，从code[0]开始执行主程序
+    struct PCode
+    {
+        std::vector<Instruction> code;
+        // 主程序变量名，按栈帧中的偏移排列，用于运行结束后输出
+        std::vector<std::string_view> globals;
+        // 以下为调试信息，执行时不使用
+        std::vector<ProcedureInfo> procedures;
+        std::vector<ConstantInfo> constants; // 按声明顺序的具名常量
+        std::vector<SourceLine> positions;
+        std::vector<uint32_t> loops; // while循环头(条件判断)的地址，按AST先序
+
+        [[nodiscard]] bool empty() const noexcept { return code.empty(); }
+    };
+
+    [[nodiscard]] std::string_view opcodeName(OpCode op) noexcept;
+    [[nodiscard]] std::string_view oprName(Opr opr) noexcept;
+
+    // 地址所属语句的源码位置，位置表为空或地址在第一项之前时返回std::nullopt
+    [[nodiscard]] std::optional<SourceLine> locate(std::span<const SourceLine> positions, size_t address) noexcept;
+
+    // 基本块的首条指令: 跳转和调用的目标，以及跳转、调用、返回之后的指令
+    // 块内的指令总是顺序连续执行，超级指令和序列剖析都不跨越块的边界
+    [[nodiscard]] std::vector<bool> blockLeaders(std::span<const Instruction> code);
+
+    // 输出带地址的指令清单
+    void disassemble(const PCode &program, std::ostream &out);
+
+} // namespace pl0
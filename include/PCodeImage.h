@@ -0,0 +1,73 @@
+#pragma once
+
+#include "PCode.h"
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <filesystem>
+#include <string_view>
+
+namespace pl0
+{
+    // 预编译的p-code文件(.pl0c)
+    //
+    // 文件为小端的定长文件头加若干8字节对齐的段: 指令、过程表、具名常量、源码位置表、
+    // 主程序变量名和字符串池。指令段与内存中的Instruction布局相同，载入时只mmap文件，
+    // 校验文件头和内容的校验和并检查指令不会越界访问，虚拟机直接在映射上执行，不做反序列化。
+    // 文件头记录源文件的大小、修改时间和内容哈希，用于判断文件是否过期
+    class PCodeImage
+    {
+    public:
+        static constexpr uint32_t VERSION = 1;
+
+        // 生成时源文件的标识
+        struct SourceStamp
+        {
+            uint64_t size = 0;
+            int64_t mtime = 0; // 修改时间，纳秒
+            uint64_t hash = 0; // 源码内容的哈希
+        };
+
+        PCodeImage() noexcept = default;
+        ~PCodeImage();
+
+        PCodeImage(PCodeImage &&other) noexcept;
+        PCodeImage &operator=(PCodeImage &&other) noexcept;
+        PCodeImage(const PCodeImage &) = delete;
+        PCodeImage &operator=(const PCodeImage &) = delete;
+
+        // 读取源文件的大小和修改时间，text为源码内容；文件不存在时抛出std::filesystem_error
+        [[nodiscard]] static SourceStamp stamp(const std::filesystem::path &source, std::string_view text);
+
+        // 先写临时文件再改名，读者不会看到写了一半的文件；失败时抛出std::runtime_error
+        static void write(const PCode &code, const SourceStamp &source, const std::filesystem::path &path);
+
+        // 映射并校验文件，失败时返回std::nullopt并在error中给出原因
+        [[nodiscard]] static std::optional<PCodeImage> open(const std::filesystem::path &path, std::string &error);
+
+        // 大小和修改时间都相同即认为与源文件一致，只有修改时间不同时才读取源码比较哈希
+        [[nodiscard]] bool matches(const std::filesystem::path &source) const;
+
+        [[nodiscard]] std::span<const Instruction> code() const noexcept;
+        [[nodiscard]] std::span<const SourceLine> positions() const noexcept;
+        [[nodiscard]] size_t globalCount() const noexcept;
+
+        // 以下按需从文件内容构造，string_view指向映射的字符串池
+        [[nodiscard]] std::vector<std::string_view> globals() const;
+        [[nodiscard]] std::vector<ProcedureInfo> procedures() const;
+        [[nodiscard]] std::vector<ConstantInfo> constants() const;
+
+        [[nodiscard]] size_t size() const noexcept { return size_; }
+
+    private:
+        void release() noexcept;
+        [[nodiscard]] std::string_view string(uint32_t offset, uint32_t length) const noexcept;
+
+        const unsigned char *data_ = nullptr;
+        size_t size_ = 0;
+    };
+
+} // namespace pl0
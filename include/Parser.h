@@ -1,8 +1,9 @@
 #pragma once
 
 #include "AST.h"
-#include "TokenInterpreter.h"
+#include "TokenStream.h"
 
+#include <span>
 #include <memory>
 #include <vector>
 #include <string>
@@ -23,8 +24,8 @@ namespace pl0
     class Parser
     {
     public:
-        explicit Parser(TokenInterpreter lexer) noexcept
-            : lexer_(std::move(lexer)) {}
+        explicit Parser(const TokenBuffer &tokens) noexcept
+            : tokens_(tokens) {}
 
         // 主解析入口
         [[nodiscard]] std::unique_ptr<Program> parse();
@@ -36,33 +37,42 @@ namespace pl0
     private:
         // 递归下降解析方法
         [[nodiscard]] std::unique_ptr<Program> parseProgram();
-        [[nodiscard]] std::unique_ptr<Block> parseBlock();
-        [[nodiscard]] std::vector<std::unique_ptr<ConstDeclaration>> parseConstDeclarations();
-        [[nodiscard]] std::vector<std::unique_ptr<VarDeclaration>> parseVarDeclarations();
-        [[nodiscard]] std::vector<std::unique_ptr<ProcedureDeclaration>> parseProcedures();
+        [[nodiscard]] const Block *parseBlock();
+        [[nodiscard]] std::span<const ConstDeclaration *const> parseConstDeclarations();
+        [[nodiscard]] std::span<const VarDeclaration *const> parseVarDeclarations();
+        [[nodiscard]] std::span<const ProcedureDeclaration *const> parseProcedures();
 
         // 语句解析
-        [[nodiscard]] std::unique_ptr<Statement> parseStatement();
-        [[nodiscard]] std::unique_ptr<Statement> parseAssignStatement();
-        [[nodiscard]] std::unique_ptr<Statement> parseCallStatement();
-        [[nodiscard]] std::unique_ptr<Statement> parseBeginStatement();
-        [[nodiscard]] std::unique_ptr<Statement> parseIfStatement();
-        [[nodiscard]] std::unique_ptr<Statement> parseWhileStatement();
+        [[nodiscard]] const Statement *parseStatement();
+        [[nodiscard]] const Statement *parseAssignStatement();
+        [[nodiscard]] const Statement *parseCallStatement();
+        [[nodiscard]] const Statement *parseBeginStatement();
+        [[nodiscard]] const Statement *parseIfStatement();
+        [[nodiscard]] const Statement *parseWhileStatement();
 
         // 表达式解析
-        [[nodiscard]] std::unique_ptr<Expression> parseExpression();
-        [[nodiscard]] std::unique_ptr<Expression> parseTerm();
-        [[nodiscard]] std::unique_ptr<Expression> parsePower();
-        [[nodiscard]] std::unique_ptr<Expression> parseFactor();
-        [[nodiscard]] std::unique_ptr<Expression> parseCondition();
-        [[nodiscard]] std::unique_ptr<Expression> parseComparison();
+        [[nodiscard]] const Expression *parseExpression();
+        [[nodiscard]] const Expression *parseTerm();
+        [[nodiscard]] const Expression *parsePower();
+        [[nodiscard]] const Expression *parseFactor();
+        [[nodiscard]] const Expression *parseCondition();
+        [[nodiscard]] const Expression *parseComparison();
 
         // 辅助方法
-        [[nodiscard]] Token peek() noexcept { return lexer_.peekToken(); }
-        [[nodiscard]] Token advance() noexcept { return lexer_.nextToken(); }
+        // 空语句(parseStatement返回nullptr)统一表示为空的BeginStatement
+        [[nodiscard]] const Statement *orEmpty(const Statement *statement);
+        [[nodiscard]] Token peek() const noexcept { return tokens_.peek(); }
+        [[nodiscard]] Token advance() noexcept { return tokens_.advance(); }
         [[nodiscard]] bool match(TokenType type) noexcept;
-        [[nodiscard]] bool check(TokenType type) noexcept;
+        [[nodiscard]] bool check(TokenType type) const noexcept;
         [[nodiscard]] Token consume(TokenType type, const std::string &message);
+        struct Identifier
+        {
+            std::string_view name;
+            SymbolId symbol;
+        };
+        [[nodiscard]] Identifier consumeIdentifier(const std::string &message);
+        [[nodiscard]] int64_t consumeNumber(const std::string &message);
         void synchronize();
 
         // 错误处理
@@ -74,13 +84,25 @@ namespace pl0
         }
 
         // 位置信息
-        [[nodiscard]] size_t currentLine() const noexcept { return lexer_.line(); }
-        [[nodiscard]] size_t currentColumn() const noexcept { return lexer_.column(); }
+        [[nodiscard]] size_t currentLine() const noexcept { return tokens_.position().line; }
+        [[nodiscard]] size_t currentColumn() const noexcept { return tokens_.position().column; }
+        // 当前Token的位置；语句按源码顺序解析，从上次的位置继续数换行，整体为线性
+        [[nodiscard]] SourcePosition locate() noexcept;
+        template <typename T>
+        [[nodiscard]] T *positioned(T *node, SourcePosition position) noexcept
+        {
+            node->setPosition(position.line, position.column);
+            return node;
+        }
 
         // 成员变量
-        TokenInterpreter lexer_;
+        TokenStream tokens_;
+        AstArena arena_;
         std::vector<std::string> errors_;
         bool had_error_ = false;
+        size_t located_offset_ = 0;
+        size_t located_line_ = 1;
+        size_t line_start_ = 0; // located_line_行首的偏移
 
         // 添加这个辅助方法的声明
         [[nodiscard]] BinaryExpression::Op tokenTypeToBinaryOp(TokenType type) const;
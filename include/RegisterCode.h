@@ -0,0 +1,86 @@
+#pragma once
+
+#include "PCode.h"
+
+#include <vector>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+namespace pl0
+{
+    // 三地址寄存器字节码
+    // 每个过程的栈帧就是它的寄存器文件: [SL, DL, RA, 变量..., 临时量...]，
+    // 寄存器编号即帧内偏移，本层变量直接作为寄存器参与运算，外层变量通过静态链读写
+    enum class RegOp : uint8_t
+    {
+        LoadK,    // dst = imm
+        Move,     // dst = a
+        GetOuter, // dst = 外层level帧的寄存器a
+        SetOuter, // 外层level帧的寄存器dst = a
+
+        // dst = a op b
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Pow,
+        Shl, // a * 2^b，由乘方的强度削弱生成
+        Eq,
+        Neq,
+        Lt,
+        Lte,
+        Gt,
+        Gte,
+
+        // dst = a op imm
+        AddK,
+        SubK,
+        MulK,
+        DivK,
+        PowK,
+        ShlK,
+        EqK,
+        NeqK,
+        LtK,
+        LteK,
+        GtK,
+        GteK,
+
+        // dst = op a
+        Neg,
+        Not,
+        Odd,
+
+        Jump,          // 跳转到imm
+        JumpIfZero,    // a为0时跳转到imm
+        JumpIfNotZero, // a非0时跳转到imm，用于循环条件后置
+        Call,          // 调用层差level、入口imm的过程
+        Enter,         // 分配imm个槽位的帧(含帧头)，其中帧头和变量占a个
+        Return         // a与对应的Enter相同
+    };
+
+    // 寄存器编号为16位，单个过程最多65535个槽位
+    struct RegInstruction
+    {
+        RegOp op;
+        uint8_t level;
+        uint16_t dst;
+        uint16_t a;
+        uint16_t b;
+        int64_t imm;
+    };
+
+    struct RegisterProgram
+    {
+        std::vector<RegInstruction> code;
+        std::vector<std::string_view> globals; // 主程序变量名，寄存器依次为FRAME_HEADER起
+
+        [[nodiscard]] bool empty() const noexcept { return code.empty(); }
+    };
+
+    [[nodiscard]] std::string_view regOpName(RegOp op) noexcept;
+
+    void disassemble(const RegisterProgram &program, std::ostream &out);
+
+} // namespace pl0
@@ -0,0 +1,63 @@
+#pragma once
+#include "ASTWalker.h"
+#include "RegisterCode.h"
+#include "SymbolTable.h"
+
+#include <optional>
+
+namespace pl0
+{
+    // 把通过语义分析的AST翻译为三地址寄存器字节码
+    // 本层变量就是寄存器；表达式的中间结果分配在变量之后的临时寄存器中，每条语句结束后全部释放；
+    // 常数作为右操作数时直接编进指令(K形式)，while循环的条件放在循环体之后
+    class RegisterGenerator : public ASTWalker<RegisterGenerator>
+    {
+    public:
+        [[nodiscard]] RegisterProgram generate(const Program &program);
+
+        void visit(const Program &node);
+        void visit(const Block &node);
+        void visit(const ConstDeclaration &node);
+        void visit(const VarDeclaration &node);
+        void visit(const ProcedureDeclaration &node);
+        void visit(const AssignStatement &node);
+        void visit(const CallStatement &node);
+        void visit(const BeginStatement &node);
+        void visit(const IfStatement &node);
+        void visit(const WhileStatement &node);
+
+    private:
+        // 表达式的值：常数或某个寄存器
+        struct Operand
+        {
+            bool constant;
+            int64_t value;
+            uint16_t reg;
+        };
+
+        // 计算表达式；target非空时顶层运算直接写入target
+        Operand lower(const Expression &expr, std::optional<uint16_t> target = std::nullopt);
+        Operand lowerBinary(const BinaryExpression &expr, std::optional<uint16_t> target);
+        Operand lowerUnary(const UnaryExpression &expr, std::optional<uint16_t> target);
+        Operand lowerIdentifier(const IdentifierExpression &expr, std::optional<uint16_t> target);
+        uint16_t toRegister(Operand operand);
+        void releaseTemps() noexcept { next_temp_ = FRAME_HEADER + var_count_; }
+        uint16_t destination(std::optional<uint16_t> target);
+
+        size_t emit(RegOp op, uint16_t dst = 0, uint16_t a = 0, uint16_t b = 0, int64_t imm = 0, uint8_t level = 0);
+        void patch(size_t at, size_t target);
+        [[nodiscard]] size_t here() const noexcept { return program_.code.size(); }
+
+        [[nodiscard]] const Symbol &resolve(SymbolId name) const;
+        [[nodiscard]] uint8_t levelDistance(const Symbol &symbol) const;
+        [[nodiscard]] static uint16_t slot(size_t index);
+
+        SymbolTable symbols_;
+        RegisterProgram program_;
+        size_t level_ = 0;
+        size_t var_count_ = 0;
+        size_t next_temp_ = 0;  // 当前语句下一个可用的临时寄存器
+        size_t frame_size_ = 0; // 当前帧已用到的槽位数
+    };
+
+} // namespace pl0
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "VM.h"
+#include "RegisterCode.h"
+
+namespace pl0
+{
+    // 寄存器字节码解释器，帧布局与p-code虚拟机相同，同样使用computed goto直接线程化分派；
+    // 尾调用(紧跟Return且层差不为0的Call)与p-code虚拟机一样复用当前帧
+    class RegisterVM
+    {
+    public:
+        explicit RegisterVM(const RegisterProgram &program, size_t stack_size = VM::DEFAULT_STACK_SIZE)
+            : program_(program), stack_size_(stack_size) {}
+
+        [[nodiscard]] ExecutionResult run();
+
+    private:
+        const RegisterProgram &program_;
+        size_t stack_size_;
+    };
+
+} // namespace pl0
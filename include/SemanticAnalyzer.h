@@ -1,63 +1,47 @@
 #pragma once
-#include "ASTVisitor.h"
+#include "ASTWalker.h"
+#include "SymbolTable.h"
 
-#include <stack>
 #include <string>
 #include <vector>
 #include <optional>
-#include <unordered_map>
 
 namespace pl0
 {
-    enum class SymbolType
-    {
-        Constant,
-        Variable,
-        Procedure
-    };
-
-    struct Symbol
-    {
-        SymbolType type;
-        std::optional<int64_t> value;
-        size_t level;
-        size_t index;
-    };
 
-    class SemanticAnalyzer : public ASTVisitor
+    class SemanticAnalyzer : public ASTWalker<SemanticAnalyzer>
     {
     public:
         SemanticAnalyzer() = default;
-        ~SemanticAnalyzer() override = default;
 
         [[nodiscard]] bool analyze(const Program &program);
         [[nodiscard]] const std::vector<std::string> &getErrors() const noexcept { return errors_; }
         [[nodiscard]] const std::vector<std::string> &getInfo() const noexcept { return info_; }
 
-        void visit(const Program &node) override;
-        void visit(const Block &node) override;
-        void visit(const ConstDeclaration &node) override;
-        void visit(const VarDeclaration &node) override;
-        void visit(const ProcedureDeclaration &node) override;
-        void visit(const AssignStatement &node) override;
-        void visit(const CallStatement &node) override;
-        void visit(const BeginStatement &node) override;
-        void visit(const IfStatement &node) override;
-        void visit(const WhileStatement &node) override;
-        void visit(const BinaryExpression &node) override;
-        void visit(const UnaryExpression &node) override;
-        void visit(const NumberExpression &node) override;
-        void visit(const IdentifierExpression &node) override;
+        void visit(const Program &node);
+        void visit(const Block &node);
+        void visit(const ConstDeclaration &node);
+        void visit(const VarDeclaration &node);
+        void visit(const ProcedureDeclaration &node);
+        void visit(const AssignStatement &node);
+        void visit(const CallStatement &node);
+        void visit(const BeginStatement &node);
+        void visit(const IfStatement &node);
+        void visit(const WhileStatement &node);
+        void visit(const BinaryExpression &node);
+        void visit(const UnaryExpression &node);
+        void visit(const NumberExpression &node);
+        void visit(const IdentifierExpression &node);
 
     private:
         void enterScope();
         void leaveScope();
-        bool declareSymbol(std::string_view name, Symbol symbol);
-        std::optional<Symbol> lookupSymbol(std::string_view name) const;
+        bool declareSymbol(SymbolId name, const Symbol &symbol);
+        [[nodiscard]] const Symbol *lookupSymbol(SymbolId name) const noexcept;
 
         void addError(std::string message);
 
-        std::vector<std::unordered_map<std::string_view, Symbol>> symbol_tables_;
+        SymbolTable symbols_;
         size_t current_level_ = 0;
 
         std::vector<std::string> errors_;
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+#include <cstddef>
+#include <optional>
+#include <filesystem>
+#include <string_view>
+
+namespace pl0
+{
+    // 只读的源码缓冲区
+    // 普通文件通过mmap映射(MADV_SEQUENTIAL)，不复制任何字节；管道/标准输入等无法映射的输入一次性读入堆内存
+    // 数据地址在对象移动后保持不变，因此Token和AST中的string_view在缓冲区存活期间始终有效
+    class SourceBuffer
+    {
+    public:
+        SourceBuffer() noexcept = default;
+        ~SourceBuffer();
+
+        SourceBuffer(SourceBuffer &&other) noexcept;
+        SourceBuffer &operator=(SourceBuffer &&other) noexcept;
+        SourceBuffer(const SourceBuffer &) = delete;
+        SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+        // 路径为"-"时读取标准输入，失败时返回std::nullopt
+        [[nodiscard]] static std::optional<SourceBuffer> open(const std::filesystem::path &path);
+
+        [[nodiscard]] std::string_view view() const noexcept { return {data_, size_}; }
+        [[nodiscard]] size_t size() const noexcept { return size_; }
+        [[nodiscard]] bool mapped() const noexcept { return mapped_; }
+
+    private:
+        static std::optional<SourceBuffer> readAll(int fd);
+        void release() noexcept;
+
+        const char *data_ = nullptr;
+        size_t size_ = 0;
+        bool mapped_ = false;
+        std::unique_ptr<char[]> owned_;
+    };
+
+} // namespace pl0
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Interner.h"
+
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+namespace pl0
+{
+    enum class SymbolType
+    {
+        Constant,
+        Variable,
+        Procedure
+    };
+
+    struct Symbol
+    {
+        SymbolType type;
+        std::optional<int64_t> value;
+        size_t level;
+        size_t index;
+        SymbolId name = INVALID_SYMBOL;
+    };
+
+    // 以SymbolId为下标的嵌套作用域符号表
+    // 每个标识符维护一个按作用域深度递增的绑定栈，查找只需访问栈顶
+    class SymbolTable
+    {
+    public:
+        void enterScope();
+        void leaveScope();
+
+        // 当前作用域已有同名符号时返回false；没有打开的作用域时自动打开一个
+        bool declare(SymbolId name, const Symbol &symbol);
+        [[nodiscard]] const Symbol *lookup(SymbolId name) const noexcept;
+
+        [[nodiscard]] size_t depth() const noexcept { return scopes_.size(); }
+
+    private:
+        struct Binding
+        {
+            size_t depth;
+            Symbol symbol;
+        };
+
+        std::vector<std::vector<Binding>> bindings_;
+        std::vector<std::vector<SymbolId>> scopes_;
+    };
+
+} // namespace pl0
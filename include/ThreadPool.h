@@ -0,0 +1,70 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+namespace pl0
+{
+    // 工作窃取线程池
+    // 每个工作线程有自己的双端队列：从队尾取自己的任务，空闲时从其他队列的队首窃取
+    // 外部线程提交的任务轮流分配到各队列；任务内部再提交的任务进入当前线程的队列
+    class ThreadPool
+    {
+    public:
+        using Task = std::function<void()>;
+
+        // threads为0时使用硬件线程数
+        explicit ThreadPool(size_t threads = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        void submit(Task task);
+
+        // 阻塞直到所有已提交的任务执行完毕
+        // 若有任务抛出异常，重新抛出其中第一个（之后的异常被丢弃）
+        void wait();
+
+        [[nodiscard]] size_t size() const noexcept { return threads_.size(); }
+
+        // 各线程从其他队列窃取到的任务数之和
+        [[nodiscard]] size_t steals() const noexcept { return steals_.load(std::memory_order_relaxed); }
+
+    private:
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void run(size_t index);
+        void waitIdle();
+        bool popLocal(size_t index, Task &task);
+        // blocking为false时跳过被占用的队列；为true时逐个阻塞加锁
+        bool steal(size_t index, Task &task, bool blocking);
+
+        std::vector<std::unique_ptr<Queue>> queues_;
+        std::vector<std::thread> threads_;
+
+        std::mutex mutex_;
+        std::condition_variable work_available_;
+        std::condition_variable all_done_;
+        bool stopping_ = false;
+        std::exception_ptr error_; // 第一个逃逸出任务的异常，受mutex_保护
+
+        std::atomic<size_t> queued_{0};  // 仍在队列中的任务
+        std::atomic<size_t> pending_{0}; // 已提交但未完成的任务
+        std::atomic<size_t> next_queue_{0};
+        std::atomic<size_t> steals_{0};
+    };
+
+} // namespace pl0
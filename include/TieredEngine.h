@@ -0,0 +1,77 @@
+#pragma once
+
+#include "VM.h"
+#include "Jit.h"
+#include "JitCompiler.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+
+namespace pl0
+{
+    // 分层执行引擎
+    //
+    // 程序先在p-code虚拟机上解释执行，虚拟机在过程入口和循环回边上计数。任一地址达到阈值时，
+    // 后台线程用JitCompiler把整个程序编译为本地代码；就绪后在下一次调用热过程或下一次到达热循环头时
+    // 转入本地代码，循环头处为栈上替换(OSR): 本地代码从解释器的帧中载入变量后接着执行这一循环。
+    // 两层共用同一个数据栈和相同的帧布局，转入时不需要转换状态，本地代码执行到所在过程返回后回到解释器。
+    // 运行时间短的程序达不到阈值，不会付出编译的开销
+    class TieredEngine : private NativeTier
+    {
+    public:
+        static constexpr uint32_t DEFAULT_THRESHOLD = 1000;
+
+        struct Stats
+        {
+            bool compiled = false;
+            double compileSeconds = 0.0; // 后台编译和载入的耗时
+            uint64_t nativeEntries = 0;  // 转入本地代码的次数
+        };
+
+        // program和code须在引擎存活期间有效，code为program生成的p-code
+        // background为false时在变热处同步编译，转入本地代码的时机可以复现
+        TieredEngine(const Program &program, const PCode &code, size_t stack_size = VM::DEFAULT_STACK_SIZE,
+                     uint32_t threshold = DEFAULT_THRESHOLD, bool background = true);
+        ~TieredEngine() override;
+
+        TieredEngine(const TieredEngine &) = delete;
+        TieredEngine &operator=(const TieredEngine &) = delete;
+
+        // 后台编译尚未完成时，返回前等待其结束
+        [[nodiscard]] ExecutionResult run();
+
+        [[nodiscard]] const Stats &stats() const noexcept { return stats_; }
+
+    private:
+        enum State : int
+        {
+            Idle,
+            Compiling,
+            Ready,
+            Failed
+        };
+
+        [[nodiscard]] uint32_t threshold() const noexcept override { return threshold_; }
+        void hot(size_t address) override;
+        Entry enter(size_t address, int64_t *base, int64_t *frame, std::string &error) override;
+
+        // 在后台线程中执行，发布Ready之前写好native_、image_和entries_，之后只读
+        void compile();
+
+        const Program &program_;
+        const PCode &code_;
+        size_t stack_size_;
+        uint32_t threshold_;
+        bool background_;
+
+        NativeCode native_;
+        std::unique_ptr<NativeImage> image_;
+        std::unordered_map<size_t, size_t> entries_; // p-code地址 -> 本地代码偏移
+        std::atomic<int> state_{Idle};
+        std::thread worker_;
+        Stats stats_;
+    };
+
+} // namespace pl0
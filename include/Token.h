@@ -1,12 +1,11 @@
 #pragma once
 
-#include <variant>
-#include <concepts>
+#include <cstdint>
 #include <string_view>
 
 namespace pl0
 {
-    enum class TokenType {
+    enum class TokenType : uint8_t {
         // 关键字
         CONST, VAR, PROCEDURE, CALL, BEGIN, END, IF, THEN, WHILE, DO, ODD,
 
@@ -18,54 +17,30 @@ namespace pl0
         IDENTIFIER, NUMBER, END_OF_FILE, ERROR
     };
 
-    // 使用concepts来约束模板参数
-    template <typename T>
-    concept TokenValue = std::same_as<T, std::string_view> ||
-                         std::same_as<T, int64_t>;
-
-    // Token类使用variant来存储不同类型的值
+    // 紧凑Token：只记录类型和在源码中的区间(偏移 + 长度)
+    // 标识符的拼写由源码切片得到，数字的值保存在TokenBuffer的数值表中
     class Token
     {
     public:
-        constexpr Token() noexcept : type_(TokenType::ERROR) {}
-        constexpr Token(TokenType type) noexcept : type_(type) {}
-
-        template <TokenValue T>
-        constexpr Token(TokenType type, T value) noexcept
-            : type_(type), value_(std::move(value)) {}
+        constexpr Token() noexcept : Token(TokenType::ERROR) {}
+        constexpr Token(TokenType type, uint32_t offset = 0, uint32_t length = 0) noexcept
+            : offset_(offset), length_(length), type_(type) {}
 
         [[nodiscard]] constexpr TokenType type() const noexcept { return type_; }
+        [[nodiscard]] constexpr uint32_t offset() const noexcept { return offset_; }
+        [[nodiscard]] constexpr uint32_t length() const noexcept { return length_; }
 
-        template <TokenValue T>
-        [[nodiscard]] constexpr const T &value() const
-        {
-            if constexpr (std::is_same_v<T, int64_t>)
-            {
-                if (std::holds_alternative<int64_t>(value_))
-                {
-                    return std::get<int64_t>(value_);
-                }
-                throw std::bad_variant_access();
-            }
-            else if constexpr (std::is_same_v<T, std::string_view>)
-            {
-                if (std::holds_alternative<std::string_view>(value_))
-                {
-                    return std::get<std::string_view>(value_);
-                }
-                throw std::bad_variant_access();
-            }
-            throw std::bad_variant_access();
-        }
-
-        [[nodiscard]] constexpr bool hasValue() const noexcept
+        [[nodiscard]] constexpr std::string_view text(std::string_view source) const noexcept
         {
-            return !value_.valueless_by_exception();
+            return source.substr(offset_, length_);
         }
 
     private:
+        uint32_t offset_;
+        uint32_t length_;
         TokenType type_;
-        std::variant<std::monostate, std::string_view, int64_t> value_;
     };
 
-} // namespace pl0
\ No newline at end of file
+    static_assert(sizeof(Token) <= 12, "Token应保持紧凑");
+
+} // namespace pl0
@@ -1,25 +1,34 @@
 #pragma once
 
 #include "Token.h"
+#include "TokenStream.h"
+#include "KeywordHash.h"
+#include "Interner.h"
 
 #include <array>
 #include <limits>
-#include <optional>
 #include <string_view>
-#include <unordered_map>
 
 namespace pl0 {
 
 class TokenInterpreter {
 public:
-    explicit TokenInterpreter(std::string_view source) noexcept 
-        : source_(source) {}
+    // 标识符驻留到interner中，SymbolId只在该驻留表内有意义
+    explicit TokenInterpreter(std::string_view source, Interner &interner) noexcept
+        : source_(source), interner_(interner) {}
 
     [[nodiscard]] Token nextToken() noexcept;
     [[nodiscard]] Token peekToken() noexcept;
+
+    // 最近读到的NUMBER Token的值
+    [[nodiscard]] int64_t lastNumber() const noexcept { return last_number_; }
+
+    // 一次性扫描全部源码，结果以END_OF_FILE或ERROR结尾
+    // Token偏移为32位，超过4GB的源码直接报ERROR
+    [[nodiscard]] TokenBuffer tokenize();
     
     [[nodiscard]] size_t line() const noexcept { return line_; }
-    [[nodiscard]] size_t column() const noexcept { return column_; }
+    [[nodiscard]] size_t column() const noexcept { return current_ - line_start_ + 1; }
 
 private:
     static constexpr std::array KEYWORDS = {
@@ -36,19 +45,21 @@ private:
         std::pair{"odd", TokenType::ODD}
     };
 
+    // 由KEYWORDS在编译期生成的完美哈希表
+    static constexpr auto KEYWORD_TABLE = makeKeywordHash<32>(KEYWORDS);
+    static_assert(KEYWORD_TABLE.collisionFree(), "关键字完美哈希存在冲突");
+
     void skipWhitespace() noexcept;
-    [[nodiscard]] std::optional<Token> tryReadNumber() noexcept;
-    [[nodiscard]] std::optional<Token> tryReadIdentifier() noexcept;
-    [[nodiscard]] std::optional<Token> tryReadOperator() noexcept;
-    
-    [[nodiscard]] char peek() const noexcept;
-    [[nodiscard]] char peekNext() const noexcept;
-    void advance() noexcept;
+    [[nodiscard]] Token readNumber(size_t start) noexcept;
+    [[nodiscard]] Token readIdentifier(size_t start) noexcept;
+    [[nodiscard]] Token readOperator(size_t start) noexcept;
 
     std::string_view source_;
+    Interner &interner_;
     mutable size_t current_ = 0;
     mutable size_t line_ = 1;
-    mutable size_t column_ = 1;
+    mutable size_t line_start_ = 0;
+    mutable int64_t last_number_ = 0;
     mutable Token peeked_token_{TokenType::ERROR};
     mutable bool has_peeked_ = false;
 };
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "Token.h"
+#include "Interner.h"
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace pl0
+{
+    // Token在源码中的位置
+    struct SourcePosition
+    {
+        size_t line = 1;
+        size_t column = 1;
+    };
+
+    // 词法分析一次性产出的Token缓冲区，按列存储(类型/偏移/长度各一个数组)，每个Token 9字节
+    // IDENTIFIER的SymbolId和NUMBER的数值按Token顺序各自紧密存放，由TokenStream的游标顺序读取
+    // 最后一个Token总是END_OF_FILE或ERROR
+    class TokenBuffer
+    {
+    public:
+        TokenBuffer() = default;
+        explicit TokenBuffer(std::string_view source) noexcept : source_(source) {}
+
+        void push(Token token)
+        {
+            types_.push_back(token.type());
+            offsets_.push_back(token.offset());
+            lengths_.push_back(token.length());
+        }
+
+        void pushNumber(Token token, int64_t value)
+        {
+            numbers_.push_back(value);
+            push(token);
+        }
+
+        void pushIdentifier(Token token, SymbolId symbol)
+        {
+            symbols_.push_back(symbol);
+            push(token);
+        }
+
+        void reserve(size_t tokens, size_t symbols, size_t numbers)
+        {
+            types_.reserve(tokens);
+            offsets_.reserve(tokens);
+            lengths_.reserve(tokens);
+            symbols_.reserve(symbols);
+            numbers_.reserve(numbers);
+        }
+
+        [[nodiscard]] size_t size() const noexcept { return types_.size(); }
+        [[nodiscard]] bool empty() const noexcept { return types_.empty(); }
+        [[nodiscard]] std::string_view source() const noexcept { return source_; }
+
+        [[nodiscard]] TokenType type(size_t index) const noexcept { return types_[index]; }
+        [[nodiscard]] uint32_t offset(size_t index) const noexcept { return offsets_[index]; }
+        [[nodiscard]] uint32_t length(size_t index) const noexcept { return lengths_[index]; }
+        [[nodiscard]] Token operator[](size_t index) const noexcept
+        {
+            return Token{types_[index], offsets_[index], lengths_[index]};
+        }
+        [[nodiscard]] TokenType backType() const noexcept { return types_.back(); }
+
+        [[nodiscard]] std::string_view text(size_t index) const noexcept
+        {
+            return source_.substr(offsets_[index], lengths_[index]);
+        }
+
+        // 第i个NUMBER的值/第i个IDENTIFIER的SymbolId
+        [[nodiscard]] const std::vector<int64_t> &numbers() const noexcept { return numbers_; }
+        [[nodiscard]] const std::vector<SymbolId> &symbols() const noexcept { return symbols_; }
+
+        // 行列号只在报错时需要，按需从源码计算
+        [[nodiscard]] SourcePosition position(size_t index) const noexcept;
+
+        // Token占用的内存(按容量计)
+        [[nodiscard]] size_t memoryBytes() const noexcept;
+
+    private:
+        std::string_view source_;
+        std::vector<TokenType> types_;
+        std::vector<uint32_t> offsets_;
+        std::vector<uint32_t> lengths_;
+        std::vector<SymbolId> symbols_;
+        std::vector<int64_t> numbers_;
+    };
+
+    // TokenBuffer上的顺序游标，供语法分析使用
+    class TokenStream
+    {
+    public:
+        explicit TokenStream(const TokenBuffer &buffer) noexcept : buffer_(buffer) {}
+
+        // 游标操作，越过末尾时停留在最后一个Token上
+        [[nodiscard]] TokenType peekType() const noexcept { return buffer_.type(current_); }
+        [[nodiscard]] Token peek() const noexcept { return buffer_[current_]; }
+        Token advance() noexcept
+        {
+            Token token = buffer_[current_];
+            if (current_ + 1 < buffer_.size())
+            {
+                number_cursor_ += token.type() == TokenType::NUMBER ? 1 : 0;
+                symbol_cursor_ += token.type() == TokenType::IDENTIFIER ? 1 : 0;
+                ++current_;
+            }
+            return token;
+        }
+        [[nodiscard]] bool check(TokenType type) const noexcept { return peekType() == type; }
+        [[nodiscard]] size_t cursor() const noexcept { return current_; }
+
+        // 当前Token的拼写、数值(NUMBER)和SymbolId(IDENTIFIER)
+        [[nodiscard]] std::string_view currentText() const noexcept { return buffer_.text(current_); }
+        [[nodiscard]] int64_t currentNumber() const noexcept { return buffer_.numbers()[number_cursor_]; }
+        [[nodiscard]] SymbolId currentSymbol() const noexcept { return buffer_.symbols()[symbol_cursor_]; }
+
+        // 当前Token的位置
+        [[nodiscard]] SourcePosition position() const noexcept { return buffer_.position(current_); }
+
+        [[nodiscard]] const TokenBuffer &buffer() const noexcept { return buffer_; }
+
+    private:
+        const TokenBuffer &buffer_;
+        size_t current_ = 0;
+        size_t number_cursor_ = 0;
+        size_t symbol_cursor_ = 0;
+    };
+
+} // namespace pl0
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+// 编译期跟踪级别：0关闭(所有PL0_TRACE展开为空)，1-3依次对应Info/Debug/Verbose
+#ifndef PL0_TRACE_LEVEL
+#define PL0_TRACE_LEVEL 0
+#endif
+
+namespace pl0::trace
+{
+    enum class Level : uint8_t
+    {
+        Off = 0,
+        Info = 1,
+        Debug = 2,
+        Verbose = 3
+    };
+
+    // 跟踪事件，每种事件对参数a/b/c的解释见注释
+    enum class Event : uint8_t
+    {
+        LexNumber,       // a=源码偏移 b=数值 c=长度
+        LexError,        // a=源码偏移 b=出错字符(或-1表示数字溢出)
+        ParseStatement,  // a=Token下标 b=TokenType
+        ParseError,      // a=Token下标 b=TokenType
+        SemanticScope,   // a=层次 b=1进入/0离开
+        SemanticDeclare, // a=层次 b=SymbolType c=变量下标
+        SemanticError,   // a=层次 b=已记录的错误数
+    };
+
+    // 定长的类型化记录，由写入线程填充、后台线程格式化
+    struct Record
+    {
+        uint64_t timestamp_ns;
+        int64_t b;
+        int64_t c;
+        uint32_t a;
+        Event event;
+        Level level;
+    };
+
+    namespace detail
+    {
+        extern std::atomic<uint8_t> runtime_level;
+        void emit(Level level, Event event, uint32_t a, int64_t b, int64_t c) noexcept;
+    }
+
+    // 运行期级别，默认读取环境变量PL0_TRACE
+    void setLevel(Level level) noexcept;
+    [[nodiscard]] Level level() noexcept;
+    // 输出目标，默认stderr
+    void setSink(std::FILE *sink) noexcept;
+    // 同步地把所有线程缓冲区中的记录写出
+    void flush() noexcept;
+    // 因缓冲区满而丢弃的记录数
+    [[nodiscard]] uint64_t dropped() noexcept;
+
+    [[nodiscard]] inline bool enabled(Level level) noexcept
+    {
+        return static_cast<uint8_t>(level) <= detail::runtime_level.load(std::memory_order_relaxed);
+    }
+
+    inline void emit(Level level, Event event, uint32_t a, int64_t b = 0, int64_t c = 0) noexcept
+    {
+        if (enabled(level))
+        {
+            detail::emit(level, event, a, b, c);
+        }
+    }
+
+} // namespace pl0::trace
+
+// 跟踪点：级别高于PL0_TRACE_LEVEL时整个语句在编译期被丢弃
+#define PL0_TRACE(level, event, ...)                                                  \
+    do                                                                                \
+    {                                                                                 \
+        if constexpr (static_cast<int>(::pl0::trace::Level::level) <= PL0_TRACE_LEVEL) \
+        {                                                                             \
+            ::pl0::trace::emit(::pl0::trace::Level::level,                            \
+                               ::pl0::trace::Event::event, __VA_ARGS__);              \
+        }                                                                             \
+    } while (0)
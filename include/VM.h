@@ -0,0 +1,89 @@
+#pragma once
+
+#include "PCode.h"
+
+#include <span>
+#include <string>
+#include <optional>
+#include <vector>
+#include <cstdint>
+
+namespace pl0
+{
+    // 一次执行的结果，各执行引擎共用
+    struct ExecutionResult
+    {
+        bool success = true;
+        std::string error;
+        std::vector<int64_t> globals; // 主程序变量的最终值，与PCode::globals对应
+        std::optional<size_t> address; // 运行时错误所在的p-code地址，用于查源码位置表
+        uint64_t instructions = 0;    // 分派的指令数
+        double seconds = 0.0;
+
+        [[nodiscard]] double instructionsPerSecond() const noexcept
+        {
+            return seconds > 0.0 ? static_cast<double>(instructions) / seconds : 0.0;
+        }
+    };
+
+    // 分层执行时虚拟机与本地代码层之间的接口
+    // 设置后，虚拟机在过程入口(CAL的目标)和循环头(向后JMP的目标)上计数，达到阈值时对该地址报告一次hot，
+    // 此后每次经过都尝试enter；本地代码就绪后即在该处转入，直到对应的过程返回
+    class NativeTier
+    {
+    public:
+        enum class Entry
+        {
+            Unavailable, // 尚未就绪，继续解释执行
+            Disabled,    // 不会再就绪(例如编译失败)，不必再尝试
+            Returned,    // 已执行到frame所属的过程返回
+            Failed       // 运行时错误，信息写入error
+        };
+
+        virtual ~NativeTier() = default;
+
+        [[nodiscard]] virtual uint32_t threshold() const noexcept = 0;
+        virtual void hot(size_t address) = 0;
+        // base为数据栈基址，frame为address所在过程的帧(调用时帧头已写好)
+        virtual Entry enter(size_t address, int64_t *base, int64_t *frame, std::string &error) = 0;
+    };
+
+    // p-code虚拟机：平坦的int64_t数据栈，computed goto直接线程化分派
+    // 执行前把每条指令翻译为(处理例程地址, 层差, 参数)，OPR按子操作展开为独立例程；
+    // 再把基本块内匹配的指令序列改由构建时生成的超级指令例程一次执行(见tools/superinstructions.cpp)。
+    // 紧跟RET且层差不为0的CAL是尾调用，被调用者复用当前帧，尾递归只占用常数的栈空间
+    class VM
+    {
+    public:
+        static constexpr size_t DEFAULT_STACK_SIZE = 1 << 20;
+
+        using Result = ExecutionResult;
+
+        explicit VM(const PCode &program, size_t stack_size = DEFAULT_STACK_SIZE)
+            : VM(program.code, program.globals.size(), stack_size) {}
+
+        // 直接执行外部的指令数组(如映射的预编译文件)，global_count为主程序变量数
+        VM(std::span<const Instruction> code, size_t global_count, size_t stack_size = DEFAULT_STACK_SIZE)
+            : code_(code), global_count_(global_count), stack_size_(stack_size) {}
+
+        // 启用分层执行，tier须在run期间有效
+        void setTier(NativeTier *tier) noexcept { tier_ = tier; }
+
+        // 超级指令融合，默认开启；关闭后逐条分派
+        void setFusion(bool enabled) noexcept { fusion_ = enabled; }
+
+        // 剖析模式: 按地址累加每条指令的执行次数(counts不足code大小时扩充)，此时不做融合
+        void setProfile(std::vector<uint64_t> *counts) noexcept { profile_ = counts; }
+
+        [[nodiscard]] Result run();
+
+    private:
+        NativeTier *tier_ = nullptr;
+        std::vector<uint64_t> *profile_ = nullptr;
+        bool fusion_ = true;
+        std::span<const Instruction> code_;
+        size_t global_count_;
+        size_t stack_size_;
+    };
+
+} // namespace pl0
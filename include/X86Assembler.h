@@ -0,0 +1,167 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace pl0::x86
+{
+    enum class Reg : uint8_t
+    {
+        RAX,
+        RCX,
+        RDX,
+        RBX,
+        RSP,
+        RBP,
+        RSI,
+        RDI,
+        R8,
+        R9,
+        R10,
+        R11,
+        R12,
+        R13,
+        R14,
+        R15
+    };
+
+    // 条件码，与Jcc/SETcc编码中的低4位一致；取反只需翻转最低位
+    enum class Cond : uint8_t
+    {
+        O = 0x0,
+        NO = 0x1,
+        B = 0x2,
+        AE = 0x3,
+        E = 0x4,
+        NE = 0x5,
+        BE = 0x6,
+        A = 0x7,
+        S = 0x8,
+        NS = 0x9,
+        L = 0xC,
+        GE = 0xD,
+        LE = 0xE,
+        G = 0xF
+    };
+
+    [[nodiscard]] constexpr Cond invert(Cond cond) noexcept
+    {
+        return static_cast<Cond>(static_cast<uint8_t>(cond) ^ 1);
+    }
+
+    // 内存操作数: [base + index*8 + disp]
+    struct Mem
+    {
+        Reg base;
+        std::optional<Reg> index;
+        int32_t disp = 0;
+    };
+
+    [[nodiscard]] inline Mem at(Reg base, int32_t disp = 0) noexcept { return Mem{base, std::nullopt, disp}; }
+    [[nodiscard]] inline Mem at(Reg base, Reg index, int32_t disp) noexcept { return Mem{base, index, disp}; }
+
+    // 代码缓冲区内的跳转目标
+    struct Label
+    {
+        uint32_t id;
+    };
+
+    // 最小的x86-64编码器，只覆盖后端用到的64位整数指令
+    // 所有跳转和调用都是rel32相对寻址，生成的代码与加载地址无关
+    class Assembler
+    {
+    public:
+        [[nodiscard]] const std::vector<uint8_t> &code() const noexcept { return code_; }
+        [[nodiscard]] size_t size() const noexcept { return code_.size(); }
+
+        [[nodiscard]] Label newLabel();
+        void bind(Label label);
+        [[nodiscard]] bool bound(Label label) const noexcept { return labels_[label.id] >= 0; }
+        [[nodiscard]] size_t offset(Label label) const noexcept { return static_cast<size_t>(labels_[label.id]); }
+
+        // 回填所有跳转；存在未绑定的标签时返回false
+        [[nodiscard]] bool finalize();
+
+        void mov(Reg dst, Reg src);
+        void mov(Reg dst, int64_t imm);
+        void mov(Reg dst, Mem src);
+        void mov(Mem dst, Reg src);
+        void mov(Mem dst, int32_t imm);
+        // 只写低8位
+        void movByte(Mem dst, Reg src);
+        void lea(Reg dst, Mem src);
+
+        void add(Reg dst, Reg src) { aluRR(0x01, dst, src); }
+        void add(Reg dst, Mem src) { aluRM(0x03, dst, src); }
+        void add(Reg dst, int32_t imm) { aluRI(0, dst, imm); }
+        void sub(Reg dst, Reg src) { aluRR(0x29, dst, src); }
+        void sub(Reg dst, Mem src) { aluRM(0x2B, dst, src); }
+        void sub(Reg dst, int32_t imm) { aluRI(5, dst, imm); }
+        void and_(Reg dst, Reg src) { aluRR(0x21, dst, src); }
+        void and_(Reg dst, int32_t imm) { aluRI(4, dst, imm); }
+        void xor_(Reg dst, Reg src) { aluRR(0x31, dst, src); }
+        void cmp(Reg left, Reg right) { aluRR(0x39, left, right); }
+        void cmp(Reg left, Mem right) { aluRM(0x3B, left, right); }
+        void cmp(Reg left, int32_t imm) { aluRI(7, left, imm); }
+        void test(Reg left, Reg right) { aluRR(0x85, left, right); }
+        void test(Reg left, int32_t imm);
+
+        void imul(Reg dst, Reg src);
+        void imul(Reg dst, Mem src);
+        void imul(Reg dst, Reg src, int32_t imm);
+        // rdx:rax = rax * src，有符号
+        void imulWide(Reg src);
+        void neg(Reg reg);
+        void dec(Reg reg);
+        void shl(Reg reg, uint8_t amount);
+        void shlCl(Reg reg); // 左移cl位
+        void shr(Reg reg, uint8_t amount);
+        void sar(Reg reg, uint8_t amount);
+        void cqo();
+        void idiv(Reg divisor);
+        // rdx:rax / divisor，无符号
+        void div(Reg divisor);
+
+        // dst = 条件成立 ? 1 : 0
+        void setcc(Cond cond, Reg dst);
+
+        void push(Reg reg);
+        void pop(Reg reg);
+
+        void jmp(Label target);
+        void jcc(Cond cond, Label target);
+        void call(Label target);
+        void call(Reg target);
+        void ret();
+        void syscall();
+
+    private:
+        void emit8(uint8_t byte) { code_.push_back(byte); }
+        void emit32(uint32_t value);
+        void emit64(uint64_t value);
+
+        void rex(bool w, uint8_t reg, uint8_t index, uint8_t base, bool force = false);
+        void modrmReg(uint8_t reg, Reg rm);
+        void modrmMem(uint8_t reg, const Mem &mem);
+        void rexMem(uint8_t reg, const Mem &mem);
+
+        void aluRR(uint8_t opcode, Reg dst, Reg src);
+        void aluRM(uint8_t opcode, Reg dst, const Mem &src);
+        void aluRI(uint8_t extension, Reg dst, int32_t imm);
+
+        void branch(Label target);
+
+        struct Fixup
+        {
+            size_t at; // rel32字段的位置
+            uint32_t label;
+        };
+
+        std::vector<uint8_t> code_;
+        std::vector<int64_t> labels_;
+        std::vector<Fixup> fixups_;
+    };
+
+} // namespace pl0::x86
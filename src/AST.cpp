@@ -69,68 +69,48 @@ namespace pl0
         visitor.visit(*this);
     }
 
-    bool BinaryExpression::isConstant() const noexcept
+    // NumberExpression
+    void NumberExpression::accept(ASTVisitor &visitor) const
     {
-        return left_->isConstant() && right_->isConstant();
+        visitor.visit(*this);
     }
 
-    std::optional<int64_t> BinaryExpression::evaluateConstant() const
+    // IdentifierExpression
+    void IdentifierExpression::accept(ASTVisitor &visitor) const
     {
-        auto left_val = left_->evaluateConstant();
-        auto right_val = right_->evaluateConstant();
-
-        if (!left_val || !right_val)
-            return std::nullopt;
-
-        switch (op_)
-        {
-        case Op::Add:
-            return *left_val + *right_val;
-        case Op::Sub:
-            return *left_val - *right_val;
-        case Op::Mul:
-            return *left_val * *right_val;
-        case Op::Div:
-            if (*right_val == 0)
-                return std::nullopt;
-            return *left_val / *right_val;
-        case Op::Pow:
-        {
-            if (*right_val < 0)
-                return std::nullopt;
-            int64_t result = 1;
-            for (int64_t i = 0; i < *right_val; ++i)
-            {
-                result *= *left_val;
-            }
-            return result;
-        }
-        case Op::Eq:
-            return *left_val == *right_val;
-        case Op::Neq:
-            return *left_val != *right_val;
-        case Op::Lt:
-            return *left_val < *right_val;
-        case Op::Lte:
-            return *left_val <= *right_val;
-        case Op::Gt:
-            return *left_val > *right_val;
-        case Op::Gte:
-            return *left_val >= *right_val;
-        }
-        return std::nullopt;
+        visitor.visit(*this);
     }
 
-    // NumberExpression
-    void NumberExpression::accept(ASTVisitor &visitor) const
+    // UnaryExpression
+    void UnaryExpression::accept(ASTVisitor &visitor) const
     {
         visitor.visit(*this);
     }
 
-    // IdentifierExpression
-    void IdentifierExpression::accept(ASTVisitor &visitor) const
+    const CallStatement *tailCall(const Statement &body) noexcept
     {
-        visitor.visit(*this);
+        const Statement *stmt = &body;
+        while (stmt)
+        {
+            switch (stmt->kind())
+            {
+            case NodeKind::CallStatement:
+                return static_cast<const CallStatement *>(stmt);
+            case NodeKind::BeginStatement:
+            {
+                const auto &statements = static_cast<const BeginStatement *>(stmt)->statements();
+                stmt = statements.empty() ? nullptr : statements.back();
+                break;
+            }
+            case NodeKind::IfStatement:
+                stmt = &static_cast<const IfStatement *>(stmt)->thenStmt();
+                break;
+            default:
+                stmt = nullptr;
+                break;
+            }
+        }
+        return nullptr;
     }
 
-} // namespace pl0
\ No newline at end of file
+} // namespace pl0
@@ -7,7 +7,7 @@ namespace pl0
     {
         out_ << "Program\n";
         increaseLevel();
-        node.block().accept(*this);
+        walk(node.block());
         decreaseLevel();
     }
 
@@ -25,7 +25,7 @@ namespace pl0
             increaseLevel();
             for (const auto &constDecl : node.consts())
             {
-                constDecl->accept(*this);
+                walk(*constDecl);
             }
             decreaseLevel();
         }
@@ -38,7 +38,7 @@ namespace pl0
             increaseLevel();
             for (const auto &varDecl : node.vars())
             {
-                varDecl->accept(*this);
+                walk(*varDecl);
             }
             decreaseLevel();
         }
@@ -51,7 +51,7 @@ namespace pl0
             increaseLevel();
             for (const auto &procDecl : node.procedures())
             {
-                procDecl->accept(*this);
+                walk(*procDecl);
             }
             decreaseLevel();
         }
@@ -60,7 +60,7 @@ namespace pl0
         indent();
         out_ << "Statement:\n";
         increaseLevel();
-        node.statement().accept(*this);
+        walk(node.statement());
         decreaseLevel();
 
         decreaseLevel();
@@ -73,7 +73,7 @@ namespace pl0
         increaseLevel();
         for (const auto &stmt : node.statements())
         {
-            stmt->accept(*this);
+            walk(*stmt);
         }
         decreaseLevel();
     }
@@ -86,12 +86,12 @@ namespace pl0
         indent();
         out_ << "Condition:\n";
         increaseLevel();
-        node.condition().accept(*this);
+        walk(node.condition());
         decreaseLevel();
         indent();
         out_ << "Then:\n";
         increaseLevel();
-        node.thenStmt().accept(*this);
+        walk(node.thenStmt());
         decreaseLevel();
         decreaseLevel();
     }
@@ -104,12 +104,12 @@ namespace pl0
         indent();
         out_ << "Condition:\n";
         increaseLevel();
-        node.condition().accept(*this);
+        walk(node.condition());
         decreaseLevel();
         indent();
         out_ << "Body:\n";
         increaseLevel();
-        node.body().accept(*this);
+        walk(node.body());
         decreaseLevel();
         decreaseLevel();
     }
@@ -135,6 +135,9 @@ namespace pl0
         case BinaryExpression::Op::Pow:
             out_ << "^";
             break;
+        case BinaryExpression::Op::Shl:
+            out_ << "<<";
+            break;
         case BinaryExpression::Op::Eq:
             out_ << "=";
             break;
@@ -159,12 +162,12 @@ namespace pl0
         indent();
         out_ << "Left:\n";
         increaseLevel();
-        node.left().accept(*this);
+        walk(node.left());
         decreaseLevel();
         indent();
         out_ << "Right:\n";
         increaseLevel();
-        node.right().accept(*this);
+        walk(node.right());
         decreaseLevel();
         decreaseLevel();
     }
@@ -181,10 +184,13 @@ namespace pl0
         case UnaryExpression::Op::Not:
             out_ << "!";
             break;
+        case UnaryExpression::Op::Odd:
+            out_ << "odd";
+            break;
         }
         out_ << '\n';
         increaseLevel();
-        node.operand().accept(*this);
+        walk(node.operand());
         decreaseLevel();
     }
 
@@ -217,7 +223,7 @@ namespace pl0
         indent();
         out_ << node.name() << ": Procedure Declaration\n";
         increaseLevel();
-        node.block().accept(*this);
+        walk(node.block());
         decreaseLevel();
     }
 
@@ -226,7 +232,7 @@ namespace pl0
         indent();
         out_ << node.name() << " := : Assignment Statement\n";
         increaseLevel();
-        node.expression().accept(*this);
+        walk(node.expression());
         decreaseLevel();
     }
 
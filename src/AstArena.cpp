@@ -0,0 +1,34 @@
+#include "../include/AstArena.h"
+
+#include <cstdint>
+#include <algorithm>
+
+namespace pl0
+{
+
+    void *AstArena::allocate(size_t bytes, size_t align)
+    {
+        auto aligned = [align](std::byte *p)
+        {
+            auto address = reinterpret_cast<uintptr_t>(p);
+            return reinterpret_cast<std::byte *>((address + align - 1) & ~(uintptr_t(align) - 1));
+        };
+
+        std::byte *start = cursor_ ? aligned(cursor_) : nullptr;
+        if (start == nullptr || start + bytes > end_)
+        {
+            size_t page_size = std::max(PAGE_SIZE, bytes + align);
+            // 不需要清零，直接new
+            auto &page = pages_.emplace_back(new std::byte[page_size]);
+            cursor_ = page.get();
+            end_ = cursor_ + page_size;
+            bytes_reserved_ += page_size;
+            start = aligned(cursor_);
+        }
+
+        cursor_ = start + bytes;
+        bytes_used_ += bytes;
+        return start;
+    }
+
+} // namespace pl0
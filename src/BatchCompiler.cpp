@@ -0,0 +1,241 @@
+#include "../include/BatchCompiler.h"
+#include "../include/ThreadPool.h"
+
+#include <chrono>
+#include <fstream>
+#include <set>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+
+namespace pl0
+{
+
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        double secondsSince(Clock::time_point start)
+        {
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        }
+    }
+
+    size_t BatchCompiler::Summary::failures() const noexcept
+    {
+        return static_cast<size_t>(std::count_if(files.begin(), files.end(),
+                                                 [](const FileResult &file)
+                                                 { return !file.success; }));
+    }
+
+    double BatchCompiler::Summary::busySeconds() const noexcept
+    {
+        double total = 0.0;
+        for (const auto &file : files)
+        {
+            total += file.seconds;
+        }
+        return total;
+    }
+
+    BatchCompiler::Summary BatchCompiler::run(const std::filesystem::path &input,
+                                              const std::filesystem::path &outputDir,
+                                              size_t threads)
+    {
+        auto start = Clock::now();
+        auto inputs = collectInputs(input);
+
+        Summary summary;
+        summary.files.resize(inputs.size());
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            summary.files[i].input = inputs[i];
+            summary.files[i].outputDir = outputDirFor(input, inputs[i], outputDir);
+        }
+        disambiguateOutputDirs(summary.files);
+
+        {
+            ThreadPool pool(threads);
+            summary.threads = pool.size();
+
+            // 每个任务只写自己的槽位，不需要加锁
+            for (size_t i = 0; i < inputs.size(); ++i)
+            {
+                FileResult &slot = summary.files[i];
+                pool.submit([&slot]
+                            {
+                    auto file_start = Clock::now();
+                    try
+                    {
+                        auto result = Compiler::compileFile(slot.input);
+                        Compiler::outputResults(result, slot.outputDir);
+                        slot.success = result.success;
+                        slot.errors = std::move(result.errors);
+                        slot.stats = result.stats;
+                    }
+                    catch (const std::exception &e)
+                    {
+                        slot.success = false;
+                        slot.errors.push_back(e.what());
+                    }
+                    slot.seconds = secondsSince(file_start); });
+            }
+
+            pool.wait();
+            summary.steals = pool.steals();
+        }
+
+        summary.wallSeconds = secondsSince(start);
+        return summary;
+    }
+
+    std::vector<std::filesystem::path> BatchCompiler::collectInputs(const std::filesystem::path &input)
+    {
+        std::vector<std::filesystem::path> inputs;
+
+        if (std::filesystem::is_directory(input))
+        {
+            for (const auto &entry : std::filesystem::recursive_directory_iterator(input))
+            {
+                if (entry.is_regular_file() && entry.path().extension() == ".pl0")
+                {
+                    inputs.push_back(entry.path());
+                }
+            }
+            // 目录遍历顺序不确定，排序以保证汇总结果稳定
+            std::sort(inputs.begin(), inputs.end());
+            return inputs;
+        }
+
+        std::ifstream list(input);
+        if (!list)
+        {
+            throw std::runtime_error("无法读取批量输入: " + input.string());
+        }
+
+        // 列表中的相对路径相对于当前工作目录
+        std::string line;
+        while (std::getline(list, line))
+        {
+            auto first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#')
+            {
+                continue;
+            }
+            auto last = line.find_last_not_of(" \t\r");
+            inputs.emplace_back(line.substr(first, last - first + 1));
+        }
+        return inputs;
+    }
+
+    std::filesystem::path BatchCompiler::outputDirFor(const std::filesystem::path &input,
+                                                      const std::filesystem::path &file,
+                                                      const std::filesystem::path &outputDir)
+    {
+        std::filesystem::path relative = std::filesystem::is_directory(input)
+                                             ? file.lexically_relative(input)
+                                             : file;
+
+        // 去掉根目录、"."和".."，保证结果落在outputDir之内
+        std::filesystem::path result = outputDir;
+        for (const auto &part : relative.lexically_normal().relative_path())
+        {
+            if (part != "." && part != ".." && !part.empty())
+            {
+                result /= part;
+            }
+        }
+        return result == outputDir ? result / "unnamed" : result.replace_extension();
+    }
+
+    void BatchCompiler::disambiguateOutputDirs(std::vector<FileResult> &files)
+    {
+        // 去掉扩展名和".."后，不同的输入可能对应同一个目录(列表中的a.pl0和a.txt，或同一文件列了两次)。
+        // 第一个保留原名，其余先改用带扩展名的名字，仍重名时再加"~序号"；改用的名字不占用其他输入的原名
+        std::set<std::filesystem::path> taken;
+        for (const auto &file : files)
+        {
+            taken.insert(file.outputDir);
+        }
+        std::set<std::filesystem::path> used;
+        for (auto &file : files)
+        {
+            if (used.insert(file.outputDir).second)
+            {
+                continue;
+            }
+            auto candidate = std::filesystem::path(file.outputDir) += file.input.extension();
+            for (size_t n = 2; taken.contains(candidate); ++n)
+            {
+                candidate = std::filesystem::path(file.outputDir) +=
+                    file.input.extension().string() + "~" + std::to_string(n);
+            }
+            taken.insert(candidate);
+            used.insert(candidate);
+            file.outputDir = candidate;
+            file.renamed = true;
+        }
+    }
+
+    void BatchCompiler::outputSummary(const Summary &summary, const std::filesystem::path &path)
+    {
+        std::filesystem::create_directories(path.parent_path());
+
+        std::ofstream file(path);
+        file << "Batch Compilation Summary:\n";
+        file << "==========================\n\n";
+        file << "Files:            " << summary.files.size() << '\n';
+        file << "Succeeded:        " << summary.files.size() - summary.failures() << '\n';
+        file << "Failed:           " << summary.failures() << '\n';
+        file << "Threads:          " << summary.threads << '\n';
+        file << "Steals:           " << summary.steals << '\n';
+        file << "Wall time:        " << summary.wallSeconds * 1000.0 << " ms\n";
+        file << "Busy time:        " << summary.busySeconds() * 1000.0 << " ms\n";
+        if (summary.wallSeconds > 0.0)
+        {
+            file << "Parallelism:      " << summary.busySeconds() / summary.wallSeconds << '\n';
+        }
+
+        if (summary.failures() > 0)
+        {
+            file << "\nFailures:\n";
+            for (const auto &result : summary.files)
+            {
+                if (result.success)
+                {
+                    continue;
+                }
+                file << "- " << result.input.string() << '\n';
+                for (const auto &error : result.errors)
+                {
+                    file << "    " << error << '\n';
+                }
+            }
+        }
+
+        bool renamed = std::any_of(summary.files.begin(), summary.files.end(),
+                                   [](const FileResult &result)
+                                   { return result.renamed; });
+        if (renamed)
+        {
+            file << "\nRenamed Output Directories:\n";
+            for (const auto &result : summary.files)
+            {
+                if (result.renamed)
+                {
+                    file << "- " << result.input.string() << " -> " << result.outputDir.string() << '\n';
+                }
+            }
+        }
+
+        file << "\nPer-file Results:\n";
+        for (const auto &result : summary.files)
+        {
+            file << (result.success ? "OK   " : "FAIL ")
+                 << std::fixed << std::setprecision(3) << std::setw(10) << result.seconds * 1000.0 << " ms  "
+                 << std::setw(8) << result.stats.tokenCount << " tokens  "
+                 << result.input.string() << '\n';
+        }
+    }
+
+} // namespace pl0
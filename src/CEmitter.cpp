@@ -0,0 +1,593 @@
+#include "../include/CEmitter.h"
+#include "../include/PCode.h"
+
+#include <limits>
+#include <algorithm>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+
+namespace pl0
+{
+
+    namespace
+    {
+        // 运行时支持，与Arith.h及虚拟机的检查保持一致
+        constexpr const char *PRELUDE = R"(/* 由PL/0编译器生成，编译时需要-pthread */
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+/* 与虚拟机相同的栈容量(槽位数)，每个帧占用3个帧头槽位加变量个数 */
+#ifndef PL0_STACK_SIZE
+#define PL0_STACK_SIZE 1048576
+#endif
+
+/* 每个过程是一个C函数，递归深度还受C栈限制: pl0_run在单独的线程上执行，
+   线程栈按每个槽位PL0_NATIVE_SLOT字节分配，使C栈不先于槽位耗尽；
+   帧头之外的开销因程序而异，进入过程时另外检查C栈的余量 */
+#ifndef PL0_NATIVE_SLOT
+#define PL0_NATIVE_SLOT 64
+#endif
+#define PL0_NATIVE_RESERVE 65536 /* 留给pl0_error和库函数 */
+
+static int64_t pl0_sp;
+static uintptr_t pl0_stack_low;
+
+static void pl0_error(const char *message)
+{
+    fprintf(stderr, "运行时错误: %s\n", message);
+    exit(1);
+}
+
+static inline void pl0_enter(int64_t size)
+{
+    char here;
+    if (PL0_STACK_SIZE - pl0_sp < size + 3 || (uintptr_t)&here < pl0_stack_low)
+        pl0_error("栈溢出");
+    pl0_sp += size;
+}
+
+static inline void pl0_leave(int64_t size)
+{
+    pl0_sp -= size;
+}
+
+/* 64位补码回绕，避免有符号溢出的未定义行为 */
+static inline int64_t pl0_add(int64_t a, int64_t b) { return (int64_t)((uint64_t)a + (uint64_t)b); }
+static inline int64_t pl0_sub(int64_t a, int64_t b) { return (int64_t)((uint64_t)a - (uint64_t)b); }
+static inline int64_t pl0_mul(int64_t a, int64_t b) { return (int64_t)((uint64_t)a * (uint64_t)b); }
+static inline int64_t pl0_neg(int64_t a) { return (int64_t)(0 - (uint64_t)a); }
+
+/* 向零取整；INT64_MIN / -1 按回绕结果处理 */
+static inline int64_t pl0_div(int64_t a, int64_t b)
+{
+    if (b == 0)
+        pl0_error("除数为零");
+    return b == -1 ? pl0_neg(a) : a / b;
+}
+
+static inline int64_t pl0_pow(int64_t base, int64_t exponent)
+{
+    uint64_t result = 1;
+    uint64_t factor = (uint64_t)base;
+    if (exponent < 0)
+        pl0_error("负指数");
+    for (; exponent > 0; exponent >>= 1)
+    {
+        if (exponent & 1)
+            result *= factor;
+        factor *= factor;
+    }
+    return (int64_t)result;
+}
+
+/* a * 2^b，由乘方的强度削弱生成 */
+static inline int64_t pl0_shl(int64_t a, int64_t b)
+{
+    if (b < 0)
+        pl0_error("负指数");
+    return b >= 64 ? 0 : (int64_t)((uint64_t)a << b);
+}
+
+)";
+
+        // 在栈足够大的线程上执行主程序；MAP_NORESERVE的栈只占用实际用到的页
+        constexpr const char *RUNNER = R"(static void *pl0_thread(void *globals)
+{
+    pl0_run(globals);
+    return NULL;
+}
+
+static void pl0_start(int64_t *globals)
+{
+    size_t size = (size_t)PL0_STACK_SIZE * PL0_NATIVE_SLOT + PL0_NATIVE_RESERVE;
+    void *stack = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    pthread_attr_t attr;
+    pthread_t thread;
+    if (stack == MAP_FAILED)
+        pl0_error("无法分配栈");
+    pl0_stack_low = (uintptr_t)stack + PL0_NATIVE_RESERVE;
+    if (pthread_attr_init(&attr) != 0 || pthread_attr_setstack(&attr, stack, size) != 0 ||
+        pthread_create(&thread, &attr, pl0_thread, globals) != 0 || pthread_join(thread, NULL) != 0)
+        pl0_error("无法创建线程");
+    pthread_attr_destroy(&attr);
+    munmap(stack, size);
+}
+
+)";
+
+        const char *comparison(BinaryExpression::Op op) noexcept
+        {
+            switch (op)
+            {
+            case BinaryExpression::Op::Eq:
+                return " == ";
+            case BinaryExpression::Op::Neq:
+                return " != ";
+            case BinaryExpression::Op::Lt:
+                return " < ";
+            case BinaryExpression::Op::Lte:
+                return " <= ";
+            case BinaryExpression::Op::Gt:
+                return " > ";
+            case BinaryExpression::Op::Gte:
+                return " >= ";
+            default:
+                return nullptr;
+            }
+        }
+
+        const char *helper(BinaryExpression::Op op) noexcept
+        {
+            switch (op)
+            {
+            case BinaryExpression::Op::Add:
+                return "pl0_add";
+            case BinaryExpression::Op::Sub:
+                return "pl0_sub";
+            case BinaryExpression::Op::Mul:
+                return "pl0_mul";
+            case BinaryExpression::Op::Div:
+                return "pl0_div";
+            case BinaryExpression::Op::Pow:
+                return "pl0_pow";
+            case BinaryExpression::Op::Shl:
+                return "pl0_shl";
+            default:
+                return nullptr;
+            }
+        }
+
+        std::string literal(int64_t value)
+        {
+            if (value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max())
+            {
+                return std::to_string(value);
+            }
+            if (value == std::numeric_limits<int64_t>::min())
+            {
+                return "INT64_MIN";
+            }
+            return "INT64_C(" + std::to_string(value) + ")";
+        }
+
+        // 数字和标识符的求值不会报错，与另一侧的求值顺序无关
+        bool leaf(const Expression &expr) noexcept
+        {
+            return expr.kind() == NodeKind::NumberExpression || expr.kind() == NodeKind::IdentifierExpression;
+        }
+
+        std::string frameType(size_t id)
+        {
+            return "struct f_" + std::to_string(id);
+        }
+    }
+
+    std::string CEmitter::emit(const Program &program)
+    {
+        structs_.clear();
+        prototypes_.clear();
+        functions_.clear();
+        body_.clear();
+        globals_.clear();
+        functions_by_frame_.clear();
+        level_ = 0;
+        frame_id_ = 0;
+        next_frame_ = 0;
+        var_count_ = 0;
+        temp_count_ = 0;
+        temp_depth_ = 0;
+        indent_ = 0;
+
+        walk(program);
+
+        std::string out = PRELUDE;
+        out += structs_;
+        out += prototypes_;
+        out += '\n';
+        out += functions_;
+
+        out += RUNNER;
+        out += "int main(void)\n{\n";
+        out += "    int64_t globals[" + std::to_string(std::max<size_t>(globals_.size(), 1)) + "];\n";
+        out += "    pl0_start(globals);\n";
+        for (size_t i = 0; i < globals_.size(); ++i)
+        {
+            out += "    printf(\"" + std::string(globals_[i]) + " = %lld\\n\", (long long)globals[" +
+                   std::to_string(i) + "]);\n";
+        }
+        out += "    return 0;\n}\n";
+        return out;
+    }
+
+    void CEmitter::visit(const Program &node)
+    {
+        symbols_.enterScope();
+        walk(node.block());
+        symbols_.leaveScope();
+    }
+
+    void CEmitter::visit(const Block &node)
+    {
+        size_t parent = frame_id_;
+        frame_id_ = next_frame_++;
+        functions_by_frame_.resize(next_frame_);
+        size_t saved_vars = std::exchange(var_count_, 0);
+        size_t saved_temps = std::exchange(temp_count_, 0);
+        std::string saved_body = std::exchange(body_, {});
+
+        for (const auto *decl : node.consts())
+        {
+            walk(*decl);
+        }
+
+        std::string fields;
+        if (level_ > 0)
+        {
+            fields += "    " + frameType(parent) + " *sl;\n";
+        }
+        for (const auto *decl : node.vars())
+        {
+            walk(*decl);
+            fields += "    int64_t v_" + std::string(decl->name()) + ";\n";
+        }
+        if (fields.empty())
+        {
+            fields = "    char unused;\n";
+        }
+        structs_ += frameType(frame_id_) + "\n{\n" + fields + "};\n\n";
+
+        for (const auto *decl : node.procedures())
+        {
+            walk(*decl);
+        }
+
+        std::string frame_size = std::to_string(FRAME_HEADER + var_count_);
+        std::string signature;
+        if (level_ == 0)
+        {
+            functions_by_frame_[frame_id_] = "pl0_run";
+            signature = "static void pl0_run(int64_t *globals)";
+        }
+        else
+        {
+            signature = "static void " + functions_by_frame_[frame_id_] + "(" + frameType(parent) + " *sl)";
+            prototypes_ += signature + ";\n";
+        }
+
+        indent_ = 1;
+        line() += frameType(frame_id_) + " f = {0};\n";
+        if (level_ > 0)
+        {
+            line() += "f.sl = sl;\n";
+        }
+        line() += "pl0_enter(" + frame_size + ");\n";
+        if (const CallStatement *call = level_ > 0 ? tailCall(node.statement()) : nullptr;
+            call && *resolve(call->symbol()).value == static_cast<int64_t>(frame_id_))
+        {
+            body_ += "pl0_tail:\n";
+        }
+        // 尾位置按语句在树中的位置逐层传递，不比较节点地址: 内联后同一个调用节点可能出现在多处
+        tail_ = level_ > 0;
+        walk(node.statement());
+        tail_ = false;
+        line() += "pl0_leave(" + frame_size + ");\n";
+        if (level_ == 0)
+        {
+            for (size_t i = 0; i < globals_.size(); ++i)
+            {
+                line() += "globals[" + std::to_string(i) + "] = f.v_" + std::string(globals_[i]) + ";\n";
+            }
+        }
+
+        std::string temps;
+        for (size_t i = 0; i < temp_count_; ++i)
+        {
+            temps += (i == 0 ? "    int64_t t" : ", t") + std::to_string(i);
+        }
+        if (!temps.empty())
+        {
+            temps += ";\n";
+        }
+        functions_ += signature + "\n{\n" + temps + body_ + "}\n\n";
+
+        body_ = std::move(saved_body);
+        var_count_ = saved_vars;
+        temp_count_ = saved_temps;
+        frame_id_ = parent;
+    }
+
+    void CEmitter::visit(const ConstDeclaration &node)
+    {
+        symbols_.declare(node.symbol(), Symbol{
+                                            .type = SymbolType::Constant,
+                                            .value = node.value(),
+                                            .level = level_,
+                                            .index = 0,
+                                            .name = node.symbol()});
+    }
+
+    void CEmitter::visit(const VarDeclaration &node)
+    {
+        if (level_ == 0 && !node.hidden())
+        {
+            globals_.push_back(node.name());
+        }
+        symbols_.declare(node.symbol(), Symbol{
+                                            .type = SymbolType::Variable,
+                                            .value = std::nullopt,
+                                            .level = level_,
+                                            .index = var_count_++,
+                                            .name = node.symbol()});
+    }
+
+    void CEmitter::visit(const ProcedureDeclaration &node)
+    {
+        // 过程体的帧结构体编号就是下一个编号，同名过程以编号区分
+        size_t id = next_frame_;
+        functions_by_frame_.resize(id + 1);
+        functions_by_frame_[id] = "p" + std::to_string(id) + "_" + std::string(node.name());
+        symbols_.declare(node.symbol(), Symbol{
+                                            .type = SymbolType::Procedure,
+                                            .value = static_cast<int64_t>(id),
+                                            .level = level_,
+                                            .index = 0,
+                                            .name = node.symbol()});
+
+        ++level_;
+        symbols_.enterScope();
+        walk(node.block());
+        symbols_.leaveScope();
+        --level_;
+    }
+
+    void CEmitter::visit(const AssignStatement &node)
+    {
+        line();
+        variable(resolve(node.symbol()), node.name());
+        body_ += " = ";
+        expression(node.expression());
+        body_ += ";\n";
+    }
+
+    void CEmitter::visit(const CallStatement &node)
+    {
+        const Symbol &symbol = resolve(node.symbol());
+        if (tail_ && *symbol.value == static_cast<int64_t>(frame_id_))
+        {
+            // 自身的静态外层就是当前帧的sl，只需清零变量
+            line() += "f = (" + frameType(frame_id_) + "){.sl = sl};\n";
+            line() += "goto pl0_tail;\n";
+            return;
+        }
+        line() += functions_by_frame_[static_cast<size_t>(*symbol.value)] + "(";
+        frameAt(level_ - symbol.level);
+        body_ += ");\n";
+    }
+
+    void CEmitter::visit(const BeginStatement &node)
+    {
+        bool tail = tail_;
+        const auto &statements = node.statements();
+        for (size_t i = 0; i < statements.size(); ++i)
+        {
+            tail_ = tail && i + 1 == statements.size();
+            walk(*statements[i]);
+        }
+        tail_ = tail;
+    }
+
+    void CEmitter::visit(const IfStatement &node)
+    {
+        line() += "if ";
+        condition(node.condition());
+        body_ += "\n";
+        open();
+        walk(node.thenStmt());
+        close();
+    }
+
+    void CEmitter::visit(const WhileStatement &node)
+    {
+        line() += "while ";
+        condition(node.condition());
+        body_ += "\n";
+        open();
+        bool tail = std::exchange(tail_, false);
+        walk(node.body());
+        tail_ = tail;
+        close();
+    }
+
+    void CEmitter::condition(const Expression &expr)
+    {
+        // 比较表达式自带括号，直接作为if/while的条件
+        if (expr.kind() == NodeKind::BinaryExpression &&
+            comparison(static_cast<const BinaryExpression &>(expr).op()))
+        {
+            expression(expr);
+            return;
+        }
+        body_ += "(";
+        expression(expr);
+        body_ += ")";
+    }
+
+    void CEmitter::expression(const Expression &expr)
+    {
+        pl0::visit(expr, [this](const auto &node)
+                   {
+            using Node = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<Node, NumberExpression>)
+            {
+                body_ += literal(node.value());
+            }
+            else if constexpr (std::is_same_v<Node, IdentifierExpression>)
+            {
+                const Symbol &symbol = resolve(node.symbol());
+                if (symbol.type == SymbolType::Constant)
+                {
+                    body_ += literal(*symbol.value);
+                }
+                else
+                {
+                    variable(symbol, node.name());
+                }
+            }
+            else if constexpr (std::is_same_v<Node, UnaryExpression>)
+            {
+                switch (node.op())
+                {
+                case UnaryExpression::Op::Neg:
+                    body_ += "pl0_neg(";
+                    expression(node.operand());
+                    body_ += ")";
+                    break;
+                case UnaryExpression::Op::Not:
+                    body_ += "(";
+                    expression(node.operand());
+                    body_ += " == 0)";
+                    break;
+                case UnaryExpression::Op::Odd:
+                    body_ += "(";
+                    expression(node.operand());
+                    body_ += " % 2 != 0)";
+                    break;
+                }
+            }
+            else
+            {
+                // C不规定运算数的求值顺序；两侧都可能报错时先把左侧存入临时变量，
+                // 以逗号运算符保证先左后右，报出的错误与虚拟机一致
+                std::string temp;
+                if (!leaf(node.left()) && !leaf(node.right()))
+                {
+                    temp = "t" + std::to_string(temp_depth_++);
+                    temp_count_ = std::max(temp_count_, temp_depth_);
+                    body_ += "(" + temp + " = ";
+                }
+                auto left = [&]
+                {
+                    if (temp.empty())
+                    {
+                        expression(node.left());
+                    }
+                    else
+                    {
+                        body_ += temp;
+                    }
+                };
+                if (!temp.empty())
+                {
+                    expression(node.left());
+                    body_ += ", ";
+                }
+
+                if (const char *op = comparison(node.op()))
+                {
+                    body_ += "(";
+                    left();
+                    body_ += op;
+                    expression(node.right());
+                    body_ += ")";
+                }
+                else
+                {
+                    body_ += helper(node.op());
+                    body_ += "(";
+                    left();
+                    body_ += ", ";
+                    expression(node.right());
+                    body_ += ")";
+                }
+                if (!temp.empty())
+                {
+                    body_ += ")";
+                    --temp_depth_;
+                }
+            } });
+    }
+
+    void CEmitter::variable(const Symbol &symbol, std::string_view name)
+    {
+        size_t distance = level_ - symbol.level;
+        body_ += "f.";
+        if (distance > 0)
+        {
+            body_ += "sl->";
+            for (size_t i = 1; i < distance; ++i)
+            {
+                body_ += "sl->";
+            }
+        }
+        body_ += "v_";
+        body_ += name;
+    }
+
+    void CEmitter::frameAt(size_t distance)
+    {
+        if (distance == 0)
+        {
+            body_ += "&f";
+            return;
+        }
+        body_ += "f.sl";
+        for (size_t i = 1; i < distance; ++i)
+        {
+            body_ += "->sl";
+        }
+    }
+
+    void CEmitter::open()
+    {
+        line() += "{\n";
+        ++indent_;
+    }
+
+    void CEmitter::close()
+    {
+        --indent_;
+        line() += "}\n";
+    }
+
+    std::string &CEmitter::line()
+    {
+        body_.append(indent_ * 4, ' ');
+        return body_;
+    }
+
+    const Symbol &CEmitter::resolve(SymbolId name) const
+    {
+        const Symbol *symbol = symbols_.lookup(name);
+        if (!symbol)
+        {
+            throw std::runtime_error("代码生成: 未解析的标识符");
+        }
+        return *symbol;
+    }
+
+} // namespace pl0
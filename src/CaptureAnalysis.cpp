@@ -0,0 +1,124 @@
+#include "../include/CaptureAnalysis.h"
+
+#include <utility>
+
+namespace pl0
+{
+
+    std::unordered_map<const Block *, std::vector<bool>> CaptureAnalysis::run(const Program &program)
+    {
+        symbols_ = SymbolTable{};
+        frames_.clear();
+        captured_.clear();
+        level_ = 0;
+        var_count_ = 0;
+        walk(program);
+        return std::move(captured_);
+    }
+
+    void CaptureAnalysis::visit(const Program &node)
+    {
+        symbols_.enterScope();
+        walk(node.block());
+        symbols_.leaveScope();
+    }
+
+    void CaptureAnalysis::visit(const Block &node)
+    {
+        size_t saved_var_count = std::exchange(var_count_, 0);
+        frames_.emplace_back(node.vars().size(), false);
+        for (const auto *decl : node.consts())
+        {
+            walk(*decl);
+        }
+        for (const auto *decl : node.vars())
+        {
+            walk(*decl);
+        }
+        for (const auto *decl : node.procedures())
+        {
+            walk(*decl);
+        }
+        walk(node.statement());
+        captured_[&node] = std::move(frames_.back());
+        frames_.pop_back();
+        var_count_ = saved_var_count;
+    }
+
+    void CaptureAnalysis::visit(const ConstDeclaration &node)
+    {
+        symbols_.declare(node.symbol(), Symbol{
+                                            .type = SymbolType::Constant,
+                                            .value = node.value(),
+                                            .level = level_,
+                                            .index = 0,
+                                            .name = node.symbol()});
+    }
+
+    void CaptureAnalysis::visit(const VarDeclaration &node)
+    {
+        symbols_.declare(node.symbol(), Symbol{
+                                            .type = SymbolType::Variable,
+                                            .value = std::nullopt,
+                                            .level = level_,
+                                            .index = var_count_++,
+                                            .name = node.symbol()});
+    }
+
+    void CaptureAnalysis::visit(const ProcedureDeclaration &node)
+    {
+        symbols_.declare(node.symbol(), Symbol{
+                                            .type = SymbolType::Procedure,
+                                            .value = std::nullopt,
+                                            .level = level_,
+                                            .index = 0,
+                                            .name = node.symbol()});
+        ++level_;
+        symbols_.enterScope();
+        walk(node.block());
+        symbols_.leaveScope();
+        --level_;
+    }
+
+    void CaptureAnalysis::visit(const AssignStatement &node)
+    {
+        reference(node.symbol());
+        walk(node.expression());
+    }
+
+    void CaptureAnalysis::visit(const BeginStatement &node)
+    {
+        for (const auto *stmt : node.statements())
+        {
+            walk(*stmt);
+        }
+    }
+
+    void CaptureAnalysis::visit(const IfStatement &node)
+    {
+        walk(node.condition());
+        walk(node.thenStmt());
+    }
+
+    void CaptureAnalysis::visit(const WhileStatement &node)
+    {
+        walk(node.condition());
+        walk(node.body());
+    }
+
+    void CaptureAnalysis::visit(const BinaryExpression &node)
+    {
+        walk(node.left());
+        walk(node.right());
+    }
+
+    void CaptureAnalysis::reference(SymbolId name)
+    {
+        const Symbol *symbol = symbols_.lookup(name);
+        if (symbol && symbol->type == SymbolType::Variable && symbol->level < level_)
+        {
+            frames_[symbol->level][symbol->index] = true;
+        }
+    }
+
+} // namespace pl0
@@ -0,0 +1,311 @@
+#include "../include/CharScanner.h"
+
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define PL0_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace pl0::scan
+{
+
+    namespace
+    {
+        constexpr size_t NPOS = std::string_view::npos;
+
+        // ---------------- 标量实现 ----------------
+
+        WhitespaceRun skipWhitespaceScalar(const char *data, size_t size, size_t pos,
+                                           WhitespaceRun run) noexcept
+        {
+            while (pos < size && is(data[pos], SPACE))
+            {
+                if (data[pos] == '\n')
+                {
+                    ++run.newlines;
+                    run.line_start = pos + 1;
+                }
+                ++pos;
+            }
+            run.end = pos;
+            return run;
+        }
+
+        size_t scanClassScalar(const char *data, size_t size, size_t pos, uint8_t mask) noexcept
+        {
+            while (pos < size && is(data[pos], mask))
+            {
+                ++pos;
+            }
+            return pos;
+        }
+
+        [[maybe_unused]] WhitespaceRun skipWhitespaceScalarEntry(std::string_view source, size_t pos) noexcept
+        {
+            return skipWhitespaceScalar(source.data(), source.size(), pos, {pos, 0, NPOS});
+        }
+
+        [[maybe_unused]] size_t scanIdentifierScalar(std::string_view source, size_t pos) noexcept
+        {
+            return scanClassScalar(source.data(), source.size(), pos, ALPHA | DIGIT);
+        }
+
+        [[maybe_unused]] size_t scanDigitsScalar(std::string_view source, size_t pos) noexcept
+        {
+            return scanClassScalar(source.data(), source.size(), pos, DIGIT);
+        }
+
+#ifdef PL0_SCAN_X86
+        // ---------------- SSE2实现(16字节/步) ----------------
+        // 所有关心的字符都在0x00-0x7F内，带符号比较下>=0x80的字节是负数，自然落在区间外
+
+        inline __m128i inRange128(__m128i x, char lo, char hi) noexcept
+        {
+            return _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                                 _mm_cmplt_epi8(x, _mm_set1_epi8(static_cast<char>(hi + 1))));
+        }
+
+        inline uint32_t spaceMask128(__m128i x) noexcept
+        {
+            __m128i space = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')), inRange128(x, '\t', '\r'));
+            return static_cast<uint32_t>(_mm_movemask_epi8(space));
+        }
+
+        inline uint32_t newlineMask128(__m128i x) noexcept
+        {
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8('\n'))));
+        }
+
+        inline uint32_t alnumMask128(__m128i x) noexcept
+        {
+            __m128i lower = _mm_or_si128(x, _mm_set1_epi8(0x20));
+            __m128i alnum = _mm_or_si128(inRange128(lower, 'a', 'z'), inRange128(x, '0', '9'));
+            return static_cast<uint32_t>(_mm_movemask_epi8(alnum));
+        }
+
+        inline uint32_t digitMask128(__m128i x) noexcept
+        {
+            return static_cast<uint32_t>(_mm_movemask_epi8(inRange128(x, '0', '9')));
+        }
+
+        WhitespaceRun skipWhitespaceSse2(std::string_view source, size_t pos) noexcept
+        {
+            const char *data = source.data();
+            size_t size = source.size();
+            WhitespaceRun run{pos, 0, NPOS};
+
+            while (pos + 16 <= size)
+            {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+                uint32_t stop = ~spaceMask128(x) & 0xFFFFu;
+                uint32_t newlines = newlineMask128(x);
+                if (stop != 0)
+                {
+                    // 只统计第一个非空白字符之前的换行
+                    newlines &= (1u << std::countr_zero(stop)) - 1;
+                }
+                if (newlines != 0)
+                {
+                    run.newlines += static_cast<size_t>(std::popcount(newlines));
+                    run.line_start = pos + (31 - static_cast<size_t>(std::countl_zero(newlines))) + 1;
+                }
+                if (stop != 0)
+                {
+                    run.end = pos + static_cast<size_t>(std::countr_zero(stop));
+                    return run;
+                }
+                pos += 16;
+            }
+            return skipWhitespaceScalar(data, size, pos, run);
+        }
+
+        size_t scanIdentifierSse2(std::string_view source, size_t pos) noexcept
+        {
+            const char *data = source.data();
+            size_t size = source.size();
+            while (pos + 16 <= size)
+            {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+                uint32_t stop = ~alnumMask128(x) & 0xFFFFu;
+                if (stop != 0)
+                {
+                    return pos + static_cast<size_t>(std::countr_zero(stop));
+                }
+                pos += 16;
+            }
+            return scanClassScalar(data, size, pos, ALPHA | DIGIT);
+        }
+
+        size_t scanDigitsSse2(std::string_view source, size_t pos) noexcept
+        {
+            const char *data = source.data();
+            size_t size = source.size();
+            while (pos + 16 <= size)
+            {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+                uint32_t stop = ~digitMask128(x) & 0xFFFFu;
+                if (stop != 0)
+                {
+                    return pos + static_cast<size_t>(std::countr_zero(stop));
+                }
+                pos += 16;
+            }
+            return scanClassScalar(data, size, pos, DIGIT);
+        }
+
+        // ---------------- AVX2实现(32字节/步) ----------------
+
+#define PL0_AVX2 __attribute__((target("avx2")))
+
+        PL0_AVX2 inline __m256i inRange256(__m256i x, char lo, char hi) noexcept
+        {
+            return _mm256_and_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8(static_cast<char>(lo - 1))),
+                                    _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), x));
+        }
+
+        PL0_AVX2 inline uint32_t spaceMask256(__m256i x) noexcept
+        {
+            __m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')), inRange256(x, '\t', '\r'));
+            return static_cast<uint32_t>(_mm256_movemask_epi8(space));
+        }
+
+        PL0_AVX2 inline uint32_t newlineMask256(__m256i x) noexcept
+        {
+            return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n'))));
+        }
+
+        PL0_AVX2 inline uint32_t alnumMask256(__m256i x) noexcept
+        {
+            __m256i lower = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+            __m256i alnum = _mm256_or_si256(inRange256(lower, 'a', 'z'), inRange256(x, '0', '9'));
+            return static_cast<uint32_t>(_mm256_movemask_epi8(alnum));
+        }
+
+        PL0_AVX2 inline uint32_t digitMask256(__m256i x) noexcept
+        {
+            return static_cast<uint32_t>(_mm256_movemask_epi8(inRange256(x, '0', '9')));
+        }
+
+        PL0_AVX2 WhitespaceRun skipWhitespaceAvx2(std::string_view source, size_t pos) noexcept
+        {
+            const char *data = source.data();
+            size_t size = source.size();
+            WhitespaceRun run{pos, 0, NPOS};
+
+            while (pos + 32 <= size)
+            {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos));
+                uint32_t stop = ~spaceMask256(x);
+                uint32_t newlines = newlineMask256(x);
+                if (stop != 0)
+                {
+                    int first = std::countr_zero(stop);
+                    newlines &= first == 0 ? 0u : (0xFFFFFFFFu >> (32 - first));
+                }
+                if (newlines != 0)
+                {
+                    run.newlines += static_cast<size_t>(std::popcount(newlines));
+                    run.line_start = pos + (31 - static_cast<size_t>(std::countl_zero(newlines))) + 1;
+                }
+                if (stop != 0)
+                {
+                    run.end = pos + static_cast<size_t>(std::countr_zero(stop));
+                    return run;
+                }
+                pos += 32;
+            }
+            return skipWhitespaceScalar(data, size, pos, run);
+        }
+
+        PL0_AVX2 size_t scanIdentifierAvx2(std::string_view source, size_t pos) noexcept
+        {
+            const char *data = source.data();
+            size_t size = source.size();
+            while (pos + 32 <= size)
+            {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos));
+                uint32_t stop = ~alnumMask256(x);
+                if (stop != 0)
+                {
+                    return pos + static_cast<size_t>(std::countr_zero(stop));
+                }
+                pos += 32;
+            }
+            return scanClassScalar(data, size, pos, ALPHA | DIGIT);
+        }
+
+        PL0_AVX2 size_t scanDigitsAvx2(std::string_view source, size_t pos) noexcept
+        {
+            const char *data = source.data();
+            size_t size = source.size();
+            while (pos + 32 <= size)
+            {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos));
+                uint32_t stop = ~digitMask256(x);
+                if (stop != 0)
+                {
+                    return pos + static_cast<size_t>(std::countr_zero(stop));
+                }
+                pos += 32;
+            }
+            return scanClassScalar(data, size, pos, DIGIT);
+        }
+
+#undef PL0_AVX2
+#endif // PL0_SCAN_X86
+
+        // ---------------- 运行时分派 ----------------
+
+        struct Backend
+        {
+            std::string_view name;
+            WhitespaceRun (*skipWhitespace)(std::string_view, size_t) noexcept;
+            size_t (*scanIdentifier)(std::string_view, size_t) noexcept;
+            size_t (*scanDigits)(std::string_view, size_t) noexcept;
+        };
+
+        Backend selectBackend() noexcept
+        {
+#ifdef PL0_SCAN_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+            {
+                return {"avx2", skipWhitespaceAvx2, scanIdentifierAvx2, scanDigitsAvx2};
+            }
+            return {"sse2", skipWhitespaceSse2, scanIdentifierSse2, scanDigitsSse2};
+#else
+            return {"scalar", skipWhitespaceScalarEntry, scanIdentifierScalar, scanDigitsScalar};
+#endif
+        }
+
+        // 静态初始化时选定一次，之后每次调用只有一次间接跳转
+        const Backend BACKEND = selectBackend();
+
+        const Backend &backend() noexcept
+        {
+            return BACKEND;
+        }
+    }
+
+    WhitespaceRun skipWhitespace(std::string_view source, size_t pos) noexcept
+    {
+        return backend().skipWhitespace(source, pos);
+    }
+
+    size_t scanIdentifier(std::string_view source, size_t pos) noexcept
+    {
+        return backend().scanIdentifier(source, pos);
+    }
+
+    size_t scanDigits(std::string_view source, size_t pos) noexcept
+    {
+        return backend().scanDigits(source, pos);
+    }
+
+    std::string_view backendName() noexcept
+    {
+        return backend().name;
+    }
+
+} // namespace pl0::scan
@@ -0,0 +1,293 @@
+#include "../include/CodeGenerator.h"
+
+#include <limits>
+#include <utility>
+#include <stdexcept>
+
+namespace pl0
+{
+
+    PCode CodeGenerator::generate(const Program &program)
+    {
+        program_ = PCode{};
+        program_.procedures.push_back(ProcedureInfo{.name = {}, .entry = 0, .level = 0, .frame_size = 0});
+        level_ = 0;
+        var_count_ = 0;
+        procedure_ = 0;
+        walk(program);
+        return std::move(program_);
+    }
+
+    void CodeGenerator::visit(const Program &node)
+    {
+        symbols_.enterScope();
+        walk(node.block());
+        symbols_.leaveScope();
+    }
+
+    void CodeGenerator::visit(const Block &node)
+    {
+        size_t saved_var_count = var_count_;
+        var_count_ = 0;
+
+        for (const auto *decl : node.consts())
+        {
+            walk(*decl);
+        }
+        for (const auto *decl : node.vars())
+        {
+            walk(*decl);
+        }
+
+        // 嵌套过程的代码放在本块语句之前，需要一条跳过它们的JMP
+        size_t jump = 0;
+        if (!node.procedures().empty())
+        {
+            jump = emit(OpCode::JMP, 0, 0);
+            for (const auto *decl : node.procedures())
+            {
+                walk(*decl);
+            }
+            patch(jump, here());
+        }
+
+        // INT前面是嵌套过程的代码，单独登记位置，序言中的栈溢出才不会定位到上一个过程里
+        if (declaration_)
+        {
+            mark(declaration_->line(), declaration_->column());
+        }
+        else
+        {
+            mark(node.statement());
+        }
+        program_.procedures[procedure_].frame_size = FRAME_HEADER + static_cast<int64_t>(var_count_);
+        emit(OpCode::INT, 0, FRAME_HEADER + static_cast<int64_t>(var_count_));
+        walk(node.statement());
+        emit(Opr::RET);
+
+        var_count_ = saved_var_count;
+    }
+
+    void CodeGenerator::visit(const ConstDeclaration &node)
+    {
+        program_.constants.push_back(ConstantInfo{.name = node.name(), .value = node.value()});
+        symbols_.declare(node.symbol(), Symbol{
+                                            .type = SymbolType::Constant,
+                                            .value = node.value(),
+                                            .level = level_,
+                                            .index = 0,
+                                            .name = node.symbol()});
+    }
+
+    void CodeGenerator::visit(const VarDeclaration &node)
+    {
+        if (level_ == 0 && !node.hidden())
+        {
+            program_.globals.push_back(node.name());
+        }
+        symbols_.declare(node.symbol(), Symbol{
+                                            .type = SymbolType::Variable,
+                                            .value = std::nullopt,
+                                            .level = level_,
+                                            .index = var_count_++,
+                                            .name = node.symbol()});
+    }
+
+    void CodeGenerator::visit(const ProcedureDeclaration &node)
+    {
+        // 入口先登记，过程体内可以递归调用自己
+        symbols_.declare(node.symbol(), Symbol{
+                                            .type = SymbolType::Procedure,
+                                            .value = static_cast<int64_t>(here()),
+                                            .level = level_,
+                                            .index = 0,
+                                            .name = node.symbol()});
+
+        size_t saved_procedure = procedure_;
+        const ProcedureDeclaration *saved_declaration = std::exchange(declaration_, &node);
+        procedure_ = program_.procedures.size();
+        program_.procedures.push_back(ProcedureInfo{.name = node.name(),
+                                                    .entry = static_cast<uint32_t>(here()),
+                                                    .level = static_cast<uint32_t>(level_ + 1),
+                                                    .frame_size = 0});
+
+        ++level_;
+        symbols_.enterScope();
+        walk(node.block());
+        symbols_.leaveScope();
+        --level_;
+        procedure_ = saved_procedure;
+        declaration_ = saved_declaration;
+    }
+
+    void CodeGenerator::visit(const AssignStatement &node)
+    {
+        mark(node);
+        const Symbol &symbol = resolve(node.symbol());
+        walk(node.expression());
+        emit(OpCode::STO, levelDistance(symbol), FRAME_HEADER + static_cast<int64_t>(symbol.index));
+    }
+
+    void CodeGenerator::visit(const CallStatement &node)
+    {
+        mark(node);
+        const Symbol &symbol = resolve(node.symbol());
+        emit(OpCode::CAL, levelDistance(symbol), *symbol.value);
+    }
+
+    void CodeGenerator::visit(const BeginStatement &node)
+    {
+        for (const auto *stmt : node.statements())
+        {
+            walk(*stmt);
+        }
+    }
+
+    void CodeGenerator::visit(const IfStatement &node)
+    {
+        mark(node);
+        walk(node.condition());
+        size_t skip = emit(OpCode::JPC, 0, 0);
+        walk(node.thenStmt());
+        patch(skip, here());
+    }
+
+    void CodeGenerator::visit(const WhileStatement &node)
+    {
+        mark(node);
+        size_t head = here();
+        program_.loops.push_back(static_cast<uint32_t>(head));
+        walk(node.condition());
+        size_t exit = emit(OpCode::JPC, 0, 0);
+        walk(node.body());
+        emit(OpCode::JMP, 0, static_cast<int64_t>(head));
+        patch(exit, here());
+    }
+
+    void CodeGenerator::visit(const BinaryExpression &node)
+    {
+        walk(node.left());
+        walk(node.right());
+
+        switch (node.op())
+        {
+        case BinaryExpression::Op::Add:
+            emit(Opr::ADD);
+            break;
+        case BinaryExpression::Op::Sub:
+            emit(Opr::SUB);
+            break;
+        case BinaryExpression::Op::Mul:
+            emit(Opr::MUL);
+            break;
+        case BinaryExpression::Op::Div:
+            emit(Opr::DIV);
+            break;
+        case BinaryExpression::Op::Pow:
+            emit(Opr::POW);
+            break;
+        case BinaryExpression::Op::Shl:
+            emit(Opr::SHL);
+            break;
+        case BinaryExpression::Op::Eq:
+            emit(Opr::EQ);
+            break;
+        case BinaryExpression::Op::Neq:
+            emit(Opr::NEQ);
+            break;
+        case BinaryExpression::Op::Lt:
+            emit(Opr::LT);
+            break;
+        case BinaryExpression::Op::Lte:
+            emit(Opr::LTE);
+            break;
+        case BinaryExpression::Op::Gt:
+            emit(Opr::GT);
+            break;
+        case BinaryExpression::Op::Gte:
+            emit(Opr::GTE);
+            break;
+        }
+    }
+
+    void CodeGenerator::visit(const UnaryExpression &node)
+    {
+        walk(node.operand());
+
+        switch (node.op())
+        {
+        case UnaryExpression::Op::Neg:
+            emit(Opr::NEG);
+            break;
+        case UnaryExpression::Op::Not:
+            emit(Opr::NOT);
+            break;
+        case UnaryExpression::Op::Odd:
+            emit(Opr::ODD);
+            break;
+        }
+    }
+
+    void CodeGenerator::visit(const NumberExpression &node)
+    {
+        emit(OpCode::LIT, 0, node.value());
+    }
+
+    void CodeGenerator::visit(const IdentifierExpression &node)
+    {
+        const Symbol &symbol = resolve(node.symbol());
+        if (symbol.type == SymbolType::Constant)
+        {
+            emit(OpCode::LIT, 0, *symbol.value);
+            return;
+        }
+        emit(OpCode::LOD, levelDistance(symbol), FRAME_HEADER + static_cast<int64_t>(symbol.index));
+    }
+
+    size_t CodeGenerator::emit(OpCode op, uint8_t level, int64_t argument)
+    {
+        program_.code.push_back(Instruction{op, level, argument});
+        return program_.code.size() - 1;
+    }
+
+    void CodeGenerator::patch(size_t at, size_t target)
+    {
+        program_.code[at].argument = static_cast<int64_t>(target);
+    }
+
+    void CodeGenerator::mark(size_t line, size_t column)
+    {
+        SourceLine entry{static_cast<uint32_t>(here()), static_cast<uint32_t>(line),
+                         static_cast<uint32_t>(column)};
+        auto &positions = program_.positions;
+        if (!positions.empty() && positions.back().address == entry.address)
+        {
+            positions.back() = entry; // 前一条语句没有生成指令
+        }
+        else
+        {
+            positions.push_back(entry);
+        }
+    }
+
+    const Symbol &CodeGenerator::resolve(SymbolId name) const
+    {
+        const Symbol *symbol = symbols_.lookup(name);
+        if (!symbol)
+        {
+            throw std::runtime_error("代码生成: 未解析的标识符");
+        }
+        return *symbol;
+    }
+
+    uint8_t CodeGenerator::levelDistance(const Symbol &symbol) const
+    {
+        size_t distance = level_ - symbol.level;
+        if (distance > std::numeric_limits<uint8_t>::max())
+        {
+            throw std::runtime_error("代码生成: 过程嵌套层数过深");
+        }
+        return static_cast<uint8_t>(distance);
+    }
+
+} // namespace pl0
@@ -1,13 +1,34 @@
 #include "../include/Compiler.h"
+#include "../include/CharScanner.h"
 
+#include <chrono>
 #include <sstream>
 #include <fstream>
+#include <stdexcept>
+#include <sys/resource.h>
 
 namespace pl0
 {
 
     namespace
     {
+        using Clock = std::chrono::steady_clock;
+
+        double secondsSince(Clock::time_point start)
+        {
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+        long peakRssKB()
+        {
+            struct rusage usage{};
+            if (::getrusage(RUSAGE_SELF, &usage) != 0)
+            {
+                return 0;
+            }
+            return usage.ru_maxrss;
+        }
+
         struct TokenTypeInfo
         {
             std::string_view cn;
@@ -93,47 +114,62 @@ namespace pl0
 
     Compiler::Result Compiler::compileFile(const std::filesystem::path &path)
     {
-        std::ifstream file(path);
-        if (!file)
+        return compileFile(path, Options{});
+    }
+
+    Compiler::Result Compiler::compileFile(const std::filesystem::path &path, const Options &options)
+    {
+        auto load_start = Clock::now();
+        auto source = SourceBuffer::open(path);
+        if (!source)
         {
             return Result{false, {std::string("无法打开文件: ") + path.string()}};
         }
+        double load_seconds = secondsSince(load_start);
 
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        return compileString(buffer.str());
+        auto result = compileString(source->view(), options);
+        result.stats.sourceMapped = source->mapped();
+        result.stats.loadSeconds = load_seconds;
+        result.source = std::move(*source);
+        return result;
     }
 
     Compiler::Result Compiler::compileString(std::string_view source)
+    {
+        return compileString(source, Options{});
+    }
+
+    Compiler::Result Compiler::compileString(std::string_view source, const Options &options)
     {
         Result result{true};
+        result.stats.sourceBytes = source.size();
 
         try
         {
-            // 词法分析
-            TokenInterpreter lexer{source};
-            std::vector<Token> tokens;
-
-            while (true)
+            // 词法分析：只扫描一次，Parser直接消费同一个Token缓冲区
+            auto lex_start = Clock::now();
+            TokenInterpreter lexer{source, result.symbols};
+            result.tokens = lexer.tokenize();
+            result.stats.lexSeconds = secondsSince(lex_start);
+            result.stats.tokenCount = result.tokens.size();
+            result.stats.tokenBytes = result.tokens.memoryBytes();
+            if (result.tokens.backType() == TokenType::ERROR)
             {
-                auto token = lexer.nextToken();
-                if (token.type() == TokenType::ERROR)
-                {
-                    result.success = false;
-                    result.errors.push_back("词法分析错误");
-                    return result;
-                }
-                tokens.push_back(token);
-                if (token.type() == TokenType::END_OF_FILE)
-                {
-                    break;
-                }
+                result.success = false;
+                result.errors.push_back("词法分析错误");
+                return result;
             }
-            result.tokens = std::move(tokens);
 
             // 语法分析
-            Parser parser{TokenInterpreter{source}};
+            auto parse_start = Clock::now();
+            Parser parser{result.tokens};
             result.ast = parser.parse();
+            result.stats.parseSeconds = secondsSince(parse_start);
+            if (result.ast)
+            {
+                result.stats.astBytes = result.ast->arena().bytesUsed();
+                result.stats.astReservedBytes = result.ast->arena().bytesReserved();
+            }
             if (!result.ast)
             {
                 result.success = false;
@@ -142,13 +178,53 @@ namespace pl0
             }
 
             // 语义分析
+            auto semantic_start = Clock::now();
             SemanticAnalyzer analyzer;
-            if (!analyzer.analyze(*result.ast))
+            bool analyzed = analyzer.analyze(*result.ast);
+            result.stats.semanticSeconds = secondsSince(semantic_start);
+            result.semanticInfo = analyzer.getInfo();
+            if (!analyzed)
             {
                 result.success = false;
                 result.errors = analyzer.getErrors();
             }
-            result.semanticInfo = analyzer.getInfo();
+            else
+            {
+                // AST上的优化
+                auto optimize_start = Clock::now();
+                if (options.inlining)
+                {
+                    Inliner inliner(result.symbols, options.inlineBudget);
+                    result.ast = inliner.run(std::move(result.ast));
+                    result.inlining = inliner.decisions();
+                }
+                if (options.folding)
+                {
+                    ConstantFolder folder;
+                    result.ast = folder.run(std::move(result.ast));
+                    result.folding = folder.diagnostics();
+                }
+                if (options.deadCode)
+                {
+                    DeadCodeEliminator eliminator;
+                    result.ast = eliminator.run(std::move(result.ast));
+                    result.deadCode = eliminator.reports();
+                }
+                if (options.hoisting)
+                {
+                    LoopInvariantHoister hoister(result.symbols);
+                    result.ast = hoister.run(std::move(result.ast));
+                    result.hoisting = hoister.reports();
+                }
+                result.stats.optimizeSeconds = secondsSince(optimize_start);
+
+                // 代码生成
+                auto codegen_start = Clock::now();
+                CodeGenerator generator;
+                result.code = generator.generate(*result.ast);
+                result.stats.codegenSeconds = secondsSince(codegen_start);
+                result.stats.instructionCount = result.code.code.size();
+            }
         }
         catch (const std::exception &e)
         {
@@ -156,9 +232,20 @@ namespace pl0
             result.errors.push_back(e.what());
         }
 
+        result.stats.peakRssKB = peakRssKB();
         return result;
     }
 
+    void Compiler::writeImage(const Result &result, const std::filesystem::path &source,
+                              const std::filesystem::path &image)
+    {
+        if (!result.success || result.code.empty())
+        {
+            throw std::runtime_error("生成预编译文件: 没有可执行的代码");
+        }
+        PCodeImage::write(result.code, PCodeImage::stamp(source, result.source.view()), image);
+    }
+
     void Compiler::outputResults(const Result &result, const std::filesystem::path &outputDir)
     {
         std::filesystem::create_directories(outputDir);
@@ -167,15 +254,17 @@ namespace pl0
             std::ofstream file(outputDir / "tokens.txt");
             file << "Lexical Analysis Result:\n";
             file << "=======================\n\n";
-            for (const auto &token : result.tokens)
+            const auto &tokens = result.tokens;
+            size_t number = 0;
+            for (size_t i = 0; i < tokens.size(); ++i)
             {
-                switch (token.type())
+                switch (tokens.type(i))
                 {
                 case TokenType::NUMBER:
-                    file << token.value<int64_t>() << ": Number\n";
+                    file << tokens.numbers()[number++] << ": Number\n";
                     break;
                 case TokenType::IDENTIFIER:
-                    file << token.value<std::string_view>() << ": Identifier\n";
+                    file << tokens.text(i) << ": Identifier\n";
                     break;
                 case TokenType::CONST:
                     file << "const: Keyword\n";
@@ -284,7 +373,7 @@ namespace pl0
             if (result.ast)
             {
                 ASTPrinter printer(file);
-                result.ast->accept(printer);
+                printer.walk(*result.ast);
             }
             else
             {
@@ -321,6 +410,16 @@ namespace pl0
             }
         }
 
+        if (!result.code.empty())
+        {
+            std::ofstream file(outputDir / "pcode.txt");
+            file << "P-Code:\n";
+            file << "=======\n\n";
+            disassemble(result.code, file);
+        }
+
+        outputStats(result.stats, outputDir / "stats.txt");
+
         if (!result.errors.empty())
         {
             std::ofstream file(outputDir / "errors.txt");
@@ -333,4 +432,26 @@ namespace pl0
         }
     }
 
-} // namespace pl0
\ No newline at end of file
+    void Compiler::outputStats(const Stats &stats, const std::filesystem::path &path)
+    {
+        std::ofstream file(path);
+        file << "Compile Statistics:\n";
+        file << "==================\n\n";
+        file << "Source bytes:     " << stats.sourceBytes << '\n';
+        file << "Source loading:   " << (stats.sourceMapped ? "mmap" : "read") << ", "
+             << stats.loadSeconds * 1000.0 << " ms\n";
+        file << "Tokens:           " << stats.tokenCount << '\n';
+        file << "Token memory:     " << stats.tokenBytes << " bytes\n";
+        file << "Scanner backend:  " << scan::backendName() << '\n';
+        file << "Lex time:         " << stats.lexSeconds * 1000.0 << " ms\n";
+        file << "Lex throughput:   " << stats.lexThroughputMBps() << " MB/s\n";
+        file << "Parse time:       " << stats.parseSeconds * 1000.0 << " ms\n";
+        file << "AST memory:       " << stats.astBytes << " bytes (" << stats.astReservedBytes << " reserved)\n";
+        file << "Semantic time:    " << stats.semanticSeconds * 1000.0 << " ms\n";
+        file << "Optimize time:    " << stats.optimizeSeconds * 1000.0 << " ms\n";
+        file << "Instructions:     " << stats.instructionCount << '\n';
+        file << "Codegen time:     " << stats.codegenSeconds * 1000.0 << " ms\n";
+        file << "Peak RSS:         " << stats.peakRssKB << " KB\n";
+    }
+
+} // namespace pl0
@@ -0,0 +1,302 @@
+#include "../include/ConstantFolder.h"
+#include "../include/Arith.h"
+
+#include <limits>
+
+namespace pl0
+{
+
+    std::unique_ptr<Program> ConstantFolder::run(std::unique_ptr<Program> program)
+    {
+        scope_ = SymbolTable{};
+        folded_.clear();
+        diagnostics_.clear();
+        scope_.enterScope();
+        auto result = transform(std::move(program));
+        scope_.leaveScope();
+        return result;
+    }
+
+    std::string ConstantFolder::describe(const Diagnostic &diagnostic)
+    {
+        std::string text = "行" + std::to_string(diagnostic.line) + "列" + std::to_string(diagnostic.column) + " ";
+        switch (diagnostic.kind)
+        {
+        case Diagnostic::Kind::Folded:
+            return text + "常量表达式折叠为 " + std::to_string(diagnostic.value);
+        case Diagnostic::Kind::Overflow:
+            return text + "常量表达式溢出, 按64位回绕折叠为 " + std::to_string(diagnostic.value);
+        case Diagnostic::Kind::NegativeExponent:
+            return text + "常量指数为负(" + std::to_string(diagnostic.value) + "), 保留到运行时报错";
+        }
+        return text;
+    }
+
+    std::optional<ConstantFolder::Value> ConstantFolder::evaluate(BinaryExpression::Op op, int64_t lhs,
+                                                                  int64_t rhs) noexcept
+    {
+        using Op = BinaryExpression::Op;
+        Value result{0, false};
+        switch (op)
+        {
+        case Op::Add:
+            result.overflow = arith::addOverflow(lhs, rhs, result.value);
+            break;
+        case Op::Sub:
+            result.overflow = arith::subOverflow(lhs, rhs, result.value);
+            break;
+        case Op::Mul:
+            result.overflow = arith::mulOverflow(lhs, rhs, result.value);
+            break;
+        case Op::Div:
+            if (rhs == 0)
+            {
+                return std::nullopt;
+            }
+            result.value = arith::div(lhs, rhs);
+            result.overflow = rhs == -1 && lhs == std::numeric_limits<int64_t>::min();
+            break;
+        case Op::Pow:
+        {
+            if (rhs < 0)
+            {
+                return std::nullopt;
+            }
+            result.overflow = arith::powOverflow(lhs, rhs, result.value);
+            break;
+        }
+        case Op::Shl:
+        {
+            if (rhs < 0)
+            {
+                return std::nullopt;
+            }
+            result.overflow = arith::shlOverflow(lhs, rhs, result.value);
+            break;
+        }
+        case Op::Eq:
+            result.value = lhs == rhs;
+            break;
+        case Op::Neq:
+            result.value = lhs != rhs;
+            break;
+        case Op::Lt:
+            result.value = lhs < rhs;
+            break;
+        case Op::Lte:
+            result.value = lhs <= rhs;
+            break;
+        case Op::Gt:
+            result.value = lhs > rhs;
+            break;
+        case Op::Gte:
+            result.value = lhs >= rhs;
+            break;
+        }
+        return result;
+    }
+
+    ConstantFolder::Value ConstantFolder::evaluate(UnaryExpression::Op op, int64_t operand) noexcept
+    {
+        switch (op)
+        {
+        case UnaryExpression::Op::Neg:
+        {
+            Value result{0, false};
+            result.overflow = arith::subOverflow(0, operand, result.value);
+            return result;
+        }
+        case UnaryExpression::Op::Not:
+            return Value{operand == 0, false};
+        case UnaryExpression::Op::Odd:
+            return Value{operand % 2 != 0, false};
+        }
+        return Value{0, false};
+    }
+
+    const Block *ConstantFolder::transform(const Block &node)
+    {
+        scope_.enterScope();
+        for (const auto *decl : node.consts())
+        {
+            scope_.declare(decl->symbol(), Symbol{
+                                               .type = SymbolType::Constant,
+                                               .value = decl->value(),
+                                               .level = 0,
+                                               .index = 0,
+                                               .name = decl->symbol()});
+        }
+        // 变量只用于遮蔽外层的同名常量
+        for (const auto *decl : node.vars())
+        {
+            scope_.declare(decl->symbol(), Symbol{
+                                               .type = SymbolType::Variable,
+                                               .value = std::nullopt,
+                                               .level = 0,
+                                               .index = 0,
+                                               .name = decl->symbol()});
+        }
+        const Block *block = ASTTransformer::transform(node);
+        scope_.leaveScope();
+        return block;
+    }
+
+    const Statement *ConstantFolder::transform(const AssignStatement &node)
+    {
+        line_ = node.line();
+        column_ = node.column();
+        return ASTTransformer::transform(node);
+    }
+
+    const Statement *ConstantFolder::transform(const IfStatement &node)
+    {
+        // 条件先于分支变换，此后分支中的语句各自更新位置
+        line_ = node.line();
+        column_ = node.column();
+        return ASTTransformer::transform(node);
+    }
+
+    const Statement *ConstantFolder::transform(const WhileStatement &node)
+    {
+        line_ = node.line();
+        column_ = node.column();
+        return ASTTransformer::transform(node);
+    }
+
+    const Expression *ConstantFolder::transform(const BinaryExpression &node)
+    {
+        if (auto it = folded_.find(&node); it != folded_.end())
+        {
+            return it->second;
+        }
+
+        size_t mark = diagnostics_.size();
+        const Expression *left = rewrite(node.left());
+        const Expression *right = rewrite(node.right());
+        const Expression *result = nullptr;
+        if (left->kind() == NodeKind::NumberExpression && right->kind() == NodeKind::NumberExpression)
+        {
+            int64_t lhs = static_cast<const NumberExpression *>(left)->value();
+            int64_t rhs = static_cast<const NumberExpression *>(right)->value();
+            if (auto value = evaluate(node.op(), lhs, rhs))
+            {
+                result = fold(node, *value, mark);
+            }
+            else if (node.op() == BinaryExpression::Op::Pow)
+            {
+                diagnostics_.push_back(Diagnostic{Diagnostic::Kind::NegativeExponent, line_, column_, rhs});
+            }
+        }
+        else
+        {
+            result = reduce(node, left, right);
+        }
+        if (!result)
+        {
+            result = left == &node.left() && right == &node.right()
+                         ? &node
+                         : make<BinaryExpression>(node, left, node.op(), right);
+        }
+        folded_.emplace(&node, result);
+        return result;
+    }
+
+    const Expression *ConstantFolder::transform(const UnaryExpression &node)
+    {
+        if (auto it = folded_.find(&node); it != folded_.end())
+        {
+            return it->second;
+        }
+
+        size_t mark = diagnostics_.size();
+        const Expression *operand = rewrite(node.operand());
+        const Expression *result = nullptr;
+        if (operand->kind() == NodeKind::NumberExpression)
+        {
+            result = fold(node, evaluate(node.op(), static_cast<const NumberExpression *>(operand)->value()), mark);
+        }
+        else
+        {
+            result = operand == &node.operand() ? &node : make<UnaryExpression>(node, node.op(), operand);
+        }
+        folded_.emplace(&node, result);
+        return result;
+    }
+
+    const Expression *ConstantFolder::transform(const IdentifierExpression &node)
+    {
+        const Symbol *symbol = scope_.lookup(node.symbol());
+        if (symbol && symbol->type == SymbolType::Constant)
+        {
+            return make<NumberExpression>(node, *symbol->value);
+        }
+        return &node;
+    }
+
+    const Expression *ConstantFolder::reduce(const BinaryExpression &node, const Expression *left,
+                                             const Expression *right)
+    {
+        using Op = BinaryExpression::Op;
+        auto number = [](const Expression *expr, int64_t value)
+        {
+            return expr->kind() == NodeKind::NumberExpression &&
+                   static_cast<const NumberExpression *>(expr)->value() == value;
+        };
+        // 1 << e，即强度削弱后的2^e
+        auto power_of_two = [&number](const Expression *expr) -> const Expression *
+        {
+            if (expr->kind() != NodeKind::BinaryExpression)
+            {
+                return nullptr;
+            }
+            const auto *binary = static_cast<const BinaryExpression *>(expr);
+            return binary->op() == Op::Shl && number(&binary->left(), 1) ? &binary->right() : nullptr;
+        };
+        auto leaf = [](const Expression *expr)
+        {
+            return expr->kind() == NodeKind::NumberExpression || expr->kind() == NodeKind::IdentifierExpression;
+        };
+
+        switch (node.op())
+        {
+        case Op::Pow:
+            if (number(left, 2))
+            {
+                return make<BinaryExpression>(node, make<NumberExpression>(*left, 1), Op::Shl, right);
+            }
+            // 叶子重复求值没有代价，也不会改变报错的顺序
+            if (number(right, 2) && leaf(left))
+            {
+                return make<BinaryExpression>(node, left, Op::Mul, left);
+            }
+            return nullptr;
+        case Op::Mul:
+            if (const Expression *exponent = power_of_two(right))
+            {
+                return make<BinaryExpression>(node, left, Op::Shl, exponent);
+            }
+            // 交换后先求值的变为right，只在它是叶子时交换
+            if (const Expression *exponent = power_of_two(left); exponent && leaf(right))
+            {
+                return make<BinaryExpression>(node, right, Op::Shl, exponent);
+            }
+            return nullptr;
+        default:
+            return nullptr;
+        }
+    }
+
+    const Expression *ConstantFolder::fold(const Expression &origin, Value value, size_t mark)
+    {
+        bool overflow = value.overflow;
+        for (size_t i = mark; i < diagnostics_.size(); ++i)
+        {
+            overflow |= diagnostics_[i].kind == Diagnostic::Kind::Overflow;
+        }
+        diagnostics_.resize(mark);
+        diagnostics_.push_back(Diagnostic{overflow ? Diagnostic::Kind::Overflow : Diagnostic::Kind::Folded,
+                                          line_, column_, value.value});
+        return make<NumberExpression>(origin, value.value);
+    }
+
+} // namespace pl0
@@ -0,0 +1,486 @@
+#include "../include/DeadCodeEliminator.h"
+#include "../include/CaptureAnalysis.h"
+#include "../include/ConstantFolder.h"
+
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+namespace pl0
+{
+
+    std::unique_ptr<Program> DeadCodeEliminator::run(std::unique_ptr<Program> program)
+    {
+        captured_ = CaptureAnalysis{}.run(*program);
+        scope_ = SymbolTable{};
+        level_ = 0;
+        current_ = Report{};
+        stats_.clear();
+        reports_.clear();
+
+        // 第一遍删除常量条件的语句和无用赋值，这会去掉其中的调用，之后再求可达的过程
+        pruning_ = false;
+        auto result = transform(std::move(program));
+        stats_[nullptr] = current_;
+
+        procedures_.assign(1, nullptr);
+        callees_.assign(1, {});
+        ids_.clear();
+        scope_ = SymbolTable{};
+        analyze(result->block(), 0);
+        markReachable();
+
+        reports_.push_back(current_);
+        pruning_ = true;
+        result = transform(std::move(result));
+        pruning_ = false;
+        return result;
+    }
+
+    std::string DeadCodeEliminator::describe(const Report &report)
+    {
+        std::string text = report.procedure.empty() ? std::string("主程序") : "过程" + std::string(report.procedure);
+        if (report.unreachable)
+        {
+            return text + ": 未被调用, 已删除";
+        }
+        std::vector<std::string> parts;
+        if (report.deadStores > 0)
+        {
+            parts.push_back("删除 " + std::to_string(report.deadStores) + " 条无用赋值");
+        }
+        if (report.falseBranches > 0)
+        {
+            parts.push_back("删除 " + std::to_string(report.falseBranches) + " 个条件恒假的语句");
+        }
+        if (report.trueBranches > 0)
+        {
+            parts.push_back(std::to_string(report.trueBranches) + " 个条件恒真的if换成分支");
+        }
+        if (parts.empty())
+        {
+            return text + ": 无删除";
+        }
+        for (size_t i = 0; i < parts.size(); ++i)
+        {
+            text += (i == 0 ? ": " : ", ") + parts[i];
+        }
+        return text;
+    }
+
+    const Block *DeadCodeEliminator::transform(const Block &node)
+    {
+        if (pruning_)
+        {
+            return prune(node);
+        }
+
+        scope_.enterScope();
+        for (const auto *decl : node.consts())
+        {
+            scope_.declare(decl->symbol(), Symbol{
+                                               .type = SymbolType::Constant,
+                                               .value = decl->value(),
+                                               .level = level_,
+                                               .index = 0,
+                                               .name = decl->symbol()});
+        }
+        size_t index = 0;
+        for (const auto *decl : node.vars())
+        {
+            scope_.declare(decl->symbol(), Symbol{
+                                               .type = SymbolType::Variable,
+                                               .value = std::nullopt,
+                                               .level = level_,
+                                               .index = index++,
+                                               .name = decl->symbol()});
+        }
+
+        std::vector<const ProcedureDeclaration *> procedures;
+        bool changed = false;
+        for (const auto *decl : node.procedures())
+        {
+            procedures.push_back(transform(*decl));
+            changed |= procedures.back() != decl;
+        }
+
+        // 嵌套过程访问的变量可能在调用中被读，不参与活跃性分析
+        auto saved_candidates = std::exchange(candidates_, std::vector<bool>(node.vars().size(), true));
+        if (auto it = captured_.find(&node); it != captured_.end())
+        {
+            for (size_t i = 0; i < candidates_.size(); ++i)
+            {
+                candidates_[i] = !it->second[i];
+            }
+        }
+        Liveness live(node.vars().size(), false);
+        for (size_t i = 0; level_ == 0 && i < live.size(); ++i)
+        {
+            live[i] = !node.vars()[i]->hidden();
+        }
+        const Statement *statement = rewrite(node.statement());
+        statement = sweep(*statement, live, true);
+        candidates_ = std::move(saved_candidates);
+        scope_.leaveScope();
+
+        if (!changed && statement == &node.statement())
+        {
+            return &node;
+        }
+        return make<Block>(node, node.consts(), node.vars(), changed ? arena().list(procedures) : node.procedures(),
+                           statement);
+    }
+
+    const ProcedureDeclaration *DeadCodeEliminator::transform(const ProcedureDeclaration &node)
+    {
+        if (pruning_)
+        {
+            if (auto it = stats_.find(&node); it != stats_.end())
+            {
+                reports_.push_back(it->second);
+            }
+            return ASTTransformer::transform(node);
+        }
+
+        scope_.declare(node.symbol(), Symbol{
+                                          .type = SymbolType::Procedure,
+                                          .value = std::nullopt,
+                                          .level = level_,
+                                          .index = 0,
+                                          .name = node.symbol()});
+        Report saved = std::exchange(current_, Report{.procedure = node.name()});
+        ++level_;
+        const ProcedureDeclaration *result = ASTTransformer::transform(node);
+        --level_;
+        stats_[result] = std::exchange(current_, saved);
+        return result;
+    }
+
+    const Statement *DeadCodeEliminator::transform(const BeginStatement &node)
+    {
+        std::vector<const Statement *> statements;
+        bool changed = false;
+        for (const auto *stmt : node.statements())
+        {
+            const Statement *result = rewrite(*stmt);
+            changed |= result != stmt;
+            if (result->kind() != NodeKind::BeginStatement ||
+                !static_cast<const BeginStatement *>(result)->statements().empty())
+            {
+                statements.push_back(result);
+            }
+        }
+        return changed ? make<BeginStatement>(node, arena().list(statements)) : &node;
+    }
+
+    const Statement *DeadCodeEliminator::transform(const IfStatement &node)
+    {
+        if (auto value = constant(node.condition()))
+        {
+            if (*value == 0)
+            {
+                ++current_.falseBranches;
+                return empty(node);
+            }
+            ++current_.trueBranches;
+            return rewrite(node.thenStmt());
+        }
+        return ASTTransformer::transform(node);
+    }
+
+    const Statement *DeadCodeEliminator::transform(const WhileStatement &node)
+    {
+        if (auto value = constant(node.condition()); value && *value == 0)
+        {
+            ++current_.falseBranches;
+            return empty(node);
+        }
+        return ASTTransformer::transform(node);
+    }
+
+    const Statement *DeadCodeEliminator::sweep(const Statement &node, Liveness &live, bool apply)
+    {
+        switch (node.kind())
+        {
+        case NodeKind::AssignStatement:
+        {
+            const auto &assign = static_cast<const AssignStatement &>(node);
+            auto index = local(assign.symbol());
+            if (index && !live[*index] && trapFree(assign.expression()))
+            {
+                // 删除的赋值不读右边的变量
+                if (apply)
+                {
+                    ++current_.deadStores;
+                    return empty(node);
+                }
+                return &node;
+            }
+            if (index)
+            {
+                live[*index] = false;
+            }
+            use(assign.expression(), live);
+            return &node;
+        }
+        case NodeKind::CallStatement:
+            return &node;
+        case NodeKind::BeginStatement:
+        {
+            const auto &statements = static_cast<const BeginStatement &>(node).statements();
+            std::vector<const Statement *> kept;
+            bool changed = false;
+            for (size_t i = statements.size(); i-- > 0;)
+            {
+                const Statement *result = sweep(*statements[i], live, apply);
+                changed |= result != statements[i];
+                if (result->kind() != NodeKind::BeginStatement ||
+                    !static_cast<const BeginStatement *>(result)->statements().empty())
+                {
+                    kept.push_back(result);
+                }
+            }
+            if (!changed)
+            {
+                return &node;
+            }
+            std::reverse(kept.begin(), kept.end());
+            return make<BeginStatement>(node, arena().list(kept));
+        }
+        case NodeKind::IfStatement:
+        {
+            const auto &stmt = static_cast<const IfStatement &>(node);
+            Liveness then_live = live;
+            const Statement *then_stmt = sweep(stmt.thenStmt(), then_live, apply);
+            for (size_t i = 0; i < live.size(); ++i)
+            {
+                live[i] = live[i] || then_live[i];
+            }
+            use(stmt.condition(), live);
+            return then_stmt == &stmt.thenStmt() ? &node : make<IfStatement>(node, &stmt.condition(), then_stmt);
+        }
+        case NodeKind::WhileStatement:
+        {
+            // 循环头的活跃集合 = 条件读的 ∪ 循环之后的 ∪ 循环体入口的，循环体入口又依赖循环头
+            const auto &stmt = static_cast<const WhileStatement &>(node);
+            Liveness header = live;
+            use(stmt.condition(), header);
+            for (;;)
+            {
+                Liveness body_live = header;
+                (void)sweep(stmt.body(), body_live, false);
+                bool grown = false;
+                for (size_t i = 0; i < header.size(); ++i)
+                {
+                    grown |= body_live[i] && !header[i];
+                    header[i] = header[i] || body_live[i];
+                }
+                if (!grown)
+                {
+                    break;
+                }
+            }
+            Liveness body_live = header;
+            const Statement *body = sweep(stmt.body(), body_live, apply);
+            live = std::move(header);
+            return body == &stmt.body() ? &node : make<WhileStatement>(node, &stmt.condition(), body);
+        }
+        default:
+            return &node;
+        }
+    }
+
+    void DeadCodeEliminator::use(const Expression &expr, Liveness &live) const
+    {
+        pl0::visit(expr, [this, &live](const auto &node)
+                   {
+            using Node = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<Node, IdentifierExpression>)
+            {
+                if (auto index = local(node.symbol()))
+                {
+                    live[*index] = true;
+                }
+            }
+            else if constexpr (std::is_same_v<Node, UnaryExpression>)
+            {
+                use(node.operand(), live);
+            }
+            else if constexpr (std::is_same_v<Node, BinaryExpression>)
+            {
+                use(node.left(), live);
+                use(node.right(), live);
+            } });
+    }
+
+    std::optional<size_t> DeadCodeEliminator::local(SymbolId name) const
+    {
+        const Symbol *symbol = scope_.lookup(name);
+        if (symbol && symbol->type == SymbolType::Variable && symbol->level == level_ &&
+            candidates_[symbol->index])
+        {
+            return symbol->index;
+        }
+        return std::nullopt;
+    }
+
+    std::optional<int64_t> DeadCodeEliminator::constant(const Expression &expr) const
+    {
+        return pl0::visit(expr, [this](const auto &node) -> std::optional<int64_t>
+                          {
+            using Node = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<Node, NumberExpression>)
+            {
+                return node.value();
+            }
+            else if constexpr (std::is_same_v<Node, IdentifierExpression>)
+            {
+                const Symbol *symbol = scope_.lookup(node.symbol());
+                return symbol && symbol->type == SymbolType::Constant ? symbol->value : std::nullopt;
+            }
+            else if constexpr (std::is_same_v<Node, UnaryExpression>)
+            {
+                auto operand = constant(node.operand());
+                return operand ? std::optional(ConstantFolder::evaluate(node.op(), *operand).value) : std::nullopt;
+            }
+            else
+            {
+                auto left = constant(node.left());
+                auto right = left ? constant(node.right()) : std::nullopt;
+                if (!right)
+                {
+                    return std::nullopt;
+                }
+                auto value = ConstantFolder::evaluate(node.op(), *left, *right);
+                return value ? std::optional(value->value) : std::nullopt;
+            } });
+    }
+
+    bool DeadCodeEliminator::trapFree(const Expression &expr) const
+    {
+        return pl0::visit(expr, [this](const auto &node)
+                          {
+            using Node = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<Node, UnaryExpression>)
+            {
+                return trapFree(node.operand());
+            }
+            else if constexpr (std::is_same_v<Node, BinaryExpression>)
+            {
+                using Op = BinaryExpression::Op;
+                if (node.op() == Op::Div || node.op() == Op::Pow || node.op() == Op::Shl)
+                {
+                    auto right = constant(node.right());
+                    if (!right || (node.op() == Op::Div ? *right == 0 : *right < 0))
+                    {
+                        return false;
+                    }
+                }
+                return trapFree(node.left()) && trapFree(node.right());
+            }
+            else
+            {
+                return true;
+            } });
+    }
+
+    const Statement *DeadCodeEliminator::empty(const Statement &origin)
+    {
+        return make<BeginStatement>(origin, std::span<const Statement *const>{});
+    }
+
+    // 第二遍: 调用图
+
+    void DeadCodeEliminator::analyze(const Block &block, size_t id)
+    {
+        // 过程在声明之后才可见，与语义分析的规则一致
+        scope_.enterScope();
+        for (const auto *decl : block.procedures())
+        {
+            size_t callee = procedures_.size();
+            procedures_.push_back(decl);
+            callees_.emplace_back();
+            ids_.emplace(decl, callee);
+            scope_.declare(decl->symbol(), Symbol{
+                                               .type = SymbolType::Procedure,
+                                               .value = static_cast<int64_t>(callee),
+                                               .level = 0,
+                                               .index = 0,
+                                               .name = decl->symbol()});
+            analyze(decl->block(), callee);
+        }
+        analyze(block.statement(), id);
+        scope_.leaveScope();
+    }
+
+    void DeadCodeEliminator::analyze(const Statement &node, size_t id)
+    {
+        switch (node.kind())
+        {
+        case NodeKind::CallStatement:
+            if (const Symbol *symbol = scope_.lookup(static_cast<const CallStatement &>(node).symbol());
+                symbol && symbol->type == SymbolType::Procedure)
+            {
+                callees_[id].push_back(static_cast<size_t>(*symbol->value));
+            }
+            break;
+        case NodeKind::BeginStatement:
+            for (const auto *stmt : static_cast<const BeginStatement &>(node).statements())
+            {
+                analyze(*stmt, id);
+            }
+            break;
+        case NodeKind::IfStatement:
+            analyze(static_cast<const IfStatement &>(node).thenStmt(), id);
+            break;
+        case NodeKind::WhileStatement:
+            analyze(static_cast<const WhileStatement &>(node).body(), id);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void DeadCodeEliminator::markReachable()
+    {
+        reachable_.assign(procedures_.size(), false);
+        std::vector<size_t> worklist{0};
+        reachable_[0] = true;
+        while (!worklist.empty())
+        {
+            size_t id = worklist.back();
+            worklist.pop_back();
+            for (size_t callee : callees_[id])
+            {
+                if (!reachable_[callee])
+                {
+                    reachable_[callee] = true;
+                    worklist.push_back(callee);
+                }
+            }
+        }
+    }
+
+    const Block *DeadCodeEliminator::prune(const Block &node)
+    {
+        std::vector<const ProcedureDeclaration *> procedures;
+        bool changed = false;
+        for (const auto *decl : node.procedures())
+        {
+            if (!reachable_[ids_.at(decl)])
+            {
+                reports_.push_back(Report{.procedure = decl->name(), .unreachable = true});
+                changed = true;
+                continue;
+            }
+            procedures.push_back(transform(*decl));
+            changed |= procedures.back() != decl;
+        }
+        if (!changed)
+        {
+            return &node;
+        }
+        return make<Block>(node, node.consts(), node.vars(), arena().list(procedures), &node.statement());
+    }
+
+} // namespace pl0
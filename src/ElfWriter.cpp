@@ -0,0 +1,277 @@
+#include "../include/ElfWriter.h"
+#include "../include/PCode.h"
+
+#include <elf.h>
+#include <string>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace pl0
+{
+
+    using x86::Reg;
+    using x86::Cond;
+    using x86::Label;
+    using x86::at;
+
+    namespace
+    {
+        constexpr uint64_t BASE_ADDRESS = 0x400000;
+        constexpr uint64_t PAGE_SIZE = 0x1000;
+        constexpr size_t PROGRAM_HEADERS = 3;
+
+        constexpr int64_t SYS_WRITE = 1;
+        constexpr int64_t SYS_EXIT = 60;
+
+        // 与NativeImage的调用栈大小一致
+        constexpr size_t NATIVE_BYTES_PER_SLOT = 16;
+        constexpr size_t NATIVE_STACK_RESERVE = 1 << 16;
+
+        // bss内的布局
+        constexpr uint64_t BSS_CONTEXT = 0;
+        constexpr uint64_t BSS_DIGITS_END = 96; // 十进制转换缓冲区[64, 96)
+        constexpr uint64_t BSS_STACK = 128;
+
+        constexpr uint64_t alignUp(uint64_t value, uint64_t alignment) noexcept
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        const char *const ERROR_MESSAGES[] = {
+            "运行时错误: 除数为零\n",
+            "运行时错误: 负指数\n",
+            "运行时错误: 栈溢出\n"};
+        static_assert(NativeCode::DivisionByZero == 1 && NativeCode::StackOverflow == 3);
+
+        struct StringRef
+        {
+            uint64_t address;
+            size_t length;
+        };
+
+        void emitWrite(x86::Assembler &as, int fd, const StringRef &text)
+        {
+            as.mov(Reg::RAX, SYS_WRITE);
+            as.mov(Reg::RDI, int64_t{fd});
+            as.mov(Reg::RSI, static_cast<int64_t>(text.address));
+            as.mov(Reg::RDX, static_cast<int64_t>(text.length));
+            as.syscall();
+        }
+
+        // 启动代码: _start和十进制输出例程
+        x86::Assembler assembleStart(uint64_t entry, uint64_t bss, size_t stack_size, bool print_globals,
+                                     const std::vector<StringRef> &prefixes, const std::vector<StringRef> &errors)
+        {
+            x86::Assembler as;
+            Label print_value = as.newLabel();
+            Label failed = as.newLabel();
+            Label exit = as.newLabel();
+
+            uint64_t stack = bss + BSS_STACK;
+            uint64_t stack_end = stack + stack_size * 8;
+            uint64_t native_top = alignUp(stack_end + stack_size * NATIVE_BYTES_PER_SLOT + NATIVE_STACK_RESERVE, 16);
+
+            as.mov(Reg::RDI, static_cast<int64_t>(bss + BSS_CONTEXT));
+            as.mov(Reg::RAX, static_cast<int64_t>(stack));
+            as.mov(at(Reg::RDI, offsetof(NativeContext, stack_base)), Reg::RAX);
+            as.mov(Reg::RAX, static_cast<int64_t>(stack_end));
+            as.mov(at(Reg::RDI, offsetof(NativeContext, stack_limit)), Reg::RAX);
+            as.mov(Reg::RAX, static_cast<int64_t>(native_top));
+            as.mov(at(Reg::RDI, offsetof(NativeContext, native_stack)), Reg::RAX);
+            as.mov(Reg::RAX, static_cast<int64_t>(entry));
+            as.call(Reg::RAX);
+            as.test(Reg::RAX, Reg::RAX);
+            as.jcc(Cond::NE, failed);
+
+            if (print_globals)
+            {
+                for (size_t i = 0; i < prefixes.size(); ++i)
+                {
+                    emitWrite(as, 1, prefixes[i]);
+                    as.mov(Reg::RAX, static_cast<int64_t>(stack + 8 * (FRAME_HEADER + i)));
+                    as.mov(Reg::RAX, at(Reg::RAX, 0));
+                    as.call(print_value);
+                }
+            }
+            as.mov(Reg::RDI, int64_t{0});
+            as.jmp(exit);
+
+            // rax为状态码，输出对应的错误信息后以1退出
+            as.bind(failed);
+            Label reported = as.newLabel();
+            for (size_t i = 0; i < errors.size(); ++i)
+            {
+                Label next = as.newLabel();
+                as.cmp(Reg::RAX, static_cast<int32_t>(i + 1));
+                as.jcc(Cond::NE, next);
+                emitWrite(as, 2, errors[i]);
+                as.jmp(reported);
+                as.bind(next);
+            }
+            as.bind(reported);
+            as.mov(Reg::RDI, int64_t{1});
+
+            as.bind(exit);
+            as.mov(Reg::RAX, SYS_EXIT);
+            as.syscall();
+
+            // 输出rax的十进制值和换行；按无符号数逐位相除，INT64_MIN取负后仍正确
+            Label positive = as.newLabel();
+            Label digit = as.newLabel();
+            Label unsigned_done = as.newLabel();
+            uint64_t digits_end = bss + BSS_DIGITS_END;
+            as.bind(print_value);
+            as.mov(Reg::RSI, static_cast<int64_t>(digits_end - 1));
+            as.mov(Reg::RDX, int64_t{'\n'});
+            as.movByte(at(Reg::RSI, 0), Reg::RDX);
+            as.mov(Reg::R8, Reg::RAX);
+            as.test(Reg::RAX, Reg::RAX);
+            as.jcc(Cond::NS, positive);
+            as.neg(Reg::RAX);
+            as.bind(positive);
+            as.mov(Reg::R9, int64_t{10});
+            as.bind(digit);
+            as.mov(Reg::RDX, int64_t{0});
+            as.div(Reg::R9);
+            as.add(Reg::RDX, int32_t{'0'});
+            as.dec(Reg::RSI);
+            as.movByte(at(Reg::RSI, 0), Reg::RDX);
+            as.test(Reg::RAX, Reg::RAX);
+            as.jcc(Cond::NE, digit);
+            as.test(Reg::R8, Reg::R8);
+            as.jcc(Cond::NS, unsigned_done);
+            as.dec(Reg::RSI);
+            as.mov(Reg::RDX, int64_t{'-'});
+            as.movByte(at(Reg::RSI, 0), Reg::RDX);
+            as.bind(unsigned_done);
+            as.mov(Reg::RDX, static_cast<int64_t>(digits_end));
+            as.sub(Reg::RDX, Reg::RSI);
+            as.mov(Reg::RAX, SYS_WRITE);
+            as.mov(Reg::RDI, int64_t{1});
+            as.syscall();
+            as.ret();
+
+            if (!as.finalize())
+            {
+                throw std::runtime_error("代码生成: 存在未绑定的跳转目标");
+            }
+            return as;
+        }
+    }
+
+    std::vector<uint8_t> ElfWriter::build(const NativeCode &code, const Options &options)
+    {
+        if (code.empty() || options.stack_size < static_cast<size_t>(FRAME_HEADER))
+        {
+            throw std::runtime_error("生成可执行文件: 没有可执行的代码");
+        }
+        if (options.stack_size > MAX_STACK_SIZE)
+        {
+            throw std::runtime_error("生成可执行文件: 栈槽位数 " + std::to_string(options.stack_size) + " 超过上限 " +
+                                     std::to_string(MAX_STACK_SIZE));
+        }
+
+        // 文件布局: ELF头 | 程序头 | 字符串常量 | 机器码 | 启动代码
+        const uint64_t headers = sizeof(Elf64_Ehdr) + PROGRAM_HEADERS * sizeof(Elf64_Phdr);
+        std::string rodata;
+        auto addString = [&rodata, headers](std::string_view text)
+        {
+            StringRef ref{BASE_ADDRESS + headers + rodata.size(), text.size()};
+            rodata += text;
+            return ref;
+        };
+
+        std::vector<StringRef> errors;
+        for (const char *message : ERROR_MESSAGES)
+        {
+            errors.push_back(addString(message));
+        }
+        std::vector<StringRef> prefixes;
+        for (auto name : code.globals)
+        {
+            prefixes.push_back(addString(std::string(name) + " = "));
+        }
+
+        const uint64_t code_offset = alignUp(headers + rodata.size(), 16);
+        const uint64_t start_offset = alignUp(code_offset + code.bytes.size(), 16);
+        const uint64_t entry = BASE_ADDRESS + code_offset + code.entry;
+
+        // 地址都小于4G时mov的编码长度与具体值无关，两遍汇编得到相同的长度
+        auto start = assembleStart(entry, BASE_ADDRESS + PAGE_SIZE, options.stack_size, options.print_globals,
+                                   prefixes, errors);
+        const uint64_t file_size = start_offset + start.size();
+        const uint64_t bss = alignUp(BASE_ADDRESS + file_size, PAGE_SIZE);
+        start = assembleStart(entry, bss, options.stack_size, options.print_globals, prefixes, errors);
+        if (start_offset + start.size() != file_size)
+        {
+            throw std::runtime_error("生成可执行文件: 启动代码长度不一致");
+        }
+        const uint64_t bss_size = alignUp(BSS_STACK + options.stack_size * (8 + NATIVE_BYTES_PER_SLOT) +
+                                              NATIVE_STACK_RESERVE + 16,
+                                          PAGE_SIZE);
+
+        std::vector<uint8_t> image(file_size, 0);
+
+        Elf64_Ehdr header{};
+        std::memcpy(header.e_ident, ELFMAG, SELFMAG);
+        header.e_ident[EI_CLASS] = ELFCLASS64;
+        header.e_ident[EI_DATA] = ELFDATA2LSB;
+        header.e_ident[EI_VERSION] = EV_CURRENT;
+        header.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+        header.e_type = ET_EXEC;
+        header.e_machine = EM_X86_64;
+        header.e_version = EV_CURRENT;
+        header.e_entry = BASE_ADDRESS + start_offset;
+        header.e_phoff = sizeof(Elf64_Ehdr);
+        header.e_ehsize = sizeof(Elf64_Ehdr);
+        header.e_phentsize = sizeof(Elf64_Phdr);
+        header.e_phnum = PROGRAM_HEADERS;
+        std::memcpy(image.data(), &header, sizeof(header));
+
+        Elf64_Phdr segments[PROGRAM_HEADERS]{};
+        segments[0].p_type = PT_LOAD;
+        segments[0].p_flags = PF_R | PF_X;
+        segments[0].p_offset = 0;
+        segments[0].p_vaddr = segments[0].p_paddr = BASE_ADDRESS;
+        segments[0].p_filesz = segments[0].p_memsz = file_size;
+        segments[0].p_align = PAGE_SIZE;
+
+        segments[1].p_type = PT_LOAD;
+        segments[1].p_flags = PF_R | PF_W;
+        segments[1].p_offset = 0;
+        segments[1].p_vaddr = segments[1].p_paddr = bss;
+        segments[1].p_filesz = 0;
+        segments[1].p_memsz = bss_size;
+        segments[1].p_align = PAGE_SIZE;
+
+        // 栈不可执行
+        segments[2].p_type = PT_GNU_STACK;
+        segments[2].p_flags = PF_R | PF_W;
+        segments[2].p_align = 16;
+        std::memcpy(image.data() + sizeof(Elf64_Ehdr), segments, sizeof(segments));
+
+        std::memcpy(image.data() + headers, rodata.data(), rodata.size());
+        std::memcpy(image.data() + code_offset, code.bytes.data(), code.bytes.size());
+        std::memcpy(image.data() + start_offset, start.code().data(), start.size());
+        return image;
+    }
+
+    void ElfWriter::write(const NativeCode &code, const std::filesystem::path &path, const Options &options)
+    {
+        auto image = build(code, options);
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(image.data()), static_cast<std::streamsize>(image.size()));
+        file.close();
+        if (!file)
+        {
+            throw std::runtime_error("无法写入: " + path.string());
+        }
+
+        using std::filesystem::perms;
+        std::filesystem::permissions(path, perms::owner_exec | perms::group_exec | perms::others_exec,
+                                     std::filesystem::perm_options::add);
+    }
+
+} // namespace pl0
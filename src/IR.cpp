@@ -0,0 +1,299 @@
+#include "../include/IR.h"
+
+#include <utility>
+
+namespace pl0
+{
+
+    std::string_view irOpName(IrOp op) noexcept
+    {
+        switch (op)
+        {
+        case IrOp::Const:
+            return "const";
+        case IrOp::Add:
+            return "add";
+        case IrOp::Sub:
+            return "sub";
+        case IrOp::Mul:
+            return "mul";
+        case IrOp::Div:
+            return "div";
+        case IrOp::Pow:
+            return "pow";
+        case IrOp::Shl:
+            return "shl";
+        case IrOp::Eq:
+            return "eq";
+        case IrOp::Neq:
+            return "neq";
+        case IrOp::Lt:
+            return "lt";
+        case IrOp::Lte:
+            return "lte";
+        case IrOp::Gt:
+            return "gt";
+        case IrOp::Gte:
+            return "gte";
+        case IrOp::Neg:
+            return "neg";
+        case IrOp::Not:
+            return "not";
+        case IrOp::Odd:
+            return "odd";
+        case IrOp::Phi:
+            return "phi";
+        case IrOp::Load:
+            return "load";
+        case IrOp::Store:
+            return "store";
+        case IrOp::Call:
+            return "call";
+        case IrOp::Jump:
+            return "br";
+        case IrOp::Branch:
+            return "condbr";
+        case IrOp::Return:
+            return "ret";
+        }
+        return "???";
+    }
+
+    bool isTerminator(IrOp op) noexcept
+    {
+        return op == IrOp::Jump || op == IrOp::Branch || op == IrOp::Return;
+    }
+
+    bool hasResult(IrOp op) noexcept
+    {
+        return op != IrOp::Store && op != IrOp::Call && !isTerminator(op);
+    }
+
+    DominatorTree::DominatorTree(const IrFunction &function)
+        : order_(function.blocks.size(), NO_BLOCK), idom_(function.blocks.size(), NO_BLOCK),
+          children_(function.blocks.size()), enter_(function.blocks.size(), 0), leave_(function.blocks.size(), 0)
+    {
+        if (function.blocks.empty())
+        {
+            return;
+        }
+
+        // 迭代的深度优先遍历求后序，栈中保存块和下一个要访问的后继
+        static const std::vector<IrBlockId> none;
+        std::vector<IrBlockId> postorder;
+        std::vector<bool> visited(function.blocks.size(), false);
+        std::vector<std::pair<IrBlockId, size_t>> stack{{0, 0}};
+        visited[0] = true;
+        while (!stack.empty())
+        {
+            auto &[block, next] = stack.back();
+            const auto &succs = function.blocks[block].instructions.empty() ? none : function.successors(block);
+            if (next < succs.size())
+            {
+                IrBlockId succ = succs[next++];
+                if (succ < function.blocks.size() && !visited[succ])
+                {
+                    visited[succ] = true;
+                    stack.emplace_back(succ, 0);
+                }
+                continue;
+            }
+            postorder.push_back(block);
+            stack.pop_back();
+        }
+        rpo_.assign(postorder.rbegin(), postorder.rend());
+        for (size_t i = 0; i < rpo_.size(); ++i)
+        {
+            order_[rpo_[i]] = static_cast<IrBlockId>(i);
+        }
+
+        idom_[0] = 0;
+        for (bool changed = true; changed;)
+        {
+            changed = false;
+            for (size_t i = 1; i < rpo_.size(); ++i)
+            {
+                IrBlockId block = rpo_[i];
+                IrBlockId dominator = NO_BLOCK;
+                for (IrBlockId pred : function.blocks[block].preds)
+                {
+                    if (pred >= idom_.size() || idom_[pred] == NO_BLOCK)
+                    {
+                        continue;
+                    }
+                    dominator = dominator == NO_BLOCK ? pred : intersect(pred, dominator);
+                }
+                if (idom_[block] != dominator)
+                {
+                    idom_[block] = dominator;
+                    changed = true;
+                }
+            }
+        }
+
+        for (IrBlockId block : rpo_)
+        {
+            if (block != 0 && idom_[block] != NO_BLOCK)
+            {
+                children_[idom_[block]].push_back(block);
+            }
+        }
+
+        // 支配树上的区间编号: a支配b当且仅当b的区间嵌套在a的区间内
+        uint32_t clock = 0;
+        std::vector<std::pair<IrBlockId, size_t>> walk{{0, 0}};
+        enter_[0] = clock++;
+        while (!walk.empty())
+        {
+            auto &[block, next] = walk.back();
+            if (next < children_[block].size())
+            {
+                IrBlockId child = children_[block][next++];
+                enter_[child] = clock++;
+                walk.emplace_back(child, 0);
+                continue;
+            }
+            leave_[block] = clock++;
+            walk.pop_back();
+        }
+    }
+
+    IrBlockId DominatorTree::intersect(IrBlockId a, IrBlockId b) const noexcept
+    {
+        while (a != b)
+        {
+            while (order_[a] > order_[b])
+            {
+                a = idom_[a];
+            }
+            while (order_[b] > order_[a])
+            {
+                b = idom_[b];
+            }
+        }
+        return a;
+    }
+
+    bool DominatorTree::dominates(IrBlockId a, IrBlockId b) const noexcept
+    {
+        if (!reachable(a) || !reachable(b))
+        {
+            return false;
+        }
+        return enter_[a] <= enter_[b] && leave_[b] <= leave_[a];
+    }
+
+    namespace
+    {
+        void printFrameSlot(const IrInstruction &inst, std::ostream &out)
+        {
+            out << static_cast<int>(inst.level) << ':' << inst.name;
+        }
+
+        void printInstruction(const IrFunction &function, IrValue id, std::ostream &out)
+        {
+            const IrInstruction &inst = function.values[id];
+            out << "    ";
+            if (hasResult(inst.op))
+            {
+                out << '%' << id << " = ";
+            }
+            out << irOpName(inst.op);
+
+            switch (inst.op)
+            {
+            case IrOp::Const:
+                out << ' ' << inst.imm;
+                break;
+            case IrOp::Phi:
+                for (size_t i = 0; i < inst.operands.size(); ++i)
+                {
+                    out << (i == 0 ? " [%" : ", [%") << inst.operands[i] << ", bb"
+                        << function.blocks[inst.block].preds[i] << ']';
+                }
+                break;
+            case IrOp::Load:
+            case IrOp::Call:
+                out << ' ';
+                printFrameSlot(inst, out);
+                break;
+            case IrOp::Store:
+                out << ' ';
+                printFrameSlot(inst, out);
+                out << ", %" << inst.operands[0];
+                break;
+            default:
+                for (size_t i = 0; i < inst.operands.size(); ++i)
+                {
+                    out << (i == 0 ? " %" : ", %") << inst.operands[i];
+                }
+                for (size_t i = 0; i < inst.targets.size(); ++i)
+                {
+                    out << (i == 0 && inst.operands.empty() ? " bb" : ", bb") << inst.targets[i];
+                }
+                break;
+            }
+            out << '\n';
+        }
+    }
+
+    void print(const IrModule &module, std::ostream &out)
+    {
+        for (size_t f = 0; f < module.functions.size(); ++f)
+        {
+            const IrFunction &function = module.functions[f];
+            if (f > 0)
+            {
+                out << '\n';
+            }
+            out << "function " << (f == 0 ? std::string_view("主程序") : function.name) << " (level "
+                << function.level;
+            if (f > 0)
+            {
+                out << ", 外层 " << (function.parent == 0 ? std::string_view("主程序")
+                                                           : module.functions[function.parent].name);
+            }
+            out << ")\n";
+
+            // 变量: 提升为SSA值的直接列出，留在帧中的加方括号
+            out << "  vars:";
+            for (size_t i = 0; i < function.variables.size(); ++i)
+            {
+                if (function.promoted[i])
+                {
+                    out << ' ' << function.variables[i];
+                }
+                else
+                {
+                    out << " [" << function.variables[i] << ']';
+                }
+            }
+            out << '\n';
+
+            DominatorTree dominators(function);
+            for (IrBlockId b = 0; b < function.blocks.size(); ++b)
+            {
+                const IrBlock &block = function.blocks[b];
+                out << "bb" << b << ':';
+                if (!block.preds.empty())
+                {
+                    out << "    ; preds:";
+                    for (IrBlockId pred : block.preds)
+                    {
+                        out << " bb" << pred;
+                    }
+                    if (b != 0 && dominators.idom(b) != NO_BLOCK)
+                    {
+                        out << ", idom: bb" << dominators.idom(b);
+                    }
+                }
+                out << '\n';
+                for (IrValue id : block.instructions)
+                {
+                    printInstruction(function, id, out);
+                }
+            }
+        }
+    }
+
+} // namespace pl0
@@ -0,0 +1,560 @@
+#include "../include/IRBuilder.h"
+#include "../include/CaptureAnalysis.h"
+
+#include <limits>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+
+namespace pl0
+{
+
+    namespace
+    {
+        IrOp irForm(BinaryExpression::Op op) noexcept
+        {
+            switch (op)
+            {
+            case BinaryExpression::Op::Add:
+                return IrOp::Add;
+            case BinaryExpression::Op::Sub:
+                return IrOp::Sub;
+            case BinaryExpression::Op::Mul:
+                return IrOp::Mul;
+            case BinaryExpression::Op::Div:
+                return IrOp::Div;
+            case BinaryExpression::Op::Pow:
+                return IrOp::Pow;
+            case BinaryExpression::Op::Shl:
+                return IrOp::Shl;
+            case BinaryExpression::Op::Eq:
+                return IrOp::Eq;
+            case BinaryExpression::Op::Neq:
+                return IrOp::Neq;
+            case BinaryExpression::Op::Lt:
+                return IrOp::Lt;
+            case BinaryExpression::Op::Lte:
+                return IrOp::Lte;
+            case BinaryExpression::Op::Gt:
+                return IrOp::Gt;
+            case BinaryExpression::Op::Gte:
+                return IrOp::Gte;
+            }
+            return IrOp::Add;
+        }
+
+        IrOp irForm(UnaryExpression::Op op) noexcept
+        {
+            switch (op)
+            {
+            case UnaryExpression::Op::Neg:
+                return IrOp::Neg;
+            case UnaryExpression::Op::Not:
+                return IrOp::Not;
+            case UnaryExpression::Op::Odd:
+                return IrOp::Odd;
+            }
+            return IrOp::Neg;
+        }
+    }
+
+    IrModule IRBuilder::build(const Program &program)
+    {
+        module_ = IrModule{};
+        captured_ = CaptureAnalysis{}.run(program);
+        level_ = 0;
+        var_count_ = 0;
+        walk(program);
+        return std::move(module_);
+    }
+
+    void IRBuilder::visit(const Program &node)
+    {
+        symbols_.enterScope();
+        module_.functions.emplace_back();
+        state_ = FunctionState{};
+        walk(node.block());
+        symbols_.leaveScope();
+    }
+
+    void IRBuilder::visit(const Block &node)
+    {
+        size_t saved_var_count = std::exchange(var_count_, 0);
+
+        for (const auto *decl : node.consts())
+        {
+            walk(*decl);
+        }
+        for (const auto *decl : node.vars())
+        {
+            walk(*decl);
+        }
+        auto captured = captured_.find(&node);
+        for (size_t i = 0; i < var_count_; ++i)
+        {
+            function().promoted.push_back(captured == captured_.end() || !captured->second[i]);
+        }
+        for (const auto *decl : node.procedures())
+        {
+            walk(*decl);
+        }
+
+        state_.current = newBlock();
+        seal(state_.current);
+        walk(node.statement());
+        finish();
+
+        var_count_ = saved_var_count;
+    }
+
+    void IRBuilder::visit(const ConstDeclaration &node)
+    {
+        symbols_.declare(node.symbol(), Symbol{
+                                            .type = SymbolType::Constant,
+                                            .value = node.value(),
+                                            .level = level_,
+                                            .index = 0,
+                                            .name = node.symbol()});
+    }
+
+    void IRBuilder::visit(const VarDeclaration &node)
+    {
+        function().variables.push_back(node.name());
+        state_.hidden.push_back(node.hidden());
+        symbols_.declare(node.symbol(), Symbol{
+                                            .type = SymbolType::Variable,
+                                            .value = std::nullopt,
+                                            .level = level_,
+                                            .index = var_count_++,
+                                            .name = node.symbol()});
+    }
+
+    void IRBuilder::visit(const ProcedureDeclaration &node)
+    {
+        // 先登记，过程体内可以递归调用自己
+        size_t index = module_.functions.size();
+        symbols_.declare(node.symbol(), Symbol{
+                                            .type = SymbolType::Procedure,
+                                            .value = static_cast<int64_t>(index),
+                                            .level = level_,
+                                            .index = 0,
+                                            .name = node.symbol()});
+
+        IrFunction callee;
+        callee.name = node.name();
+        callee.level = level_ + 1;
+        callee.parent = state_.function;
+        module_.functions.push_back(std::move(callee));
+
+        FunctionState saved = std::exchange(state_, FunctionState{.function = index});
+        ++level_;
+        symbols_.enterScope();
+        walk(node.block());
+        symbols_.leaveScope();
+        --level_;
+        state_ = std::move(saved);
+    }
+
+    void IRBuilder::visit(const AssignStatement &node)
+    {
+        const Symbol &symbol = lookup(node.symbol());
+        IrValue value = lower(node.expression());
+        if (symbol.level == level_ && function().promoted[symbol.index])
+        {
+            writeVariable(symbol.index, state_.current, value);
+            return;
+        }
+        append(IrInstruction{.op = IrOp::Store,
+                             .level = levelDistance(symbol),
+                             .index = symbol.index,
+                             .name = node.name(),
+                             .operands = {value}});
+    }
+
+    void IRBuilder::visit(const CallStatement &node)
+    {
+        const Symbol &symbol = lookup(node.symbol());
+        append(IrInstruction{.op = IrOp::Call,
+                             .level = levelDistance(symbol),
+                             .index = static_cast<size_t>(*symbol.value),
+                             .name = node.procName()});
+    }
+
+    void IRBuilder::visit(const BeginStatement &node)
+    {
+        for (const auto *stmt : node.statements())
+        {
+            walk(*stmt);
+        }
+    }
+
+    void IRBuilder::visit(const IfStatement &node)
+    {
+        IrValue condition = lower(node.condition());
+        IrBlockId then_block = newBlock();
+        IrBlockId join = newBlock();
+        append(IrInstruction{.op = IrOp::Branch, .operands = {condition}, .targets = {then_block, join}});
+        addEdge(state_.current, then_block);
+        addEdge(state_.current, join);
+        seal(then_block);
+
+        state_.current = then_block;
+        walk(node.thenStmt());
+        jump(join);
+        seal(join);
+        state_.current = join;
+    }
+
+    void IRBuilder::visit(const WhileStatement &node)
+    {
+        // 循环头的前驱在循环体翻译完之后才齐全，此前不封闭
+        IrBlockId header = newBlock();
+        jump(header);
+        state_.current = header;
+        IrValue condition = lower(node.condition());
+        IrBlockId body = newBlock();
+        IrBlockId exit = newBlock();
+        append(IrInstruction{.op = IrOp::Branch, .operands = {condition}, .targets = {body, exit}});
+        addEdge(header, body);
+        addEdge(header, exit);
+        seal(body);
+
+        state_.current = body;
+        walk(node.body());
+        jump(header);
+        seal(header);
+        seal(exit);
+        state_.current = exit;
+    }
+
+    IrValue IRBuilder::lower(const Expression &expr)
+    {
+        return pl0::visit(expr, [this](const auto &node) -> IrValue
+                          {
+            using Node = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<Node, NumberExpression>)
+            {
+                return append(IrInstruction{.op = IrOp::Const, .imm = node.value()});
+            }
+            else if constexpr (std::is_same_v<Node, IdentifierExpression>)
+            {
+                const Symbol &symbol = lookup(node.symbol());
+                if (symbol.type == SymbolType::Constant)
+                {
+                    return append(IrInstruction{.op = IrOp::Const, .imm = *symbol.value});
+                }
+                if (symbol.level == level_ && function().promoted[symbol.index])
+                {
+                    return readVariable(symbol.index, state_.current);
+                }
+                return append(IrInstruction{.op = IrOp::Load,
+                                            .level = levelDistance(symbol),
+                                            .index = symbol.index,
+                                            .name = node.name()});
+            }
+            else if constexpr (std::is_same_v<Node, UnaryExpression>)
+            {
+                IrValue operand = lower(node.operand());
+                return append(IrInstruction{.op = irForm(node.op()), .operands = {operand}});
+            }
+            else
+            {
+                IrValue left = lower(node.left());
+                IrValue right = lower(node.right());
+                return append(IrInstruction{.op = irForm(node.op()), .operands = {left, right}});
+            } });
+    }
+
+    IrValue IRBuilder::append(IrInstruction inst)
+    {
+        IrFunction &fn = function();
+        auto id = static_cast<IrValue>(fn.values.size());
+        inst.block = state_.current;
+        fn.values.push_back(std::move(inst));
+        fn.blocks[state_.current].instructions.push_back(id);
+        state_.forward.push_back(id);
+        return id;
+    }
+
+    IrBlockId IRBuilder::newBlock()
+    {
+        IrFunction &fn = function();
+        fn.blocks.emplace_back();
+        state_.sealed.push_back(false);
+        return static_cast<IrBlockId>(fn.blocks.size() - 1);
+    }
+
+    void IRBuilder::addEdge(IrBlockId from, IrBlockId to)
+    {
+        function().blocks[to].preds.push_back(from);
+    }
+
+    void IRBuilder::jump(IrBlockId target)
+    {
+        append(IrInstruction{.op = IrOp::Jump, .targets = {target}});
+        addEdge(state_.current, target);
+    }
+
+    void IRBuilder::finish()
+    {
+        if (state_.function == 0)
+        {
+            for (size_t i = 0; i < function().variables.size(); ++i)
+            {
+                if (function().promoted[i] && !state_.hidden[i])
+                {
+                    IrValue value = readVariable(i, state_.current);
+                    append(IrInstruction{.op = IrOp::Store,
+                                         .level = 0,
+                                         .index = i,
+                                         .name = function().variables[i],
+                                         .operands = {value}});
+                }
+            }
+        }
+        append(IrInstruction{.op = IrOp::Return});
+
+        // 构造时删掉的phi可能仍被引用，也可能因此让别的phi变得平凡，改写到不动点
+        IrFunction &fn = function();
+        for (bool changed = true; changed;)
+        {
+            changed = false;
+            for (auto &block : fn.blocks)
+            {
+                for (IrValue id : block.instructions)
+                {
+                    for (auto &operand : fn.values[id].operands)
+                    {
+                        operand = resolve(operand);
+                    }
+                }
+            }
+            std::vector<IrValue> phis;
+            for (const auto &block : fn.blocks)
+            {
+                for (IrValue id : block.instructions)
+                {
+                    if (fn.values[id].op == IrOp::Phi)
+                    {
+                        phis.push_back(id);
+                    }
+                }
+            }
+            for (IrValue phi : phis)
+            {
+                changed |= tryRemoveTrivialPhi(phi) != phi;
+            }
+        }
+        removeDeadPhis();
+    }
+
+    void IRBuilder::writeVariable(size_t variable, IrBlockId block, IrValue value)
+    {
+        state_.definitions[static_cast<uint64_t>(block) << 32 | variable] = value;
+    }
+
+    IrValue IRBuilder::readVariable(size_t variable, IrBlockId block)
+    {
+        if (auto it = state_.definitions.find(static_cast<uint64_t>(block) << 32 | variable);
+            it != state_.definitions.end())
+        {
+            return resolve(it->second);
+        }
+        return readVariableRecursive(variable, block);
+    }
+
+    IrValue IRBuilder::readVariableRecursive(size_t variable, IrBlockId block)
+    {
+        const auto &preds = function().blocks[block].preds;
+        IrValue value;
+        if (!state_.sealed[block])
+        {
+            value = newPhi(block);
+            state_.incomplete[block].emplace_back(variable, value);
+        }
+        else if (preds.empty())
+        {
+            value = initialValue();
+        }
+        else if (preds.size() == 1)
+        {
+            value = readVariable(variable, preds[0]);
+        }
+        else
+        {
+            // 先登记phi再查前驱，沿循环回到本块时就会读到它
+            value = newPhi(block);
+            writeVariable(variable, block, value);
+            value = addPhiOperands(variable, value);
+        }
+        writeVariable(variable, block, value);
+        return value;
+    }
+
+    IrValue IRBuilder::newPhi(IrBlockId block)
+    {
+        IrFunction &fn = function();
+        auto id = static_cast<IrValue>(fn.values.size());
+        fn.values.push_back(IrInstruction{.op = IrOp::Phi, .block = block});
+        auto &instructions = fn.blocks[block].instructions;
+        instructions.insert(instructions.begin(), id);
+        state_.forward.push_back(id);
+        return id;
+    }
+
+    IrValue IRBuilder::addPhiOperands(size_t variable, IrValue phi)
+    {
+        // 读前驱时可能新增块内的phi和指令，不能持有对preds和values的引用
+        size_t count = function().blocks[function().values[phi].block].preds.size();
+        for (size_t i = 0; i < count; ++i)
+        {
+            IrBlockId pred = function().blocks[function().values[phi].block].preds[i];
+            IrValue operand = readVariable(variable, pred);
+            function().values[phi].operands.push_back(operand);
+        }
+        return tryRemoveTrivialPhi(phi);
+    }
+
+    IrValue IRBuilder::tryRemoveTrivialPhi(IrValue phi)
+    {
+        IrValue same = phi;
+        for (IrValue operand : function().values[phi].operands)
+        {
+            operand = resolve(operand);
+            if (operand == same || operand == phi)
+            {
+                continue;
+            }
+            if (same != phi)
+            {
+                return phi;
+            }
+            same = operand;
+        }
+        if (same == phi)
+        {
+            // 只引用自身: 块从入口不可达，或变量在到达这里的路径上都没有定义
+            same = initialValue();
+        }
+
+        IrInstruction &inst = function().values[phi];
+        auto &instructions = function().blocks[inst.block].instructions;
+        std::erase(instructions, phi);
+        inst.block = NO_BLOCK;
+        inst.operands.clear();
+        state_.forward[phi] = same;
+        return same;
+    }
+
+    IrValue IRBuilder::initialValue()
+    {
+        // 各执行方式在进入过程时都把变量清零，未赋值就读到的值是0；放在入口块开头，对所有使用处都可见
+        IrFunction &fn = function();
+        auto id = static_cast<IrValue>(fn.values.size());
+        fn.values.push_back(IrInstruction{.op = IrOp::Const, .imm = 0, .block = 0});
+        auto &instructions = fn.blocks[0].instructions;
+        instructions.insert(instructions.begin(), id);
+        state_.forward.push_back(id);
+        return id;
+    }
+
+    void IRBuilder::seal(IrBlockId block)
+    {
+        if (auto it = state_.incomplete.find(block); it != state_.incomplete.end())
+        {
+            auto pending = std::move(it->second);
+            state_.incomplete.erase(it);
+            for (auto [variable, phi] : pending)
+            {
+                addPhiOperands(variable, phi);
+            }
+        }
+        state_.sealed[block] = true;
+    }
+
+    IrValue IRBuilder::resolve(IrValue value)
+    {
+        IrValue root = value;
+        while (state_.forward[root] != root)
+        {
+            root = state_.forward[root];
+        }
+        while (state_.forward[value] != root)
+        {
+            value = std::exchange(state_.forward[value], root);
+        }
+        return root;
+    }
+
+    void IRBuilder::removeDeadPhis()
+    {
+        // 从非phi的使用出发沿phi的操作数标记，剩下的phi只互相引用
+        IrFunction &fn = function();
+        std::vector<bool> live(fn.values.size(), false);
+        std::vector<IrValue> worklist;
+        for (const auto &block : fn.blocks)
+        {
+            for (IrValue id : block.instructions)
+            {
+                if (fn.values[id].op == IrOp::Phi)
+                {
+                    continue;
+                }
+                for (IrValue operand : fn.values[id].operands)
+                {
+                    if (fn.values[operand].op == IrOp::Phi && !live[operand])
+                    {
+                        live[operand] = true;
+                        worklist.push_back(operand);
+                    }
+                }
+            }
+        }
+        while (!worklist.empty())
+        {
+            IrValue phi = worklist.back();
+            worklist.pop_back();
+            for (IrValue operand : fn.values[phi].operands)
+            {
+                if (fn.values[operand].op == IrOp::Phi && !live[operand])
+                {
+                    live[operand] = true;
+                    worklist.push_back(operand);
+                }
+            }
+        }
+        for (auto &block : fn.blocks)
+        {
+            std::erase_if(block.instructions, [&](IrValue id)
+                          {
+                if (fn.values[id].op != IrOp::Phi || live[id])
+                {
+                    return false;
+                }
+                fn.values[id].block = NO_BLOCK;
+                fn.values[id].operands.clear();
+                return true; });
+        }
+    }
+
+    const Symbol &IRBuilder::lookup(SymbolId name) const
+    {
+        const Symbol *symbol = symbols_.lookup(name);
+        if (!symbol)
+        {
+            throw std::runtime_error("IR生成: 未解析的标识符");
+        }
+        return *symbol;
+    }
+
+    uint8_t IRBuilder::levelDistance(const Symbol &symbol) const
+    {
+        size_t distance = level_ - symbol.level;
+        if (distance > std::numeric_limits<uint8_t>::max())
+        {
+            throw std::runtime_error("IR生成: 过程嵌套层数过深");
+        }
+        return static_cast<uint8_t>(distance);
+    }
+
+} // namespace pl0
@@ -0,0 +1,306 @@
+#include "../include/IRVerifier.h"
+
+#include <algorithm>
+
+namespace pl0
+{
+
+    namespace
+    {
+        std::string value(IrValue id)
+        {
+            return "%" + std::to_string(id);
+        }
+
+        std::string block(IrBlockId id)
+        {
+            return "bb" + std::to_string(id);
+        }
+
+        // 操作数个数，phi另行按前驱数检查
+        size_t operandCount(IrOp op) noexcept
+        {
+            switch (op)
+            {
+            case IrOp::Add:
+            case IrOp::Sub:
+            case IrOp::Mul:
+            case IrOp::Div:
+            case IrOp::Pow:
+            case IrOp::Shl:
+            case IrOp::Eq:
+            case IrOp::Neq:
+            case IrOp::Lt:
+            case IrOp::Lte:
+            case IrOp::Gt:
+            case IrOp::Gte:
+                return 2;
+            case IrOp::Neg:
+            case IrOp::Not:
+            case IrOp::Odd:
+            case IrOp::Store:
+            case IrOp::Branch:
+                return 1;
+            default:
+                return 0;
+            }
+        }
+
+        size_t targetCount(IrOp op) noexcept
+        {
+            return op == IrOp::Jump ? 1 : op == IrOp::Branch ? 2 : 0;
+        }
+    }
+
+    bool IRVerifier::verify(const IrModule &module)
+    {
+        module_ = &module;
+        errors_.clear();
+        if (module.functions.empty())
+        {
+            errors_.push_back("IR中没有主程序");
+            return false;
+        }
+        for (size_t f = 0; f < module.functions.size(); ++f)
+        {
+            if (verifyStructure(f))
+            {
+                verifyDominance(f);
+            }
+        }
+        return errors_.empty();
+    }
+
+    bool IRVerifier::verifyStructure(size_t function)
+    {
+        const IrFunction &fn = module_->functions[function];
+        size_t mark = errors_.size();
+        if (fn.blocks.empty())
+        {
+            addError(function, "没有基本块");
+            return false;
+        }
+        if (fn.promoted.size() != fn.variables.size())
+        {
+            addError(function, "变量表与提升标记的长度不一致");
+        }
+        if (function > 0 && fn.parent >= function)
+        {
+            addError(function, "静态外层函数须在它之前");
+        }
+
+        std::vector<size_t> placed(fn.values.size(), 0);
+        for (IrBlockId b = 0; b < fn.blocks.size(); ++b)
+        {
+            const auto &instructions = fn.blocks[b].instructions;
+            if (instructions.empty())
+            {
+                addError(function, block(b) + "为空");
+                continue;
+            }
+            bool phis = true;
+            for (size_t k = 0; k < instructions.size(); ++k)
+            {
+                IrValue id = instructions[k];
+                if (id >= fn.values.size())
+                {
+                    addError(function, block(b) + "引用了不存在的指令" + value(id));
+                    continue;
+                }
+                const IrInstruction &inst = fn.values[id];
+                if (inst.block != b)
+                {
+                    addError(function, value(id) + "在" + block(b) + "中，但记录的块不同");
+                }
+                if (++placed[id] == 2)
+                {
+                    addError(function, value(id) + "出现了不止一次");
+                }
+                if (inst.op == IrOp::Phi && !phis)
+                {
+                    addError(function, block(b) + "中的phi " + value(id) + "不在块的开头");
+                }
+                phis &= inst.op == IrOp::Phi;
+                bool last = k + 1 == instructions.size();
+                if (isTerminator(inst.op) && !last)
+                {
+                    addError(function, block(b) + "中的终结指令" + value(id) + "不在末尾");
+                }
+                if (!isTerminator(inst.op) && last)
+                {
+                    addError(function, block(b) + "没有以终结指令结尾");
+                }
+                verifyInstruction(function, b, id);
+            }
+        }
+        for (IrValue id = 0; id < fn.values.size(); ++id)
+        {
+            if (placed[id] == 0 && fn.values[id].block != NO_BLOCK)
+            {
+                addError(function, value(id) + "记录在" + block(fn.values[id].block) + "中，但不在该块里");
+            }
+        }
+        if (errors_.size() != mark)
+        {
+            return false;
+        }
+
+        // 前驱表必须恰好是各终结指令跳转目标的逆
+        std::vector<std::vector<IrBlockId>> expected(fn.blocks.size());
+        for (IrBlockId b = 0; b < fn.blocks.size(); ++b)
+        {
+            for (IrBlockId target : fn.successors(b))
+            {
+                expected[target].push_back(b);
+            }
+        }
+        for (IrBlockId b = 0; b < fn.blocks.size(); ++b)
+        {
+            auto preds = fn.blocks[b].preds;
+            std::sort(preds.begin(), preds.end());
+            if (preds != expected[b])
+            {
+                addError(function, block(b) + "的前驱表与跳转不一致");
+            }
+        }
+        if (!fn.blocks[0].preds.empty())
+        {
+            addError(function, "入口块有前驱");
+        }
+        return errors_.size() == mark;
+    }
+
+    void IRVerifier::verifyInstruction(size_t function, IrBlockId b, IrValue id)
+    {
+        const IrFunction &fn = module_->functions[function];
+        const IrInstruction &inst = fn.values[id];
+
+        size_t operands = inst.op == IrOp::Phi ? fn.blocks[b].preds.size() : operandCount(inst.op);
+        if (inst.operands.size() != operands)
+        {
+            addError(function, value(id) + "(" + std::string(irOpName(inst.op)) + ")应有" + std::to_string(operands) +
+                                   "个操作数");
+        }
+        if (inst.targets.size() != targetCount(inst.op))
+        {
+            addError(function, value(id) + "(" + std::string(irOpName(inst.op)) + ")的跳转目标个数不对");
+        }
+        for (IrBlockId target : inst.targets)
+        {
+            if (target >= fn.blocks.size())
+            {
+                addError(function, value(id) + "跳转到不存在的" + block(target));
+            }
+            else if (target == 0)
+            {
+                addError(function, value(id) + "跳转到入口块");
+            }
+        }
+        for (IrValue operand : inst.operands)
+        {
+            if (operand >= fn.values.size())
+            {
+                addError(function, value(id) + "引用了不存在的值" + value(operand));
+            }
+            else if (!hasResult(fn.values[operand].op))
+            {
+                addError(function, value(id) + "引用的" + value(operand) + "没有结果");
+            }
+            else if (fn.values[operand].block == NO_BLOCK)
+            {
+                addError(function, value(id) + "引用了已删除的" + value(operand));
+            }
+        }
+
+        switch (inst.op)
+        {
+        case IrOp::Load:
+        case IrOp::Store:
+            if (const IrFunction *owner = ancestor(function, inst.level); !owner)
+            {
+                addError(function, value(id) + "的层差超出了嵌套层");
+            }
+            else if (inst.index >= owner->variables.size())
+            {
+                addError(function, value(id) + "访问的变量序号" + std::to_string(inst.index) + "超出范围");
+            }
+            break;
+        case IrOp::Call:
+            if (inst.index == 0 || inst.index >= module_->functions.size() ||
+                module_->functions[inst.index].parent >= inst.index)
+            {
+                addError(function, value(id) + "调用了不存在的函数");
+            }
+            else if (ancestor(function, inst.level) != &module_->functions[module_->functions[inst.index].parent])
+            {
+                addError(function, value(id) + "的层差与被调过程的声明位置不符");
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    void IRVerifier::verifyDominance(size_t function)
+    {
+        const IrFunction &fn = module_->functions[function];
+        DominatorTree dominators(fn);
+
+        std::vector<size_t> position(fn.values.size(), 0);
+        for (IrBlockId b = 0; b < fn.blocks.size(); ++b)
+        {
+            if (!dominators.reachable(b))
+            {
+                addError(function, block(b) + "从入口不可达");
+            }
+            const auto &instructions = fn.blocks[b].instructions;
+            for (size_t k = 0; k < instructions.size(); ++k)
+            {
+                position[instructions[k]] = k;
+            }
+        }
+
+        for (IrBlockId b = 0; b < fn.blocks.size(); ++b)
+        {
+            for (IrValue id : fn.blocks[b].instructions)
+            {
+                const IrInstruction &inst = fn.values[id];
+                for (size_t i = 0; i < inst.operands.size(); ++i)
+                {
+                    IrValue operand = inst.operands[i];
+                    IrBlockId def = fn.values[operand].block;
+                    bool dominated = inst.op == IrOp::Phi
+                                         ? dominators.dominates(def, fn.blocks[b].preds[i])
+                                     : def == b ? position[operand] < position[id]
+                                                : dominators.dominates(def, b);
+                    if (!dominated)
+                    {
+                        addError(function, block(b) + "中" + value(id) + "使用的" + value(operand) + "不被其定义支配");
+                    }
+                }
+            }
+        }
+    }
+
+    const IrFunction *IRVerifier::ancestor(size_t function, size_t distance) const noexcept
+    {
+        for (; distance > 0; --distance)
+        {
+            size_t parent = module_->functions[function].parent;
+            if (function == 0 || parent >= function)
+            {
+                return nullptr;
+            }
+            function = parent;
+        }
+        return &module_->functions[function];
+    }
+
+    void IRVerifier::addError(size_t function, std::string message)
+    {
+        const IrFunction &fn = module_->functions[function];
+        errors_.push_back("IR校验: " + (function == 0 ? std::string("主程序") : "过程" + std::string(fn.name)) +
+                          ": " + std::move(message));
+    }
+
+} // namespace pl0
@@ -0,0 +1,520 @@
+#include "../include/Inliner.h"
+
+#include <limits>
+#include <algorithm>
+
+namespace pl0
+{
+
+    std::unique_ptr<Program> Inliner::run(std::unique_ptr<Program> program)
+    {
+        procedures_.assign(1, Procedure{});
+        ids_.clear();
+        decisions_.clear();
+
+        scope_ = SymbolTable{};
+        level_ = 0;
+        scope_.enterScope();
+        analyze(program->block(), 0);
+        scope_.leaveScope();
+        markRecursive();
+
+        scope_ = SymbolTable{};
+        level_ = 0;
+        procedure_ = 0;
+        scope_.enterScope();
+        auto result = transform(std::move(program));
+        scope_.leaveScope();
+        return result;
+    }
+
+    size_t Inliner::inlinedCount() const noexcept
+    {
+        return static_cast<size_t>(std::count_if(decisions_.begin(), decisions_.end(),
+                                                 [](const Decision &decision)
+                                                 { return decision.inlined; }));
+    }
+
+    std::string Inliner::describe(const Decision &decision)
+    {
+        auto name = [](std::string_view procedure)
+        { return procedure.empty() ? std::string("主程序") : std::string(procedure); };
+
+        std::string text = "行" + std::to_string(decision.line) + "列" + std::to_string(decision.column) + " " +
+                           name(decision.caller);
+        if (decision.host != decision.caller)
+        {
+            text += "(内联于" + name(decision.host) + ")";
+        }
+        text += " -> " + std::string(decision.callee);
+        text += decision.inlined ? ": 已内联 (" + decision.reason + ")" : ": 未内联, " + decision.reason;
+        return text;
+    }
+
+    // 第一遍: 调用图、过程体大小和引用的外层名字
+
+    void Inliner::analyze(const Block &block, size_t id)
+    {
+        size_t index = 0;
+        for (const auto *decl : block.consts())
+        {
+            scope_.declare(decl->symbol(), Symbol{
+                                               .type = SymbolType::Constant,
+                                               .value = decl->value(),
+                                               .level = level_,
+                                               .index = 0,
+                                               .name = decl->symbol()});
+        }
+        for (const auto *decl : block.vars())
+        {
+            scope_.declare(decl->symbol(), Symbol{
+                                               .type = SymbolType::Variable,
+                                               .value = std::nullopt,
+                                               .level = level_,
+                                               .index = index++,
+                                               .name = decl->symbol()});
+        }
+
+        procedures_[id].nested = !block.procedures().empty();
+        procedures_[id].readsFirst.assign(index, false);
+        for (const auto *decl : block.procedures())
+        {
+            size_t child = procedures_.size();
+            procedures_.push_back(Procedure{.decl = decl, .level = level_ + 1});
+            ids_.emplace(decl, child);
+            scope_.declare(decl->symbol(), Symbol{
+                                               .type = SymbolType::Procedure,
+                                               .value = static_cast<int64_t>(child),
+                                               .level = level_,
+                                               .index = 0,
+                                               .name = decl->symbol()});
+            ++level_;
+            scope_.enterScope();
+            analyze(decl->block(), child);
+            scope_.leaveScope();
+            --level_;
+        }
+
+        assigned_.assign(index, false);
+        analyze(block.statement(), id);
+    }
+
+    void Inliner::analyze(const Statement &node, size_t id)
+    {
+        ++procedures_[id].size;
+        switch (node.kind())
+        {
+        case NodeKind::AssignStatement:
+        {
+            const auto &assign = static_cast<const AssignStatement &>(node);
+            reference(assign.symbol(), id);
+            analyze(assign.expression(), id);
+            if (auto index = local(assign.symbol(), id))
+            {
+                assigned_[*index] = true;
+            }
+            break;
+        }
+        case NodeKind::CallStatement:
+        {
+            const auto &call = static_cast<const CallStatement &>(node);
+            const Symbol *symbol = scope_.lookup(call.symbol());
+            procedures_[id].callees.push_back(static_cast<size_t>(*symbol->value));
+            reference(call.symbol(), id);
+            break;
+        }
+        case NodeKind::BeginStatement:
+            for (const auto *stmt : static_cast<const BeginStatement &>(node).statements())
+            {
+                analyze(*stmt, id);
+            }
+            break;
+        case NodeKind::IfStatement:
+        {
+            // 分支和循环体可能不执行，其中的赋值不算一定已赋值
+            const auto &branch = static_cast<const IfStatement &>(node);
+            analyze(branch.condition(), id);
+            auto assigned = assigned_;
+            analyze(branch.thenStmt(), id);
+            assigned_ = std::move(assigned);
+            break;
+        }
+        case NodeKind::WhileStatement:
+        {
+            const auto &loop = static_cast<const WhileStatement &>(node);
+            analyze(loop.condition(), id);
+            auto assigned = assigned_;
+            analyze(loop.body(), id);
+            assigned_ = std::move(assigned);
+            break;
+        }
+        default:
+            __builtin_unreachable();
+        }
+    }
+
+    void Inliner::analyze(const Expression &node, size_t id)
+    {
+        ++procedures_[id].size;
+        switch (node.kind())
+        {
+        case NodeKind::BinaryExpression:
+        {
+            const auto &binary = static_cast<const BinaryExpression &>(node);
+            analyze(binary.left(), id);
+            analyze(binary.right(), id);
+            break;
+        }
+        case NodeKind::UnaryExpression:
+            analyze(static_cast<const UnaryExpression &>(node).operand(), id);
+            break;
+        case NodeKind::IdentifierExpression:
+        {
+            SymbolId name = static_cast<const IdentifierExpression &>(node).symbol();
+            reference(name, id);
+            if (auto index = local(name, id); index && !assigned_[*index])
+            {
+                procedures_[id].readsFirst[*index] = true;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    void Inliner::reference(SymbolId name, size_t id)
+    {
+        const Symbol *symbol = scope_.lookup(name);
+        if (symbol->type == SymbolType::Constant)
+        {
+            // 外层常量在调用处可能被同名的常量或变量遮蔽，展开时直接换成数值
+            if (symbol->level != procedures_[id].level)
+            {
+                procedures_[id].constants.emplace(name, *symbol->value);
+            }
+            return;
+        }
+        if (symbol->type == SymbolType::Variable && symbol->level == procedures_[id].level)
+        {
+            return;
+        }
+        procedures_[id].outside.emplace(name, *symbol);
+    }
+
+    // 过程自己的变量的序号，其他名字为空
+    std::optional<size_t> Inliner::local(SymbolId name, size_t id) const
+    {
+        const Symbol *symbol = scope_.lookup(name);
+        if (symbol->type == SymbolType::Variable && symbol->level == procedures_[id].level)
+        {
+            return symbol->index;
+        }
+        return std::nullopt;
+    }
+
+    // Tarjan强连通分量: 多于一个过程的分量和调用自身的过程都是递归的
+    void Inliner::markRecursive()
+    {
+        constexpr size_t UNVISITED = std::numeric_limits<size_t>::max();
+        const size_t count = procedures_.size();
+        std::vector<size_t> order(count, UNVISITED);
+        std::vector<size_t> low(count, 0);
+        std::vector<bool> on_stack(count, false);
+        std::vector<size_t> stack;
+        size_t next = 0;
+
+        auto connect = [&](auto &self, size_t v) -> void
+        {
+            order[v] = low[v] = next++;
+            stack.push_back(v);
+            on_stack[v] = true;
+            for (size_t w : procedures_[v].callees)
+            {
+                if (w == v)
+                {
+                    procedures_[v].recursive = true;
+                }
+                if (order[w] == UNVISITED)
+                {
+                    self(self, w);
+                    low[v] = std::min(low[v], low[w]);
+                }
+                else if (on_stack[w])
+                {
+                    low[v] = std::min(low[v], order[w]);
+                }
+            }
+            if (low[v] != order[v])
+            {
+                return;
+            }
+            size_t first = stack.size();
+            do
+            {
+                --first;
+            } while (stack[first] != v);
+            bool cycle = stack.size() - first > 1;
+            for (size_t i = first; i < stack.size(); ++i)
+            {
+                on_stack[stack[i]] = false;
+                procedures_[stack[i]].recursive = procedures_[stack[i]].recursive || cycle;
+            }
+            stack.resize(first);
+        };
+
+        for (size_t v = 0; v < count; ++v)
+        {
+            if (order[v] == UNVISITED)
+            {
+                connect(connect, v);
+            }
+        }
+    }
+
+    size_t Inliner::expandedSize(size_t id)
+    {
+        if (procedures_[id].expanded == 0)
+        {
+            size_t total = procedures_[id].size;
+            for (size_t callee : procedures_[id].callees)
+            {
+                if (inlinable(callee))
+                {
+                    total += expandedSize(callee) - 1;
+                }
+            }
+            procedures_[id].expanded = total;
+        }
+        return procedures_[id].expanded;
+    }
+
+    bool Inliner::inlinable(size_t id)
+    {
+        const auto &procedure = procedures_[id];
+        return id != 0 && !procedure.recursive && !procedure.nested && expandedSize(id) <= budget_;
+    }
+
+    // 第二遍: 变换
+
+    const Block *Inliner::transform(const Block &node)
+    {
+        size_t index = 0;
+        for (const auto *decl : node.consts())
+        {
+            scope_.declare(decl->symbol(), Symbol{
+                                               .type = SymbolType::Constant,
+                                               .value = decl->value(),
+                                               .level = level_,
+                                               .index = 0,
+                                               .name = decl->symbol()});
+        }
+        for (const auto *decl : node.vars())
+        {
+            scope_.declare(decl->symbol(), Symbol{
+                                               .type = SymbolType::Variable,
+                                               .value = std::nullopt,
+                                               .level = level_,
+                                               .index = index++,
+                                               .name = decl->symbol()});
+        }
+
+        std::vector<const ProcedureDeclaration *> procedures;
+        bool changed = false;
+        for (const auto *decl : node.procedures())
+        {
+            scope_.declare(decl->symbol(), Symbol{
+                                               .type = SymbolType::Procedure,
+                                               .value = static_cast<int64_t>(ids_.at(decl)),
+                                               .level = level_,
+                                               .index = 0,
+                                               .name = decl->symbol()});
+            procedures.push_back(transform(*decl));
+            changed |= procedures.back() != decl;
+        }
+
+        hosts_.emplace_back();
+        const Statement *statement = rewrite(node.statement());
+        Host host = std::move(hosts_.back());
+        hosts_.pop_back();
+
+        if (!changed && statement == &node.statement() && host.hidden.empty())
+        {
+            return &node;
+        }
+        auto vars = node.vars();
+        if (!host.hidden.empty())
+        {
+            std::vector<const VarDeclaration *> all(node.vars().begin(), node.vars().end());
+            all.insert(all.end(), host.hidden.begin(), host.hidden.end());
+            vars = arena().list(all);
+        }
+        return make<Block>(node, node.consts(), vars, changed ? arena().list(procedures) : node.procedures(),
+                           statement);
+    }
+
+    const ProcedureDeclaration *Inliner::transform(const ProcedureDeclaration &node)
+    {
+        size_t saved_procedure = procedure_;
+        procedure_ = ids_.at(&node);
+        ++level_;
+        scope_.enterScope();
+        const Block *block = transform(node.block());
+        scope_.leaveScope();
+        --level_;
+        procedure_ = saved_procedure;
+        return block == &node.block() ? &node : make<ProcedureDeclaration>(node, node.name(), node.symbol(), block);
+    }
+
+    const Statement *Inliner::transform(const AssignStatement &node)
+    {
+        const Expression *expr = rewrite(node.expression());
+        if (!expansions_.empty())
+        {
+            const auto &vars = expansions_.back().vars;
+            if (auto it = vars.find(node.symbol()); it != vars.end())
+            {
+                return make<AssignStatement>(node, it->second->name(), it->second->symbol(), expr);
+            }
+        }
+        return expr == &node.expression() ? &node : make<AssignStatement>(node, node.name(), node.symbol(), expr);
+    }
+
+    const Statement *Inliner::transform(const CallStatement &node)
+    {
+        size_t callee = static_cast<size_t>(*scope_.lookup(node.symbol())->value);
+        Decision decision{
+            .caller = procedureName(expansions_.empty() ? procedure_ : expansions_.back().callee),
+            .host = procedureName(procedure_),
+            .callee = procedureName(callee),
+            .line = node.line(),
+            .column = node.column(),
+            .inlined = false,
+            .reason = {}};
+
+        if (auto reason = refuse(callee))
+        {
+            decision.reason = std::move(*reason);
+            decisions_.push_back(std::move(decision));
+            return &node;
+        }
+        decision.inlined = true;
+        decision.reason = "节点数 " + std::to_string(expandedSize(callee));
+        decisions_.push_back(std::move(decision));
+
+        // 过程体内的调用在同一个宿主块中继续按各自的情况决定是否内联
+        expansions_.push_back(expand(callee));
+        const Block &block = procedures_[callee].decl->block();
+        std::vector<const Statement *> statements;
+        for (size_t i = 0; i < block.vars().size(); ++i)
+        {
+            if (procedures_[callee].readsFirst[i])
+            {
+                const VarDeclaration *hidden = expansions_.back().vars.at(block.vars()[i]->symbol());
+                statements.push_back(make<AssignStatement>(node, hidden->name(), hidden->symbol(),
+                                                           make<NumberExpression>(node, 0)));
+            }
+        }
+        const Statement *body = rewrite(block.statement());
+        expansions_.pop_back();
+        if (statements.empty())
+        {
+            return body;
+        }
+        statements.push_back(body);
+        return make<BeginStatement>(node, arena().list(statements));
+    }
+
+    const Expression *Inliner::transform(const IdentifierExpression &node)
+    {
+        if (!expansions_.empty())
+        {
+            const auto &expansion = expansions_.back();
+            if (auto it = expansion.vars.find(node.symbol()); it != expansion.vars.end())
+            {
+                return make<IdentifierExpression>(node, it->second->name(), it->second->symbol());
+            }
+            if (auto it = expansion.consts.find(node.symbol()); it != expansion.consts.end())
+            {
+                return make<NumberExpression>(node, it->second);
+            }
+        }
+        return &node;
+    }
+
+    std::optional<std::string> Inliner::refuse(size_t callee)
+    {
+        const auto &procedure = procedures_[callee];
+        if (procedure.recursive)
+        {
+            return "递归调用";
+        }
+        if (procedure.nested)
+        {
+            return "含嵌套过程";
+        }
+        if (size_t size = expandedSize(callee); size > budget_)
+        {
+            return "过程体过大 (节点数 " + std::to_string(size) + " > " + std::to_string(budget_) + ")";
+        }
+        for (const auto &[name, symbol] : procedure.outside)
+        {
+            const Symbol *here = scope_.lookup(name);
+            bool same = here && here->type == symbol.type &&
+                        (symbol.type == SymbolType::Procedure
+                             ? here->value == symbol.value
+                             : here->level == symbol.level && here->index == symbol.index);
+            if (!same)
+            {
+                return "名字" + std::string(symbols_.spelling(name)) + "在调用处指向不同的声明";
+            }
+        }
+        return std::nullopt;
+    }
+
+    Inliner::Expansion Inliner::expand(size_t callee)
+    {
+        Expansion expansion{.callee = callee, .vars = {}, .consts = procedures_[callee].constants};
+        const Block &block = procedures_[callee].decl->block();
+        for (const auto *decl : block.consts())
+        {
+            expansion.consts.emplace(decl->symbol(), decl->value());
+        }
+        size_t index = 0;
+        for (const auto *decl : block.vars())
+        {
+            expansion.vars.emplace(decl->symbol(), hiddenVariable(callee, index++, *decl));
+        }
+        return expansion;
+    }
+
+    // 名字形如"过程_变量"，用户标识符不含下划线，不会冲突；同一块内同名过程再加上过程编号
+    const VarDeclaration *Inliner::hiddenVariable(size_t callee, size_t index, const VarDeclaration &origin)
+    {
+        Host &host = hosts_.back();
+        const uint64_t key = (static_cast<uint64_t>(callee) << 32) | index;
+        if (auto it = host.slots.find(key); it != host.slots.end())
+        {
+            return it->second;
+        }
+
+        std::string name = std::string(procedureName(callee)) + "_" + std::string(origin.name());
+        if (auto it = host.names.find(name); it != host.names.end() && it->second != key)
+        {
+            name += "_" + std::to_string(callee);
+        }
+        host.names.emplace(name, key);
+
+        SymbolId symbol = symbols_.intern(name);
+        const VarDeclaration *variable = make<VarDeclaration>(origin, symbols_.spelling(symbol), symbol, true);
+        host.hidden.push_back(variable);
+        host.slots.emplace(key, variable);
+        return variable;
+    }
+
+    std::string_view Inliner::procedureName(size_t id) const noexcept
+    {
+        return procedures_[id].decl ? procedures_[id].decl->name() : std::string_view{};
+    }
+
+} // namespace pl0
@@ -0,0 +1,145 @@
+#include "../include/Interner.h"
+
+#include <cstring>
+
+namespace pl0
+{
+
+    SymbolId Interner::intern(std::string_view spelling)
+    {
+        if (slots_.empty())
+        {
+            grow();
+        }
+
+        uint32_t h = hash(spelling);
+        Slot &slot = slots_[probe(spelling, h)];
+        if (slot.id != INVALID_SYMBOL)
+        {
+            return slot.id;
+        }
+
+        auto id = static_cast<SymbolId>(spellings_.size());
+        spellings_.push_back(store(spelling));
+        slot = Slot{h, id};
+        if (spellings_.size() * 2 > slots_.size())
+        {
+            grow();
+        }
+        return id;
+    }
+
+    std::optional<SymbolId> Interner::find(std::string_view spelling) const
+    {
+        if (slots_.empty())
+        {
+            return std::nullopt;
+        }
+        const Slot &slot = slots_[probe(spelling, hash(spelling))];
+        if (slot.id == INVALID_SYMBOL)
+        {
+            return std::nullopt;
+        }
+        return slot.id;
+    }
+
+    namespace
+    {
+        template <typename Word>
+        Word load(const char *data) noexcept
+        {
+            Word word;
+            std::memcpy(&word, data, sizeof(Word));
+            return word;
+        }
+    }
+
+    uint32_t Interner::hash(std::string_view spelling) noexcept
+    {
+        // 每次混入8个字节，不足8字节的尾部用首尾两次重叠的定长读取拼出，避免按字节循环
+        constexpr uint64_t MULTIPLIER = 0x9E3779B97F4A7C15ull;
+        const char *data = spelling.data();
+        size_t length = spelling.size();
+        uint64_t h = length * MULTIPLIER;
+        auto mix = [&h](uint64_t word)
+        {
+            h = (h ^ word) * MULTIPLIER;
+            h ^= h >> 29;
+        };
+
+        if (length >= 8)
+        {
+            for (size_t i = 0; i + 8 < length; i += 8)
+            {
+                mix(load<uint64_t>(data + i));
+            }
+            mix(load<uint64_t>(data + length - 8));
+        }
+        else if (length >= 4)
+        {
+            mix(load<uint32_t>(data) | uint64_t{load<uint32_t>(data + length - 4)} << 32);
+        }
+        else if (length != 0)
+        {
+            auto byte = [data](size_t i) { return uint64_t{static_cast<unsigned char>(data[i])}; };
+            mix(byte(0) | byte(length / 2) << 8 | byte(length - 1) << 16);
+        }
+        return static_cast<uint32_t>(h ^ (h >> 32));
+    }
+
+    size_t Interner::probe(std::string_view spelling, uint32_t hash) const noexcept
+    {
+        size_t mask = slots_.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask)
+        {
+            const Slot &slot = slots_[i];
+            if (slot.id == INVALID_SYMBOL || (slot.hash == hash && spellings_[slot.id] == spelling))
+            {
+                return i;
+            }
+        }
+    }
+
+    void Interner::grow()
+    {
+        std::vector<Slot> old = std::move(slots_);
+        slots_.assign(old.empty() ? 64 : old.size() * 2, Slot{});
+        size_t mask = slots_.size() - 1;
+        for (const Slot &slot : old)
+        {
+            if (slot.id == INVALID_SYMBOL)
+            {
+                continue;
+            }
+            size_t i = slot.hash & mask;
+            while (slots_[i].id != INVALID_SYMBOL)
+            {
+                i = (i + 1) & mask;
+            }
+            slots_[i] = slot;
+        }
+    }
+
+    std::string_view Interner::store(std::string_view spelling)
+    {
+        // 超长拼写单独占用一块
+        if (spelling.size() > CHUNK_SIZE / 4)
+        {
+            auto &chunk = chunks_.emplace_back(std::make_unique<char[]>(spelling.size()));
+            std::memcpy(chunk.get(), spelling.data(), spelling.size());
+            return {chunk.get(), spelling.size()};
+        }
+
+        if (chunk_ == nullptr || chunk_used_ + spelling.size() > CHUNK_SIZE)
+        {
+            chunk_ = chunks_.emplace_back(std::make_unique<char[]>(CHUNK_SIZE)).get();
+            chunk_used_ = 0;
+        }
+
+        char *dest = chunk_ + chunk_used_;
+        std::memcpy(dest, spelling.data(), spelling.size());
+        chunk_used_ += spelling.size();
+        return {dest, spelling.size()};
+    }
+
+} // namespace pl0
@@ -0,0 +1,145 @@
+#include "../include/Jit.h"
+
+#include <chrono>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace pl0
+{
+
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        // 每次调用在调用栈上至多占用返回地址和3个常驻寄存器，而数据栈上至少占用一个帧头
+        constexpr size_t NATIVE_BYTES_PER_SLOT = 16;
+        // 表达式求值时临时寄存器不足而压栈的余量
+        constexpr size_t NATIVE_STACK_RESERVE = 1 << 16;
+
+        size_t pageAlign(size_t size)
+        {
+            auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            return (size + page - 1) / page * page;
+        }
+
+        uint8_t *map(size_t size, int flags = 0)
+        {
+            void *address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+            return address == MAP_FAILED ? nullptr : static_cast<uint8_t *>(address);
+        }
+    }
+
+    NativeImage::NativeImage(const NativeCode &code, size_t stack_size)
+        : code_(code), stack_size_(stack_size)
+    {
+        if (code_.empty() || code_.entry >= code_.bytes.size())
+        {
+            error_ = "运行时错误: 没有可执行的代码";
+            return;
+        }
+        if (stack_size_ < static_cast<size_t>(FRAME_HEADER))
+        {
+            error_ = "运行时错误: 栈空间不足";
+            return;
+        }
+
+        text_size_ = pageAlign(code_.bytes.size());
+        text_ = map(text_size_);
+        if (!text_)
+        {
+            error_ = "运行时错误: 无法分配可执行内存";
+            return;
+        }
+        std::memcpy(text_, code_.bytes.data(), code_.bytes.size());
+        if (mprotect(text_, text_size_, PROT_READ | PROT_EXEC) != 0)
+        {
+            error_ = "运行时错误: 无法分配可执行内存";
+            return;
+        }
+
+        native_stack_size_ = pageAlign(stack_size_ * NATIVE_BYTES_PER_SLOT + NATIVE_STACK_RESERVE);
+        native_stack_ = map(native_stack_size_, MAP_NORESERVE | MAP_STACK);
+        if (!native_stack_)
+        {
+            error_ = "运行时错误: 无法分配调用栈";
+        }
+    }
+
+    NativeImage::~NativeImage()
+    {
+        if (text_)
+        {
+            munmap(text_, text_size_);
+        }
+        if (native_stack_)
+        {
+            munmap(native_stack_, native_stack_size_);
+        }
+    }
+
+    NativeContext NativeImage::context(int64_t *stack) const noexcept
+    {
+        return NativeContext{
+            .stack_base = stack,
+            .stack_limit = stack + stack_size_,
+            .saved_rsp = nullptr,
+            .native_stack = native_stack_ + native_stack_size_};
+    }
+
+    int64_t NativeImage::run(int64_t *stack) const
+    {
+        using Entry = int64_t (*)(NativeContext *);
+        auto context = this->context(stack);
+        return reinterpret_cast<Entry>(text_ + code_.entry)(&context);
+    }
+
+    int64_t NativeImage::enter(int64_t *stack, int64_t *frame, size_t target) const
+    {
+        using Enter = int64_t (*)(NativeContext *, int64_t *, const void *);
+        auto context = this->context(stack);
+        return reinterpret_cast<Enter>(text_ + code_.enter)(&context, frame, text_ + target);
+    }
+
+    const char *NativeImage::message(int64_t status) noexcept
+    {
+        switch (status)
+        {
+        case NativeCode::DivisionByZero:
+            return "运行时错误: 除数为零";
+        case NativeCode::NegativeExponent:
+            return "运行时错误: 负指数";
+        case NativeCode::StackOverflow:
+            return "运行时错误: 栈溢出";
+        default:
+            return "运行时错误: 未知的执行状态";
+        }
+    }
+
+    ExecutionResult Jit::run()
+    {
+        ExecutionResult result;
+        NativeImage image(code_, stack_size_);
+        if (!image.valid())
+        {
+            result.success = false;
+            result.error = image.error();
+            return result;
+        }
+
+        std::vector<int64_t> stack(stack_size_);
+        auto start = Clock::now();
+        int64_t status = image.run(stack.data());
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        if (status != NativeCode::Ok)
+        {
+            result.success = false;
+            result.error = NativeImage::message(status);
+            return result;
+        }
+        result.globals.assign(stack.data() + FRAME_HEADER, stack.data() + FRAME_HEADER + code_.globals.size());
+        return result;
+    }
+
+} // namespace pl0
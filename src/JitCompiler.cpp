@@ -0,0 +1,1105 @@
+#include "../include/JitCompiler.h"
+#include "../include/PCode.h"
+
+#include <bit>
+#include <limits>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+namespace pl0
+{
+
+    using x86::Reg;
+    using x86::Cond;
+    using x86::Label;
+    using x86::at;
+
+    namespace
+    {
+        constexpr Reg FRAME = Reg::RBX;   // 当前帧
+        constexpr Reg STACK = Reg::R14;   // 数据栈基址
+        constexpr Reg CONTEXT = Reg::R15; // NativeContext
+        constexpr Reg SCRATCH = Reg::R11; // 除rax/rdx外的第三个暂存寄存器
+
+        // 临时寄存器，调用者保存
+        constexpr Reg TEMPS[] = {Reg::RCX, Reg::RSI, Reg::RDI, Reg::R8, Reg::R9, Reg::R10};
+        // 常驻寄存器(变量或display)，使用它们的过程负责保存和恢复
+        constexpr Reg HOMES[] = {Reg::RBP, Reg::R12, Reg::R13};
+        // 入口处按System V约定需要保存的寄存器
+        constexpr Reg CALLEE_SAVED[] = {Reg::RBX, Reg::RBP, Reg::R12, Reg::R13, Reg::R14, Reg::R15};
+
+        constexpr int32_t CONTEXT_STACK_BASE = offsetof(NativeContext, stack_base);
+        constexpr int32_t CONTEXT_STACK_LIMIT = offsetof(NativeContext, stack_limit);
+        constexpr int32_t CONTEXT_SAVED_RSP = offsetof(NativeContext, saved_rsp);
+        constexpr int32_t CONTEXT_NATIVE_STACK = offsetof(NativeContext, native_stack);
+
+        // 循环内的使用按嵌套深度加权
+        constexpr uint64_t LOOP_WEIGHT = 8;
+        constexpr uint64_t MAX_WEIGHT = uint64_t{1} << 40;
+
+        bool fitsInt32(int64_t value) noexcept
+        {
+            return value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max();
+        }
+
+        // 有符号除以常数d(|d| >= 2)的魔数和移位量
+        std::pair<int64_t, int> divisionMagic(int64_t d) noexcept
+        {
+            constexpr uint64_t two63 = uint64_t{1} << 63;
+            uint64_t ad = d < 0 ? 0 - static_cast<uint64_t>(d) : static_cast<uint64_t>(d);
+            uint64_t t = two63 + (static_cast<uint64_t>(d) >> 63);
+            uint64_t anc = t - 1 - t % ad;
+            int p = 63;
+            uint64_t q1 = two63 / anc;
+            uint64_t r1 = two63 - q1 * anc;
+            uint64_t q2 = two63 / ad;
+            uint64_t r2 = two63 - q2 * ad;
+            uint64_t delta = 0;
+            do
+            {
+                ++p;
+                q1 *= 2;
+                r1 *= 2;
+                if (r1 >= anc)
+                {
+                    ++q1;
+                    r1 -= anc;
+                }
+                q2 *= 2;
+                r2 *= 2;
+                if (r2 >= ad)
+                {
+                    ++q2;
+                    r2 -= ad;
+                }
+                delta = ad - r2;
+            } while (q1 < delta || (q1 == delta && r1 == 0));
+
+            auto magic = static_cast<int64_t>(q2 + 1);
+            return {d < 0 ? static_cast<int64_t>(0 - static_cast<uint64_t>(magic)) : magic, p - 64};
+        }
+
+        std::optional<Cond> condition(BinaryExpression::Op op) noexcept
+        {
+            switch (op)
+            {
+            case BinaryExpression::Op::Eq:
+                return Cond::E;
+            case BinaryExpression::Op::Neq:
+                return Cond::NE;
+            case BinaryExpression::Op::Lt:
+                return Cond::L;
+            case BinaryExpression::Op::Lte:
+                return Cond::LE;
+            case BinaryExpression::Op::Gt:
+                return Cond::G;
+            case BinaryExpression::Op::Gte:
+                return Cond::GE;
+            default:
+                return std::nullopt;
+            }
+        }
+    }
+
+    static_assert(std::size(TEMPS) == 6 && std::size(HOMES) == 3);
+
+    NativeCode JitCompiler::compile(const Program &program)
+    {
+        as_ = x86::Assembler{};
+        code_ = NativeCode{};
+        procedures_.clear();
+        loops_.clear();
+        frame_ = Frame{};
+        level_ = 0;
+        temp_busy_ = {};
+        div_zero_ = as_.newLabel();
+        negative_exponent_ = as_.newLabel();
+        stack_overflow_ = as_.newLabel();
+
+        // 入口: 保存宿主寄存器，切换到独立的调用栈，建立主帧后调用主程序块
+        Label main = as_.newLabel();
+        Label exit = as_.newLabel();
+        for (Reg reg : CALLEE_SAVED)
+        {
+            as_.push(reg);
+        }
+        as_.mov(CONTEXT, Reg::RDI);
+        as_.mov(at(CONTEXT, CONTEXT_SAVED_RSP), Reg::RSP);
+        as_.mov(Reg::RSP, at(CONTEXT, CONTEXT_NATIVE_STACK));
+        as_.mov(STACK, at(CONTEXT, CONTEXT_STACK_BASE));
+        as_.mov(FRAME, STACK);
+        for (int32_t slot = 0; slot < static_cast<int32_t>(FRAME_HEADER); ++slot)
+        {
+            as_.mov(at(FRAME, slot * 8), 0);
+        }
+        as_.call(main);
+        as_.mov(Reg::RAX, int64_t{NativeCode::Ok});
+
+        // 正常返回和运行时错误都从这里恢复宿主栈
+        as_.bind(exit);
+        as_.mov(Reg::RSP, at(CONTEXT, CONTEXT_SAVED_RSP));
+        for (auto it = std::rbegin(CALLEE_SAVED); it != std::rend(CALLEE_SAVED); ++it)
+        {
+            as_.pop(*it);
+        }
+        as_.ret();
+
+        // 分层执行的入口: rsi为当前帧，rdx为目标地址
+        code_.enter = as_.size();
+        for (Reg reg : CALLEE_SAVED)
+        {
+            as_.push(reg);
+        }
+        as_.mov(CONTEXT, Reg::RDI);
+        as_.mov(at(CONTEXT, CONTEXT_SAVED_RSP), Reg::RSP);
+        as_.mov(Reg::RSP, at(CONTEXT, CONTEXT_NATIVE_STACK));
+        as_.mov(STACK, at(CONTEXT, CONTEXT_STACK_BASE));
+        as_.mov(FRAME, Reg::RSI);
+        as_.call(Reg::RDX);
+        as_.mov(Reg::RAX, int64_t{NativeCode::Ok});
+        as_.jmp(exit);
+
+        for (auto [label, status] : {std::pair{div_zero_, NativeCode::DivisionByZero},
+                                     std::pair{negative_exponent_, NativeCode::NegativeExponent},
+                                     std::pair{stack_overflow_, NativeCode::StackOverflow}})
+        {
+            as_.bind(label);
+            as_.mov(Reg::RAX, int64_t{status});
+            as_.jmp(exit);
+        }
+
+        pending_entry_ = main;
+        walk(program);
+
+        if (!as_.finalize())
+        {
+            throw std::runtime_error("代码生成: 存在未绑定的跳转目标");
+        }
+        code_.bytes = as_.code();
+        code_.entry = 0;
+        for (Label label : procedures_)
+        {
+            code_.procedures.push_back(as_.offset(label));
+        }
+        for (Label label : loops_)
+        {
+            code_.loops.push_back(as_.offset(label));
+        }
+        return std::move(code_);
+    }
+
+    void JitCompiler::visit(const Program &node)
+    {
+        symbols_.enterScope();
+        walk(node.block());
+        symbols_.leaveScope();
+    }
+
+    void JitCompiler::visit(const Block &node)
+    {
+        Label entry = pending_entry_;
+        Frame saved = std::exchange(frame_, Frame{});
+
+        for (const auto *decl : node.consts())
+        {
+            walk(*decl);
+        }
+        for (const auto *decl : node.vars())
+        {
+            walk(*decl);
+        }
+        // 嵌套过程的代码放在本块之前
+        for (const auto *decl : node.procedures())
+        {
+            walk(*decl);
+        }
+
+        frame_.size = FRAME_HEADER + frame_.var_count;
+        frame_.var_uses.assign(frame_.var_count, 0);
+        frame_.display_uses.assign(level_ + 1, 0);
+        countUses(node.statement(), 1);
+        assignHomes(node.procedures().empty());
+
+        as_.bind(entry);
+
+        // 与虚拟机的INT相同，另留出下一次调用写帧头的空间
+        as_.lea(Reg::RAX, at(FRAME, slotOffset(frame_.size + FRAME_HEADER)));
+        as_.cmp(Reg::RAX, at(CONTEXT, CONTEXT_STACK_LIMIT));
+        as_.jcc(Cond::A, stack_overflow_);
+
+        // 变量的初值为0，常驻寄存器中的和留在数据栈中的都要清零
+        saveHomes();
+        for (size_t i = 0; i < frame_.var_homes.size(); ++i)
+        {
+            if (int home = frame_.var_homes[i]; home >= 0)
+            {
+                as_.mov(HOMES[home], int64_t{0});
+            }
+            else
+            {
+                as_.mov(at(FRAME, slotOffset(FRAME_HEADER + i)), int32_t{0});
+            }
+        }
+        loadDisplay();
+
+        // 尾位置按语句在树中的位置逐层传递，不比较节点地址: 内联后同一个调用节点可能出现在多处
+        frame_.tail = level_ > 0;
+        walk(node.statement());
+
+        // 主程序的变量结果从数据栈读取，常驻寄存器的变量需要写回
+        if (level_ == 0)
+        {
+            for (size_t i = 0; i < frame_.var_homes.size(); ++i)
+            {
+                if (frame_.var_homes[i] >= 0)
+                {
+                    as_.mov(at(FRAME, slotOffset(FRAME_HEADER + i)), HOMES[frame_.var_homes[i]]);
+                }
+            }
+        }
+        for (size_t i = frame_.homes_used; i > 0; --i)
+        {
+            as_.pop(HOMES[i - 1]);
+        }
+        as_.ret();
+
+        // OSR入口放在过程体之后: 解释器已经建立了帧并检查过栈空间，变量的当前值都在帧中
+        for (auto [osr, cond] : frame_.osr)
+        {
+            as_.bind(osr);
+            saveHomes();
+            for (size_t i = 0; i < frame_.var_homes.size(); ++i)
+            {
+                if (frame_.var_homes[i] >= 0)
+                {
+                    as_.mov(HOMES[frame_.var_homes[i]], at(FRAME, slotOffset(FRAME_HEADER + i)));
+                }
+            }
+            loadDisplay();
+            as_.jmp(cond);
+        }
+
+        frame_ = std::move(saved);
+    }
+
+    void JitCompiler::visit(const ConstDeclaration &node)
+    {
+        symbols_.declare(node.symbol(), Symbol{
+                                            .type = SymbolType::Constant,
+                                            .value = node.value(),
+                                            .level = level_,
+                                            .index = 0,
+                                            .name = node.symbol()});
+    }
+
+    void JitCompiler::visit(const VarDeclaration &node)
+    {
+        if (level_ == 0 && !node.hidden())
+        {
+            code_.globals.push_back(node.name());
+        }
+        symbols_.declare(node.symbol(), Symbol{
+                                            .type = SymbolType::Variable,
+                                            .value = std::nullopt,
+                                            .level = level_,
+                                            .index = frame_.var_count++,
+                                            .name = node.symbol()});
+    }
+
+    void JitCompiler::visit(const ProcedureDeclaration &node)
+    {
+        Label entry = as_.newLabel();
+        procedures_.push_back(entry);
+        symbols_.declare(node.symbol(), Symbol{
+                                            .type = SymbolType::Procedure,
+                                            .value = static_cast<int64_t>(procedures_.size() - 1),
+                                            .level = level_,
+                                            .index = 0,
+                                            .name = node.symbol()});
+
+        ++level_;
+        symbols_.enterScope();
+        pending_entry_ = entry;
+        walk(node.block());
+        symbols_.leaveScope();
+        --level_;
+    }
+
+    void JitCompiler::visit(const AssignStatement &node)
+    {
+        const Symbol &symbol = resolve(node.symbol());
+        const Expression &expr = node.expression();
+
+        if (distance(symbol) == 0 && frame_.var_homes[symbol.index] >= 0)
+        {
+            Reg home = HOMES[frame_.var_homes[symbol.index]];
+
+            // x := x op 叶子，直接在常驻寄存器上运算
+            if (expr.kind() == NodeKind::BinaryExpression)
+            {
+                const auto &binary = static_cast<const BinaryExpression &>(expr);
+                bool in_place = binary.op() == BinaryExpression::Op::Add ||
+                                binary.op() == BinaryExpression::Op::Sub ||
+                                binary.op() == BinaryExpression::Op::Mul;
+                if (in_place && binary.left().kind() == NodeKind::IdentifierExpression &&
+                    static_cast<const IdentifierExpression &>(binary.left()).symbol() == node.symbol() &&
+                    isLeaf(binary.right()))
+                {
+                    apply(binary.op(), home, leaf(binary.right()));
+                    return;
+                }
+            }
+
+            if (isLeaf(expr))
+            {
+                Operand value = leaf(expr);
+                switch (value.kind)
+                {
+                case Operand::Kind::Imm:
+                    as_.mov(home, value.imm);
+                    break;
+                case Operand::Kind::Reg:
+                    as_.mov(home, value.reg);
+                    break;
+                case Operand::Kind::Mem:
+                    as_.mov(home, value.mem);
+                    break;
+                }
+                return;
+            }
+
+            Reg value = evaluate(expr);
+            as_.mov(home, value);
+            free(value);
+            return;
+        }
+
+        if (isLeaf(expr))
+        {
+            Operand value = leaf(expr);
+            if (value.kind == Operand::Kind::Imm && fitsInt32(value.imm))
+            {
+                as_.mov(variable(symbol), static_cast<int32_t>(value.imm));
+                return;
+            }
+        }
+
+        // 先求值再定位变量，定位外层变量时会用到rax
+        Reg value = evaluate(expr);
+        as_.mov(variable(symbol), value);
+        free(value);
+    }
+
+    void JitCompiler::visit(const CallStatement &node)
+    {
+        const Symbol &symbol = resolve(node.symbol());
+        int32_t callee = slotOffset(frame_.size);
+
+        // 尾调用: 改写当前帧的SL，恢复常驻寄存器后跳到被调用者，由它直接返回到当前过程的调用者；
+        // 被调用者的序言清零全部变量，复用的帧不保留当前过程的值
+        if (frame_.tail && distance(symbol) > 0)
+        {
+            loadFrameIndex(Reg::RDX, distance(symbol));
+            as_.mov(at(FRAME, 0), Reg::RDX);
+            for (size_t i = frame_.homes_used; i > 0; --i)
+            {
+                as_.pop(HOMES[i - 1]);
+            }
+            as_.jmp(procedures_[static_cast<size_t>(*symbol.value)]);
+            return;
+        }
+
+        // 被调用者的帧紧接在当前帧之后，写入SL和DL(数据栈下标)
+        loadFrameIndex(Reg::RDX, distance(symbol));
+        as_.mov(at(FRAME, callee), Reg::RDX);
+        loadFrameIndex(Reg::RDX, 0);
+        as_.mov(at(FRAME, callee + 8), Reg::RDX);
+
+        as_.lea(FRAME, at(FRAME, callee));
+        as_.call(procedures_[static_cast<size_t>(*symbol.value)]);
+        as_.lea(FRAME, at(FRAME, -callee));
+    }
+
+    void JitCompiler::visit(const BeginStatement &node)
+    {
+        bool tail = frame_.tail;
+        const auto &statements = node.statements();
+        for (size_t i = 0; i < statements.size(); ++i)
+        {
+            frame_.tail = tail && i + 1 == statements.size();
+            walk(*statements[i]);
+        }
+        frame_.tail = tail;
+    }
+
+    void JitCompiler::visit(const IfStatement &node)
+    {
+        Label skip = as_.newLabel();
+        branch(node.condition(), false, skip);
+        walk(node.thenStmt());
+        as_.bind(skip);
+    }
+
+    void JitCompiler::visit(const WhileStatement &node)
+    {
+        // 条件后置: jmp cond; body: ...; cond: 条件成立时跳回body
+        Label body = as_.newLabel();
+        Label cond = as_.newLabel();
+        Label osr = as_.newLabel();
+        loops_.push_back(osr);
+        frame_.osr.emplace_back(osr, cond);
+        as_.jmp(cond);
+        as_.bind(body);
+        bool tail = std::exchange(frame_.tail, false);
+        walk(node.body());
+        frame_.tail = tail;
+        as_.bind(cond);
+        branch(node.condition(), true, body);
+    }
+
+    void JitCompiler::saveHomes()
+    {
+        for (size_t i = 0; i < frame_.homes_used; ++i)
+        {
+            as_.push(HOMES[i]);
+        }
+    }
+
+    void JitCompiler::loadDisplay()
+    {
+        for (size_t d = 1; d < frame_.display.size(); ++d)
+        {
+            if (frame_.display[d] >= 0)
+            {
+                Reg reg = HOMES[frame_.display[d]];
+                as_.mov(reg, at(FRAME, 0));
+                for (size_t i = 1; i < d; ++i)
+                {
+                    as_.mov(reg, at(STACK, reg, 0));
+                }
+                as_.lea(reg, at(STACK, reg, 0));
+            }
+        }
+    }
+
+    void JitCompiler::countUses(const Statement &stmt, uint64_t weight)
+    {
+        pl0::visit(stmt, [this, weight](const auto &node)
+                   {
+            using Node = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<Node, AssignStatement>)
+            {
+                const Symbol &symbol = resolve(node.symbol());
+                if (distance(symbol) == 0)
+                {
+                    frame_.var_uses[symbol.index] += weight;
+                }
+                else
+                {
+                    frame_.display_uses[distance(symbol)] += weight;
+                }
+                countUses(node.expression(), weight);
+            }
+            else if constexpr (std::is_same_v<Node, CallStatement>)
+            {
+                size_t d = distance(resolve(node.symbol()));
+                if (d > 0)
+                {
+                    frame_.display_uses[d] += weight;
+                }
+            }
+            else if constexpr (std::is_same_v<Node, BeginStatement>)
+            {
+                for (const auto *child : node.statements())
+                {
+                    countUses(*child, weight);
+                }
+            }
+            else if constexpr (std::is_same_v<Node, IfStatement>)
+            {
+                countUses(node.condition(), weight);
+                countUses(node.thenStmt(), weight);
+            }
+            else
+            {
+                uint64_t inner = std::min(weight * LOOP_WEIGHT, MAX_WEIGHT);
+                countUses(node.condition(), inner);
+                countUses(node.body(), inner);
+            } });
+    }
+
+    void JitCompiler::countUses(const Expression &expr, uint64_t weight)
+    {
+        pl0::visit(expr, [this, weight](const auto &node)
+                   {
+            using Node = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<Node, IdentifierExpression>)
+            {
+                const Symbol &symbol = resolve(node.symbol());
+                if (symbol.type != SymbolType::Variable)
+                {
+                    return;
+                }
+                if (distance(symbol) == 0)
+                {
+                    frame_.var_uses[symbol.index] += weight;
+                }
+                else
+                {
+                    frame_.display_uses[distance(symbol)] += weight;
+                }
+            }
+            else if constexpr (std::is_same_v<Node, UnaryExpression>)
+            {
+                countUses(node.operand(), weight);
+            }
+            else if constexpr (std::is_same_v<Node, BinaryExpression>)
+            {
+                countUses(node.left(), weight);
+                countUses(node.right(), weight);
+            } });
+    }
+
+    void JitCompiler::assignHomes(bool locals_allowed)
+    {
+        struct Candidate
+        {
+            uint64_t weight;
+            bool is_var;
+            size_t index;
+        };
+
+        std::vector<Candidate> candidates;
+        if (locals_allowed)
+        {
+            for (size_t i = 0; i < frame_.var_uses.size(); ++i)
+            {
+                candidates.push_back(Candidate{frame_.var_uses[i], true, i});
+            }
+        }
+        // 只用一次的外层帧地址不值得在入口预先求出
+        for (size_t d = 1; d < frame_.display_uses.size(); ++d)
+        {
+            if (frame_.display_uses[d] > 1)
+            {
+                candidates.push_back(Candidate{frame_.display_uses[d], false, d});
+            }
+        }
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [](const Candidate &a, const Candidate &b)
+                         { return a.weight > b.weight; });
+
+        frame_.var_homes.assign(frame_.var_count, -1);
+        frame_.display.assign(level_ + 1, -1);
+        frame_.homes_used = 0;
+        for (const auto &candidate : candidates)
+        {
+            if (frame_.homes_used == HOME_COUNT || candidate.weight == 0)
+            {
+                break;
+            }
+            int home = static_cast<int>(frame_.homes_used++);
+            (candidate.is_var ? frame_.var_homes : frame_.display)[candidate.index] = home;
+        }
+    }
+
+    Reg JitCompiler::evaluate(const Expression &expr)
+    {
+        if (isLeaf(expr))
+        {
+            Operand value = leaf(expr);
+            Reg dst = allocate();
+            switch (value.kind)
+            {
+            case Operand::Kind::Imm:
+                as_.mov(dst, value.imm);
+                break;
+            case Operand::Kind::Reg:
+                as_.mov(dst, value.reg);
+                break;
+            case Operand::Kind::Mem:
+                as_.mov(dst, value.mem);
+                break;
+            }
+            return dst;
+        }
+
+        if (expr.kind() == NodeKind::BinaryExpression)
+        {
+            return evaluateBinary(static_cast<const BinaryExpression &>(expr));
+        }
+
+        const auto &unary = static_cast<const UnaryExpression &>(expr);
+        Reg dst = evaluate(unary.operand());
+        switch (unary.op())
+        {
+        case UnaryExpression::Op::Neg:
+            as_.neg(dst);
+            break;
+        case UnaryExpression::Op::Not:
+            as_.test(dst, dst);
+            as_.setcc(Cond::E, dst);
+            break;
+        case UnaryExpression::Op::Odd:
+            as_.and_(dst, 1);
+            break;
+        }
+        return dst;
+    }
+
+    Reg JitCompiler::evaluateBinary(const BinaryExpression &expr)
+    {
+        Reg dst = evaluate(expr.left());
+        Operand right = rightOperand(expr.right(), dst);
+        apply(expr.op(), dst, right);
+        release(right);
+        return dst;
+    }
+
+    bool JitCompiler::isLeaf(const Expression &expr) const
+    {
+        return expr.kind() == NodeKind::NumberExpression || expr.kind() == NodeKind::IdentifierExpression;
+    }
+
+    JitCompiler::Operand JitCompiler::leaf(const Expression &expr)
+    {
+        if (expr.kind() == NodeKind::NumberExpression)
+        {
+            return Operand{.kind = Operand::Kind::Imm, .imm = static_cast<const NumberExpression &>(expr).value()};
+        }
+
+        const Symbol &symbol = resolve(static_cast<const IdentifierExpression &>(expr).symbol());
+        if (symbol.type == SymbolType::Constant)
+        {
+            return Operand{.kind = Operand::Kind::Imm, .imm = *symbol.value};
+        }
+        if (distance(symbol) == 0 && frame_.var_homes[symbol.index] >= 0)
+        {
+            return Operand{.kind = Operand::Kind::Reg, .reg = HOMES[frame_.var_homes[symbol.index]]};
+        }
+        return Operand{.kind = Operand::Kind::Mem, .mem = variable(symbol)};
+    }
+
+    JitCompiler::Operand JitCompiler::rightOperand(const Expression &expr, Reg &left)
+    {
+        if (isLeaf(expr))
+        {
+            return leaf(expr);
+        }
+
+        // 临时寄存器将要用尽时把左操作数暂存到调用栈上，右操作数求值后还要一个寄存器取回它
+        if (std::count(temp_busy_.begin(), temp_busy_.end(), false) < 2)
+        {
+            as_.push(left);
+            free(left);
+            Reg right = evaluate(expr);
+            left = allocate();
+            as_.pop(left);
+            return Operand{.kind = Operand::Kind::Reg, .reg = right, .owned = true};
+        }
+        return Operand{.kind = Operand::Kind::Reg, .reg = evaluate(expr), .owned = true};
+    }
+
+    void JitCompiler::apply(BinaryExpression::Op op, Reg dst, const Operand &right)
+    {
+        // 不能编码为imm32的常数先装入暂存寄存器
+        auto materialize = [this](const Operand &operand) -> Operand
+        {
+            if (operand.kind == Operand::Kind::Imm && !fitsInt32(operand.imm))
+            {
+                as_.mov(SCRATCH, operand.imm);
+                return Operand{.kind = Operand::Kind::Reg, .reg = SCRATCH};
+            }
+            return operand;
+        };
+        auto load = [this](Reg target, const Operand &operand)
+        {
+            switch (operand.kind)
+            {
+            case Operand::Kind::Imm:
+                as_.mov(target, operand.imm);
+                break;
+            case Operand::Kind::Reg:
+                as_.mov(target, operand.reg);
+                break;
+            case Operand::Kind::Mem:
+                as_.mov(target, operand.mem);
+                break;
+            }
+        };
+
+        switch (op)
+        {
+        case BinaryExpression::Op::Add:
+        case BinaryExpression::Op::Sub:
+        {
+            bool add = op == BinaryExpression::Op::Add;
+            Operand value = materialize(right);
+            switch (value.kind)
+            {
+            case Operand::Kind::Imm:
+                add ? as_.add(dst, static_cast<int32_t>(value.imm)) : as_.sub(dst, static_cast<int32_t>(value.imm));
+                break;
+            case Operand::Kind::Reg:
+                add ? as_.add(dst, value.reg) : as_.sub(dst, value.reg);
+                break;
+            case Operand::Kind::Mem:
+                add ? as_.add(dst, value.mem) : as_.sub(dst, value.mem);
+                break;
+            }
+            return;
+        }
+        case BinaryExpression::Op::Mul:
+        {
+            Operand value = materialize(right);
+            switch (value.kind)
+            {
+            case Operand::Kind::Imm:
+                as_.imul(dst, dst, static_cast<int32_t>(value.imm));
+                break;
+            case Operand::Kind::Reg:
+                as_.imul(dst, value.reg);
+                break;
+            case Operand::Kind::Mem:
+                as_.imul(dst, value.mem);
+                break;
+            }
+            return;
+        }
+        case BinaryExpression::Op::Div:
+        {
+            if (right.kind == Operand::Kind::Imm)
+            {
+                int64_t divisor = right.imm;
+                if (divisor == 0)
+                {
+                    as_.jmp(div_zero_);
+                    return;
+                }
+                if (divisor == 1)
+                {
+                    return;
+                }
+                if (divisor == -1)
+                {
+                    as_.neg(dst);
+                    return;
+                }
+                if (divisor > 0 && std::has_single_bit(static_cast<uint64_t>(divisor)))
+                {
+                    // 向零取整: 负数先加上2^k-1再算术右移
+                    auto shift = static_cast<uint8_t>(std::countr_zero(static_cast<uint64_t>(divisor)));
+                    as_.mov(SCRATCH, dst);
+                    as_.sar(SCRATCH, 63);
+                    as_.shr(SCRATCH, static_cast<uint8_t>(64 - shift));
+                    as_.add(dst, SCRATCH);
+                    as_.sar(dst, shift);
+                    return;
+                }
+                // 乘以魔数取高64位代替idiv，见Hacker's Delight 10-4
+                auto [multiplier, shift] = divisionMagic(divisor);
+                as_.mov(Reg::RAX, multiplier);
+                as_.imulWide(dst);
+                if (divisor > 0 && multiplier < 0)
+                {
+                    as_.add(Reg::RDX, dst);
+                }
+                else if (divisor < 0 && multiplier > 0)
+                {
+                    as_.sub(Reg::RDX, dst);
+                }
+                if (shift > 0)
+                {
+                    as_.sar(Reg::RDX, static_cast<uint8_t>(shift));
+                }
+                // 商为负时加1，向零取整
+                as_.mov(dst, Reg::RDX);
+                as_.shr(Reg::RDX, 63);
+                as_.add(dst, Reg::RDX);
+                return;
+            }
+
+            // 除数为-1时idiv在INT64_MIN上会触发异常，单独取负
+            Label general = as_.newLabel();
+            Label done = as_.newLabel();
+            load(SCRATCH, right);
+            as_.test(SCRATCH, SCRATCH);
+            as_.jcc(Cond::E, div_zero_);
+            as_.cmp(SCRATCH, -1);
+            as_.jcc(Cond::NE, general);
+            as_.neg(dst);
+            as_.jmp(done);
+            as_.bind(general);
+            as_.mov(Reg::RAX, dst);
+            as_.cqo();
+            as_.idiv(SCRATCH);
+            as_.mov(dst, Reg::RAX);
+            as_.bind(done);
+            return;
+        }
+        case BinaryExpression::Op::Pow:
+        {
+            if (right.kind == Operand::Kind::Imm)
+            {
+                if (right.imm < 0)
+                {
+                    as_.jmp(negative_exponent_);
+                    return;
+                }
+                if (right.imm == 0)
+                {
+                    as_.mov(dst, int64_t{1});
+                    return;
+                }
+                if (right.imm == 1)
+                {
+                    return;
+                }
+                if (right.imm == 2)
+                {
+                    as_.imul(dst, dst);
+                    return;
+                }
+            }
+
+            // 平方求幂: rdx为指数的剩余位，rax累乘，dst逐次平方
+            Label loop = as_.newLabel();
+            Label skip = as_.newLabel();
+            Label done = as_.newLabel();
+            load(Reg::RDX, right);
+            as_.test(Reg::RDX, Reg::RDX);
+            as_.jcc(Cond::S, negative_exponent_);
+            as_.mov(Reg::RAX, int64_t{1});
+            as_.bind(loop);
+            as_.test(Reg::RDX, Reg::RDX);
+            as_.jcc(Cond::E, done);
+            as_.test(Reg::RDX, 1);
+            as_.jcc(Cond::E, skip);
+            as_.imul(Reg::RAX, dst);
+            as_.bind(skip);
+            as_.imul(dst, dst);
+            as_.shr(Reg::RDX, 1);
+            as_.jmp(loop);
+            as_.bind(done);
+            as_.mov(dst, Reg::RAX);
+            return;
+        }
+        case BinaryExpression::Op::Shl:
+        {
+            if (right.kind == Operand::Kind::Imm)
+            {
+                if (right.imm < 0)
+                {
+                    as_.jmp(negative_exponent_);
+                }
+                else if (right.imm >= 64)
+                {
+                    as_.mov(dst, int64_t{0});
+                }
+                else if (right.imm > 0)
+                {
+                    as_.shl(dst, static_cast<uint8_t>(right.imm));
+                }
+                return;
+            }
+
+            // 移位次数必须在cl中，而rcx是临时寄存器: 在SCRATCH中移位，借rax保存rcx
+            Label zero = as_.newLabel();
+            Label done = as_.newLabel();
+            load(Reg::RDX, right);
+            as_.test(Reg::RDX, Reg::RDX);
+            as_.jcc(Cond::S, negative_exponent_);
+            as_.cmp(Reg::RDX, 63);
+            as_.jcc(Cond::A, zero);
+            as_.mov(SCRATCH, dst);
+            as_.mov(Reg::RAX, Reg::RCX);
+            as_.mov(Reg::RCX, Reg::RDX);
+            as_.shlCl(SCRATCH);
+            as_.mov(Reg::RCX, Reg::RAX);
+            as_.mov(dst, SCRATCH);
+            as_.jmp(done);
+            as_.bind(zero);
+            as_.mov(dst, int64_t{0});
+            as_.bind(done);
+            return;
+        }
+        default:
+            compare(dst, right);
+            as_.setcc(*condition(op), dst);
+            return;
+        }
+    }
+
+    void JitCompiler::compare(Reg left, const Operand &right)
+    {
+        switch (right.kind)
+        {
+        case Operand::Kind::Imm:
+            if (fitsInt32(right.imm))
+            {
+                as_.cmp(left, static_cast<int32_t>(right.imm));
+            }
+            else
+            {
+                as_.mov(SCRATCH, right.imm);
+                as_.cmp(left, SCRATCH);
+            }
+            break;
+        case Operand::Kind::Reg:
+            as_.cmp(left, right.reg);
+            break;
+        case Operand::Kind::Mem:
+            as_.cmp(left, right.mem);
+            break;
+        }
+    }
+
+    void JitCompiler::branch(const Expression &cond, bool when, Label target)
+    {
+        if (cond.kind() == NodeKind::BinaryExpression)
+        {
+            const auto &binary = static_cast<const BinaryExpression &>(cond);
+            if (auto cc = condition(binary.op()))
+            {
+                // 左操作数已在常驻寄存器中时直接比较
+                if (isLeaf(binary.left()) && isLeaf(binary.right()))
+                {
+                    Operand left = leaf(binary.left());
+                    if (left.kind == Operand::Kind::Reg)
+                    {
+                        compare(left.reg, leaf(binary.right()));
+                        as_.jcc(when ? *cc : x86::invert(*cc), target);
+                        return;
+                    }
+                }
+
+                Reg left = evaluate(binary.left());
+                Operand right = rightOperand(binary.right(), left);
+                compare(left, right);
+                release(right);
+                free(left);
+                as_.jcc(when ? *cc : x86::invert(*cc), target);
+                return;
+            }
+        }
+
+        if (cond.kind() == NodeKind::UnaryExpression)
+        {
+            const auto &unary = static_cast<const UnaryExpression &>(cond);
+            if (unary.op() == UnaryExpression::Op::Not)
+            {
+                branch(unary.operand(), !when, target);
+                return;
+            }
+            if (unary.op() == UnaryExpression::Op::Odd)
+            {
+                Reg value = evaluate(unary.operand());
+                as_.test(value, 1);
+                free(value);
+                as_.jcc(when ? Cond::NE : Cond::E, target);
+                return;
+            }
+        }
+
+        Reg value = evaluate(cond);
+        as_.test(value, value);
+        free(value);
+        as_.jcc(when ? Cond::NE : Cond::E, target);
+    }
+
+    x86::Mem JitCompiler::variable(const Symbol &symbol)
+    {
+        int32_t offset = slotOffset(FRAME_HEADER + symbol.index);
+        size_t d = distance(symbol);
+        if (d == 0)
+        {
+            return at(FRAME, offset);
+        }
+        if (frame_.display[d] >= 0)
+        {
+            return at(HOMES[frame_.display[d]], offset);
+        }
+
+        // 沿静态链取外层帧的下标，返回的操作数使用rax，必须立即使用
+        as_.mov(Reg::RAX, at(FRAME, 0));
+        for (size_t i = 1; i < d; ++i)
+        {
+            as_.mov(Reg::RAX, at(STACK, Reg::RAX, 0));
+        }
+        return at(STACK, Reg::RAX, offset);
+    }
+
+    void JitCompiler::loadFrameIndex(Reg dst, size_t d)
+    {
+        if (d > 0 && frame_.display[d] < 0)
+        {
+            as_.mov(dst, at(FRAME, 0));
+            for (size_t i = 1; i < d; ++i)
+            {
+                as_.mov(dst, at(STACK, dst, 0));
+            }
+            return;
+        }
+
+        as_.mov(dst, d == 0 ? FRAME : HOMES[frame_.display[d]]);
+        as_.sub(dst, STACK);
+        as_.sar(dst, 3);
+    }
+
+    void JitCompiler::release(const Operand &operand)
+    {
+        if (operand.owned)
+        {
+            free(operand.reg);
+        }
+    }
+
+    Reg JitCompiler::allocate()
+    {
+        for (size_t i = 0; i < TEMP_COUNT; ++i)
+        {
+            if (!temp_busy_[i])
+            {
+                temp_busy_[i] = true;
+                return TEMPS[i];
+            }
+        }
+        throw std::runtime_error("代码生成: 临时寄存器不足");
+    }
+
+    void JitCompiler::free(Reg reg)
+    {
+        for (size_t i = 0; i < TEMP_COUNT; ++i)
+        {
+            if (TEMPS[i] == reg)
+            {
+                temp_busy_[i] = false;
+                return;
+            }
+        }
+    }
+
+    const Symbol &JitCompiler::resolve(SymbolId name) const
+    {
+        const Symbol *symbol = symbols_.lookup(name);
+        if (!symbol)
+        {
+            throw std::runtime_error("代码生成: 未解析的标识符");
+        }
+        return *symbol;
+    }
+
+    int32_t JitCompiler::slotOffset(size_t slot)
+    {
+        // 帧内偏移编码为disp32
+        if (slot > (std::numeric_limits<int32_t>::max() >> 4))
+        {
+            throw std::runtime_error("代码生成: 过程的变量过多");
+        }
+        return static_cast<int32_t>(slot * 8);
+    }
+
+} // namespace pl0
@@ -0,0 +1,476 @@
+#include "../include/LoopInvariantHoister.h"
+#include "../include/ConstantFolder.h"
+
+#include <utility>
+#include <algorithm>
+
+namespace pl0
+{
+
+    std::unique_ptr<Program> LoopInvariantHoister::run(std::unique_ptr<Program> program)
+    {
+        procedures_.assign(1, Procedure{});
+        ids_.clear();
+        variables_.clear();
+        variableCount_ = 0;
+        temporaryCount_ = 0;
+        reports_.clear();
+
+        scope_ = SymbolTable{};
+        analyze(program->block(), 0);
+        summarize();
+
+        scope_ = SymbolTable{};
+        procedure_ = 0;
+        return transform(std::move(program));
+    }
+
+    std::string LoopInvariantHoister::describe(const Report &report)
+    {
+        std::string where = report.procedure.empty() ? std::string("主程序") : "过程" + std::string(report.procedure);
+        return "行" + std::to_string(report.line) + "列" + std::to_string(report.column) + " " + where +
+               ": 外提 " + std::to_string(report.hoisted) + " 个不变表达式";
+    }
+
+    // 分析与变换共用: 常量和变量进入当前作用域，变量第一次出现时编号
+    void LoopInvariantHoister::declare(const Block &block)
+    {
+        for (const auto *decl : block.consts())
+        {
+            scope_.declare(decl->symbol(), Symbol{
+                                               .type = SymbolType::Constant,
+                                               .value = decl->value(),
+                                               .level = 0,
+                                               .index = 0,
+                                               .name = decl->symbol()});
+        }
+        for (const auto *decl : block.vars())
+        {
+            auto [it, inserted] = variables_.try_emplace(decl, variableCount_);
+            variableCount_ += inserted ? 1 : 0;
+            scope_.declare(decl->symbol(), Symbol{
+                                               .type = SymbolType::Variable,
+                                               .value = static_cast<int64_t>(it->second),
+                                               .level = 0,
+                                               .index = 0,
+                                               .name = decl->symbol()});
+        }
+    }
+
+    void LoopInvariantHoister::analyze(const Block &block, size_t id)
+    {
+        scope_.enterScope();
+        procedures_[id].firstVariable = variableCount_;
+        procedures_[id].variableCount = block.vars().size();
+        declare(block);
+        // 过程在声明之后才可见，与语义分析的规则一致
+        for (const auto *decl : block.procedures())
+        {
+            size_t callee = procedures_.size();
+            procedures_.push_back(Procedure{.decl = decl});
+            ids_.emplace(decl, callee);
+            scope_.declare(decl->symbol(), Symbol{
+                                               .type = SymbolType::Procedure,
+                                               .value = static_cast<int64_t>(callee),
+                                               .level = 0,
+                                               .index = 0,
+                                               .name = decl->symbol()});
+            analyze(decl->block(), callee);
+        }
+        analyze(block.statement(), id);
+        scope_.leaveScope();
+    }
+
+    void LoopInvariantHoister::analyze(const Statement &node, size_t id)
+    {
+        switch (node.kind())
+        {
+        case NodeKind::AssignStatement:
+            if (const Symbol *symbol = scope_.lookup(static_cast<const AssignStatement &>(node).symbol());
+                symbol && symbol->type == SymbolType::Variable)
+            {
+                procedures_[id].writes.push_back(static_cast<size_t>(*symbol->value));
+            }
+            break;
+        case NodeKind::CallStatement:
+            if (const Symbol *symbol = scope_.lookup(static_cast<const CallStatement &>(node).symbol());
+                symbol && symbol->type == SymbolType::Procedure)
+            {
+                procedures_[id].callees.push_back(static_cast<size_t>(*symbol->value));
+            }
+            break;
+        case NodeKind::BeginStatement:
+            for (const auto *stmt : static_cast<const BeginStatement &>(node).statements())
+            {
+                analyze(*stmt, id);
+            }
+            break;
+        case NodeKind::IfStatement:
+            analyze(static_cast<const IfStatement &>(node).thenStmt(), id);
+            break;
+        case NodeKind::WhileStatement:
+            analyze(static_cast<const WhileStatement &>(node).body(), id);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // 过程的副作用 = (直接赋值的 ∪ 被调过程的副作用) - 自己的变量，在调用图上迭代到不动点
+    void LoopInvariantHoister::summarize()
+    {
+        for (bool changed = true; changed;)
+        {
+            changed = false;
+            for (size_t id = procedures_.size(); id-- > 0;)
+            {
+                Procedure &procedure = procedures_[id];
+                std::vector<size_t> effects = procedure.writes;
+                for (size_t callee : procedure.callees)
+                {
+                    effects.insert(effects.end(), procedures_[callee].effects.begin(), procedures_[callee].effects.end());
+                }
+                std::erase_if(effects, [&procedure](size_t variable)
+                              { return variable >= procedure.firstVariable &&
+                                       variable < procedure.firstVariable + procedure.variableCount; });
+                std::sort(effects.begin(), effects.end());
+                effects.erase(std::unique(effects.begin(), effects.end()), effects.end());
+                if (effects != procedure.effects)
+                {
+                    procedure.effects = std::move(effects);
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    const Block *LoopInvariantHoister::transform(const Block &node)
+    {
+        scope_.enterScope();
+        declare(node);
+        std::vector<const ProcedureDeclaration *> procedures;
+        bool changed = false;
+        for (const auto *decl : node.procedures())
+        {
+            scope_.declare(decl->symbol(), Symbol{
+                                               .type = SymbolType::Procedure,
+                                               .value = static_cast<int64_t>(ids_.at(decl)),
+                                               .level = 0,
+                                               .index = 0,
+                                               .name = decl->symbol()});
+            procedures.push_back(transform(*decl));
+            changed |= procedures.back() != decl;
+        }
+
+        hidden_.emplace_back();
+        const Statement *statement = rewrite(node.statement());
+        std::vector<const VarDeclaration *> hidden = std::move(hidden_.back());
+        hidden_.pop_back();
+        scope_.leaveScope();
+
+        if (!changed && statement == &node.statement() && hidden.empty())
+        {
+            return &node;
+        }
+        auto vars = node.vars();
+        if (!hidden.empty())
+        {
+            std::vector<const VarDeclaration *> all(node.vars().begin(), node.vars().end());
+            all.insert(all.end(), hidden.begin(), hidden.end());
+            vars = arena().list(all);
+        }
+        return make<Block>(node, node.consts(), vars, changed ? arena().list(procedures) : node.procedures(),
+                           statement);
+    }
+
+    const ProcedureDeclaration *LoopInvariantHoister::transform(const ProcedureDeclaration &node)
+    {
+        size_t saved_procedure = std::exchange(procedure_, ids_.at(&node));
+        const ProcedureDeclaration *result = ASTTransformer::transform(node);
+        procedure_ = saved_procedure;
+        return result;
+    }
+
+    const Statement *LoopInvariantHoister::transform(const WhileStatement &node)
+    {
+        const auto &inner = static_cast<const WhileStatement &>(*ASTTransformer::transform(node));
+        Loop loop{.origin = &node};
+        modified(inner.body(), loop);
+        const Expression *condition = hoist(inner.condition(), loop);
+        const Statement *body = hoist(inner.body(), loop);
+        reports_.push_back(Report{
+            .procedure = procedureName(),
+            .line = node.line(),
+            .column = node.column(),
+            .hoisted = loop.preheader.size()});
+        if (loop.preheader.empty())
+        {
+            return &inner;
+        }
+
+        loop.preheader.push_back(make<WhileStatement>(node, condition, body));
+        return make<BeginStatement>(node, arena().list(loop.preheader));
+    }
+
+    // 条件中没有赋值和调用，只需看循环体
+    void LoopInvariantHoister::modified(const Statement &node, Loop &loop) const
+    {
+        switch (node.kind())
+        {
+        case NodeKind::AssignStatement:
+            if (const Symbol *symbol = scope_.lookup(static_cast<const AssignStatement &>(node).symbol());
+                symbol && symbol->type == SymbolType::Variable)
+            {
+                loop.modified.insert(static_cast<size_t>(*symbol->value));
+            }
+            break;
+        case NodeKind::CallStatement:
+            if (const Symbol *symbol = scope_.lookup(static_cast<const CallStatement &>(node).symbol());
+                symbol && symbol->type == SymbolType::Procedure)
+            {
+                const auto &effects = procedures_[static_cast<size_t>(*symbol->value)].effects;
+                loop.modified.insert(effects.begin(), effects.end());
+            }
+            break;
+        case NodeKind::BeginStatement:
+            for (const auto *stmt : static_cast<const BeginStatement &>(node).statements())
+            {
+                modified(*stmt, loop);
+            }
+            break;
+        case NodeKind::IfStatement:
+            modified(static_cast<const IfStatement &>(node).thenStmt(), loop);
+            break;
+        case NodeKind::WhileStatement:
+            modified(static_cast<const WhileStatement &>(node).body(), loop);
+            break;
+        default:
+            break;
+        }
+    }
+
+    const Statement *LoopInvariantHoister::hoist(const Statement &node, Loop &loop)
+    {
+        switch (node.kind())
+        {
+        case NodeKind::AssignStatement:
+        {
+            const auto &stmt = static_cast<const AssignStatement &>(node);
+            const Expression *expr = hoist(stmt.expression(), loop);
+            return expr == &stmt.expression() ? &node : make<AssignStatement>(node, stmt.name(), stmt.symbol(), expr);
+        }
+        case NodeKind::BeginStatement:
+        {
+            const auto &statements = static_cast<const BeginStatement &>(node).statements();
+            std::vector<const Statement *> result;
+            bool changed = false;
+            for (const auto *stmt : statements)
+            {
+                result.push_back(hoist(*stmt, loop));
+                changed |= result.back() != stmt;
+            }
+            return changed ? make<BeginStatement>(node, arena().list(result)) : &node;
+        }
+        case NodeKind::IfStatement:
+        {
+            const auto &stmt = static_cast<const IfStatement &>(node);
+            const Expression *condition = hoist(stmt.condition(), loop);
+            const Statement *then_stmt = hoist(stmt.thenStmt(), loop);
+            if (condition == &stmt.condition() && then_stmt == &stmt.thenStmt())
+            {
+                return &node;
+            }
+            return make<IfStatement>(node, condition, then_stmt);
+        }
+        case NodeKind::WhileStatement:
+        {
+            const auto &stmt = static_cast<const WhileStatement &>(node);
+            const Expression *condition = hoist(stmt.condition(), loop);
+            const Statement *body = hoist(stmt.body(), loop);
+            if (condition == &stmt.condition() && body == &stmt.body())
+            {
+                return &node;
+            }
+            return make<WhileStatement>(node, condition, body);
+        }
+        default:
+            return &node;
+        }
+    }
+
+    const Expression *LoopInvariantHoister::hoist(const Expression &expr, Loop &loop)
+    {
+        return materialize(inspect(expr, loop), loop);
+    }
+
+    // 不变的表达式原样返回，由上层决定外提整体还是其中的部分；可变的表达式返回其中不变部分已外提的结果
+    LoopInvariantHoister::Fact LoopInvariantHoister::inspect(const Expression &expr, Loop &loop)
+    {
+        switch (expr.kind())
+        {
+        case NodeKind::NumberExpression:
+            return Fact{&expr, true, true, static_cast<const NumberExpression &>(expr).value()};
+        case NodeKind::IdentifierExpression:
+        {
+            const Symbol *symbol = scope_.lookup(static_cast<const IdentifierExpression &>(expr).symbol());
+            if (symbol && symbol->type == SymbolType::Constant)
+            {
+                return Fact{&expr, true, true, symbol->value};
+            }
+            bool invariant = symbol && symbol->type == SymbolType::Variable &&
+                             !loop.modified.contains(static_cast<size_t>(*symbol->value));
+            return Fact{&expr, invariant, true, std::nullopt};
+        }
+        case NodeKind::UnaryExpression:
+        {
+            const auto &node = static_cast<const UnaryExpression &>(expr);
+            Fact operand = inspect(node.operand(), loop);
+            if (operand.invariant)
+            {
+                std::optional<int64_t> value;
+                if (operand.value)
+                {
+                    value = ConstantFolder::evaluate(node.op(), *operand.value).value;
+                }
+                return Fact{&expr, true, operand.trapFree, value};
+            }
+            const Expression *result = operand.expr == &node.operand()
+                                           ? &expr
+                                           : make<UnaryExpression>(node, node.op(), operand.expr);
+            return Fact{result, false, false, std::nullopt};
+        }
+        case NodeKind::BinaryExpression:
+        {
+            using Op = BinaryExpression::Op;
+            const auto &node = static_cast<const BinaryExpression &>(expr);
+            Fact left = inspect(node.left(), loop);
+            Fact right = inspect(node.right(), loop);
+            if (left.invariant && right.invariant)
+            {
+                bool trap_free = left.trapFree && right.trapFree;
+                if (node.op() == Op::Div)
+                {
+                    trap_free = trap_free && right.value && *right.value != 0;
+                }
+                else if (node.op() == Op::Pow || node.op() == Op::Shl)
+                {
+                    trap_free = trap_free && right.value && *right.value >= 0;
+                }
+                std::optional<int64_t> value;
+                if (left.value && right.value)
+                {
+                    if (auto folded = ConstantFolder::evaluate(node.op(), *left.value, *right.value))
+                    {
+                        value = folded->value;
+                    }
+                }
+                return Fact{&expr, true, trap_free, value};
+            }
+            const Expression *lhs = materialize(left, loop);
+            const Expression *rhs = materialize(right, loop);
+            const Expression *result = lhs == &node.left() && rhs == &node.right()
+                                           ? &expr
+                                           : make<BinaryExpression>(node, lhs, node.op(), rhs);
+            return Fact{result, false, false, std::nullopt};
+        }
+        default:
+            __builtin_unreachable();
+        }
+    }
+
+    // 不变的表达式能外提就整体外提，否则(会报错、是比较或常量)再看它的子表达式
+    const Expression *LoopInvariantHoister::materialize(const Fact &fact, Loop &loop)
+    {
+        if (!fact.invariant || fact.value)
+        {
+            return fact.expr;
+        }
+        const Expression &expr = *fact.expr;
+        if (expr.kind() == NodeKind::UnaryExpression)
+        {
+            const auto &node = static_cast<const UnaryExpression &>(expr);
+            if (node.op() == UnaryExpression::Op::Neg && fact.trapFree)
+            {
+                const VarDeclaration *variable = temporary(expr, loop);
+                return make<IdentifierExpression>(expr, variable->name(), variable->symbol());
+            }
+            const Expression *operand = hoist(node.operand(), loop);
+            return operand == &node.operand() ? &expr : make<UnaryExpression>(node, node.op(), operand);
+        }
+        if (expr.kind() == NodeKind::BinaryExpression)
+        {
+            using Op = BinaryExpression::Op;
+            const auto &node = static_cast<const BinaryExpression &>(expr);
+            bool arithmetic = node.op() == Op::Add || node.op() == Op::Sub || node.op() == Op::Mul ||
+                              node.op() == Op::Div || node.op() == Op::Pow || node.op() == Op::Shl;
+            if (arithmetic && fact.trapFree)
+            {
+                const VarDeclaration *variable = temporary(expr, loop);
+                return make<IdentifierExpression>(expr, variable->name(), variable->symbol());
+            }
+            const Expression *lhs = hoist(node.left(), loop);
+            const Expression *rhs = hoist(node.right(), loop);
+            if (lhs == &node.left() && rhs == &node.right())
+            {
+                return &expr;
+            }
+            return make<BinaryExpression>(node, lhs, node.op(), rhs);
+        }
+        return fact.expr;
+    }
+
+    // 名字形如"loop_3"，用户标识符不含下划线，内联生成的名字下划线后是标识符，都不会冲突
+    const VarDeclaration *LoopInvariantHoister::temporary(const Expression &expr, Loop &loop)
+    {
+        std::string structure = key(expr);
+        if (auto it = loop.temporaries.find(structure); it != loop.temporaries.end())
+        {
+            return it->second;
+        }
+
+        SymbolId symbol = symbols_.intern("loop_" + std::to_string(++temporaryCount_));
+        std::string_view name = symbols_.spelling(symbol);
+        const VarDeclaration *variable = make<VarDeclaration>(*loop.origin, name, symbol, true);
+        scope_.declare(symbol, Symbol{
+                                   .type = SymbolType::Variable,
+                                   .value = static_cast<int64_t>(variableCount_++),
+                                   .level = 0,
+                                   .index = 0,
+                                   .name = symbol});
+        hidden_.back().push_back(variable);
+        loop.preheader.push_back(make<AssignStatement>(*loop.origin, name, symbol, &expr));
+        loop.temporaries.emplace(std::move(structure), variable);
+        return variable;
+    }
+
+    // 同一循环内名字解析到同一声明，用SymbolId即可区分变量
+    std::string LoopInvariantHoister::key(const Expression &expr)
+    {
+        switch (expr.kind())
+        {
+        case NodeKind::NumberExpression:
+            return "#" + std::to_string(static_cast<const NumberExpression &>(expr).value());
+        case NodeKind::IdentifierExpression:
+            return "$" + std::to_string(static_cast<const IdentifierExpression &>(expr).symbol());
+        case NodeKind::UnaryExpression:
+        {
+            const auto &node = static_cast<const UnaryExpression &>(expr);
+            return "(" + std::to_string(static_cast<int>(node.op())) + " " + key(node.operand()) + ")";
+        }
+        case NodeKind::BinaryExpression:
+        {
+            const auto &node = static_cast<const BinaryExpression &>(expr);
+            return "(" + key(node.left()) + " " + std::to_string(static_cast<int>(node.op())) + " " +
+                   key(node.right()) + ")";
+        }
+        default:
+            __builtin_unreachable();
+        }
+    }
+
+    std::string_view LoopInvariantHoister::procedureName() const noexcept
+    {
+        return procedures_[procedure_].decl ? procedures_[procedure_].decl->name() : std::string_view{};
+    }
+
+} // namespace pl0
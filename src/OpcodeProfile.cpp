@@ -0,0 +1,56 @@
+#include "../include/OpcodeProfile.h"
+
+#include <algorithm>
+
+namespace pl0
+{
+
+    std::string_view OpcodeProfile::primitiveName(const Instruction &inst) noexcept
+    {
+        return inst.op == OpCode::OPR ? oprName(static_cast<Opr>(inst.argument)) : opcodeName(inst.op);
+    }
+
+    void OpcodeProfile::record(std::span<const Instruction> code, std::span<const uint64_t> counts)
+    {
+        auto leaders = blockLeaders(code);
+        size_t size = std::min(code.size(), counts.size());
+        for (size_t start = 0; start < size; ++start)
+        {
+            if (counts[start] == 0)
+            {
+                continue;
+            }
+            instructions_ += counts[start];
+            std::string sequence;
+            for (size_t end = start; end < size && end - start < MAX_LENGTH; ++end)
+            {
+                if (end > start && leaders[end])
+                {
+                    break;
+                }
+                if (end > start)
+                {
+                    sequence += ' ';
+                }
+                sequence += primitiveName(code[end]);
+                sequences_[sequence] += counts[start];
+            }
+        }
+        ++programs_;
+    }
+
+    void OpcodeProfile::write(std::ostream &out) const
+    {
+        std::vector<std::pair<std::string_view, uint64_t>> sorted(sequences_.begin(), sequences_.end());
+        std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b)
+                  { return a.second != b.second ? a.second > b.second : a.first < b.first; });
+
+        out << "# PL/0操作码序列剖析: " << programs_ << " 个程序, " << instructions_ << " 次分派\n"
+            << "# 次数 序列\n";
+        for (const auto &[sequence, count] : sorted)
+        {
+            out << count << ' ' << sequence << '\n';
+        }
+    }
+
+} // namespace pl0
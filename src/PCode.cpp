@@ -0,0 +1,124 @@
+#include "../include/PCode.h"
+
+#include <iomanip>
+#include <algorithm>
+
+namespace pl0
+{
+
+    std::string_view opcodeName(OpCode op) noexcept
+    {
+        switch (op)
+        {
+        case OpCode::LIT:
+            return "LIT";
+        case OpCode::OPR:
+            return "OPR";
+        case OpCode::LOD:
+            return "LOD";
+        case OpCode::STO:
+            return "STO";
+        case OpCode::CAL:
+            return "CAL";
+        case OpCode::INT:
+            return "INT";
+        case OpCode::JMP:
+            return "JMP";
+        case OpCode::JPC:
+            return "JPC";
+        }
+        return "???";
+    }
+
+    std::string_view oprName(Opr opr) noexcept
+    {
+        switch (opr)
+        {
+        case Opr::RET:
+            return "RET";
+        case Opr::NEG:
+            return "NEG";
+        case Opr::ADD:
+            return "ADD";
+        case Opr::SUB:
+            return "SUB";
+        case Opr::MUL:
+            return "MUL";
+        case Opr::DIV:
+            return "DIV";
+        case Opr::ODD:
+            return "ODD";
+        case Opr::EQ:
+            return "EQ";
+        case Opr::NEQ:
+            return "NEQ";
+        case Opr::LT:
+            return "LT";
+        case Opr::GTE:
+            return "GTE";
+        case Opr::GT:
+            return "GT";
+        case Opr::LTE:
+            return "LTE";
+        case Opr::POW:
+            return "POW";
+        case Opr::NOT:
+            return "NOT";
+        case Opr::SHL:
+            return "SHL";
+        }
+        return "???";
+    }
+
+    std::optional<SourceLine> locate(std::span<const SourceLine> positions, size_t address) noexcept
+    {
+        auto it = std::upper_bound(positions.begin(), positions.end(), address,
+                                   [](size_t value, const SourceLine &entry)
+                                   { return value < entry.address; });
+        if (it == positions.begin())
+        {
+            return std::nullopt;
+        }
+        return *(it - 1);
+    }
+
+    std::vector<bool> blockLeaders(std::span<const Instruction> code)
+    {
+        std::vector<bool> leaders(code.size() + 1, false);
+        if (!code.empty())
+        {
+            leaders[0] = true;
+        }
+        for (size_t i = 0; i < code.size(); ++i)
+        {
+            const auto &inst = code[i];
+            bool is_jump = inst.op == OpCode::JMP || inst.op == OpCode::JPC || inst.op == OpCode::CAL;
+            if (is_jump && inst.argument >= 0 && inst.argument < static_cast<int64_t>(code.size()))
+            {
+                leaders[static_cast<size_t>(inst.argument)] = true;
+            }
+            if (is_jump || (inst.op == OpCode::OPR && inst.argument == static_cast<int64_t>(Opr::RET)))
+            {
+                leaders[i + 1] = true;
+            }
+        }
+        leaders.resize(code.size());
+        return leaders;
+    }
+
+    void disassemble(const PCode &program, std::ostream &out)
+    {
+        for (size_t i = 0; i < program.code.size(); ++i)
+        {
+            const auto &inst = program.code[i];
+            out << std::setw(5) << i << "  " << opcodeName(inst.op) << ' '
+                << static_cast<int>(inst.level) << ' ' << inst.argument;
+            if (inst.op == OpCode::OPR)
+            {
+                out << "  ; " << oprName(static_cast<Opr>(inst.argument));
+            }
+            out << '\n';
+        }
+    }
+
+} // namespace pl0
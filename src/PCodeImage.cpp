@@ -0,0 +1,700 @@
+#include "../include/PCodeImage.h"
+
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+#include <type_traits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace pl0
+{
+
+    namespace
+    {
+        // 指令段按内存布局原样存放，只支持与写入方相同布局的小端机器
+        static_assert(std::endian::native == std::endian::little);
+        static_assert(std::is_trivially_copyable_v<Instruction> && sizeof(Instruction) == 16 &&
+                      offsetof(Instruction, argument) == 8);
+        static_assert(std::is_trivially_copyable_v<SourceLine> && sizeof(SourceLine) == 12);
+
+        constexpr char MAGIC[4] = {'P', 'L', '0', 'C'};
+        constexpr size_t SECTION_ALIGNMENT = 8;
+
+        enum Section : size_t
+        {
+            CODE,
+            PROCEDURES,
+            CONSTANTS,
+            POSITIONS,
+            GLOBALS,
+            STRINGS,
+            SECTION_COUNT
+        };
+
+        struct SectionEntry
+        {
+            uint64_t offset;
+            uint64_t count;
+        };
+
+        struct FileHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t header_size;
+            uint32_t instruction_size;
+            uint64_t source_size;
+            int64_t source_mtime;
+            uint64_t source_hash;
+            uint64_t file_size;
+            uint64_t payload_checksum; // 文件头之后所有字节的校验和
+            SectionEntry sections[SECTION_COUNT];
+            uint64_t header_checksum; // 本字段之前的文件头字节的校验和
+        };
+
+        // 字符串池中的一段
+        struct StringRef
+        {
+            uint32_t offset;
+            uint32_t length;
+        };
+
+        struct ProcedureRecord
+        {
+            StringRef name;
+            uint32_t entry;
+            uint32_t level;
+            int64_t frame_size;
+        };
+
+        struct ConstantRecord
+        {
+            StringRef name;
+            int64_t value;
+        };
+
+        // 按8字节字做FNV-1a，不足8字节的尾部逐字节处理
+        uint64_t checksum(const void *data, size_t size) noexcept
+        {
+            constexpr uint64_t PRIME = 1099511628211ull;
+            auto bytes = static_cast<const unsigned char *>(data);
+            uint64_t hash = 14695981039346656037ull;
+            size_t i = 0;
+            for (; i + 8 <= size; i += 8)
+            {
+                uint64_t word;
+                std::memcpy(&word, bytes + i, sizeof(word));
+                hash = (hash ^ word) * PRIME;
+            }
+            for (; i < size; ++i)
+            {
+                hash = (hash ^ bytes[i]) * PRIME;
+            }
+            return hash;
+        }
+
+        uint64_t headerChecksum(const FileHeader &header) noexcept
+        {
+            return checksum(&header, offsetof(FileHeader, header_checksum));
+        }
+
+        const FileHeader &headerOf(const unsigned char *data) noexcept
+        {
+            return *reinterpret_cast<const FileHeader *>(data);
+        }
+
+        template <typename T>
+        std::span<const T> sectionOf(const unsigned char *data, Section section) noexcept
+        {
+            const auto &entry = headerOf(data).sections[section];
+            return {reinterpret_cast<const T *>(data + entry.offset), static_cast<size_t>(entry.count)};
+        }
+
+        // 按段追加内容，每段起点对齐到8字节
+        class ImageBuilder
+        {
+        public:
+            ImageBuilder() : bytes_(sizeof(FileHeader), 0) {}
+
+            template <typename T>
+            void section(Section section, std::span<const T> items)
+            {
+                bytes_.resize((bytes_.size() + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT, 0);
+                header_.sections[section] = SectionEntry{bytes_.size(), items.size()};
+                const auto *begin = reinterpret_cast<const unsigned char *>(items.data());
+                bytes_.insert(bytes_.end(), begin, begin + items.size_bytes());
+            }
+
+            StringRef intern(std::string_view text)
+            {
+                StringRef ref{static_cast<uint32_t>(strings_.size()), static_cast<uint32_t>(text.size())};
+                strings_ += text;
+                return ref;
+            }
+
+            [[nodiscard]] const std::string &strings() const noexcept { return strings_; }
+            FileHeader &header() noexcept { return header_; }
+
+            std::vector<unsigned char> finish()
+            {
+                header_.file_size = bytes_.size();
+                header_.payload_checksum = checksum(bytes_.data() + sizeof(FileHeader),
+                                                    bytes_.size() - sizeof(FileHeader));
+                header_.header_checksum = headerChecksum(header_);
+                std::memcpy(bytes_.data(), &header_, sizeof(FileHeader));
+                return std::move(bytes_);
+            }
+
+        private:
+            FileHeader header_{};
+            std::vector<unsigned char> bytes_;
+            std::string strings_;
+        };
+
+        // 指令段的结构检查: 映射上的指令直接执行，改写过并重算了校验和的文件不能让虚拟机越界读写。
+        // 过程表按代码生成的先序排列，由层次可以确定每个过程的外层过程；从各过程入口沿控制流遍历，
+        // 要求每条指令只属于一个过程、入口之后先经INT分配登记的帧大小、LOD/STO/CAL的层差不超过
+        // 嵌套深度、变量下标在对应外层过程的帧内、调用的目标是以当前过程的外层为外层的过程，
+        // 表达式栈不会弹空，且每条指令的栈深度与顺序扫描的相同(虚拟机按顺序扫描预留栈空间)
+        const char *verifyCode(std::span<const Instruction> code, std::span<const ProcedureRecord> procedures,
+                               uint64_t globals)
+        {
+            constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+            constexpr int64_t MAX_FRAME_SIZE = std::numeric_limits<int32_t>::max();
+
+            // 每条指令的栈深度变化，RET之后从0开始
+            auto effect = [](const Instruction &inst) -> int64_t
+            {
+                switch (inst.op)
+                {
+                case OpCode::LIT:
+                case OpCode::LOD:
+                    return 1;
+                case OpCode::STO:
+                case OpCode::JPC:
+                    return -1;
+                case OpCode::OPR:
+                    switch (static_cast<Opr>(inst.argument))
+                    {
+                    case Opr::RET:
+                    case Opr::NEG:
+                    case Opr::ODD:
+                    case Opr::NOT:
+                        return 0;
+                    default:
+                        return -1;
+                    }
+                default:
+                    return 0;
+                }
+            };
+
+            // 每条指令弹出的操作数个数
+            auto operands = [](const Instruction &inst) -> int64_t
+            {
+                switch (inst.op)
+                {
+                case OpCode::STO:
+                case OpCode::JPC:
+                    return 1;
+                case OpCode::OPR:
+                    switch (static_cast<Opr>(inst.argument))
+                    {
+                    case Opr::RET:
+                        return 0;
+                    case Opr::NEG:
+                    case Opr::ODD:
+                    case Opr::NOT:
+                        return 1;
+                    default:
+                        return 2;
+                    }
+                default:
+                    return 0;
+                }
+            };
+
+            for (const auto &inst : code)
+            {
+                bool valid_opr = inst.argument >= 0 && inst.argument <= static_cast<int64_t>(Opr::SHL) &&
+                                 inst.argument != 7; // 7未使用
+                if (inst.op > OpCode::JPC || (inst.op == OpCode::OPR && !valid_opr))
+                {
+                    return "操作码无效";
+                }
+            }
+
+            if (code.empty() || procedures.empty() || procedures[0].entry != 0 || procedures[0].level != 0)
+            {
+                return "过程表无效";
+            }
+            std::vector<uint32_t> procedure_at(code.size(), NONE);
+            std::vector<uint32_t> parent(procedures.size(), NONE);
+            for (size_t i = 0; i < procedures.size(); ++i)
+            {
+                const auto &procedure = procedures[i];
+                if (procedure.entry >= code.size() || procedure_at[procedure.entry] != NONE ||
+                    procedure.frame_size < FRAME_HEADER || procedure.frame_size > MAX_FRAME_SIZE)
+                {
+                    return "过程表无效";
+                }
+                procedure_at[procedure.entry] = static_cast<uint32_t>(i);
+                // 先序中向前第一个层次更低的过程是外层过程，必须恰好低一层
+                for (size_t j = i; i > 0 && j-- > 0;)
+                {
+                    if (procedures[j].level < procedure.level)
+                    {
+                        parent[i] = procedures[j].level + 1 == procedure.level ? static_cast<uint32_t>(j) : NONE;
+                        break;
+                    }
+                }
+                if (i > 0 && parent[i] == NONE)
+                {
+                    return "过程表无效";
+                }
+            }
+            if (globals > static_cast<uint64_t>(procedures[0].frame_size - FRAME_HEADER))
+            {
+                return "过程表无效";
+            }
+
+            // 层差不超过过程的层次时，沿外层过程走level步
+            auto outer = [&](uint32_t procedure, uint8_t level)
+            {
+                for (uint8_t i = 0; i < level; ++i)
+                {
+                    procedure = parent[procedure];
+                }
+                return procedure;
+            };
+
+            struct State
+            {
+                uint32_t procedure = NONE;
+                int64_t depth = 0;
+                bool framed = false;
+            };
+            std::vector<State> states(code.size());
+            std::vector<size_t> pending;
+            auto reach = [&](int64_t target, State state)
+            {
+                if (target < 0 || target >= static_cast<int64_t>(code.size()))
+                {
+                    return false;
+                }
+                auto &seen = states[static_cast<size_t>(target)];
+                if (seen.procedure == NONE)
+                {
+                    seen = state;
+                    pending.push_back(static_cast<size_t>(target));
+                    return true;
+                }
+                return seen.procedure == state.procedure && seen.depth == state.depth && seen.framed == state.framed;
+            };
+
+            for (size_t i = 0; i < procedures.size(); ++i)
+            {
+                if (!reach(procedures[i].entry, State{.procedure = static_cast<uint32_t>(i)}))
+                {
+                    return "控制流无效";
+                }
+            }
+            while (!pending.empty())
+            {
+                size_t at = pending.back();
+                pending.pop_back();
+                State state = states[at];
+                const auto &inst = code[at];
+                const auto &procedure = procedures[state.procedure];
+                int64_t next = static_cast<int64_t>(at) + 1;
+
+                // 分配帧之前只有跳过嵌套过程的JMP
+                if (!state.framed && inst.op != OpCode::JMP && inst.op != OpCode::INT)
+                {
+                    return "控制流无效";
+                }
+                bool ret = inst.op == OpCode::OPR && inst.argument == static_cast<int64_t>(Opr::RET);
+                if (state.depth < operands(inst) || (ret && state.depth != 0))
+                {
+                    return "表达式栈无效";
+                }
+
+                bool reached = true;
+                switch (inst.op)
+                {
+                case OpCode::LOD:
+                case OpCode::STO:
+                    if (inst.level > procedure.level || inst.argument < FRAME_HEADER ||
+                        inst.argument >= procedures[outer(state.procedure, inst.level)].frame_size)
+                    {
+                        return "变量访问越界";
+                    }
+                    state.depth += effect(inst);
+                    reached = reach(next, state);
+                    break;
+                case OpCode::CAL:
+                {
+                    bool valid = inst.level <= procedure.level && inst.argument >= 0 &&
+                                 inst.argument < static_cast<int64_t>(code.size());
+                    uint32_t callee = valid ? procedure_at[static_cast<size_t>(inst.argument)] : NONE;
+                    if (callee == NONE || callee == 0 || parent[callee] != outer(state.procedure, inst.level))
+                    {
+                        return "调用目标无效";
+                    }
+                    reached = reach(next, state);
+                    break;
+                }
+                case OpCode::INT:
+                    if (state.framed || state.depth != 0 || inst.argument != procedure.frame_size)
+                    {
+                        return "帧大小无效";
+                    }
+                    state.framed = true;
+                    reached = reach(next, state);
+                    break;
+                case OpCode::JMP:
+                    reached = reach(inst.argument, state);
+                    break;
+                case OpCode::JPC:
+                    --state.depth;
+                    reached = reach(inst.argument, state) && reach(next, state);
+                    break;
+                case OpCode::OPR:
+                    if (!ret)
+                    {
+                        state.depth += effect(inst);
+                        reached = reach(next, state);
+                    }
+                    break;
+                default:
+                    state.depth += effect(inst);
+                    reached = reach(next, state);
+                    break;
+                }
+                if (!reached)
+                {
+                    return "控制流无效";
+                }
+            }
+
+            int64_t depth = 0;
+            for (size_t i = 0; i < code.size(); ++i)
+            {
+                if (states[i].procedure != NONE && states[i].depth != depth)
+                {
+                    return "表达式栈无效";
+                }
+                bool ret = code[i].op == OpCode::OPR && code[i].argument == static_cast<int64_t>(Opr::RET);
+                depth = ret ? 0 : depth + effect(code[i]);
+            }
+            return nullptr;
+        }
+
+        // 校验失败时返回原因
+        const char *validate(const unsigned char *data, size_t size)
+        {
+            if (size < sizeof(FileHeader) || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0)
+            {
+                return "不是预编译文件";
+            }
+            const auto &header = headerOf(data);
+            if (header.version != PCodeImage::VERSION || header.header_size != sizeof(FileHeader) ||
+                header.instruction_size != sizeof(Instruction))
+            {
+                return "预编译文件版本不匹配";
+            }
+            if (header.header_checksum != headerChecksum(header))
+            {
+                return "文件头校验失败";
+            }
+            if (header.file_size != size ||
+                header.payload_checksum != checksum(data + sizeof(FileHeader), size - sizeof(FileHeader)))
+            {
+                return "文件内容校验失败";
+            }
+
+            constexpr size_t ITEM_SIZES[SECTION_COUNT] = {
+                sizeof(Instruction), sizeof(ProcedureRecord), sizeof(ConstantRecord),
+                sizeof(SourceLine), sizeof(StringRef), 1};
+            for (size_t i = 0; i < SECTION_COUNT; ++i)
+            {
+                const auto &entry = header.sections[i];
+                if (entry.offset % SECTION_ALIGNMENT != 0 || entry.offset < sizeof(FileHeader) ||
+                    entry.offset > size || entry.count > (size - entry.offset) / ITEM_SIZES[i])
+                {
+                    return "段越界";
+                }
+            }
+
+            uint64_t pool = header.sections[STRINGS].count;
+            auto inPool = [pool](const StringRef &ref)
+            { return uint64_t{ref.offset} + ref.length <= pool; };
+            for (const auto &record : sectionOf<ProcedureRecord>(data, PROCEDURES))
+            {
+                if (!inPool(record.name))
+                {
+                    return "段越界";
+                }
+            }
+            for (const auto &record : sectionOf<ConstantRecord>(data, CONSTANTS))
+            {
+                if (!inPool(record.name))
+                {
+                    return "段越界";
+                }
+            }
+            for (const auto &ref : sectionOf<StringRef>(data, GLOBALS))
+            {
+                if (!inPool(ref))
+                {
+                    return "段越界";
+                }
+            }
+            return verifyCode(sectionOf<Instruction>(data, CODE), sectionOf<ProcedureRecord>(data, PROCEDURES),
+                              header.sections[GLOBALS].count);
+        }
+    }
+
+    PCodeImage::~PCodeImage()
+    {
+        release();
+    }
+
+    PCodeImage::PCodeImage(PCodeImage &&other) noexcept
+        : data_(other.data_), size_(other.size_)
+    {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+
+    PCodeImage &PCodeImage::operator=(PCodeImage &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            data_ = other.data_;
+            size_ = other.size_;
+            other.data_ = nullptr;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    void PCodeImage::release() noexcept
+    {
+        if (data_ != nullptr)
+        {
+            ::munmap(const_cast<unsigned char *>(data_), size_);
+        }
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    PCodeImage::SourceStamp PCodeImage::stamp(const std::filesystem::path &source, std::string_view text)
+    {
+        auto mtime = std::filesystem::last_write_time(source).time_since_epoch();
+        return SourceStamp{
+            .size = std::filesystem::file_size(source),
+            .mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(mtime).count(),
+            .hash = checksum(text.data(), text.size())};
+    }
+
+    void PCodeImage::write(const PCode &code, const SourceStamp &source, const std::filesystem::path &path)
+    {
+        ImageBuilder builder;
+        auto &header = builder.header();
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.header_size = sizeof(FileHeader);
+        header.instruction_size = sizeof(Instruction);
+        header.source_size = source.size;
+        header.source_mtime = source.mtime;
+        header.source_hash = source.hash;
+
+        // 逐条重建指令，保证填充字节为零，同样的输入得到同样的文件
+        std::vector<Instruction> instructions(code.code.size());
+        std::memset(instructions.data(), 0, instructions.size() * sizeof(Instruction));
+        for (size_t i = 0; i < code.code.size(); ++i)
+        {
+            instructions[i].op = code.code[i].op;
+            instructions[i].level = code.code[i].level;
+            instructions[i].argument = code.code[i].argument;
+        }
+
+        std::vector<ProcedureRecord> procedures;
+        for (const auto &info : code.procedures)
+        {
+            procedures.push_back(ProcedureRecord{builder.intern(info.name), info.entry, info.level, info.frame_size});
+        }
+        std::vector<ConstantRecord> constants;
+        for (const auto &info : code.constants)
+        {
+            constants.push_back(ConstantRecord{builder.intern(info.name), info.value});
+        }
+        std::vector<StringRef> globals;
+        for (auto name : code.globals)
+        {
+            globals.push_back(builder.intern(name));
+        }
+
+        builder.section(CODE, std::span<const Instruction>(instructions));
+        builder.section(PROCEDURES, std::span<const ProcedureRecord>(procedures));
+        builder.section(CONSTANTS, std::span<const ConstantRecord>(constants));
+        builder.section(POSITIONS, std::span<const SourceLine>(code.positions));
+        builder.section(GLOBALS, std::span<const StringRef>(globals));
+        builder.section(STRINGS, std::span<const char>(builder.strings()));
+        auto bytes = builder.finish();
+
+        auto temporary = path;
+        temporary += ".tmp" + std::to_string(::getpid());
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            file.close();
+            if (!file)
+            {
+                std::error_code ignored;
+                std::filesystem::remove(temporary, ignored);
+                throw std::runtime_error("无法写入: " + path.string());
+            }
+        }
+        std::filesystem::rename(temporary, path);
+    }
+
+    std::optional<PCodeImage> PCodeImage::open(const std::filesystem::path &path, std::string &error)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            error = "无法打开: " + path.string();
+            return std::nullopt;
+        }
+
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+        {
+            ::close(fd);
+            error = "不是预编译文件";
+            return std::nullopt;
+        }
+
+        auto size = static_cast<size_t>(st.st_size);
+        void *addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED)
+        {
+            error = "无法映射: " + path.string();
+            return std::nullopt;
+        }
+
+        PCodeImage image;
+        image.data_ = static_cast<const unsigned char *>(addr);
+        image.size_ = size;
+        if (const char *reason = validate(image.data_, size))
+        {
+            error = reason;
+            return std::nullopt;
+        }
+        return image;
+    }
+
+    bool PCodeImage::matches(const std::filesystem::path &source) const
+    {
+        if (data_ == nullptr)
+        {
+            return false;
+        }
+        const auto &header = headerOf(data_);
+
+        std::error_code ec;
+        auto size = std::filesystem::file_size(source, ec);
+        auto mtime = std::filesystem::last_write_time(source, ec);
+        if (ec || size != header.source_size)
+        {
+            return false;
+        }
+        auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count();
+        if (nanoseconds == header.source_mtime)
+        {
+            return true;
+        }
+
+        // 只是修改时间变了(例如重新检出)，内容相同时仍可使用
+        std::ifstream file(source, std::ios::binary);
+        std::string text(size, '\0');
+        file.read(text.data(), static_cast<std::streamsize>(size));
+        return file && checksum(text.data(), text.size()) == header.source_hash;
+    }
+
+    std::span<const Instruction> PCodeImage::code() const noexcept
+    {
+        return data_ ? sectionOf<Instruction>(data_, CODE) : std::span<const Instruction>{};
+    }
+
+    std::span<const SourceLine> PCodeImage::positions() const noexcept
+    {
+        return data_ ? sectionOf<SourceLine>(data_, POSITIONS) : std::span<const SourceLine>{};
+    }
+
+    size_t PCodeImage::globalCount() const noexcept
+    {
+        return data_ ? static_cast<size_t>(headerOf(data_).sections[GLOBALS].count) : 0;
+    }
+
+    std::vector<std::string_view> PCodeImage::globals() const
+    {
+        std::vector<std::string_view> names;
+        if (data_)
+        {
+            for (const auto &ref : sectionOf<StringRef>(data_, GLOBALS))
+            {
+                names.push_back(string(ref.offset, ref.length));
+            }
+        }
+        return names;
+    }
+
+    std::vector<ProcedureInfo> PCodeImage::procedures() const
+    {
+        std::vector<ProcedureInfo> procedures;
+        if (data_)
+        {
+            for (const auto &record : sectionOf<ProcedureRecord>(data_, PROCEDURES))
+            {
+                procedures.push_back(ProcedureInfo{.name = string(record.name.offset, record.name.length),
+                                                   .entry = record.entry,
+                                                   .level = record.level,
+                                                   .frame_size = record.frame_size});
+            }
+        }
+        return procedures;
+    }
+
+    std::vector<ConstantInfo> PCodeImage::constants() const
+    {
+        std::vector<ConstantInfo> constants;
+        if (data_)
+        {
+            for (const auto &record : sectionOf<ConstantRecord>(data_, CONSTANTS))
+            {
+                constants.push_back(ConstantInfo{.name = string(record.name.offset, record.name.length),
+                                                 .value = record.value});
+            }
+        }
+        return constants;
+    }
+
+    std::string_view PCodeImage::string(uint32_t offset, uint32_t length) const noexcept
+    {
+        auto pool = sectionOf<char>(data_, STRINGS);
+        return {pool.data() + offset, length};
+    }
+
+} // namespace pl0
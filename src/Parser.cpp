@@ -1,7 +1,8 @@
 #include "../include/Parser.h"
+#include "../include/Trace.h"
 
 #include <sstream>
-#include <iostream>
+#include <algorithm>
 
 namespace pl0
 {
@@ -23,97 +24,90 @@ namespace pl0
     {
         auto block = parseBlock();
         [[maybe_unused]] auto period = consume(TokenType::PERIOD, "程序必须以'.'结束");
-        return std::make_unique<Program>(std::move(block));
+        return std::make_unique<Program>(std::move(arena_), block);
     }
 
-    std::unique_ptr<Block> Parser::parseBlock()
+    const Block *Parser::parseBlock()
     {
         auto constDecls = parseConstDeclarations();
         auto varDecls = parseVarDeclarations();
         auto procedures = parseProcedures();
-        auto statement = parseStatement();
+        auto statement = orEmpty(parseStatement());
 
-        return std::make_unique<Block>(
-            std::move(constDecls),
-            std::move(varDecls),
-            std::move(procedures),
-            std::move(statement));
+        return arena_.make<Block>(
+            constDecls,
+            varDecls,
+            procedures,
+            statement);
     }
 
-    std::vector<std::unique_ptr<ConstDeclaration>> Parser::parseConstDeclarations()
+    std::span<const ConstDeclaration *const> Parser::parseConstDeclarations()
     {
-        std::vector<std::unique_ptr<ConstDeclaration>> decls;
+        std::vector<const ConstDeclaration *> decls;
 
         if (match(TokenType::CONST))
         {
             do
             {
-                auto name = consume(TokenType::IDENTIFIER, "常量声明需要标识符");
+                auto [name, symbol] = consumeIdentifier("常量声明需要标识符");
                 [[maybe_unused]] auto eq = consume(TokenType::EQ, "常量声明需要'='");
-                auto value = consume(TokenType::NUMBER, "常量声明需要数字");
+                auto value = consumeNumber("常量声明需要数字");
 
-                decls.push_back(std::make_unique<ConstDeclaration>(
-                    name.value<std::string_view>(),
-                    value.value<int64_t>()));
+                decls.push_back(arena_.make<ConstDeclaration>(name, symbol, value));
             } while (match(TokenType::COMMA));
 
             [[maybe_unused]] auto semi = consume(TokenType::SEMICOLON, "常量声明需要以';'结束");
         }
 
-        return decls;
+        return arena_.list(decls);
     }
 
-    std::vector<std::unique_ptr<VarDeclaration>> Parser::parseVarDeclarations()
+    std::span<const VarDeclaration *const> Parser::parseVarDeclarations()
     {
-        std::vector<std::unique_ptr<VarDeclaration>> decls;
+        std::vector<const VarDeclaration *> decls;
 
         if (match(TokenType::VAR))
         {
             do
             {
-                auto name = consume(TokenType::IDENTIFIER, "变量声明需要标识符");
-                decls.push_back(std::make_unique<VarDeclaration>(
-                    name.value<std::string_view>()));
+                auto [name, symbol] = consumeIdentifier("变量声明需要标识符");
+                decls.push_back(arena_.make<VarDeclaration>(name, symbol));
             } while (match(TokenType::COMMA));
 
             [[maybe_unused]] auto semi = consume(TokenType::SEMICOLON, "变量声明需要以';'结束");
         }
 
-        return decls;
+        return arena_.list(decls);
     }
 
-    std::vector<std::unique_ptr<ProcedureDeclaration>> Parser::parseProcedures()
+    std::span<const ProcedureDeclaration *const> Parser::parseProcedures()
     {
-        std::vector<std::unique_ptr<ProcedureDeclaration>> procs;
+        std::vector<const ProcedureDeclaration *> procs;
 
-        while (match(TokenType::PROCEDURE))
+        while (check(TokenType::PROCEDURE))
         {
-            auto name = consume(TokenType::IDENTIFIER, "过程声明需要标识符");
+            auto position = locate();
+            [[maybe_unused]] auto keyword = advance();
+            auto [name, symbol] = consumeIdentifier("过程声明需要标识符");
             [[maybe_unused]] auto semi1 = consume(TokenType::SEMICOLON, "过程声明头部需要以';'结束");
 
             auto block = parseBlock();
             [[maybe_unused]] auto semi2 = consume(TokenType::SEMICOLON, "过程声明需要以';'结束");
 
-            procs.push_back(std::make_unique<ProcedureDeclaration>(
-                name.value<std::string_view>(),
-                std::move(block)));
+            procs.push_back(positioned(arena_.make<ProcedureDeclaration>(
+                                           name,
+                                           symbol,
+                                           block),
+                                       position));
         }
 
-        return procs;
+        return arena_.list(procs);
     }
 
-    std::unique_ptr<Statement> Parser::parseStatement()
+    const Statement *Parser::parseStatement()
     {
         auto token = peek();
-        std::cerr << "解析语句,当前token: " << static_cast<int>(token.type());
-        if (token.hasValue())
-        {
-            if (token.type() == TokenType::IDENTIFIER)
-            {
-                std::cerr << " (标识符: " << token.value<std::string_view>() << ")";
-            }
-        }
-        std::cerr << '\n';
+        PL0_TRACE(Debug, ParseStatement, static_cast<uint32_t>(tokens_.cursor()), static_cast<int64_t>(token.type()));
 
         switch (token.type())
         {
@@ -143,32 +137,35 @@ namespace pl0
         }
     }
 
-    std::unique_ptr<Statement> Parser::parseAssignStatement()
+    const Statement *Parser::parseAssignStatement()
     {
-        auto name = consume(TokenType::IDENTIFIER, "赋值语句需要标识符").value<std::string_view>();
+        auto position = locate();
+        auto [name, symbol] = consumeIdentifier("赋值语句需要标识符");
         [[maybe_unused]] auto assign = consume(TokenType::ASSIGN, "赋值语句需要':='");
         auto expr = parseExpression();
-        return std::make_unique<AssignStatement>(name, std::move(expr));
+        return positioned(arena_.make<AssignStatement>(name, symbol, expr), position);
     }
 
-    std::unique_ptr<Statement> Parser::parseCallStatement()
+    const Statement *Parser::parseCallStatement()
     {
+        auto position = locate();
         [[maybe_unused]] auto call_token = advance(); // 消费CALL
-        auto name = consume(TokenType::IDENTIFIER, "CALL语句需要过程名");
-        return std::make_unique<CallStatement>(name.value<std::string_view>());
+        auto [name, symbol] = consumeIdentifier("CALL语句需要过程名");
+        return positioned(arena_.make<CallStatement>(name, symbol), position);
     }
 
-    std::unique_ptr<Statement> Parser::parseBeginStatement()
+    const Statement *Parser::parseBeginStatement()
     {
+        auto position = locate();
         [[maybe_unused]] auto begin_token = advance(); // 消费BEGIN
-        std::vector<std::unique_ptr<Statement>> statements;
+        std::vector<const Statement *> statements;
 
         while (!check(TokenType::END))
         {
             auto stmt = parseStatement();
             if (stmt)
             {
-                statements.push_back(std::move(stmt));
+                statements.push_back(stmt);
             }
 
             if (!match(TokenType::SEMICOLON) && !check(TokenType::END))
@@ -178,53 +175,55 @@ namespace pl0
         }
 
         [[maybe_unused]] auto end_token = consume(TokenType::END, "BEGIN语句需要以END结束");
-        return std::make_unique<BeginStatement>(std::move(statements));
+        return positioned(arena_.make<BeginStatement>(arena_.list(statements)), position);
     }
 
-    std::unique_ptr<Statement> Parser::parseIfStatement()
+    const Statement *Parser::parseIfStatement()
     {
+        auto position = locate();
         [[maybe_unused]] auto if_token = advance(); // 消费IF
         auto condition = parseCondition();
         [[maybe_unused]] auto then = consume(TokenType::THEN, "IF语句需要THEN");
-        auto then_stmt = parseStatement();
+        auto then_stmt = orEmpty(parseStatement());
 
         // 检查是否有BEGIN-END块
-        if (then_stmt && !dynamic_cast<BeginStatement *>(then_stmt.get()) && !check(TokenType::END) && !check(TokenType::SEMICOLON))
+        if (!dynamic_cast<const BeginStatement *>(then_stmt) && !check(TokenType::END) && !check(TokenType::SEMICOLON))
         {
             // 如果then_stmt不是BEGIN块，且后面不是END或分号，则需要将其包装在BEGIN-END块中
-            std::vector<std::unique_ptr<Statement>> statements;
-            statements.push_back(std::move(then_stmt));
+            std::vector<const Statement *> statements;
+            statements.push_back(then_stmt);
 
             while (!check(TokenType::END) && !check(TokenType::SEMICOLON))
             {
                 if (auto stmt = parseStatement())
                 {
-                    statements.push_back(std::move(stmt));
+                    statements.push_back(stmt);
                 }
                 [[maybe_unused]] bool has_semi = match(TokenType::SEMICOLON); // 修复match()的[[nodiscard]]警告
             }
 
-            then_stmt = std::make_unique<BeginStatement>(std::move(statements));
+            then_stmt = arena_.make<BeginStatement>(arena_.list(statements));
         }
 
-        return std::make_unique<IfStatement>(std::move(condition), std::move(then_stmt));
+        return positioned(arena_.make<IfStatement>(condition, then_stmt), position);
     }
 
-    std::unique_ptr<Statement> Parser::parseWhileStatement()
+    const Statement *Parser::parseWhileStatement()
     {
+        auto position = locate();
         [[maybe_unused]] auto while_token = advance(); // 消费WHILE
         auto condition = parseCondition();
         [[maybe_unused]] auto do_token = consume(TokenType::DO, "WHILE语句需要DO");
-        auto body = parseStatement();
-        return std::make_unique<WhileStatement>(std::move(condition), std::move(body));
+        auto body = orEmpty(parseStatement());
+        return positioned(arena_.make<WhileStatement>(condition, body), position);
     }
 
-    std::unique_ptr<Expression> Parser::parseCondition()
+    const Expression *Parser::parseCondition()
     {
         if (check(TokenType::ODD))
         {
             [[maybe_unused]] auto token = advance(); // 消费ODD
-            return parseExpression();
+            return arena_.make<UnaryExpression>(UnaryExpression::Op::Odd, parseExpression());
         }
 
         auto left = parseExpression();
@@ -240,31 +239,45 @@ namespace pl0
         [[maybe_unused]] auto token = advance(); // 消费运算符
         auto right = parseExpression();
 
-        return std::make_unique<BinaryExpression>(
-            std::move(left),
+        return arena_.make<BinaryExpression>(
+            left,
             tokenTypeToBinaryOp(op), // 使用已经获取的运算符类型
-            std::move(right));
+            right);
     }
 
-    std::unique_ptr<Expression> Parser::parseExpression()
+    const Expression *Parser::parseExpression()
     {
-        auto expr = parseTerm();
+        // 可选的前导正负号，作用于第一个项
+        const Expression *expr = nullptr;
+        if (check(TokenType::PLUS) || check(TokenType::MINUS))
+        {
+            bool negate = advance().type() == TokenType::MINUS;
+            expr = parseTerm();
+            if (negate)
+            {
+                expr = arena_.make<UnaryExpression>(UnaryExpression::Op::Neg, expr);
+            }
+        }
+        else
+        {
+            expr = parseTerm();
+        }
 
         while (check(TokenType::PLUS) || check(TokenType::MINUS))
         {
             auto op = tokenTypeToBinaryOp(peek().type());
             [[maybe_unused]] auto token = advance(); // 消费运算符
             auto right = parseTerm();
-            expr = std::make_unique<BinaryExpression>(
-                std::move(expr),
+            expr = arena_.make<BinaryExpression>(
+                expr,
                 op,
-                std::move(right));
+                right);
         }
 
         return expr;
     }
 
-    std::unique_ptr<Expression> Parser::parseTerm()
+    const Expression *Parser::parseTerm()
     {
         auto expr = parsePower(); // 先解析幂运算
 
@@ -273,17 +286,17 @@ namespace pl0
             auto op = tokenTypeToBinaryOp(peek().type());
             [[maybe_unused]] auto token = advance(); // 消费运算符
             auto right = parsePower();               // 递归解析幂运算
-            expr = std::make_unique<BinaryExpression>(
-                std::move(expr),
+            expr = arena_.make<BinaryExpression>(
+                expr,
                 op,
-                std::move(right));
+                right);
         }
 
         return expr;
     }
 
     // 添加新的解析幂运算的方法
-    std::unique_ptr<Expression> Parser::parsePower()
+    const Expression *Parser::parsePower()
     {
         auto expr = parseFactor();
 
@@ -291,45 +304,26 @@ namespace pl0
         {
             [[maybe_unused]] auto token = advance();
             auto right = parsePower();
-            expr = std::make_unique<BinaryExpression>(
-                std::move(expr),
+            expr = arena_.make<BinaryExpression>(
+                expr,
                 BinaryExpression::Op::Pow,
-                std::move(right));
+                right);
         }
 
         return expr;
     }
 
-    std::unique_ptr<Expression> Parser::parseFactor()
+    const Expression *Parser::parseFactor()
     {
-        Token token; // 先声明token
-
         if (check(TokenType::NUMBER))
         {
-            token = advance();
-            try
-            {
-                return std::make_unique<NumberExpression>(token.value<int64_t>());
-            }
-            catch (const std::bad_variant_access &)
-            {
-                error("无效的数字");
-                return nullptr;
-            }
+            return arena_.make<NumberExpression>(consumeNumber("无效的数字"));
         }
 
         if (check(TokenType::IDENTIFIER))
         {
-            token = advance();
-            try
-            {
-                return std::make_unique<IdentifierExpression>(token.value<std::string_view>());
-            }
-            catch (const std::bad_variant_access &)
-            {
-                error("无效的标识符");
-                return nullptr;
-            }
+            auto [name, symbol] = consumeIdentifier("无效的标识符");
+            return arena_.make<IdentifierExpression>(name, symbol);
         }
 
         if (check(TokenType::LPAREN))
@@ -344,6 +338,15 @@ namespace pl0
         return nullptr;
     }
 
+    const Statement *Parser::orEmpty(const Statement *statement)
+    {
+        if (statement)
+        {
+            return statement;
+        }
+        return arena_.make<BeginStatement>(std::span<const Statement *const>{});
+    }
+
     bool Parser::match(TokenType type) noexcept
     {
         if (!check(type))
@@ -354,9 +357,9 @@ namespace pl0
         return true;
     }
 
-    bool Parser::check(TokenType type) noexcept
+    bool Parser::check(TokenType type) const noexcept
     {
-        return peek().type() == type;
+        return tokens_.check(type);
     }
 
     Token Parser::consume(TokenType type, const std::string &message)
@@ -368,22 +371,62 @@ namespace pl0
         return advance();
     }
 
+    Parser::Identifier Parser::consumeIdentifier(const std::string &message)
+    {
+        if (!check(TokenType::IDENTIFIER))
+        {
+            error(message);
+        }
+        Identifier identifier{tokens_.currentText(), tokens_.currentSymbol()};
+        [[maybe_unused]] auto token = advance();
+        return identifier;
+    }
+
+    int64_t Parser::consumeNumber(const std::string &message)
+    {
+        if (!check(TokenType::NUMBER))
+        {
+            error(message);
+        }
+        auto value = tokens_.currentNumber();
+        [[maybe_unused]] auto token = advance();
+        return value;
+    }
+
+    SourcePosition Parser::locate() noexcept
+    {
+        auto source = tokens_.buffer().source();
+        size_t offset = std::min<size_t>(peek().offset(), source.size());
+        if (offset < located_offset_)
+        {
+            return tokens_.position();
+        }
+        for (size_t i = located_offset_; i < offset; ++i)
+        {
+            if (source[i] == '\n')
+            {
+                ++located_line_;
+                line_start_ = i + 1;
+            }
+        }
+        located_offset_ = offset;
+        return SourcePosition{located_line_, offset - line_start_ + 1};
+    }
+
     void Parser::error(const std::string &message)
     {
         had_error_ = true;
+        PL0_TRACE(Info, ParseError, static_cast<uint32_t>(tokens_.cursor()), static_cast<int64_t>(peek().type()));
         std::stringstream ss;
-        ss << "行" << lexer_.line() << "列" << lexer_.column() << ": " << message;
+        ss << "行" << currentLine() << "列" << currentColumn() << ": " << message;
         ss << "\n当前token: " << static_cast<int>(peek().type());
-        if (peek().hasValue())
+        if (check(TokenType::NUMBER))
         {
-            if (peek().type() == TokenType::NUMBER)
-            {
-                ss << " (数字: " << peek().value<int64_t>() << ")";
-            }
-            else if (peek().type() == TokenType::IDENTIFIER)
-            {
-                ss << " (标识符: " << peek().value<std::string_view>() << ")";
-            }
+            ss << " (数字: " << tokens_.currentNumber() << ")";
+        }
+        else if (check(TokenType::IDENTIFIER))
+        {
+            ss << " (标识符: " << tokens_.currentText() << ")";
         }
         ss << "\n上下文: ";
         // 添加更多上下文信息，比如当前正在解析的语句类型等
@@ -0,0 +1,165 @@
+#include "../include/RegisterCode.h"
+
+#include <iomanip>
+
+namespace pl0
+{
+
+    std::string_view regOpName(RegOp op) noexcept
+    {
+        switch (op)
+        {
+        case RegOp::LoadK:
+            return "LOADK";
+        case RegOp::Move:
+            return "MOVE";
+        case RegOp::GetOuter:
+            return "GETOUTER";
+        case RegOp::SetOuter:
+            return "SETOUTER";
+        case RegOp::Add:
+            return "ADD";
+        case RegOp::Sub:
+            return "SUB";
+        case RegOp::Mul:
+            return "MUL";
+        case RegOp::Div:
+            return "DIV";
+        case RegOp::Pow:
+            return "POW";
+        case RegOp::Shl:
+            return "SHL";
+        case RegOp::Eq:
+            return "EQ";
+        case RegOp::Neq:
+            return "NEQ";
+        case RegOp::Lt:
+            return "LT";
+        case RegOp::Lte:
+            return "LTE";
+        case RegOp::Gt:
+            return "GT";
+        case RegOp::Gte:
+            return "GTE";
+        case RegOp::AddK:
+            return "ADDK";
+        case RegOp::SubK:
+            return "SUBK";
+        case RegOp::MulK:
+            return "MULK";
+        case RegOp::DivK:
+            return "DIVK";
+        case RegOp::PowK:
+            return "POWK";
+        case RegOp::ShlK:
+            return "SHLK";
+        case RegOp::EqK:
+            return "EQK";
+        case RegOp::NeqK:
+            return "NEQK";
+        case RegOp::LtK:
+            return "LTK";
+        case RegOp::LteK:
+            return "LTEK";
+        case RegOp::GtK:
+            return "GTK";
+        case RegOp::GteK:
+            return "GTEK";
+        case RegOp::Neg:
+            return "NEG";
+        case RegOp::Not:
+            return "NOT";
+        case RegOp::Odd:
+            return "ODD";
+        case RegOp::Jump:
+            return "JUMP";
+        case RegOp::JumpIfZero:
+            return "JZ";
+        case RegOp::JumpIfNotZero:
+            return "JNZ";
+        case RegOp::Call:
+            return "CALL";
+        case RegOp::Enter:
+            return "ENTER";
+        case RegOp::Return:
+            return "RET";
+        }
+        return "???";
+    }
+
+    void disassemble(const RegisterProgram &program, std::ostream &out)
+    {
+        for (size_t i = 0; i < program.code.size(); ++i)
+        {
+            const auto &inst = program.code[i];
+            out << std::setw(5) << i << "  " << std::left << std::setw(9) << regOpName(inst.op) << std::right;
+
+            switch (inst.op)
+            {
+            case RegOp::LoadK:
+                out << 'r' << inst.dst << ", " << inst.imm;
+                break;
+            case RegOp::Move:
+                out << 'r' << inst.dst << ", r" << inst.a;
+                break;
+            case RegOp::GetOuter:
+                out << 'r' << inst.dst << ", " << static_cast<int>(inst.level) << ":r" << inst.a;
+                break;
+            case RegOp::SetOuter:
+                out << static_cast<int>(inst.level) << ":r" << inst.dst << ", r" << inst.a;
+                break;
+            case RegOp::Add:
+            case RegOp::Sub:
+            case RegOp::Mul:
+            case RegOp::Div:
+            case RegOp::Pow:
+            case RegOp::Shl:
+            case RegOp::Eq:
+            case RegOp::Neq:
+            case RegOp::Lt:
+            case RegOp::Lte:
+            case RegOp::Gt:
+            case RegOp::Gte:
+                out << 'r' << inst.dst << ", r" << inst.a << ", r" << inst.b;
+                break;
+            case RegOp::AddK:
+            case RegOp::SubK:
+            case RegOp::MulK:
+            case RegOp::DivK:
+            case RegOp::PowK:
+            case RegOp::ShlK:
+            case RegOp::EqK:
+            case RegOp::NeqK:
+            case RegOp::LtK:
+            case RegOp::LteK:
+            case RegOp::GtK:
+            case RegOp::GteK:
+                out << 'r' << inst.dst << ", r" << inst.a << ", " << inst.imm;
+                break;
+            case RegOp::Neg:
+            case RegOp::Not:
+            case RegOp::Odd:
+                out << 'r' << inst.dst << ", r" << inst.a;
+                break;
+            case RegOp::Jump:
+                out << inst.imm;
+                break;
+            case RegOp::JumpIfZero:
+            case RegOp::JumpIfNotZero:
+                out << 'r' << inst.a << ", " << inst.imm;
+                break;
+            case RegOp::Call:
+                out << static_cast<int>(inst.level) << ", " << inst.imm;
+                break;
+            case RegOp::Enter:
+                out << inst.imm << ", " << inst.a;
+                break;
+            case RegOp::Return:
+                out << inst.a;
+                break;
+            }
+            out << '\n';
+        }
+    }
+
+} // namespace pl0
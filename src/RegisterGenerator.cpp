@@ -0,0 +1,390 @@
+#include "../include/RegisterGenerator.h"
+
+#include <tuple>
+#include <limits>
+#include <utility>
+#include <type_traits>
+#include <stdexcept>
+#include <algorithm>
+
+namespace pl0
+{
+
+    namespace
+    {
+        RegOp registerForm(BinaryExpression::Op op) noexcept
+        {
+            switch (op)
+            {
+            case BinaryExpression::Op::Add:
+                return RegOp::Add;
+            case BinaryExpression::Op::Sub:
+                return RegOp::Sub;
+            case BinaryExpression::Op::Mul:
+                return RegOp::Mul;
+            case BinaryExpression::Op::Div:
+                return RegOp::Div;
+            case BinaryExpression::Op::Pow:
+                return RegOp::Pow;
+            case BinaryExpression::Op::Shl:
+                return RegOp::Shl;
+            case BinaryExpression::Op::Eq:
+                return RegOp::Eq;
+            case BinaryExpression::Op::Neq:
+                return RegOp::Neq;
+            case BinaryExpression::Op::Lt:
+                return RegOp::Lt;
+            case BinaryExpression::Op::Lte:
+                return RegOp::Lte;
+            case BinaryExpression::Op::Gt:
+                return RegOp::Gt;
+            case BinaryExpression::Op::Gte:
+                return RegOp::Gte;
+            }
+            return RegOp::Add;
+        }
+
+        // 右操作数为常数时的K形式，与寄存器形式一一对应
+        static_assert(static_cast<uint8_t>(RegOp::GteK) - static_cast<uint8_t>(RegOp::AddK) ==
+                      static_cast<uint8_t>(RegOp::Gte) - static_cast<uint8_t>(RegOp::Add));
+
+        RegOp constantForm(RegOp op) noexcept
+        {
+            return static_cast<RegOp>(static_cast<uint8_t>(op) - static_cast<uint8_t>(RegOp::Add) +
+                                      static_cast<uint8_t>(RegOp::AddK));
+        }
+
+        // 左操作数为常数时交换操作数后的等价运算；不可交换时返回nullopt
+        std::optional<RegOp> swappedForm(RegOp op) noexcept
+        {
+            switch (op)
+            {
+            case RegOp::Add:
+            case RegOp::Mul:
+            case RegOp::Eq:
+            case RegOp::Neq:
+                return op;
+            case RegOp::Lt:
+                return RegOp::Gt;
+            case RegOp::Lte:
+                return RegOp::Gte;
+            case RegOp::Gt:
+                return RegOp::Lt;
+            case RegOp::Gte:
+                return RegOp::Lte;
+            default:
+                return std::nullopt;
+            }
+        }
+    }
+
+    RegisterProgram RegisterGenerator::generate(const Program &program)
+    {
+        program_ = RegisterProgram{};
+        level_ = 0;
+        var_count_ = 0;
+        walk(program);
+        return std::move(program_);
+    }
+
+    void RegisterGenerator::visit(const Program &node)
+    {
+        symbols_.enterScope();
+        walk(node.block());
+        symbols_.leaveScope();
+    }
+
+    void RegisterGenerator::visit(const Block &node)
+    {
+        auto saved = std::tuple{var_count_, next_temp_, frame_size_};
+        var_count_ = 0;
+
+        for (const auto *decl : node.consts())
+        {
+            walk(*decl);
+        }
+        for (const auto *decl : node.vars())
+        {
+            walk(*decl);
+        }
+
+        if (!node.procedures().empty())
+        {
+            size_t jump = emit(RegOp::Jump);
+            for (const auto *decl : node.procedures())
+            {
+                walk(*decl);
+            }
+            patch(jump, here());
+        }
+
+        // 帧头和变量的槽位数，与其他执行方式的帧大小相同，按它检查--max-stack
+        auto counted = static_cast<uint16_t>(FRAME_HEADER + var_count_);
+        frame_size_ = counted;
+        releaseTemps();
+        size_t enter = emit(RegOp::Enter, 0, counted);
+        walk(node.statement());
+        emit(RegOp::Return, 0, counted);
+        program_.code[enter].imm = static_cast<int64_t>(frame_size_);
+
+        std::tie(var_count_, next_temp_, frame_size_) = saved;
+    }
+
+    void RegisterGenerator::visit(const ConstDeclaration &node)
+    {
+        symbols_.declare(node.symbol(), Symbol{
+                                            .type = SymbolType::Constant,
+                                            .value = node.value(),
+                                            .level = level_,
+                                            .index = 0,
+                                            .name = node.symbol()});
+    }
+
+    void RegisterGenerator::visit(const VarDeclaration &node)
+    {
+        if (level_ == 0 && !node.hidden())
+        {
+            program_.globals.push_back(node.name());
+        }
+        symbols_.declare(node.symbol(), Symbol{
+                                            .type = SymbolType::Variable,
+                                            .value = std::nullopt,
+                                            .level = level_,
+                                            .index = var_count_++,
+                                            .name = node.symbol()});
+    }
+
+    void RegisterGenerator::visit(const ProcedureDeclaration &node)
+    {
+        symbols_.declare(node.symbol(), Symbol{
+                                            .type = SymbolType::Procedure,
+                                            .value = static_cast<int64_t>(here()),
+                                            .level = level_,
+                                            .index = 0,
+                                            .name = node.symbol()});
+
+        ++level_;
+        symbols_.enterScope();
+        walk(node.block());
+        symbols_.leaveScope();
+        --level_;
+    }
+
+    void RegisterGenerator::visit(const AssignStatement &node)
+    {
+        releaseTemps();
+        const Symbol &symbol = resolve(node.symbol());
+        uint16_t target = slot(FRAME_HEADER + symbol.index);
+
+        if (symbol.level == level_)
+        {
+            Operand value = lower(node.expression(), target);
+            if (value.constant)
+            {
+                emit(RegOp::LoadK, target, 0, 0, value.value);
+            }
+            else if (value.reg != target)
+            {
+                emit(RegOp::Move, target, value.reg);
+            }
+            return;
+        }
+
+        uint16_t value = toRegister(lower(node.expression()));
+        emit(RegOp::SetOuter, target, value, 0, 0, levelDistance(symbol));
+    }
+
+    void RegisterGenerator::visit(const CallStatement &node)
+    {
+        const Symbol &symbol = resolve(node.symbol());
+        emit(RegOp::Call, 0, 0, 0, *symbol.value, levelDistance(symbol));
+    }
+
+    void RegisterGenerator::visit(const BeginStatement &node)
+    {
+        for (const auto *stmt : node.statements())
+        {
+            walk(*stmt);
+        }
+    }
+
+    void RegisterGenerator::visit(const IfStatement &node)
+    {
+        releaseTemps();
+        uint16_t condition = toRegister(lower(node.condition()));
+        size_t skip = emit(RegOp::JumpIfZero, 0, condition);
+        walk(node.thenStmt());
+        patch(skip, here());
+    }
+
+    void RegisterGenerator::visit(const WhileStatement &node)
+    {
+        // 条件后置: JUMP cond; body: ...; cond: ...; JNZ body
+        size_t enter = emit(RegOp::Jump);
+        size_t body = here();
+        walk(node.body());
+        patch(enter, here());
+
+        releaseTemps();
+        uint16_t condition = toRegister(lower(node.condition()));
+        emit(RegOp::JumpIfNotZero, 0, condition, 0, static_cast<int64_t>(body));
+    }
+
+    RegisterGenerator::Operand RegisterGenerator::lower(const Expression &expr, std::optional<uint16_t> target)
+    {
+        return pl0::visit(expr, [this, target](const auto &node) -> Operand
+                          {
+            using Node = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<Node, NumberExpression>)
+            {
+                return Operand{true, node.value(), 0};
+            }
+            else if constexpr (std::is_same_v<Node, IdentifierExpression>)
+            {
+                return lowerIdentifier(node, target);
+            }
+            else if constexpr (std::is_same_v<Node, UnaryExpression>)
+            {
+                return lowerUnary(node, target);
+            }
+            else
+            {
+                return lowerBinary(node, target);
+            } });
+    }
+
+    RegisterGenerator::Operand RegisterGenerator::lowerIdentifier(const IdentifierExpression &expr,
+                                                                  std::optional<uint16_t> target)
+    {
+        const Symbol &symbol = resolve(expr.symbol());
+        if (symbol.type == SymbolType::Constant)
+        {
+            return Operand{true, *symbol.value, 0};
+        }
+
+        uint16_t reg = slot(FRAME_HEADER + symbol.index);
+        if (symbol.level == level_)
+        {
+            return Operand{false, 0, reg};
+        }
+
+        uint16_t dst = destination(target);
+        emit(RegOp::GetOuter, dst, reg, 0, 0, levelDistance(symbol));
+        return Operand{false, 0, dst};
+    }
+
+    RegisterGenerator::Operand RegisterGenerator::lowerUnary(const UnaryExpression &expr,
+                                                             std::optional<uint16_t> target)
+    {
+        uint16_t operand = toRegister(lower(expr.operand()));
+        uint16_t dst = destination(target);
+
+        switch (expr.op())
+        {
+        case UnaryExpression::Op::Neg:
+            emit(RegOp::Neg, dst, operand);
+            break;
+        case UnaryExpression::Op::Not:
+            emit(RegOp::Not, dst, operand);
+            break;
+        case UnaryExpression::Op::Odd:
+            emit(RegOp::Odd, dst, operand);
+            break;
+        }
+        return Operand{false, 0, dst};
+    }
+
+    RegisterGenerator::Operand RegisterGenerator::lowerBinary(const BinaryExpression &expr,
+                                                              std::optional<uint16_t> target)
+    {
+        Operand left = lower(expr.left());
+        Operand right = lower(expr.right());
+        RegOp op = registerForm(expr.op());
+
+        if (right.constant)
+        {
+            uint16_t a = toRegister(left);
+            uint16_t dst = destination(target);
+            emit(constantForm(op), dst, a, 0, right.value);
+            return Operand{false, 0, dst};
+        }
+
+        if (left.constant)
+        {
+            if (auto swapped = swappedForm(op))
+            {
+                uint16_t dst = destination(target);
+                emit(constantForm(*swapped), dst, right.reg, 0, left.value);
+                return Operand{false, 0, dst};
+            }
+        }
+
+        uint16_t a = toRegister(left);
+        uint16_t dst = destination(target);
+        emit(op, dst, a, right.reg);
+        return Operand{false, 0, dst};
+    }
+
+    uint16_t RegisterGenerator::toRegister(Operand operand)
+    {
+        if (!operand.constant)
+        {
+            return operand.reg;
+        }
+        uint16_t reg = destination(std::nullopt);
+        emit(RegOp::LoadK, reg, 0, 0, operand.value);
+        return reg;
+    }
+
+    uint16_t RegisterGenerator::destination(std::optional<uint16_t> target)
+    {
+        if (target)
+        {
+            return *target;
+        }
+        uint16_t reg = slot(next_temp_++);
+        frame_size_ = std::max(frame_size_, next_temp_);
+        return reg;
+    }
+
+    size_t RegisterGenerator::emit(RegOp op, uint16_t dst, uint16_t a, uint16_t b, int64_t imm, uint8_t level)
+    {
+        program_.code.push_back(RegInstruction{op, level, dst, a, b, imm});
+        return program_.code.size() - 1;
+    }
+
+    void RegisterGenerator::patch(size_t at, size_t target)
+    {
+        program_.code[at].imm = static_cast<int64_t>(target);
+    }
+
+    const Symbol &RegisterGenerator::resolve(SymbolId name) const
+    {
+        const Symbol *symbol = symbols_.lookup(name);
+        if (!symbol)
+        {
+            throw std::runtime_error("代码生成: 未解析的标识符");
+        }
+        return *symbol;
+    }
+
+    uint8_t RegisterGenerator::levelDistance(const Symbol &symbol) const
+    {
+        size_t distance = level_ - symbol.level;
+        if (distance > std::numeric_limits<uint8_t>::max())
+        {
+            throw std::runtime_error("代码生成: 过程嵌套层数过深");
+        }
+        return static_cast<uint8_t>(distance);
+    }
+
+    uint16_t RegisterGenerator::slot(size_t index)
+    {
+        if (index > std::numeric_limits<uint16_t>::max())
+        {
+            throw std::runtime_error("代码生成: 过程的变量和临时量过多");
+        }
+        return static_cast<uint16_t>(index);
+    }
+
+} // namespace pl0
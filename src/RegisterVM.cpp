@@ -0,0 +1,322 @@
+#include "../include/RegisterVM.h"
+#include "../include/Arith.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace pl0
+{
+
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        struct Threaded
+        {
+            const void *handler;
+            int64_t imm;
+            uint16_t dst;
+            uint16_t a;
+            uint16_t b;
+            uint8_t level;
+        };
+    }
+
+    ExecutionResult RegisterVM::run()
+    {
+        // 与RegOp的声明顺序一致
+        static const void *const LABELS[] = {
+            &&op_loadk, &&op_move, &&op_getouter, &&op_setouter,
+            &&op_add, &&op_sub, &&op_mul, &&op_div, &&op_pow, &&op_shl,
+            &&op_eq, &&op_neq, &&op_lt, &&op_lte, &&op_gt, &&op_gte,
+            &&op_addk, &&op_subk, &&op_mulk, &&op_divk, &&op_powk, &&op_shlk,
+            &&op_eqk, &&op_neqk, &&op_ltk, &&op_ltek, &&op_gtk, &&op_gtek,
+            &&op_neg, &&op_not, &&op_odd,
+            &&op_jump, &&op_jz, &&op_jnz, &&op_call, &&op_enter, &&op_return};
+        static_assert(std::size(LABELS) == static_cast<size_t>(RegOp::Return) + 1);
+
+        ExecutionResult result;
+        const auto &code = program_.code;
+        if (code.empty())
+        {
+            result.success = false;
+            result.error = "运行时错误: 没有可执行的代码";
+            return result;
+        }
+
+        std::vector<Threaded> threaded(code.size() + 1);
+        for (size_t i = 0; i < code.size(); ++i)
+        {
+            const auto &inst = code[i];
+            bool is_jump = inst.op == RegOp::Jump || inst.op == RegOp::JumpIfZero ||
+                           inst.op == RegOp::JumpIfNotZero || inst.op == RegOp::Call;
+            if (static_cast<size_t>(inst.op) >= std::size(LABELS) ||
+                (is_jump && (inst.imm < 0 || inst.imm >= static_cast<int64_t>(code.size()))))
+            {
+                result.success = false;
+                result.error = "运行时错误: 无效的指令 (地址 " + std::to_string(i) + ")";
+                return result;
+            }
+            threaded[i] = Threaded{LABELS[static_cast<size_t>(inst.op)], inst.imm, inst.dst, inst.a, inst.b, inst.level};
+            // 紧跟Return的Call是尾调用，被调用者的静态链不是当前帧时复用当前帧
+            if (inst.op == RegOp::Call && inst.level > 0 && i + 1 < code.size() && code[i + 1].op == RegOp::Return)
+            {
+                threaded[i].handler = &&op_tail;
+            }
+        }
+        threaded.back() = Threaded{&&op_halt, 0, 0, 0, 0, 0};
+
+        if (stack_size_ < static_cast<size_t>(FRAME_HEADER))
+        {
+            result.success = false;
+            result.error = "运行时错误: 栈空间不足";
+            return result;
+        }
+
+        // --max-stack只计各帧的帧头和变量(counted)，与其他执行方式的单位相同；
+        // 临时寄存器另外占用物理栈，不够时在ENTER处扩大，帧之间只保存相对base的偏移
+        std::vector<int64_t> stack(stack_size_);
+        int64_t *base = stack.data();
+        int64_t *limit = base + stack.size();
+        const auto budget = static_cast<int64_t>(stack_size_);
+        int64_t counted = 0;
+        const Threaded *const tcode = threaded.data();
+
+        // bp为当前帧(寄存器文件)的基址，sp为当前帧之后的第一个空闲槽位
+        int64_t *bp = base;
+        int64_t *sp = base;
+        bp[0] = 0;
+        bp[1] = 0;
+        bp[2] = static_cast<int64_t>(code.size());
+
+        const Threaded *ip = tcode;
+        const Threaded *cur = nullptr;
+        uint64_t executed = 0;
+
+        auto frameAt = [&base](int64_t *frame, uint32_t level) noexcept
+        {
+            for (; level > 0; --level)
+            {
+                frame = base + frame[0];
+            }
+            return frame;
+        };
+
+#define DISPATCH()          \
+    do                      \
+    {                       \
+        cur = ip++;         \
+        ++executed;         \
+        goto *cur->handler; \
+    } while (false)
+
+#define R(field) bp[cur->field]
+
+#define BINARY(expr)                  \
+    do                                \
+    {                                 \
+        int64_t lhs = R(a);           \
+        int64_t rhs = R(b);           \
+        R(dst) = (expr);              \
+        DISPATCH();                   \
+    } while (false)
+
+#define BINARY_K(expr)                \
+    do                                \
+    {                                 \
+        int64_t lhs = R(a);           \
+        int64_t rhs = cur->imm;       \
+        R(dst) = (expr);              \
+        DISPATCH();                   \
+    } while (false)
+
+        auto start = Clock::now();
+        DISPATCH();
+
+    op_loadk:
+        R(dst) = cur->imm;
+        DISPATCH();
+
+    op_move:
+        R(dst) = R(a);
+        DISPATCH();
+
+    op_getouter:
+        R(dst) = frameAt(bp, cur->level)[cur->a];
+        DISPATCH();
+
+    op_setouter:
+        frameAt(bp, cur->level)[cur->dst] = R(a);
+        DISPATCH();
+
+    op_add:
+        BINARY(arith::add(lhs, rhs));
+    op_sub:
+        BINARY(arith::sub(lhs, rhs));
+    op_mul:
+        BINARY(arith::mul(lhs, rhs));
+    op_div:
+        if (R(b) == 0)
+        {
+            result.error = "运行时错误: 除数为零";
+            goto fail;
+        }
+        BINARY(arith::div(lhs, rhs));
+    op_pow:
+        if (R(b) < 0)
+        {
+            result.error = "运行时错误: 负指数";
+            goto fail;
+        }
+        BINARY(arith::pow(lhs, rhs));
+    op_shl:
+        if (R(b) < 0)
+        {
+            result.error = "运行时错误: 负指数";
+            goto fail;
+        }
+        BINARY(arith::shl(lhs, rhs));
+    op_eq:
+        BINARY(lhs == rhs);
+    op_neq:
+        BINARY(lhs != rhs);
+    op_lt:
+        BINARY(lhs < rhs);
+    op_lte:
+        BINARY(lhs <= rhs);
+    op_gt:
+        BINARY(lhs > rhs);
+    op_gte:
+        BINARY(lhs >= rhs);
+
+    op_addk:
+        BINARY_K(arith::add(lhs, rhs));
+    op_subk:
+        BINARY_K(arith::sub(lhs, rhs));
+    op_mulk:
+        BINARY_K(arith::mul(lhs, rhs));
+    op_divk:
+        if (cur->imm == 0)
+        {
+            result.error = "运行时错误: 除数为零";
+            goto fail;
+        }
+        BINARY_K(arith::div(lhs, rhs));
+    op_powk:
+        if (cur->imm < 0)
+        {
+            result.error = "运行时错误: 负指数";
+            goto fail;
+        }
+        BINARY_K(arith::pow(lhs, rhs));
+    op_shlk:
+        if (cur->imm < 0)
+        {
+            result.error = "运行时错误: 负指数";
+            goto fail;
+        }
+        BINARY_K(arith::shl(lhs, rhs));
+    op_eqk:
+        BINARY_K(lhs == rhs);
+    op_neqk:
+        BINARY_K(lhs != rhs);
+    op_ltk:
+        BINARY_K(lhs < rhs);
+    op_ltek:
+        BINARY_K(lhs <= rhs);
+    op_gtk:
+        BINARY_K(lhs > rhs);
+    op_gtek:
+        BINARY_K(lhs >= rhs);
+
+    op_neg:
+        R(dst) = arith::sub(0, R(a));
+        DISPATCH();
+    op_not:
+        R(dst) = R(a) == 0;
+        DISPATCH();
+    op_odd:
+        R(dst) = R(a) % 2 != 0;
+        DISPATCH();
+
+    op_jump:
+        ip = tcode + cur->imm;
+        DISPATCH();
+    op_jz:
+        if (R(a) == 0)
+        {
+            ip = tcode + cur->imm;
+        }
+        DISPATCH();
+    op_jnz:
+        if (R(a) != 0)
+        {
+            ip = tcode + cur->imm;
+        }
+        DISPATCH();
+
+    op_call:
+        sp[0] = frameAt(bp, cur->level) - base;
+        sp[1] = bp - base;
+        sp[2] = ip - tcode;
+        bp = sp;
+        ip = tcode + cur->imm;
+        DISPATCH();
+
+    op_tail:
+        // 保留DL和返回地址，被调用者返回时直接回到当前过程的调用者；紧随其后的是当前过程的Return
+        // 复用的帧中当前过程的变量由被调用者的ENTER清零
+        bp[0] = frameAt(bp, cur->level) - base;
+        counted -= cur[1].a;
+        sp = bp;
+        ip = tcode + cur->imm;
+        DISPATCH();
+
+    op_enter:
+        // 留出下一次CALL写帧头的空间
+        if (budget - counted < cur->a + FRAME_HEADER)
+        {
+            result.error = "运行时错误: 栈溢出";
+            goto fail;
+        }
+        counted += cur->a;
+        if (limit - bp < cur->imm + FRAME_HEADER)
+        {
+            auto frame = bp - base;
+            stack.resize(std::max(stack.size() * 2, static_cast<size_t>(frame + cur->imm + FRAME_HEADER)));
+            base = stack.data();
+            limit = base + stack.size();
+            bp = base + frame;
+        }
+        // 变量的初值为0；临时寄存器总是先写后读，不必清零
+        std::fill(bp + FRAME_HEADER, bp + cur->a, 0);
+        sp = bp + cur->imm;
+        DISPATCH();
+
+    op_return:
+        counted -= cur->a;
+        sp = bp;
+        ip = tcode + bp[2];
+        bp = base + bp[1];
+        DISPATCH();
+
+#undef BINARY_K
+#undef BINARY
+#undef R
+#undef DISPATCH
+
+    fail:
+        result.success = false;
+        result.error += " (地址 " + std::to_string(cur - tcode) + ")";
+
+    op_halt:
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        result.instructions = result.success ? executed - 1 : executed;
+        if (result.success)
+        {
+            result.globals.assign(base + FRAME_HEADER, base + FRAME_HEADER + program_.globals.size());
+        }
+        return result;
+    }
+
+} // namespace pl0
@@ -1,4 +1,6 @@
 #include "../include/SemanticAnalyzer.h"
+#include "../include/Trace.h"
+#include "../include/ConstantFolder.h"
 
 #include <sstream>
 
@@ -19,7 +21,7 @@ namespace pl0
     {
         try
         {
-            program.accept(*this);
+            walk(program);
             return !had_error_;
         }
         catch (const std::exception &e)
@@ -33,7 +35,7 @@ namespace pl0
     {
         info_.push_back("Analyzing program...");
         enterScope();
-        node.block().accept(*this);
+        walk(node.block());
         leaveScope();
     }
 
@@ -42,23 +44,23 @@ namespace pl0
         // 处理常量声明
         for (const auto &constDecl : node.consts())
         {
-            constDecl->accept(*this);
+            walk(*constDecl);
         }
 
         // 处理变量声明
         for (const auto &varDecl : node.vars())
         {
-            varDecl->accept(*this);
+            walk(*varDecl);
         }
 
         // 处理过程声明
         for (const auto &procDecl : node.procedures())
         {
-            procDecl->accept(*this);
+            walk(*procDecl);
         }
 
         // 处理语句
-        node.statement().accept(*this);
+        walk(node.statement());
     }
 
     void SemanticAnalyzer::visit(const ConstDeclaration &node)
@@ -71,10 +73,10 @@ namespace pl0
             .type = SymbolType::Constant,
             .value = node.value(),
             .level = current_level_,
-            .index = 0 // 常量不需要地址
-        };
+            .index = 0, // 常量不需要地址
+            .name = node.symbol()};
 
-        if (!declareSymbol(node.name(), symbol))
+        if (!declareSymbol(node.symbol(), symbol))
         {
             addError("Duplicate constant declaration: " + std::string(node.name()));
         }
@@ -90,9 +92,10 @@ namespace pl0
             .type = SymbolType::Variable,
             .value = std::nullopt,
             .level = current_level_,
-            .index = var_index_++};
+            .index = var_index_++,
+            .name = node.symbol()};
 
-        if (!declareSymbol(node.name(), symbol))
+        if (!declareSymbol(node.symbol(), symbol))
         {
             addError("Duplicate variable declaration: " + std::string(node.name()));
         }
@@ -108,23 +111,23 @@ namespace pl0
             .type = SymbolType::Procedure,
             .value = std::nullopt,
             .level = current_level_,
-            .index = 0 // 过程不需要地址
-        };
+            .index = 0, // 过程不需要地址
+            .name = node.symbol()};
 
-        if (!declareSymbol(node.name(), symbol))
+        if (!declareSymbol(node.symbol(), symbol))
         {
             addError("Duplicate procedure declaration: " + std::string(node.name()));
             return;
         }
 
         enterScope();
-        node.block().accept(*this);
+        walk(node.block());
         leaveScope();
     }
 
     void SemanticAnalyzer::visit(const AssignStatement &node)
     {
-        auto symbol = lookupSymbol(node.name());
+        const auto *symbol = lookupSymbol(node.symbol());
         if (!symbol)
         {
             addError(makeError("未声明的标识符", node.name()));
@@ -137,12 +140,12 @@ namespace pl0
             return;
         }
 
-        node.expression().accept(*this);
+        walk(node.expression());
     }
 
     void SemanticAnalyzer::visit(const CallStatement &node)
     {
-        auto symbol = lookupSymbol(node.procName());
+        const auto *symbol = lookupSymbol(node.symbol());
         if (!symbol)
         {
             addError(makeError("未声明的过程", node.procName()));
@@ -159,43 +162,53 @@ namespace pl0
     {
         for (const auto &stmt : node.statements())
         {
-            stmt->accept(*this);
+            walk(*stmt);
         }
     }
 
     void SemanticAnalyzer::visit(const IfStatement &node)
     {
-        node.condition().accept(*this);
-        node.thenStmt().accept(*this);
+        walk(node.condition());
+        walk(node.thenStmt());
     }
 
     void SemanticAnalyzer::visit(const WhileStatement &node)
     {
-        node.condition().accept(*this);
-        node.body().accept(*this);
+        walk(node.condition());
+        walk(node.body());
     }
 
+    // 子表达式的常量值经last_expression_value_自底向上传递，每个节点只求值一次
     void SemanticAnalyzer::visit(const BinaryExpression &node)
     {
-        node.left().accept(*this);
-        node.right().accept(*this);
+        walk(node.left());
+        auto lhs = last_expression_value_;
+        walk(node.right());
+        auto rhs = last_expression_value_;
 
         // 检查除零错误
-        if (node.op() == BinaryExpression::Op::Div)
+        if (node.op() == BinaryExpression::Op::Div && rhs && *rhs == 0)
         {
-            if (auto right_val = node.right().evaluateConstant())
+            addError("除数不能为零");
+        }
+
+        last_expression_value_.reset();
+        if (lhs && rhs)
+        {
+            if (auto value = ConstantFolder::evaluate(node.op(), *lhs, *rhs))
             {
-                if (*right_val == 0)
-                {
-                    addError("除数不能为零");
-                }
+                last_expression_value_ = value->value;
             }
         }
     }
 
     void SemanticAnalyzer::visit(const UnaryExpression &node)
     {
-        node.operand().accept(*this);
+        walk(node.operand());
+        if (last_expression_value_)
+        {
+            last_expression_value_ = ConstantFolder::evaluate(node.op(), *last_expression_value_).value;
+        }
     }
 
     void SemanticAnalyzer::visit(const NumberExpression &node)
@@ -205,7 +218,8 @@ namespace pl0
 
     void SemanticAnalyzer::visit(const IdentifierExpression &node)
     {
-        auto symbol = lookupSymbol(node.name());
+        last_expression_value_.reset();
+        const auto *symbol = lookupSymbol(node.symbol());
         if (!symbol)
         {
             addError(makeError("未声明的标识符", node.name()));
@@ -226,56 +240,43 @@ namespace pl0
 
     void SemanticAnalyzer::enterScope()
     {
-        symbol_tables_.emplace_back();
+        symbols_.enterScope();
         current_level_++;
         var_index_ = 0;
+        PL0_TRACE(Debug, SemanticScope, static_cast<uint32_t>(current_level_), 1);
     }
 
     void SemanticAnalyzer::leaveScope()
     {
-        if (!symbol_tables_.empty())
-        {
-            symbol_tables_.pop_back();
-        }
+        PL0_TRACE(Debug, SemanticScope, static_cast<uint32_t>(current_level_), 0);
+        symbols_.leaveScope();
         if (current_level_ > 0)
         {
             current_level_--;
         }
     }
 
-    bool SemanticAnalyzer::declareSymbol(std::string_view name, Symbol symbol)
+    bool SemanticAnalyzer::declareSymbol(SymbolId name, const Symbol &symbol)
     {
-        if (symbol_tables_.empty())
-        {
-            symbol_tables_.emplace_back();
-        }
-
-        auto &current_scope = symbol_tables_.back();
-        if (current_scope.contains(name))
+        if (!symbols_.declare(name, symbol))
         {
             return false;
         }
-
-        current_scope.emplace(name, symbol);
+        PL0_TRACE(Verbose, SemanticDeclare, static_cast<uint32_t>(symbol.level),
+                  static_cast<int64_t>(symbol.type), static_cast<int64_t>(symbol.index));
         return true;
     }
 
-    std::optional<Symbol> SemanticAnalyzer::lookupSymbol(std::string_view name) const
+    const Symbol *SemanticAnalyzer::lookupSymbol(SymbolId name) const noexcept
     {
-        for (auto it = symbol_tables_.rbegin(); it != symbol_tables_.rend(); ++it)
-        {
-            if (auto found = it->find(name); found != it->end())
-            {
-                return found->second;
-            }
-        }
-        return std::nullopt;
+        return symbols_.lookup(name);
     }
 
     void SemanticAnalyzer::addError(std::string message)
     {
         errors_.push_back(std::move(message));
         had_error_ = true;
+        PL0_TRACE(Info, SemanticError, static_cast<uint32_t>(current_level_), static_cast<int64_t>(errors_.size()));
     }
 
 } // namespace pl0
\ No newline at end of file
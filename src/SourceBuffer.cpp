@@ -0,0 +1,136 @@
+#include "../include/SourceBuffer.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace pl0
+{
+
+    SourceBuffer::~SourceBuffer()
+    {
+        release();
+    }
+
+    SourceBuffer::SourceBuffer(SourceBuffer &&other) noexcept
+        : data_(other.data_), size_(other.size_), mapped_(other.mapped_), owned_(std::move(other.owned_))
+    {
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.mapped_ = false;
+    }
+
+    SourceBuffer &SourceBuffer::operator=(SourceBuffer &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            data_ = other.data_;
+            size_ = other.size_;
+            mapped_ = other.mapped_;
+            owned_ = std::move(other.owned_);
+            other.data_ = nullptr;
+            other.size_ = 0;
+            other.mapped_ = false;
+        }
+        return *this;
+    }
+
+    void SourceBuffer::release() noexcept
+    {
+        if (mapped_ && data_ != nullptr)
+        {
+            ::munmap(const_cast<char *>(data_), size_);
+        }
+        owned_.reset();
+        data_ = nullptr;
+        size_ = 0;
+        mapped_ = false;
+    }
+
+    std::optional<SourceBuffer> SourceBuffer::open(const std::filesystem::path &path)
+    {
+        if (path == "-")
+        {
+            return readAll(STDIN_FILENO);
+        }
+
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return std::nullopt;
+        }
+
+        struct stat st{};
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            return std::nullopt;
+        }
+
+        // 只映射非空的普通文件
+        if (S_ISREG(st.st_mode) && st.st_size > 0)
+        {
+            auto size = static_cast<size_t>(st.st_size);
+            void *addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED)
+            {
+                ::madvise(addr, size, MADV_SEQUENTIAL);
+                ::close(fd);
+
+                SourceBuffer buffer;
+                buffer.data_ = static_cast<const char *>(addr);
+                buffer.size_ = size;
+                buffer.mapped_ = true;
+                return buffer;
+            }
+        }
+
+        auto buffer = readAll(fd);
+        ::close(fd);
+        return buffer;
+    }
+
+    std::optional<SourceBuffer> SourceBuffer::readAll(int fd)
+    {
+        size_t capacity = 64 * 1024;
+        size_t size = 0;
+        auto data = std::make_unique<char[]>(capacity);
+
+        while (true)
+        {
+            if (size == capacity)
+            {
+                auto grown = std::make_unique<char[]>(capacity * 2);
+                std::memcpy(grown.get(), data.get(), size);
+                data = std::move(grown);
+                capacity *= 2;
+            }
+
+            ssize_t n = ::read(fd, data.get() + size, capacity - size);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return std::nullopt;
+            }
+            if (n == 0)
+            {
+                break;
+            }
+            size += static_cast<size_t>(n);
+        }
+
+        SourceBuffer buffer;
+        buffer.size_ = size;
+        buffer.owned_ = std::move(data);
+        buffer.data_ = buffer.owned_.get();
+        return buffer;
+    }
+
+} // namespace pl0
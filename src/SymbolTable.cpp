@@ -0,0 +1,55 @@
+#include "../include/SymbolTable.h"
+
+namespace pl0
+{
+
+    void SymbolTable::enterScope()
+    {
+        scopes_.emplace_back();
+    }
+
+    void SymbolTable::leaveScope()
+    {
+        if (scopes_.empty())
+        {
+            return;
+        }
+        for (SymbolId name : scopes_.back())
+        {
+            bindings_[name].pop_back();
+        }
+        scopes_.pop_back();
+    }
+
+    bool SymbolTable::declare(SymbolId name, const Symbol &symbol)
+    {
+        if (scopes_.empty())
+        {
+            enterScope();
+        }
+        if (name >= bindings_.size())
+        {
+            bindings_.resize(static_cast<size_t>(name) + 1);
+        }
+
+        auto &stack = bindings_[name];
+        if (!stack.empty() && stack.back().depth == scopes_.size())
+        {
+            return false;
+        }
+
+        stack.push_back(Binding{scopes_.size(), symbol});
+        scopes_.back().push_back(name);
+        return true;
+    }
+
+    const Symbol *SymbolTable::lookup(SymbolId name) const noexcept
+    {
+        if (name >= bindings_.size() || bindings_[name].empty())
+        {
+            return nullptr;
+        }
+        return &bindings_[name].back().symbol;
+    }
+
+} // namespace pl0
@@ -0,0 +1,175 @@
+#include "../include/ThreadPool.h"
+
+#include <utility>
+#include <algorithm>
+
+namespace pl0
+{
+
+    namespace
+    {
+        // 当前线程所属的线程池及其队列下标，用于把任务内提交的任务放进自己的队列
+        thread_local const ThreadPool *current_pool = nullptr;
+        thread_local size_t current_index = 0;
+    }
+
+    ThreadPool::ThreadPool(size_t threads)
+    {
+        if (threads == 0)
+        {
+            threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+
+        queues_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i)
+        {
+            queues_.push_back(std::make_unique<Queue>());
+        }
+
+        threads_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i)
+        {
+            threads_.emplace_back([this, i]
+                                  { run(i); });
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        waitIdle();
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        work_available_.notify_all();
+        for (auto &thread : threads_)
+        {
+            thread.join();
+        }
+    }
+
+    void ThreadPool::submit(Task task)
+    {
+        size_t index = current_pool == this
+                           ? current_index
+                           : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard lock(queues_[index]->mutex);
+            queues_[index]->tasks.push_back(std::move(task));
+            queued_.fetch_add(1, std::memory_order_release);
+        }
+
+        // 持锁通知，避免与工作线程的等待条件检查交错而丢失唤醒
+        std::lock_guard lock(mutex_);
+        work_available_.notify_one();
+    }
+
+    void ThreadPool::wait()
+    {
+        waitIdle();
+
+        std::exception_ptr error;
+        {
+            std::lock_guard lock(mutex_);
+            error = std::exchange(error_, nullptr);
+        }
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    void ThreadPool::waitIdle()
+    {
+        std::unique_lock lock(mutex_);
+        all_done_.wait(lock, [this]
+                       { return pending_.load(std::memory_order_acquire) == 0; });
+    }
+
+    bool ThreadPool::popLocal(size_t index, Task &task)
+    {
+        auto &queue = *queues_[index];
+        std::lock_guard lock(queue.mutex);
+        if (queue.tasks.empty())
+        {
+            return false;
+        }
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool ThreadPool::steal(size_t index, Task &task, bool blocking)
+    {
+        for (size_t offset = 1; offset < queues_.size(); ++offset)
+        {
+            auto &queue = *queues_[(index + offset) % queues_.size()];
+            std::unique_lock lock(queue.mutex, std::defer_lock);
+            if (blocking)
+            {
+                lock.lock();
+            }
+            else if (!lock.try_lock())
+            {
+                continue;
+            }
+            if (queue.tasks.empty())
+            {
+                continue;
+            }
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            steals_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void ThreadPool::run(size_t index)
+    {
+        current_pool = this;
+        current_index = index;
+
+        while (true)
+        {
+            Task task;
+            // 先用try_lock窃取；全部失败时再阻塞地逐个加锁，避免在仍有任务时空转
+            if (popLocal(index, task) || steal(index, task, false) || steal(index, task, true))
+            {
+                try
+                {
+                    task();
+                }
+                catch (...)
+                {
+                    std::lock_guard lock(mutex_);
+                    if (!error_)
+                    {
+                        error_ = std::current_exception();
+                    }
+                }
+
+                if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    std::lock_guard lock(mutex_);
+                    all_done_.notify_all();
+                }
+                continue;
+            }
+
+            // 没取到任务：队列全空时休眠；阻塞窃取期间有新任务入队时重试
+            std::unique_lock lock(mutex_);
+            work_available_.wait(lock, [this]
+                                 { return stopping_ || queued_.load(std::memory_order_acquire) > 0; });
+            if (stopping_ && queued_.load(std::memory_order_acquire) == 0)
+            {
+                return;
+            }
+        }
+    }
+
+} // namespace pl0
@@ -0,0 +1,118 @@
+#include "../include/TieredEngine.h"
+
+#include <chrono>
+#include <stdexcept>
+
+namespace pl0
+{
+
+    TieredEngine::TieredEngine(const Program &program, const PCode &code, size_t stack_size, uint32_t threshold,
+                               bool background)
+        : program_(program), code_(code), stack_size_(stack_size), threshold_(threshold == 0 ? 1 : threshold),
+          background_(background)
+    {
+    }
+
+    TieredEngine::~TieredEngine()
+    {
+        if (worker_.joinable())
+        {
+            worker_.join();
+        }
+    }
+
+    ExecutionResult TieredEngine::run()
+    {
+        VM vm(code_, stack_size_);
+        vm.setTier(this);
+        auto result = vm.run();
+        if (worker_.joinable())
+        {
+            worker_.join();
+        }
+        return result;
+    }
+
+    void TieredEngine::hot(size_t)
+    {
+        // 第一个变热的地址触发整个程序的编译，之后的只需等待
+        int expected = Idle;
+        if (!state_.compare_exchange_strong(expected, Compiling, std::memory_order_relaxed))
+        {
+            return;
+        }
+        if (background_)
+        {
+            worker_ = std::thread(&TieredEngine::compile, this);
+        }
+        else
+        {
+            compile();
+        }
+    }
+
+    NativeTier::Entry TieredEngine::enter(size_t address, int64_t *base, int64_t *frame, std::string &error)
+    {
+        switch (state_.load(std::memory_order_acquire))
+        {
+        case Ready:
+            break;
+        case Failed:
+            return Entry::Disabled;
+        default:
+            return Entry::Unavailable;
+        }
+
+        auto it = entries_.find(address);
+        if (it == entries_.end())
+        {
+            return Entry::Unavailable;
+        }
+        ++stats_.nativeEntries;
+        int64_t status = image_->enter(base, frame, it->second);
+        if (status != NativeCode::Ok)
+        {
+            error = NativeImage::message(status);
+            return Entry::Failed;
+        }
+        return Entry::Returned;
+    }
+
+    void TieredEngine::compile()
+    {
+        auto start = std::chrono::steady_clock::now();
+        try
+        {
+            JitCompiler compiler;
+            native_ = compiler.compile(program_);
+            // 两边都按AST先序记录，数目不一致说明p-code不是由这个AST生成的
+            if (native_.procedures.size() + 1 != code_.procedures.size() ||
+                native_.loops.size() != code_.loops.size())
+            {
+                throw std::runtime_error("分层执行: p-code与AST不一致");
+            }
+            image_ = std::make_unique<NativeImage>(native_, stack_size_);
+            if (!image_->valid())
+            {
+                throw std::runtime_error(image_->error());
+            }
+            for (size_t i = 0; i < native_.procedures.size(); ++i)
+            {
+                entries_.emplace(code_.procedures[i + 1].entry, native_.procedures[i]);
+            }
+            for (size_t i = 0; i < native_.loops.size(); ++i)
+            {
+                entries_.emplace(code_.loops[i], native_.loops[i]);
+            }
+        }
+        catch (const std::exception &)
+        {
+            state_.store(Failed, std::memory_order_release);
+            return;
+        }
+        stats_.compiled = true;
+        stats_.compileSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        state_.store(Ready, std::memory_order_release);
+    }
+
+} // namespace pl0
@@ -1,18 +1,79 @@
 #include "../include/TokenInterpreter.h"
+#include "../include/CharScanner.h"
+#include "../include/Trace.h"
 
-#include <limits>
-#include <cctype>
-#include <iostream>
 #include <algorithm>
+#include <limits>
 
 namespace pl0
 {
 
     namespace
     {
-        constexpr bool isDigit(char c) noexcept { return c >= '0' && c <= '9'; }
-        constexpr bool isAlpha(char c) noexcept { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
-        constexpr bool isAlphaNum(char c) noexcept { return isAlpha(c) || isDigit(c); }
+        // Token首字符的分类
+        enum class Lead : uint8_t
+        {
+            INVALID,
+            ALPHA,
+            DIGIT,
+            SINGLE, // 单字符运算符，类型直接查表
+            COLON,
+            LESS,
+            GREATER,
+        };
+
+        struct LeadEntry
+        {
+            Lead lead = Lead::INVALID;
+            TokenType type = TokenType::ERROR;
+        };
+
+        // 按首字符一次查表分派，取代逐个尝试数字、标识符、运算符
+        constexpr std::array<LeadEntry, 256> LEAD_TABLE = []
+        {
+            std::array<LeadEntry, 256> table{};
+            for (int c = 0; c < 256; ++c)
+            {
+                if (scan::is(static_cast<char>(c), scan::ALPHA))
+                    table[c].lead = Lead::ALPHA;
+                if (scan::is(static_cast<char>(c), scan::DIGIT))
+                    table[c].lead = Lead::DIGIT;
+            }
+            constexpr std::pair<char, TokenType> SINGLES[] = {
+                {'+', TokenType::PLUS}, {'-', TokenType::MINUS}, {'*', TokenType::MULTIPLY},
+                {'/', TokenType::DIVIDE}, {'(', TokenType::LPAREN}, {')', TokenType::RPAREN},
+                {',', TokenType::COMMA}, {';', TokenType::SEMICOLON}, {'.', TokenType::PERIOD},
+                {'=', TokenType::EQ}, {'#', TokenType::NEQ}, {'^', TokenType::POWER},
+            };
+            for (auto [c, type] : SINGLES)
+                table[static_cast<unsigned char>(c)] = {Lead::SINGLE, type};
+            table[':'].lead = Lead::COLON;
+            table['<'].lead = Lead::LESS;
+            table['>'].lead = Lead::GREATER;
+            return table;
+        }();
+
+        // 源码中的空白和标识符大多只有几个字符，逐字节判断比调用向量化扫描更快；
+        // 超过SHORT_RUN个字符仍未结束时才交给scan中的向量化实现
+        constexpr size_t SHORT_RUN = 16;
+
+        // 不超过18位的十进制数不会溢出int64，无需逐位检查
+        constexpr size_t SAFE_DIGITS = std::numeric_limits<int64_t>::digits10;
+
+        template <typename Scan>
+        size_t scanRun(std::string_view source, size_t pos, uint8_t mask, Scan vectorScan) noexcept
+        {
+            size_t limit = std::min(source.length(), pos + SHORT_RUN);
+            while (pos < limit && scan::is(source[pos], mask))
+            {
+                ++pos;
+            }
+            if (pos == limit && pos < source.length())
+            {
+                return vectorScan(source, pos);
+            }
+            return pos;
+        }
     }
 
     Token TokenInterpreter::nextToken() noexcept
@@ -20,36 +81,37 @@ namespace pl0
         if (has_peeked_)
         {
             has_peeked_ = false;
-            return std::move(peeked_token_);
+            return peeked_token_;
         }
 
         skipWhitespace();
 
-        if (current_ >= source_.length())
-        {
-            return Token{TokenType::END_OF_FILE};
-        }
-
-        if (auto number = tryReadNumber())
-        {
-            return *number;
-        }
-
-        if (auto identifier = tryReadIdentifier())
+        size_t start = current_;
+        if (start >= source_.length())
         {
-            return *identifier;
+            return Token{TokenType::END_OF_FILE, static_cast<uint32_t>(start), 0};
         }
 
-        if (auto op = tryReadOperator())
+        const LeadEntry &entry = LEAD_TABLE[static_cast<unsigned char>(source_[start])];
+        switch (entry.lead)
         {
-            return *op;
+        case Lead::ALPHA:
+            return readIdentifier(start);
+        case Lead::DIGIT:
+            return readNumber(start);
+        case Lead::SINGLE:
+            current_ = start + 1;
+            return Token{entry.type, static_cast<uint32_t>(start), 1};
+        case Lead::INVALID:
+            break;
+        default:
+            return readOperator(start);
         }
 
-        char invalid = peek();
-        advance();
-        std::string error_msg = "无效的字符: ";
-        error_msg += invalid;
-        return Token{TokenType::ERROR};
+        // 无效的字符
+        PL0_TRACE(Info, LexError, static_cast<uint32_t>(start), static_cast<unsigned char>(source_[start]));
+        current_ = start + 1;
+        return Token{TokenType::ERROR, static_cast<uint32_t>(start), 1};
     }
 
     Token TokenInterpreter::peekToken() noexcept
@@ -62,182 +124,152 @@ namespace pl0
         return peeked_token_;
     }
 
-    void TokenInterpreter::skipWhitespace() noexcept
+    TokenBuffer TokenInterpreter::tokenize()
     {
-        while (current_ < source_.length() && std::isspace(static_cast<unsigned char>(source_[current_])))
+        TokenBuffer buffer{source_};
+        if (source_.length() > std::numeric_limits<uint32_t>::max())
         {
-            if (source_[current_] == '\n')
+            buffer.push(Token{TokenType::ERROR});
+            return buffer;
+        }
+
+        // 扫过开头一段后按其中各列的密度外推全文的数量，多留1/8余量，减少扩容次数；
+        // 按源码长度的固定比例预留会在Token稀疏的源码上多占数倍内存
+        constexpr size_t SAMPLE_BYTES = 64 * 1024;
+        bool reserved = source_.length() <= SAMPLE_BYTES;
+
+        while (true)
+        {
+            if (!reserved && current_ >= SAMPLE_BYTES)
+            {
+                reserved = true;
+                auto extrapolate = [this](size_t count)
+                { return count * source_.length() / current_ * 9 / 8 + 1; };
+                buffer.reserve(extrapolate(buffer.size()), extrapolate(buffer.symbols().size()),
+                               extrapolate(buffer.numbers().size()));
+            }
+            auto token = nextToken();
+            auto type = token.type();
+            if (type == TokenType::NUMBER)
+            {
+                buffer.pushNumber(token, last_number_);
+                continue;
+            }
+            if (type == TokenType::IDENTIFIER)
             {
-                line_++;
-                column_ = 0;
+                buffer.pushIdentifier(token, interner_.intern(token.text(source_)));
+                continue;
             }
-            else
+            buffer.push(token);
+            if (type == TokenType::END_OF_FILE || type == TokenType::ERROR)
             {
-                column_++;
+                break;
             }
-            current_++;
         }
+        return buffer;
     }
 
-    std::optional<Token> TokenInterpreter::tryReadNumber() noexcept
+    void TokenInterpreter::skipWhitespace() noexcept
     {
-        if (!isDigit(peek()))
+        size_t pos = current_;
+        size_t limit = std::min(source_.length(), pos + SHORT_RUN);
+        while (pos < limit && scan::is(source_[pos], scan::SPACE))
         {
-            return std::nullopt;
+            if (source_[pos] == '\n')
+            {
+                ++line_;
+                line_start_ = pos + 1;
+            }
+            ++pos;
         }
 
-        size_t start = current_;
-        int64_t value = 0;
-
-        while (isDigit(peek()))
+        if (pos == limit && pos < source_.length())
         {
-            char digit = peek();
-            if (value > (std::numeric_limits<int64_t>::max() - (digit - '0')) / 10)
+            auto run = scan::skipWhitespace(source_, pos);
+            if (run.newlines != 0)
             {
-                std::cerr << "数字溢出: " << source_.substr(start, current_ - start) << '\n';
-                return Token{TokenType::ERROR};
+                line_ += run.newlines;
+                line_start_ = run.line_start;
             }
-            value = value * 10 + (digit - '0');
-            advance();
+            pos = run.end;
         }
-
-        std::cerr << "解析数字: " << value << " 从位置 " << start << " 到 " << current_ << '\n';
-        return Token{TokenType::NUMBER, value};
+        current_ = pos;
     }
 
-    std::optional<Token> TokenInterpreter::tryReadIdentifier() noexcept
+    Token TokenInterpreter::readNumber(size_t start) noexcept
     {
-        if (!isAlpha(peek()))
-        {
-            return std::nullopt;
-        }
+        size_t end = scanRun(source_, start, scan::DIGIT, scan::scanDigits);
+        int64_t value = 0;
 
-        size_t start = current_;
-        while (isAlphaNum(peek()))
+        if (end - start <= SAFE_DIGITS)
         {
-            advance();
+            for (size_t i = start; i < end; ++i)
+            {
+                value = value * 10 + (source_[i] - '0');
+            }
         }
-
-        std::string_view identifier = source_.substr(start, current_ - start);
-
-        if (identifier.empty() || std::all_of(identifier.begin(), identifier.end(),
-                                              [](char c)
-                                              { return std::isspace(static_cast<unsigned char>(c)); }))
+        else
         {
-            return std::nullopt;
+            for (size_t i = start; i < end; ++i)
+            {
+                int digit = source_[i] - '0';
+                if (value > (std::numeric_limits<int64_t>::max() - digit) / 10)
+                {
+                    PL0_TRACE(Info, LexError, static_cast<uint32_t>(start), -1);
+                    current_ = end;
+                    return Token{TokenType::ERROR, static_cast<uint32_t>(start), static_cast<uint32_t>(end - start)};
+                }
+                value = value * 10 + digit;
+            }
         }
+        current_ = end;
 
-        auto it = std::find_if(KEYWORDS.begin(), KEYWORDS.end(),
-                               [identifier](const auto &pair)
-                               { return pair.first == identifier; });
+        PL0_TRACE(Verbose, LexNumber, static_cast<uint32_t>(start), value, static_cast<int64_t>(end - start));
+        last_number_ = value;
+        return Token{TokenType::NUMBER, static_cast<uint32_t>(start), static_cast<uint32_t>(end - start)};
+    }
+
+    Token TokenInterpreter::readIdentifier(size_t start) noexcept
+    {
+        size_t end = scanRun(source_, start + 1, scan::ALPHA | scan::DIGIT, scan::scanIdentifier);
+        current_ = end;
 
-        if (it != KEYWORDS.end())
+        auto token = Token{TokenType::IDENTIFIER, static_cast<uint32_t>(start), static_cast<uint32_t>(end - start)};
+        if (auto keyword = KEYWORD_TABLE.find(source_.substr(start, end - start)))
         {
-            return Token{it->second};
+            return Token{*keyword, token.offset(), token.length()};
         }
-
-        return Token{TokenType::IDENTIFIER, identifier};
+        return token;
     }
 
-    std::optional<Token> TokenInterpreter::tryReadOperator() noexcept
+    Token TokenInterpreter::readOperator(size_t start) noexcept
     {
-        char c = peek();
-        char next = peekNext();
+        // 可能由两个字符组成的运算符: ":=" "<=" ">="
+        char c = source_[start];
+        bool equals = start + 1 < source_.length() && source_[start + 1] == '=';
+        auto offset = static_cast<uint32_t>(start);
 
         switch (c)
         {
-        case '+':
-            advance();
-            return Token{TokenType::PLUS};
-        case '-':
-            advance();
-            return Token{TokenType::MINUS};
-        case '*':
-            advance();
-            return Token{TokenType::MULTIPLY};
-        case '/':
-            advance();
-            return Token{TokenType::DIVIDE};
-        case '(':
-            advance();
-            return Token{TokenType::LPAREN};
-        case ')':
-            advance();
-            return Token{TokenType::RPAREN};
-        case ',':
-            advance();
-            return Token{TokenType::COMMA};
-        case ';':
-            advance();
-            return Token{TokenType::SEMICOLON};
-        case '.':
-            advance();
-            return Token{TokenType::PERIOD};
-
         case ':':
-            if (next == '=')
+            if (equals)
             {
-                advance();
-                advance();
-                return Token{TokenType::ASSIGN};
+                current_ = start + 2;
+                return Token{TokenType::ASSIGN, offset, 2};
             }
             break;
-
-        case '=':
-            advance();
-            return Token{TokenType::EQ};
-
-        case '#':
-            advance();
-            return Token{TokenType::NEQ};
-
         case '<':
-            advance();
-            if (peek() == '=')
-            {
-                advance();
-                return Token{TokenType::LTE};
-            }
-            return Token{TokenType::LT};
-
+            current_ = start + (equals ? 2 : 1);
+            return Token{equals ? TokenType::LTE : TokenType::LT, offset, equals ? 2u : 1u};
         case '>':
-            advance();
-            if (peek() == '=')
-            {
-                advance();
-                return Token{TokenType::GTE};
-            }
-            return Token{TokenType::GT};
-
-        case '^':
-            advance();
-            return Token{TokenType::POWER};
+            current_ = start + (equals ? 2 : 1);
+            return Token{equals ? TokenType::GTE : TokenType::GT, offset, equals ? 2u : 1u};
         }
 
-        return std::nullopt;
-    }
-
-    char TokenInterpreter::peek() const noexcept
-    {
-        if (current_ >= source_.length())
-            return '\0';
-        return source_[current_];
-    }
-
-    char TokenInterpreter::peekNext() const noexcept
-    {
-        if (current_ + 1 >= source_.length())
-            return '\0';
-        return source_[current_ + 1];
-    }
-
-    void TokenInterpreter::advance() noexcept
-    {
-        if (current_ < source_.length())
-        {
-            current_++;
-            column_++;
-        }
+        // 单独的':'
+        PL0_TRACE(Info, LexError, offset, static_cast<unsigned char>(c));
+        current_ = start + 1;
+        return Token{TokenType::ERROR, offset, 1};
     }
 
-} // namespace pl0
\ No newline at end of file
+} // namespace pl0
@@ -0,0 +1,29 @@
+#include "../include/TokenStream.h"
+
+#include <algorithm>
+
+namespace pl0
+{
+
+    SourcePosition TokenBuffer::position(size_t index) const noexcept
+    {
+        size_t offset = std::min<size_t>(offsets_[index], source_.size());
+        std::string_view prefix = source_.substr(0, offset);
+
+        SourcePosition position;
+        position.line = 1 + static_cast<size_t>(std::count(prefix.begin(), prefix.end(), '\n'));
+        size_t line_start = prefix.rfind('\n');
+        position.column = line_start == std::string_view::npos ? offset + 1 : offset - line_start;
+        return position;
+    }
+
+    size_t TokenBuffer::memoryBytes() const noexcept
+    {
+        return types_.capacity() * sizeof(TokenType) +
+               offsets_.capacity() * sizeof(uint32_t) +
+               lengths_.capacity() * sizeof(uint32_t) +
+               symbols_.capacity() * sizeof(SymbolId) +
+               numbers_.capacity() * sizeof(int64_t);
+    }
+
+} // namespace pl0
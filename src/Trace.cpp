@@ -0,0 +1,247 @@
+#include "../include/Trace.h"
+
+#include <array>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+#include <condition_variable>
+
+namespace pl0::trace
+{
+
+    namespace
+    {
+        // 单生产者(所属线程)/单消费者(后台线程)的无锁环形缓冲区
+        class Ring
+        {
+        public:
+            static constexpr size_t CAPACITY = 4096;
+
+            bool push(const Record &record) noexcept
+            {
+                uint64_t head = head_.load(std::memory_order_relaxed);
+                uint64_t tail = tail_.load(std::memory_order_acquire);
+                if (head - tail >= CAPACITY)
+                {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                records_[head & (CAPACITY - 1)] = record;
+                head_.store(head + 1, std::memory_order_release);
+                return true;
+            }
+
+            template <typename Fn>
+            void drain(Fn &&fn)
+            {
+                uint64_t tail = tail_.load(std::memory_order_relaxed);
+                uint64_t head = head_.load(std::memory_order_acquire);
+                for (; tail != head; ++tail)
+                {
+                    fn(records_[tail & (CAPACITY - 1)]);
+                }
+                tail_.store(tail, std::memory_order_release);
+            }
+
+            [[nodiscard]] bool halfFull() const noexcept
+            {
+                return head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_relaxed) >= CAPACITY / 2;
+            }
+
+            [[nodiscard]] uint64_t dropped() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+
+        private:
+            std::array<Record, CAPACITY> records_{};
+            alignas(64) std::atomic<uint64_t> head_{0};
+            alignas(64) std::atomic<uint64_t> tail_{0};
+            std::atomic<uint64_t> dropped_{0};
+        };
+
+        const char *eventName(Event event) noexcept
+        {
+            switch (event)
+            {
+            case Event::LexNumber:
+                return "lex.number";
+            case Event::LexError:
+                return "lex.error";
+            case Event::ParseStatement:
+                return "parse.statement";
+            case Event::ParseError:
+                return "parse.error";
+            case Event::SemanticScope:
+                return "sema.scope";
+            case Event::SemanticDeclare:
+                return "sema.declare";
+            case Event::SemanticError:
+                return "sema.error";
+            }
+            return "unknown";
+        }
+
+        // 持有所有线程的缓冲区和后台刷新线程
+        class Collector
+        {
+        public:
+            ~Collector()
+            {
+                {
+                    std::lock_guard lock(mutex_);
+                    stopping_ = true;
+                }
+                wakeup_.notify_all();
+                if (worker_.joinable())
+                {
+                    worker_.join();
+                }
+                drainAll();
+            }
+
+            std::shared_ptr<Ring> registerThread()
+            {
+                auto ring = std::make_shared<Ring>();
+                std::lock_guard lock(mutex_);
+                rings_.push_back(ring);
+                if (!worker_.joinable() && !stopping_)
+                {
+                    worker_ = std::thread([this]
+                                          { run(); });
+                }
+                return ring;
+            }
+
+            void notify() noexcept { wakeup_.notify_one(); }
+
+            void drainAll() noexcept
+            {
+                std::lock_guard lock(drain_mutex_);
+                std::vector<std::shared_ptr<Ring>> rings;
+                {
+                    std::lock_guard registry(mutex_);
+                    rings = rings_;
+                }
+                std::FILE *sink = sink_.load(std::memory_order_relaxed);
+                for (const auto &ring : rings)
+                {
+                    ring->drain([sink](const Record &r)
+                                { std::fprintf(sink, "[%llu] %s a=%u b=%lld c=%lld\n",
+                                               static_cast<unsigned long long>(r.timestamp_ns), eventName(r.event),
+                                               r.a, static_cast<long long>(r.b), static_cast<long long>(r.c)); });
+                }
+                std::fflush(sink);
+            }
+
+            uint64_t dropped()
+            {
+                std::lock_guard lock(mutex_);
+                uint64_t total = 0;
+                for (const auto &ring : rings_)
+                {
+                    total += ring->dropped();
+                }
+                return total;
+            }
+
+            void setSink(std::FILE *sink) noexcept { sink_.store(sink, std::memory_order_relaxed); }
+
+        private:
+            void run()
+            {
+                std::unique_lock lock(mutex_);
+                while (!stopping_)
+                {
+                    wakeup_.wait_for(lock, std::chrono::milliseconds(20));
+                    lock.unlock();
+                    drainAll();
+                    lock.lock();
+                }
+            }
+
+            std::mutex mutex_;
+            std::mutex drain_mutex_;
+            std::condition_variable wakeup_;
+            std::vector<std::shared_ptr<Ring>> rings_;
+            std::thread worker_;
+            std::atomic<std::FILE *> sink_{stderr};
+            bool stopping_ = false;
+        };
+
+        Collector &collector()
+        {
+            static Collector instance;
+            return instance;
+        }
+
+        Ring &localRing()
+        {
+            thread_local std::shared_ptr<Ring> ring = collector().registerThread();
+            return *ring;
+        }
+
+        uint8_t initialLevel() noexcept
+        {
+            if (const char *env = std::getenv("PL0_TRACE"))
+            {
+                int value = std::atoi(env);
+                if (value > 0)
+                {
+                    return static_cast<uint8_t>(value > 3 ? 3 : value);
+                }
+            }
+            return 0;
+        }
+    }
+
+    namespace detail
+    {
+        std::atomic<uint8_t> runtime_level{initialLevel()};
+
+        void emit(Level level, Event event, uint32_t a, int64_t b, int64_t c) noexcept
+        {
+            auto now = std::chrono::steady_clock::now().time_since_epoch();
+            Record record{
+                .timestamp_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()),
+                .b = b,
+                .c = c,
+                .a = a,
+                .event = event,
+                .level = level};
+
+            Ring &ring = localRing();
+            ring.push(record);
+            if (ring.halfFull())
+            {
+                collector().notify();
+            }
+        }
+    }
+
+    void setLevel(Level level) noexcept
+    {
+        detail::runtime_level.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+    }
+
+    Level level() noexcept
+    {
+        return static_cast<Level>(detail::runtime_level.load(std::memory_order_relaxed));
+    }
+
+    void setSink(std::FILE *sink) noexcept
+    {
+        collector().setSink(sink);
+    }
+
+    void flush() noexcept
+    {
+        collector().drainAll();
+    }
+
+    uint64_t dropped() noexcept
+    {
+        return collector().dropped();
+    }
+
+} // namespace pl0::trace
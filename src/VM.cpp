@@ -0,0 +1,458 @@
+#include "../include/VM.h"
+#include "../include/Arith.h"
+// 构建时由tools/superinstructions.cpp生成在构建目录中
+#include "Superinstructions.h"
+
+#include <array>
+#include <chrono>
+#include <algorithm>
+
+namespace pl0
+{
+
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        // 线程化后的指令，handler为处理例程的标签地址
+        struct Threaded
+        {
+            const void *handler;
+            int64_t argument;
+            uint32_t level;
+        };
+
+        // 语句之间操作数栈为空，因此线性扫描即可得到表达式求值所需的最大深度
+        int64_t maxOperandDepth(std::span<const Instruction> code) noexcept
+        {
+            int64_t depth = 0;
+            int64_t max_depth = 0;
+            for (const auto &inst : code)
+            {
+                switch (inst.op)
+                {
+                case OpCode::LIT:
+                case OpCode::LOD:
+                    ++depth;
+                    break;
+                case OpCode::STO:
+                case OpCode::JPC:
+                    --depth;
+                    break;
+                case OpCode::OPR:
+                    switch (static_cast<Opr>(inst.argument))
+                    {
+                    case Opr::RET:
+                        depth = 0;
+                        break;
+                    case Opr::NEG:
+                    case Opr::ODD:
+                    case Opr::NOT:
+                        break;
+                    default:
+                        --depth;
+                        break;
+                    }
+                    break;
+                default:
+                    break;
+                }
+                max_depth = std::max(max_depth, depth);
+            }
+            return max_depth;
+        }
+    }
+
+    VM::Result VM::run()
+    {
+        // OpCode和Opr到处理例程的映射，OPR不单独分派
+        static const void *const OPCODE_LABELS[] = {
+            &&op_lit, nullptr, &&op_lod, &&op_sto, &&op_cal, &&op_int, &&op_jmp, &&op_jpc};
+        static const void *const OPR_LABELS[] = {
+            &&opr_ret, &&opr_neg, &&opr_add, &&opr_sub, &&opr_mul, &&opr_div, &&opr_odd, nullptr,
+            &&opr_eq, &&opr_neq, &&opr_lt, &&opr_gte, &&opr_gt, &&opr_lte, &&opr_pow, &&opr_not, &&opr_shl};
+        static const std::array<const void *, superinstructions::PATTERNS.size()> SUPERINSTRUCTION_LABELS{
+            PL0_SUPERINSTRUCTION_LABELS};
+
+        Result result;
+        const auto code = code_;
+        if (code.empty())
+        {
+            result.success = false;
+            result.error = "运行时错误: 没有可执行的代码";
+            return result;
+        }
+
+        // 翻译为线程化代码，末尾追加停机例程作为主程序的返回地址
+        std::vector<Threaded> threaded(code.size() + 1);
+        for (size_t i = 0; i < code.size(); ++i)
+        {
+            const auto &inst = code[i];
+            const void *handler = nullptr;
+            if (inst.op == OpCode::OPR)
+            {
+                if (inst.argument >= 0 && inst.argument < static_cast<int64_t>(std::size(OPR_LABELS)))
+                {
+                    handler = OPR_LABELS[inst.argument];
+                }
+            }
+            else if (static_cast<size_t>(inst.op) < std::size(OPCODE_LABELS))
+            {
+                handler = OPCODE_LABELS[static_cast<size_t>(inst.op)];
+            }
+            // 紧跟RET的CAL是尾调用，被调用者的静态链不是当前帧时复用当前帧；
+            // 分层执行时，调用和回边改用计数的例程
+            bool tail = inst.op == OpCode::CAL && inst.level > 0 && i + 1 < code.size() &&
+                        code[i + 1].op == OpCode::OPR && code[i + 1].argument == static_cast<int64_t>(Opr::RET);
+            if (tail)
+            {
+                handler = tier_ ? &&op_tail_counted : &&op_tail;
+            }
+            else if (tier_ && inst.op == OpCode::CAL)
+            {
+                handler = &&op_cal_counted;
+            }
+            else if (tier_ && inst.op == OpCode::JMP && inst.argument <= static_cast<int64_t>(i))
+            {
+                handler = &&op_loop;
+            }
+
+            bool is_jump = inst.op == OpCode::JMP || inst.op == OpCode::JPC || inst.op == OpCode::CAL;
+            bool bad_frame = inst.op == OpCode::INT && inst.argument < FRAME_HEADER;
+            if (!handler || bad_frame || (is_jump && (inst.argument < 0 || inst.argument >= static_cast<int64_t>(code.size()))))
+            {
+                result.success = false;
+                result.error = "运行时错误: 无效的指令 (地址 " + std::to_string(i) + ")";
+                return result;
+            }
+            threaded[i] = Threaded{handler, inst.argument, inst.level};
+        }
+        threaded.back() = Threaded{&&op_halt, 0, 0};
+
+        // 剖析时每条指令先经op_profile计数，再转到原来的例程
+        std::vector<const void *> handlers;
+        uint64_t *counts = nullptr;
+        if (profile_)
+        {
+            if (profile_->size() < code.size())
+            {
+                profile_->resize(code.size());
+            }
+            counts = profile_->data();
+            handlers.resize(code.size());
+            for (size_t i = 0; i < code.size(); ++i)
+            {
+                handlers[i] = threaded[i].handler;
+                threaded[i].handler = &&op_profile;
+            }
+        }
+        else if (fusion_)
+        {
+            // 序列的首条指令改用超级指令例程，其余各条保留原样供例程读取操作数；
+            // 序列不跨越基本块，因此不会有跳转或返回落在序列中间
+            auto leaders = blockLeaders(code);
+            const void *const loop = &&op_loop;
+            auto matches = [&](const superinstructions::Pattern &pattern, size_t start)
+            {
+                if (start + pattern.length > code.size())
+                {
+                    return false;
+                }
+                for (size_t k = 0; k < pattern.length; ++k)
+                {
+                    const auto &inst = code[start + k];
+                    const auto &step = pattern.steps[k];
+                    if ((k > 0 && leaders[start + k]) || inst.op != step.op ||
+                        (inst.op == OpCode::OPR && inst.argument != static_cast<int64_t>(step.opr)) ||
+                        threaded[start + k].handler == loop)
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            };
+            for (size_t i = 0; i < code.size();)
+            {
+                size_t length = 1;
+                for (size_t p = 0; p < superinstructions::PATTERNS.size(); ++p)
+                {
+                    if (matches(superinstructions::PATTERNS[p], i))
+                    {
+                        threaded[i].handler = SUPERINSTRUCTION_LABELS[p];
+                        length = superinstructions::PATTERNS[p].length;
+                        break;
+                    }
+                }
+                i += length;
+            }
+        }
+
+        // INT时保证新帧之外还留有表达式求值和下一次CAL写帧头的空间，入栈时不再检查
+        const int64_t headroom = maxOperandDepth(code) + FRAME_HEADER;
+        if (static_cast<int64_t>(stack_size_) < FRAME_HEADER + headroom ||
+            stack_size_ < FRAME_HEADER + global_count_)
+        {
+            result.success = false;
+            result.error = "运行时错误: 栈空间不足";
+            return result;
+        }
+
+        std::vector<int64_t> stack(stack_size_);
+        int64_t *const base = stack.data();
+        int64_t *const limit = base + stack_size_;
+        const Threaded *const tcode = threaded.data();
+
+        // 主程序帧：SL和DL指向自身，返回地址为停机例程
+        int64_t *bp = base;
+        int64_t *sp = base;
+        bp[0] = 0;
+        bp[1] = 0;
+        bp[2] = static_cast<int64_t>(code.size());
+
+        const Threaded *ip = tcode;
+        const Threaded *cur = nullptr;
+        uint64_t executed = 0;
+
+        NativeTier *tier = tier_;
+        const uint32_t threshold = tier ? tier->threshold() : 0;
+        std::vector<uint32_t> counters(tier ? code.size() : 0);
+        // 计数(达到阈值后不再增加)，返回是否已经变热
+        auto heat = [&counters, tier, threshold](int64_t address)
+        {
+            auto &count = counters[static_cast<size_t>(address)];
+            if (count < threshold && ++count == threshold)
+            {
+                tier->hot(static_cast<size_t>(address));
+            }
+            return count >= threshold;
+        };
+
+        // 沿静态链向外走level层
+        auto frameAt = [base](int64_t *frame, uint32_t level) noexcept
+        {
+            for (; level > 0; --level)
+            {
+                frame = base + frame[0];
+            }
+            return frame;
+        };
+
+#define DISPATCH()              \
+    do                          \
+    {                           \
+        cur = ip++;             \
+        ++executed;             \
+        goto *cur->handler;     \
+    } while (false)
+
+#define BINARY(expr)            \
+    do                          \
+    {                           \
+        int64_t rhs = *--sp;    \
+        int64_t lhs = sp[-1];   \
+        sp[-1] = (expr);        \
+        DISPATCH();             \
+    } while (false)
+
+        auto start = Clock::now();
+        DISPATCH();
+
+    op_profile:
+        ++counts[cur - tcode];
+        goto *handlers[static_cast<size_t>(cur - tcode)];
+
+    op_lit:
+        *sp++ = cur->argument;
+        DISPATCH();
+
+    op_lod:
+        *sp++ = frameAt(bp, cur->level)[cur->argument];
+        DISPATCH();
+
+    op_sto:
+        frameAt(bp, cur->level)[cur->argument] = *--sp;
+        DISPATCH();
+
+    op_cal:
+        sp[0] = frameAt(bp, cur->level) - base;
+        sp[1] = bp - base;
+        sp[2] = ip - tcode;
+        bp = sp;
+        ip = tcode + cur->argument;
+        DISPATCH();
+
+    op_cal_counted:
+        sp[0] = frameAt(bp, cur->level) - base;
+        sp[1] = bp - base;
+        sp[2] = ip - tcode;
+        if (tier && heat(cur->argument))
+        {
+            switch (tier->enter(static_cast<size_t>(cur->argument), base, sp, result.error))
+            {
+            case NativeTier::Entry::Returned:
+                DISPATCH();
+            case NativeTier::Entry::Failed:
+                goto fail_native;
+            case NativeTier::Entry::Disabled:
+                tier = nullptr;
+                break;
+            case NativeTier::Entry::Unavailable:
+                break;
+            }
+        }
+        bp = sp;
+        ip = tcode + cur->argument;
+        DISPATCH();
+
+    op_tail:
+        // 保留DL和返回地址，被调用者返回时直接回到当前过程的调用者；
+        // 复用的帧中当前过程的变量由被调用者入口的INT清零(转入本地代码时由序言清零)，与C后端的尾调用相同
+        bp[0] = frameAt(bp, cur->level) - base;
+        sp = bp;
+        ip = tcode + cur->argument;
+        DISPATCH();
+
+    op_tail_counted:
+        bp[0] = frameAt(bp, cur->level) - base;
+        sp = bp;
+        ip = tcode + cur->argument;
+        goto enter_native;
+
+    op_loop:
+        ip = tcode + cur->argument;
+    enter_native:
+        if (tier && heat(cur->argument))
+        {
+            switch (tier->enter(static_cast<size_t>(cur->argument), base, bp, result.error))
+            {
+            case NativeTier::Entry::Returned:
+                // 本地代码执行完了整个过程，等同于RET
+                sp = bp;
+                ip = tcode + bp[2];
+                bp = base + bp[1];
+                break;
+            case NativeTier::Entry::Failed:
+                goto fail_native;
+            case NativeTier::Entry::Disabled:
+                tier = nullptr;
+                break;
+            case NativeTier::Entry::Unavailable:
+                break;
+            }
+        }
+        DISPATCH();
+
+    op_int:
+        if (limit - sp < cur->argument + headroom)
+        {
+            result.error = "运行时错误: 栈溢出";
+            goto fail;
+        }
+        // 变量的初值为0，不能留有之前的帧在同一位置写下的值
+        std::fill(sp + FRAME_HEADER, sp + cur->argument, 0);
+        sp += cur->argument;
+        DISPATCH();
+
+    op_jmp:
+        ip = tcode + cur->argument;
+        DISPATCH();
+
+    op_jpc:
+        if (*--sp == 0)
+        {
+            ip = tcode + cur->argument;
+        }
+        DISPATCH();
+
+    opr_ret:
+        sp = bp;
+        ip = tcode + bp[2];
+        bp = base + bp[1];
+        DISPATCH();
+
+    opr_neg:
+        sp[-1] = arith::sub(0, sp[-1]);
+        DISPATCH();
+
+    opr_not:
+        sp[-1] = sp[-1] == 0;
+        DISPATCH();
+
+    opr_odd:
+        sp[-1] = sp[-1] % 2 != 0;
+        DISPATCH();
+
+    opr_add:
+        BINARY(arith::add(lhs, rhs));
+
+    opr_sub:
+        BINARY(arith::sub(lhs, rhs));
+
+    opr_mul:
+        BINARY(arith::mul(lhs, rhs));
+
+    opr_div:
+        if (sp[-1] == 0)
+        {
+            result.error = "运行时错误: 除数为零";
+            goto fail;
+        }
+        BINARY(arith::div(lhs, rhs));
+
+    opr_pow:
+        if (sp[-1] < 0)
+        {
+            result.error = "运行时错误: 负指数";
+            goto fail;
+        }
+        BINARY(arith::pow(lhs, rhs));
+
+    opr_shl:
+        if (sp[-1] < 0)
+        {
+            result.error = "运行时错误: 负指数";
+            goto fail;
+        }
+        BINARY(arith::shl(lhs, rhs));
+
+    opr_eq:
+        BINARY(lhs == rhs);
+
+    opr_neq:
+        BINARY(lhs != rhs);
+
+    opr_lt:
+        BINARY(lhs < rhs);
+
+    opr_lte:
+        BINARY(lhs <= rhs);
+
+    opr_gt:
+        BINARY(lhs > rhs);
+
+    opr_gte:
+        BINARY(lhs >= rhs);
+
+#include "SuperinstructionHandlers.inc"
+
+#undef BINARY
+#undef DISPATCH
+
+    fail:
+        result.address = static_cast<size_t>(cur - tcode);
+        result.error += " (地址 " + std::to_string(cur - tcode) + ")";
+    fail_native: // 本地代码中的错误没有对应的p-code地址
+        result.success = false;
+
+    op_halt:
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        // 停机例程本身不计入
+        result.instructions = result.success ? executed - 1 : executed;
+        if (result.success)
+        {
+            result.globals.assign(base + FRAME_HEADER, base + FRAME_HEADER + global_count_);
+        }
+        return result;
+    }
+
+} // namespace pl0
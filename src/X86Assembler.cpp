@@ -0,0 +1,391 @@
+#include "../include/X86Assembler.h"
+
+namespace pl0::x86
+{
+
+    namespace
+    {
+        constexpr uint8_t low(Reg reg) noexcept { return static_cast<uint8_t>(reg) & 7; }
+        constexpr bool fitsInt8(int64_t value) noexcept { return value >= -128 && value <= 127; }
+        constexpr bool fitsInt32(int64_t value) noexcept { return value >= INT32_MIN && value <= INT32_MAX; }
+    }
+
+    Label Assembler::newLabel()
+    {
+        labels_.push_back(-1);
+        return Label{static_cast<uint32_t>(labels_.size() - 1)};
+    }
+
+    void Assembler::bind(Label label)
+    {
+        labels_[label.id] = static_cast<int64_t>(code_.size());
+    }
+
+    bool Assembler::finalize()
+    {
+        for (const auto &fixup : fixups_)
+        {
+            int64_t target = labels_[fixup.label];
+            if (target < 0)
+            {
+                return false;
+            }
+            // rel32相对于紧随其后的下一条指令
+            auto rel = static_cast<uint32_t>(static_cast<int32_t>(target - static_cast<int64_t>(fixup.at + 4)));
+            for (int i = 0; i < 4; ++i)
+            {
+                code_[fixup.at + i] = static_cast<uint8_t>(rel >> (8 * i));
+            }
+        }
+        fixups_.clear();
+        return true;
+    }
+
+    void Assembler::emit32(uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            emit8(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    void Assembler::emit64(uint64_t value)
+    {
+        emit32(static_cast<uint32_t>(value));
+        emit32(static_cast<uint32_t>(value >> 32));
+    }
+
+    void Assembler::rex(bool w, uint8_t reg, uint8_t index, uint8_t base, bool force)
+    {
+        uint8_t prefix = 0x40 | (w ? 8 : 0) | ((reg >> 3) << 2) | ((index >> 3) << 1) | (base >> 3);
+        if (prefix != 0x40 || force)
+        {
+            emit8(prefix);
+        }
+    }
+
+    void Assembler::modrmReg(uint8_t reg, Reg rm)
+    {
+        emit8(static_cast<uint8_t>(0xC0 | ((reg & 7) << 3) | low(rm)));
+    }
+
+    void Assembler::rexMem(uint8_t reg, const Mem &mem)
+    {
+        rex(true, reg, mem.index ? static_cast<uint8_t>(*mem.index) : 0, static_cast<uint8_t>(mem.base));
+    }
+
+    void Assembler::modrmMem(uint8_t reg, const Mem &mem)
+    {
+        // 总是带位移(mod=01/10)，避开rbp/r13在mod=00下的RIP相对寻址
+        uint8_t mod = fitsInt8(mem.disp) ? 0x40 : 0x80;
+        if (mem.index)
+        {
+            emit8(static_cast<uint8_t>(mod | ((reg & 7) << 3) | 4));
+            emit8(static_cast<uint8_t>(0xC0 | (low(*mem.index) << 3) | low(mem.base)));
+        }
+        else if (low(mem.base) == 4)
+        {
+            // rsp/r12作基址时必须带SIB
+            emit8(static_cast<uint8_t>(mod | ((reg & 7) << 3) | 4));
+            emit8(0x24);
+        }
+        else
+        {
+            emit8(static_cast<uint8_t>(mod | ((reg & 7) << 3) | low(mem.base)));
+        }
+
+        if (mod == 0x40)
+        {
+            emit8(static_cast<uint8_t>(mem.disp));
+        }
+        else
+        {
+            emit32(static_cast<uint32_t>(mem.disp));
+        }
+    }
+
+    void Assembler::aluRR(uint8_t opcode, Reg dst, Reg src)
+    {
+        rex(true, static_cast<uint8_t>(src), 0, static_cast<uint8_t>(dst));
+        emit8(opcode);
+        modrmReg(static_cast<uint8_t>(src), dst);
+    }
+
+    void Assembler::aluRM(uint8_t opcode, Reg dst, const Mem &src)
+    {
+        rexMem(static_cast<uint8_t>(dst), src);
+        emit8(opcode);
+        modrmMem(static_cast<uint8_t>(dst), src);
+    }
+
+    void Assembler::aluRI(uint8_t extension, Reg dst, int32_t imm)
+    {
+        rex(true, 0, 0, static_cast<uint8_t>(dst));
+        if (fitsInt8(imm))
+        {
+            emit8(0x83);
+            modrmReg(extension, dst);
+            emit8(static_cast<uint8_t>(imm));
+        }
+        else
+        {
+            emit8(0x81);
+            modrmReg(extension, dst);
+            emit32(static_cast<uint32_t>(imm));
+        }
+    }
+
+    void Assembler::mov(Reg dst, Reg src)
+    {
+        if (dst != src)
+        {
+            aluRR(0x89, dst, src);
+        }
+    }
+
+    void Assembler::mov(Reg dst, int64_t imm)
+    {
+        if (imm == 0)
+        {
+            // xor r32, r32会清零整个64位寄存器
+            rex(false, static_cast<uint8_t>(dst), 0, static_cast<uint8_t>(dst));
+            emit8(0x31);
+            modrmReg(static_cast<uint8_t>(dst), dst);
+        }
+        else if (imm > 0 && imm <= UINT32_MAX)
+        {
+            // mov r32, imm32零扩展
+            rex(false, 0, 0, static_cast<uint8_t>(dst));
+            emit8(static_cast<uint8_t>(0xB8 | low(dst)));
+            emit32(static_cast<uint32_t>(imm));
+        }
+        else if (fitsInt32(imm))
+        {
+            rex(true, 0, 0, static_cast<uint8_t>(dst));
+            emit8(0xC7);
+            modrmReg(0, dst);
+            emit32(static_cast<uint32_t>(imm));
+        }
+        else
+        {
+            rex(true, 0, 0, static_cast<uint8_t>(dst));
+            emit8(static_cast<uint8_t>(0xB8 | low(dst)));
+            emit64(static_cast<uint64_t>(imm));
+        }
+    }
+
+    void Assembler::mov(Reg dst, Mem src)
+    {
+        aluRM(0x8B, dst, src);
+    }
+
+    void Assembler::mov(Mem dst, Reg src)
+    {
+        aluRM(0x89, src, dst);
+    }
+
+    void Assembler::mov(Mem dst, int32_t imm)
+    {
+        rexMem(0, dst);
+        emit8(0xC7);
+        modrmMem(0, dst);
+        emit32(static_cast<uint32_t>(imm));
+    }
+
+    void Assembler::movByte(Mem dst, Reg src)
+    {
+        // spl/bpl/sil/dil需要REX前缀，否则会编码为ah/ch/dh/bh
+        rex(false, static_cast<uint8_t>(src), dst.index ? static_cast<uint8_t>(*dst.index) : 0,
+            static_cast<uint8_t>(dst.base), static_cast<uint8_t>(src) >= 4);
+        emit8(0x88);
+        modrmMem(static_cast<uint8_t>(src), dst);
+    }
+
+    void Assembler::lea(Reg dst, Mem src)
+    {
+        aluRM(0x8D, dst, src);
+    }
+
+    void Assembler::test(Reg left, int32_t imm)
+    {
+        rex(true, 0, 0, static_cast<uint8_t>(left));
+        emit8(0xF7);
+        modrmReg(0, left);
+        emit32(static_cast<uint32_t>(imm));
+    }
+
+    void Assembler::imul(Reg dst, Reg src)
+    {
+        rex(true, static_cast<uint8_t>(dst), 0, static_cast<uint8_t>(src));
+        emit8(0x0F);
+        emit8(0xAF);
+        modrmReg(static_cast<uint8_t>(dst), src);
+    }
+
+    void Assembler::imul(Reg dst, Mem src)
+    {
+        rexMem(static_cast<uint8_t>(dst), src);
+        emit8(0x0F);
+        emit8(0xAF);
+        modrmMem(static_cast<uint8_t>(dst), src);
+    }
+
+    void Assembler::imul(Reg dst, Reg src, int32_t imm)
+    {
+        rex(true, static_cast<uint8_t>(dst), 0, static_cast<uint8_t>(src));
+        if (fitsInt8(imm))
+        {
+            emit8(0x6B);
+            modrmReg(static_cast<uint8_t>(dst), src);
+            emit8(static_cast<uint8_t>(imm));
+        }
+        else
+        {
+            emit8(0x69);
+            modrmReg(static_cast<uint8_t>(dst), src);
+            emit32(static_cast<uint32_t>(imm));
+        }
+    }
+
+    void Assembler::imulWide(Reg src)
+    {
+        rex(true, 0, 0, static_cast<uint8_t>(src));
+        emit8(0xF7);
+        modrmReg(5, src);
+    }
+
+    void Assembler::neg(Reg reg)
+    {
+        rex(true, 0, 0, static_cast<uint8_t>(reg));
+        emit8(0xF7);
+        modrmReg(3, reg);
+    }
+
+    void Assembler::dec(Reg reg)
+    {
+        rex(true, 0, 0, static_cast<uint8_t>(reg));
+        emit8(0xFF);
+        modrmReg(1, reg);
+    }
+
+    void Assembler::shl(Reg reg, uint8_t amount)
+    {
+        rex(true, 0, 0, static_cast<uint8_t>(reg));
+        emit8(0xC1);
+        modrmReg(4, reg);
+        emit8(amount);
+    }
+
+    void Assembler::shlCl(Reg reg)
+    {
+        rex(true, 0, 0, static_cast<uint8_t>(reg));
+        emit8(0xD3);
+        modrmReg(4, reg);
+    }
+
+    void Assembler::shr(Reg reg, uint8_t amount)
+    {
+        rex(true, 0, 0, static_cast<uint8_t>(reg));
+        emit8(0xC1);
+        modrmReg(5, reg);
+        emit8(amount);
+    }
+
+    void Assembler::sar(Reg reg, uint8_t amount)
+    {
+        rex(true, 0, 0, static_cast<uint8_t>(reg));
+        emit8(0xC1);
+        modrmReg(7, reg);
+        emit8(amount);
+    }
+
+    void Assembler::cqo()
+    {
+        emit8(0x48);
+        emit8(0x99);
+    }
+
+    void Assembler::idiv(Reg divisor)
+    {
+        rex(true, 0, 0, static_cast<uint8_t>(divisor));
+        emit8(0xF7);
+        modrmReg(7, divisor);
+    }
+
+    void Assembler::div(Reg divisor)
+    {
+        rex(true, 0, 0, static_cast<uint8_t>(divisor));
+        emit8(0xF7);
+        modrmReg(6, divisor);
+    }
+
+    void Assembler::setcc(Cond cond, Reg dst)
+    {
+        // setcc写低8位，再movzx扩展；强制REX以访问sil/dil
+        rex(false, 0, 0, static_cast<uint8_t>(dst), true);
+        emit8(0x0F);
+        emit8(static_cast<uint8_t>(0x90 | static_cast<uint8_t>(cond)));
+        modrmReg(0, dst);
+
+        rex(true, static_cast<uint8_t>(dst), 0, static_cast<uint8_t>(dst));
+        emit8(0x0F);
+        emit8(0xB6);
+        modrmReg(static_cast<uint8_t>(dst), dst);
+    }
+
+    void Assembler::push(Reg reg)
+    {
+        rex(false, 0, 0, static_cast<uint8_t>(reg));
+        emit8(static_cast<uint8_t>(0x50 | low(reg)));
+    }
+
+    void Assembler::pop(Reg reg)
+    {
+        rex(false, 0, 0, static_cast<uint8_t>(reg));
+        emit8(static_cast<uint8_t>(0x58 | low(reg)));
+    }
+
+    void Assembler::branch(Label target)
+    {
+        fixups_.push_back(Fixup{code_.size(), target.id});
+        emit32(0);
+    }
+
+    void Assembler::jmp(Label target)
+    {
+        emit8(0xE9);
+        branch(target);
+    }
+
+    void Assembler::jcc(Cond cond, Label target)
+    {
+        emit8(0x0F);
+        emit8(static_cast<uint8_t>(0x80 | static_cast<uint8_t>(cond)));
+        branch(target);
+    }
+
+    void Assembler::call(Label target)
+    {
+        emit8(0xE8);
+        branch(target);
+    }
+
+    void Assembler::call(Reg target)
+    {
+        rex(false, 0, 0, static_cast<uint8_t>(target));
+        emit8(0xFF);
+        modrmReg(2, target);
+    }
+
+    void Assembler::ret()
+    {
+        emit8(0xC3);
+    }
+
+    void Assembler::syscall()
+    {
+        emit8(0x0F);
+        emit8(0x05);
+    }
+
+} // namespace pl0::x86
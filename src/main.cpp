@@ -1,14 +1,654 @@
 #include "../include/Compiler.h"
+#include "../include/BatchCompiler.h"
+#include "../include/VM.h"
+#include "../include/RegisterVM.h"
+#include "../include/RegisterGenerator.h"
+#include "../include/Jit.h"
+#include "../include/JitCompiler.h"
+#include "../include/CEmitter.h"
+#include "../include/IRBuilder.h"
+#include "../include/IRVerifier.h"
+#include "../include/ElfWriter.h"
+#include "../include/TieredEngine.h"
+#include "../include/OpcodeProfile.h"
 
+#include <chrono>
+#include <span>
+#include <charconv>
+#include <string>
+#include <vector>
+#include <thread>
+#include <cstdlib>
+#include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <optional>
+#include <string_view>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+    void printUsage(const char *program)
+    {
+        std::cerr << "用法: " << program << " <输入文件> <输出目录>\n"
+                  << "      " << program
+                  << " --run [--reg|--jit|--tiered|--cc] [--inline] [--fold] [--dce] [--licm] [--max-stack <槽位数>] <输入文件>\n"
+                  << "      " << program << " --emit-c <输入文件> [-o <输出文件>]\n"
+                  << "      " << program << " --emit-ir <输入文件> [-o <输出文件>]\n"
+                  << "      " << program << " --emit-pl0c <输入文件> [-o <输出文件>]\n"
+                  << "      " << program
+                  << " --emit-exe <输入文件> [-o <输出文件>] [--silent] [--max-stack <槽位数>]\n"
+                  << "      " << program << " --batch <目录|列表文件> <输出目录> [-j 线程数]\n"
+                  << "      " << program << " --profile <输出文件> <输入文件>...\n";
+    }
+
+    // --batch -j的上限为硬件线程数的这个倍数
+    constexpr size_t MAX_THREADS_PER_CORE = 4;
+
+    // 完整的十进制正整数，负数、0和其他字符都返回std::nullopt
+    std::optional<size_t> parsePositive(std::string_view text)
+    {
+        size_t value = 0;
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (ec != std::errc() || end != text.data() + text.size() || value == 0)
+        {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    // --max-stack的参数: 数据栈的槽位数，各执行方式的递归深度都受它限制
+    // 每层调用计帧头和变量的槽位；寄存器虚拟机的临时寄存器不计入，
+    // 栈式虚拟机另外固定留出表达式求值所需的最大深度
+    std::optional<size_t> parseStackSize(std::string_view text)
+    {
+        return parsePositive(text);
+    }
+
+    int runBatch(int argc, char *argv[])
+    {
+        size_t threads = 0;
+        if (argc == 6 && std::string_view(argv[4]) == "-j")
+        {
+            auto requested = parsePositive(argv[5]);
+            if (!requested)
+            {
+                std::cerr << "线程数必须是正整数: " << argv[5] << '\n';
+                return 1;
+            }
+            // 编译以CPU为主，远多于硬件线程只增加调度开销，过大的值还会耗尽系统的线程
+            size_t limit = std::max<size_t>(1, std::thread::hardware_concurrency()) * MAX_THREADS_PER_CORE;
+            threads = std::min(*requested, limit);
+            if (threads < *requested)
+            {
+                std::cerr << "线程数 " << *requested << " 超过上限, 改为 " << limit << '\n';
+            }
+        }
+        else if (argc != 4)
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        auto summary = pl0::BatchCompiler::run(argv[2], argv[3], threads);
+        pl0::BatchCompiler::outputSummary(summary, std::filesystem::path(argv[3]) / "summary.txt");
+
+        std::cout << "批量编译: " << summary.files.size() << " 个文件, "
+                  << summary.failures() << " 个失败, "
+                  << summary.threads << " 个线程, 耗时 " << summary.wallSeconds * 1000.0 << " ms\n";
+        for (const auto &file : summary.files)
+        {
+            if (file.renamed)
+            {
+                std::cerr << "输出目录重名: " << file.input.string() << " 的结果写到 " << file.outputDir.string() << '\n';
+            }
+            if (!file.success)
+            {
+                std::cerr << "编译失败: " << file.input.string() << '\n';
+            }
+        }
+        return summary.failures() == 0 ? 0 : 1;
+    }
+
+    bool reportErrors(const pl0::Compiler::Result &result)
+    {
+        if (result.success)
+        {
+            return false;
+        }
+        std::cerr << "编译失败！\n";
+        for (const auto &error : result.errors)
+        {
+            std::cerr << error << '\n';
+        }
+        return true;
+    }
+
+    // 生成C代码，默认写到与输入同名的.c文件
+    int emitC(int argc, char *argv[])
+    {
+        if (argc != 3 && !(argc == 5 && std::string_view(argv[3]) == "-o"))
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        auto result = pl0::Compiler::compileFile(argv[2]);
+        if (reportErrors(result))
+        {
+            return 1;
+        }
+
+        std::filesystem::path output = argc == 5 ? std::filesystem::path(argv[4])
+                                                 : std::filesystem::path(argv[2]).replace_extension(".c");
+        pl0::CEmitter emitter;
+        std::ofstream file(output);
+        file << emitter.emit(*result.ast);
+        if (!file)
+        {
+            std::cerr << "无法写入: " << output.string() << '\n';
+            return 1;
+        }
+        std::cout << "已生成: " << output.string() << '\n';
+        return 0;
+    }
+
+    // 降低为SSA形式的IR并校验，文本写到与输入同名的.ir文件
+    int emitIr(int argc, char *argv[])
+    {
+        if (argc != 3 && !(argc == 5 && std::string_view(argv[3]) == "-o"))
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        auto result = pl0::Compiler::compileFile(argv[2]);
+        if (reportErrors(result))
+        {
+            return 1;
+        }
+
+        pl0::IrModule module = pl0::IRBuilder{}.build(*result.ast);
+        pl0::IRVerifier verifier;
+        if (!verifier.verify(module))
+        {
+            for (const auto &error : verifier.getErrors())
+            {
+                std::cerr << error << '\n';
+            }
+            return 1;
+        }
+
+        std::filesystem::path output = argc == 5 ? std::filesystem::path(argv[4])
+                                                 : std::filesystem::path(argv[2]).replace_extension(".ir");
+        std::ofstream file(output);
+        pl0::print(module, file);
+        if (!file)
+        {
+            std::cerr << "无法写入: " << output.string() << '\n';
+            return 1;
+        }
+        std::cout << "已生成: " << output.string() << '\n';
+        return 0;
+    }
+
+    // 生成预编译文件，默认写到与输入同名的.pl0c文件
+    int emitImage(int argc, char *argv[])
+    {
+        if (argc != 3 && !(argc == 5 && std::string_view(argv[3]) == "-o"))
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        auto result = pl0::Compiler::compileFile(argv[2]);
+        if (reportErrors(result))
+        {
+            return 1;
+        }
+
+        std::filesystem::path output = argc == 5 ? std::filesystem::path(argv[4])
+                                                 : std::filesystem::path(argv[2]).replace_extension(".pl0c");
+        pl0::Compiler::writeImage(result, argv[2], output);
+        std::cout << "已生成: " << output.string() << '\n';
+        return 0;
+    }
+
+    // 输入本身是.pl0c时直接载入，失败时置failed；否则只使用与源文件一致的同名.pl0c
+    std::optional<pl0::PCodeImage> findImage(const std::filesystem::path &input, bool &failed)
+    {
+        std::string error;
+        if (input.extension() == ".pl0c")
+        {
+            auto image = pl0::PCodeImage::open(input, error);
+            if (!image)
+            {
+                std::cerr << "无法载入预编译文件: " << error << '\n';
+                failed = true;
+            }
+            return image;
+        }
+
+        auto path = std::filesystem::path(input).replace_extension(".pl0c");
+        if (!std::filesystem::exists(path))
+        {
+            return std::nullopt;
+        }
+        auto image = pl0::PCodeImage::open(path, error);
+        if (!image || !image->matches(input))
+        {
+            return std::nullopt;
+        }
+        std::cerr << "使用预编译文件: " << path.string() << '\n';
+        return image;
+    }
+
+    // 生成静态ELF可执行文件，默认输出为去掉扩展名的输入文件；--silent不输出变量的值
+    int emitExecutable(int argc, char *argv[])
+    {
+        const char *input = nullptr;
+        const char *output = nullptr;
+        bool silent = false;
+        std::optional<size_t> stack_size = pl0::VM::DEFAULT_STACK_SIZE;
+        for (int i = 2; i < argc && stack_size; ++i)
+        {
+            std::string_view arg = argv[i];
+            if (arg == "-o" && i + 1 < argc && !output)
+            {
+                output = argv[++i];
+            }
+            else if (arg == "--silent")
+            {
+                silent = true;
+            }
+            else if (arg == "--max-stack" && i + 1 < argc)
+            {
+                stack_size = parseStackSize(argv[++i]);
+            }
+            else if (!input && !arg.starts_with("-"))
+            {
+                input = argv[i];
+            }
+            else
+            {
+                input = nullptr;
+                break;
+            }
+        }
+        if (!input || !stack_size)
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        auto result = pl0::Compiler::compileFile(input);
+        if (reportErrors(result))
+        {
+            return 1;
+        }
+
+        std::filesystem::path path = output ? std::filesystem::path(output)
+                                            : std::filesystem::path(input).replace_extension();
+        pl0::JitCompiler compiler;
+        auto code = compiler.compile(*result.ast);
+        pl0::ElfWriter::write(code, path, pl0::ElfWriter::Options{
+                                              .stack_size = *stack_size,
+                                              .print_globals = !silent});
+        std::cout << "已生成: " << path.string() << '\n';
+        return 0;
+    }
+
+    std::string shellQuote(const std::string &text)
+    {
+        std::string quoted = "'";
+        for (char c : text)
+        {
+            quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+        }
+        return quoted + "'";
+    }
+
+    // 经C编译器(环境变量CC，默认cc)以-O2 -pthread编译后执行，程序自己输出变量的值
+    int runThroughC(const pl0::Compiler::Result &result, size_t stack_size)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        // mkdtemp以0700权限新建名字不可预测的目录，避免在共享的临时目录中被他人抢先创建或替换
+        std::string pattern = (std::filesystem::temp_directory_path() / "pl0-XXXXXX").string();
+        if (!mkdtemp(pattern.data()))
+        {
+            std::cerr << "无法创建临时目录: " << pattern << '\n';
+            return 1;
+        }
+        std::filesystem::path dir = pattern;
+        auto source = dir / "program.c";
+        auto executable = dir / "program";
+        {
+            pl0::CEmitter emitter;
+            std::ofstream file(source);
+            file << emitter.emit(*result.ast);
+        }
+
+        const char *cc = std::getenv("CC");
+        std::string command = std::string(cc && *cc ? cc : "cc") + " -O2 -pthread -DPL0_STACK_SIZE=" +
+                              std::to_string(stack_size) + " -o " + shellQuote(executable.string()) + " " +
+                              shellQuote(source.string());
+        auto start = Clock::now();
+        int status = std::system(command.c_str());
+        auto compiled = Clock::now();
+        if (status != 0)
+        {
+            std::cerr << "C编译失败: " << command << '\n';
+            std::filesystem::remove_all(dir);
+            return 1;
+        }
+
+        status = std::system(shellQuote(executable.string()).c_str());
+        auto finished = Clock::now();
+        std::filesystem::remove_all(dir);
+
+        std::cerr << "C编译耗时 " << std::chrono::duration<double, std::milli>(compiled - start).count()
+                  << " ms, 执行耗时 " << std::chrono::duration<double, std::milli>(finished - compiled).count()
+                  << " ms\n";
+        return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+    }
+
+    // 在p-code虚拟机上逐条执行一组程序，统计操作码序列的频度，供构建时生成超级指令
+    int profileOpcodes(int argc, char *argv[])
+    {
+        if (argc < 4)
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        pl0::OpcodeProfile profile;
+        int failures = 0;
+        for (int i = 3; i < argc; ++i)
+        {
+            auto result = pl0::Compiler::compileFile(argv[i]);
+            if (reportErrors(result))
+            {
+                std::cerr << "跳过: " << argv[i] << '\n';
+                ++failures;
+                continue;
+            }
+
+            std::vector<uint64_t> counts;
+            pl0::VM vm(result.code);
+            vm.setProfile(&counts);
+            auto execution = vm.run();
+            if (!execution.success)
+            {
+                // 出错前的执行次数仍然有效，corpus中也有专门检查运行时错误的程序，不算失败
+                std::cerr << argv[i] << ": " << execution.error << '\n';
+            }
+            profile.record(result.code.code, counts);
+        }
+
+        std::ofstream file(argv[2]);
+        profile.write(file);
+        if (!file)
+        {
+            std::cerr << "无法写入: " << argv[2] << '\n';
+            return 1;
+        }
+        std::cout << "操作码剖析: " << profile.programs() << " 个程序, " << profile.instructions() << " 次分派, "
+                  << profile.sequences().size() << " 种序列, 已写入 " << argv[2] << '\n';
+        return failures == 0 ? 0 : 1;
+    }
+
+    // 编译并执行，输出主程序变量的最终值
+    // 默认在p-code虚拟机上执行，并优先使用预编译文件；--reg使用寄存器字节码解释器，
+    // --jit编译为本地代码执行，--tiered先解释执行、热点在后台编译后转入本地代码，
+    // --cc生成C代码交给系统C编译器；--inline先内联小过程并输出每个调用点的决定；
+    // --fold折叠常量表达式并输出折叠和溢出的诊断；--dce删除死代码和不可达的过程并输出每个过程删除的内容；
+    // --licm把循环不变的计算移到循环之前并输出每个循环外提的表达式数；
+    // --max-stack设置数据栈的槽位数，递归超出时以栈溢出报错
+    int runProgram(int argc, char *argv[])
+    {
+        enum class Engine
+        {
+            Stack,
+            Register,
+            Native,
+            Tiered,
+            C
+        } engine = Engine::Stack;
+        pl0::Compiler::Options options;
+        const char *input = nullptr;
+        std::optional<size_t> stack_size = pl0::VM::DEFAULT_STACK_SIZE;
+        for (int i = 2; i < argc && stack_size; ++i)
+        {
+            std::string_view arg = argv[i];
+            if (arg == "--inline")
+            {
+                options.inlining = true;
+            }
+            else if (arg == "--fold")
+            {
+                options.folding = true;
+            }
+            else if (arg == "--dce")
+            {
+                options.deadCode = true;
+            }
+            else if (arg == "--licm")
+            {
+                options.hoisting = true;
+            }
+            else if (arg == "--max-stack" && i + 1 < argc)
+            {
+                stack_size = parseStackSize(argv[++i]);
+            }
+            else if (arg == "--reg")
+            {
+                engine = Engine::Register;
+            }
+            else if (arg == "--jit")
+            {
+                engine = Engine::Native;
+            }
+            else if (arg == "--tiered")
+            {
+                engine = Engine::Tiered;
+            }
+            else if (arg == "--cc")
+            {
+                engine = Engine::C;
+            }
+            else if (!input && !arg.starts_with("--"))
+            {
+                input = argv[i];
+            }
+            else
+            {
+                input = nullptr;
+                break;
+            }
+        }
+        if (!input || !stack_size)
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        // 预编译文件是未经优化的p-code，只在默认方式下使用
+        std::optional<pl0::PCodeImage> image;
+        if (engine == Engine::Stack && !options.inlining && !options.folding && !options.deadCode &&
+            !options.hoisting)
+        {
+            bool failed = false;
+            image = findImage(input, failed);
+            if (failed)
+            {
+                return 1;
+            }
+        }
+        else if (std::filesystem::path(input).extension() == ".pl0c")
+        {
+            std::cerr << "预编译文件只能在p-code虚拟机上直接执行\n";
+            return 1;
+        }
+
+        pl0::Compiler::Result result;
+        if (!image)
+        {
+            result = pl0::Compiler::compileFile(input, options);
+            if (reportErrors(result))
+            {
+                return 1;
+            }
+        }
+        if (options.inlining)
+        {
+            size_t inlined = 0;
+            for (const auto &decision : result.inlining)
+            {
+                std::cerr << "内联: " << pl0::Inliner::describe(decision) << '\n';
+                inlined += decision.inlined ? 1 : 0;
+            }
+            std::cerr << "内联了 " << inlined << "/" << result.inlining.size() << " 个调用点\n";
+        }
+        if (options.folding)
+        {
+            using Kind = pl0::ConstantFolder::Diagnostic::Kind;
+            size_t folded = 0;
+            size_t overflowed = 0;
+            for (const auto &diagnostic : result.folding)
+            {
+                std::cerr << "折叠: " << pl0::ConstantFolder::describe(diagnostic) << '\n';
+                folded += diagnostic.kind != Kind::NegativeExponent ? 1 : 0;
+                overflowed += diagnostic.kind == Kind::Overflow ? 1 : 0;
+            }
+            std::cerr << "折叠了 " << folded << " 个常量表达式, 其中 " << overflowed << " 个溢出\n";
+        }
+        if (options.deadCode)
+        {
+            size_t procedures = 0;
+            size_t statements = 0;
+            for (const auto &report : result.deadCode)
+            {
+                std::cerr << "死代码: " << pl0::DeadCodeEliminator::describe(report) << '\n';
+                procedures += report.unreachable ? 1 : 0;
+                statements += report.deadStores + report.falseBranches;
+            }
+            std::cerr << "删除了 " << procedures << " 个过程, " << statements << " 条语句\n";
+        }
+        if (options.hoisting)
+        {
+            size_t hoisted = 0;
+            for (const auto &report : result.hoisting)
+            {
+                std::cerr << "外提: " << pl0::LoopInvariantHoister::describe(report) << '\n';
+                hoisted += report.hoisted;
+            }
+            std::cerr << "从 " << result.hoisting.size() << " 个循环外提了 " << hoisted << " 个不变表达式\n";
+        }
+
+        pl0::ExecutionResult execution;
+        switch (engine)
+        {
+        case Engine::Stack:
+            execution = image ? pl0::VM(image->code(), image->globalCount(), *stack_size).run()
+                              : pl0::VM(result.code, *stack_size).run();
+            break;
+        case Engine::Register:
+        {
+            pl0::RegisterGenerator generator;
+            auto program = generator.generate(*result.ast);
+            execution = pl0::RegisterVM(program, *stack_size).run();
+            break;
+        }
+        case Engine::Native:
+        {
+            pl0::JitCompiler compiler;
+            auto code = compiler.compile(*result.ast);
+            execution = pl0::Jit(code, *stack_size).run();
+            break;
+        }
+        case Engine::Tiered:
+        {
+            pl0::TieredEngine tiered(*result.ast, result.code, *stack_size);
+            execution = tiered.run();
+            const auto &stats = tiered.stats();
+            if (stats.compiled)
+            {
+                std::cerr << "分层执行: 后台编译耗时 " << stats.compileSeconds * 1000.0 << " ms, 转入本地代码 "
+                          << stats.nativeEntries << " 次\n";
+            }
+            break;
+        }
+        case Engine::C:
+            return runThroughC(result, *stack_size);
+        }
+        if (!execution.success)
+        {
+            std::cerr << execution.error;
+            auto positions = image ? image->positions() : std::span<const pl0::SourceLine>(result.code.positions);
+            if (auto where = execution.address ? pl0::locate(positions, *execution.address) : std::nullopt)
+            {
+                std::cerr << " 行" << where->line << "列" << where->column;
+            }
+            std::cerr << '\n';
+            return 1;
+        }
+
+        auto names = image ? image->globals() : result.code.globals;
+        for (size_t i = 0; i < execution.globals.size(); ++i)
+        {
+            std::cout << names[i] << " = " << execution.globals[i] << '\n';
+        }
+        if (engine == Engine::Native)
+        {
+            std::cerr << "本地代码执行耗时 " << execution.seconds * 1000.0 << " ms\n";
+        }
+        else
+        {
+            std::cerr << "执行指令: " << execution.instructions << ", 耗时 " << execution.seconds * 1000.0
+                      << " ms, " << execution.instructionsPerSecond() / 1e6 << " M指令/秒\n";
+        }
+        return 0;
+    }
+}
 
 int main(int argc, char *argv[])
 {
     try
     {
+        if (argc >= 2 && std::string_view(argv[1]) == "--batch")
+        {
+            return runBatch(argc, argv);
+        }
+        if (argc >= 2 && std::string_view(argv[1]) == "--run")
+        {
+            return runProgram(argc, argv);
+        }
+        if (argc >= 2 && std::string_view(argv[1]) == "--emit-c")
+        {
+            return emitC(argc, argv);
+        }
+        if (argc >= 2 && std::string_view(argv[1]) == "--emit-ir")
+        {
+            return emitIr(argc, argv);
+        }
+        if (argc >= 2 && std::string_view(argv[1]) == "--emit-pl0c")
+        {
+            return emitImage(argc, argv);
+        }
+        if (argc >= 2 && std::string_view(argv[1]) == "--emit-exe")
+        {
+            return emitExecutable(argc, argv);
+        }
+        if (argc >= 2 && std::string_view(argv[1]) == "--profile")
+        {
+            return profileOpcodes(argc, argv);
+        }
+
         if (argc != 3)
         {
-            std::cerr << "用法: " << argv[0] << " <输入文件> <输出目录>\n";
+            printUsage(argv[0]);
             return 1;
         }
 
@@ -33,4 +673,4 @@ int main(int argc, char *argv[])
         std::cerr << "错误：" << e.what() << '\n';
         return 1;
     }
-}
\ No newline at end of file
+}
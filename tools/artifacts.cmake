@@ -0,0 +1,65 @@
+# 生成的文件与直接执行的结果对比: 以栈式虚拟机为准，逐个程序比较--emit-exe生成的可执行文件
+# 和--emit-pl0c生成的预编译文件输出的变量值和运行时错误
+# 用法: cmake -DPL0=<PL0可执行文件> -DCORPUS=<目录> -DWORK=<临时目录> -P artifacts.cmake
+
+if(NOT PL0 OR NOT CORPUS OR NOT WORK)
+    message(FATAL_ERROR "需要 -DPL0=<PL0可执行文件> -DCORPUS=<目录> -DWORK=<临时目录>")
+endif()
+
+file(REMOVE_RECURSE ${WORK})
+file(MAKE_DIRECTORY ${WORK})
+
+# 只保留"名字 = 值"和运行时错误，去掉耗时、统计和错误地址
+function(run_command out)
+    execute_process(COMMAND ${ARGN} OUTPUT_VARIABLE stdout ERROR_VARIABLE stderr)
+    string(REGEX MATCHALL "[A-Za-z][A-Za-z0-9]* = -?[0-9]+" values "${stdout}")
+    string(REGEX MATCHALL "运行时错误: [^\n(]*" errors "${stdout}${stderr}")
+    list(TRANSFORM errors STRIP)
+    set(${out} "${values};${errors}" PARENT_SCOPE)
+endfunction()
+
+# 生成失败时记一处不一致
+function(generate name kind)
+    execute_process(COMMAND ${PL0} ${ARGN} RESULT_VARIABLE status OUTPUT_QUIET ERROR_VARIABLE stderr)
+    if(NOT status EQUAL 0)
+        message(SEND_ERROR "${name} ${kind}: 生成失败: ${stderr}")
+        math(EXPR failures "${failures} + 1")
+        set(failures ${failures} PARENT_SCOPE)
+    endif()
+endfunction()
+
+file(GLOB programs ${CORPUS}/*.pl0)
+list(SORT programs)
+set(failures 0)
+foreach(program ${programs})
+    get_filename_component(name ${program} NAME_WE)
+    run_command(expected ${PL0} --run ${program})
+
+    generate(${name} --emit-exe --emit-exe ${program} -o ${WORK}/${name})
+    run_command(actual ${WORK}/${name})
+    if(NOT actual STREQUAL expected)
+        message(SEND_ERROR "${name} --emit-exe: ${actual}\n  栈式虚拟机: ${expected}")
+        math(EXPR failures "${failures} + 1")
+    endif()
+
+    generate(${name} --emit-pl0c --emit-pl0c ${program} -o ${WORK}/${name}.pl0c)
+    run_command(actual ${PL0} --run ${WORK}/${name}.pl0c)
+    if(NOT actual STREQUAL expected)
+        message(SEND_ERROR "${name} --emit-pl0c: ${actual}\n  栈式虚拟机: ${expected}")
+        math(EXPR failures "${failures} + 1")
+    endif()
+endforeach()
+
+# 栈槽位数超过可执行文件的上限时应拒绝生成，而不是写出运行即崩溃的文件
+list(GET programs 0 program)
+execute_process(COMMAND ${PL0} --emit-exe ${program} -o ${WORK}/oversized --max-stack 1000000000000
+                RESULT_VARIABLE status OUTPUT_QUIET ERROR_QUIET)
+if(status EQUAL 0 OR EXISTS ${WORK}/oversized)
+    message(SEND_ERROR "--emit-exe --max-stack 1000000000000: 没有拒绝过大的栈")
+    math(EXPR failures "${failures} + 1")
+endif()
+
+file(REMOVE_RECURSE ${WORK})
+
+list(LENGTH programs count)
+message(STATUS "${count} 个程序 x 2 种生成文件, ${failures} 处不一致")
@@ -0,0 +1,49 @@
+# 各执行方式与优化选项的结果对比: 以栈式虚拟机为准，逐个程序比较输出的变量值和运行时错误
+# 用法: cmake -DPL0=<PL0可执行文件> -DCORPUS=<目录> [-DCC=<C编译器>] -P crossengine.cmake
+# 未给出CC时跳过--cc
+
+if(NOT PL0 OR NOT CORPUS)
+    message(FATAL_ERROR "需要 -DPL0=<PL0可执行文件> -DCORPUS=<目录>")
+endif()
+
+# 组合用"+"连接，例如内联后的树交给各后端，检查后端对变换后的树同样正确
+set(ENGINES --reg --jit --tiered --inline --fold --dce --licm)
+set(BACKENDS --reg --jit --tiered)
+if(CC)
+    set(ENV{CC} ${CC})
+    list(APPEND ENGINES --cc)
+    list(APPEND BACKENDS --cc)
+endif()
+foreach(backend ${BACKENDS})
+    list(APPEND ENGINES "${backend}+--inline+--fold+--dce+--licm")
+endforeach()
+
+# 只保留"名字 = 值"和运行时错误，去掉耗时、统计和错误地址
+function(run_program out program)
+    execute_process(COMMAND ${PL0} --run ${ARGN} ${program}
+                    OUTPUT_VARIABLE stdout ERROR_VARIABLE stderr)
+    string(REGEX MATCHALL "[A-Za-z][A-Za-z0-9]* = -?[0-9]+" values "${stdout}")
+    string(REGEX MATCHALL "运行时错误: [^\n(]*" errors "${stdout}${stderr}")
+    list(TRANSFORM errors STRIP)
+    set(${out} "${values};${errors}" PARENT_SCOPE)
+endfunction()
+
+file(GLOB programs ${CORPUS}/*.pl0)
+list(SORT programs)
+set(failures 0)
+foreach(program ${programs})
+    get_filename_component(name ${program} NAME)
+    run_program(expected ${program})
+    foreach(engine ${ENGINES})
+        string(REPLACE "+" ";" flags "${engine}")
+        run_program(actual ${program} ${flags})
+        if(NOT actual STREQUAL expected)
+            message(SEND_ERROR "${name} ${engine}: ${actual}\n  栈式虚拟机: ${expected}")
+            math(EXPR failures "${failures} + 1")
+        endif()
+    endforeach()
+endforeach()
+
+list(LENGTH programs count)
+list(LENGTH ENGINES engines)
+message(STATUS "${count} 个程序 x ${engines} 种执行方式, ${failures} 处不一致")
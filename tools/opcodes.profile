@@ -0,0 +1,502 @@
+# PL/0操作码序列剖析: 18 个程序, 34706699 次分派
+# 次数 序列
+11359592 LOD
+4837365 LIT
+4301876 LOD LIT
+3442200 STO
+3379649 LOD LOD
+3175241 JPC
+2286735 ADD
+1668705 JMP
+1572789 MUL
+1547128 ADD STO
+1489943 LT
+1489943 LT JPC
+1437396 LIT ADD
+1437394 LIT ADD STO
+1416851 SUB
+1381027 SUB STO
+1351143 LOD LIT ADD
+1351143 LOD LIT ADD STO
+1303138 STO JMP
+1223142 ADD STO JMP
+1223142 LIT ADD STO JMP
+1193325 STO LOD
+1124375 STO LOD LIT
+1122516 DIV
+959087 SUB STO LOD
+959086 SUB STO LOD LIT
+896561 LOD LOD LT
+896561 LOD LOD LT JPC
+896561 LOD LT
+896561 LOD LT JPC
+894231 LIT DIV
+893830 LOD LIT DIV
+827677 LOD MUL
+744528 STO LOD LIT ADD
+739485 ADD LOD
+734616 MUL ADD
+734412 MUL ADD LOD
+720041 LIT MUL
+715167 LOD LOD LIT
+683317 EQ
+683317 EQ JPC
+593382 LIT LT
+593382 LIT LT JPC
+593382 LOD LIT LT
+593382 LOD LIT LT JPC
+583645 LOD SUB
+583645 LOD SUB STO
+548273 NEQ
+548273 NEQ JPC
+505021 LOD LIT MUL
+500014 LIT MUL ADD
+500014 LOD LIT MUL ADD
+500012 LIT MUL ADD LOD
+500010 LOD LOD LIT MUL
+500005 ADD LOD LIT
+500004 MUL ADD LOD LIT
+500001 DIV SUB
+500001 DIV SUB STO
+500000 ADD LOD LIT DIV
+500000 DIV SUB STO LOD
+500000 LIT DIV SUB
+500000 LIT DIV SUB STO
+500000 LOD LIT DIV SUB
+468135 LOD LOD MUL
+461549 LOD MUL LOD
+461549 MUL LOD
+455042 LIT EQ
+455042 LIT EQ JPC
+455032 LOD LIT EQ
+455032 LOD LIT EQ JPC
+349645 LOD LOD SUB
+349645 LOD LOD SUB STO
+330255 LOD LOD NEQ
+330255 LOD LOD NEQ JPC
+330255 LOD NEQ
+330255 LOD NEQ JPC
+298339 LTE
+298339 LTE JPC
+288266 LOD LTE
+288266 LOD LTE JPC
+244019 LOD SUB STO LOD
+234531 LOD MUL ADD
+234460 LOD LOD LOD
+234460 LOD LOD LOD MUL
+234460 LOD LOD MUL ADD
+234400 LOD MUL ADD LOD
+234000 ADD LOD SUB
+234000 ADD LOD SUB STO
+234000 MUL ADD LOD SUB
+233274 LOD LOD MUL LOD
+233274 LOD MUL LOD LTE
+233274 MUL LOD LTE
+233274 MUL LOD LTE JPC
+228283 LOD DIV
+228282 LOD LOD DIV
+228276 DIV LOD
+228276 LOD DIV LOD
+228276 LOD LOD DIV LOD
+228275 DIV LOD MUL
+228275 DIV LOD MUL LOD
+228275 LOD DIV LOD MUL
+228275 LOD EQ
+228275 LOD EQ JPC
+228275 LOD MUL LOD EQ
+228275 MUL LOD EQ
+228275 MUL LOD EQ JPC
+224719 INT
+224701 CAL
+220015 DIV LIT
+220015 LIT DIV LIT
+220015 LOD LIT DIV LIT
+218018 LIT NEQ
+218018 LIT NEQ JPC
+218014 LOD LIT NEQ
+218014 LOD LIT NEQ JPC
+215416 MUL SUB
+215017 STO LOD LIT EQ
+215016 LIT MUL SUB
+215015 DIV LIT MUL
+215015 DIV LIT MUL SUB
+215015 LIT DIV LIT MUL
+215015 LIT MUL SUB STO
+215015 LOD LOD LIT DIV
+215015 MUL SUB STO
+215015 MUL SUB STO LOD
+173823 DIV STO
+173816 LIT DIV STO
+173815 LOD LIT DIV STO
+166428 LIT LOD
+164663 RET
+157729 LOD STO
+132394 INT LOD
+131196 LIT LOD MUL
+117789 LIT SUB
+117779 LOD LIT SUB
+117330 INT LOD LIT
+106764 ADD STO LOD
+104161 LOD ADD
+102413 LIT STO
+99153 LOD LOD ADD
+99090 LOD ADD STO
+97325 INT LOD LIT ADD
+94082 LOD LOD ADD STO
+92330 STO CAL
+85330 STO RET
+82366 LIT SUB STO
+82363 LOD LIT SUB STO
+81203 MUL LIT
+81200 MUL LIT ADD
+81200 MUL LIT ADD STO
+80317 ADD STO RET
+80003 MUL STO
+80002 INT CAL
+78349 STO LIT
+77908 ADD STO LOD LIT
+76200 LIT LOD MUL LIT
+76200 LOD MUL LIT
+76200 LOD MUL LIT ADD
+68055 GT
+68055 GT JPC
+67390 LOD STO LOD
+65056 LIT GT
+65056 LIT GT JPC
+65056 LOD LIT GT
+65056 LOD LIT GT JPC
+62370 LIT ADD STO LOD
+57365 LOD STO LOD LIT
+57363 STO LOD LIT SUB
+57316 STO LOD LIT LT
+57313 GTE
+57313 GTE JPC
+57313 LIT GTE
+57313 LIT GTE JPC
+57313 LOD LIT GTE
+57313 LOD LIT GTE JPC
+57312 LIT SUB STO CAL
+57312 SUB STO CAL
+55001 MUL STO LOD
+54997 LOD MUL STO
+54996 LIT LOD MUL STO
+54992 LOD LOD LTE
+54992 LOD LOD LTE JPC
+48337 STO LIT STO
+43780 LOD ADD STO LOD
+43734 STO LOD STO
+40305 LOD ADD STO RET
+40012 LIT ADD STO RET
+35381 POW
+35159 LOD LIT LOD
+35016 LIT LOD LIT
+35016 LIT LOD LIT SUB
+35016 LIT SUB POW
+35016 LOD LIT SUB POW
+35016 SUB POW
+35015 LOD LIT LOD LIT
+35002 ADD STO LIT
+35000 STO LOD LIT DIV
+34997 LIT ADD STO LIT
+30006 LIT STO CAL
+30005 MUL STO LOD LIT
+30003 STO LIT STO CAL
+30001 ODD
+30001 ODD JPC
+30000 DIV STO JMP
+30000 LIT DIV STO JMP
+30000 LOD MUL STO LOD
+30000 LOD ODD
+30000 LOD ODD JPC
+29996 ADD STO LIT LOD
+29996 STO LIT LOD
+29996 STO LIT LOD MUL
+28709 ADD STO LOD STO
+25332 LIT STO LIT
+25326 LIT STO LIT STO
+25216 STO LOD LOD
+25070 POW MUL
+25000 LIT SUB STO JMP
+25000 SUB STO JMP
+24999 POW MUL STO
+24997 LIT SUB POW MUL
+24997 POW MUL STO LOD
+24997 SUB POW MUL
+24997 SUB POW MUL STO
+24996 LOD MUL STO JMP
+24996 MUL STO JMP
+24996 MUL STO LOD LOD
+24996 STO LOD LOD LTE
+20001 INT LOD LIT EQ
+17999 LOD STO LIT
+17999 LOD STO LIT STO
+15003 INT LOD STO
+12323 INT LIT
+12321 INT LIT STO
+10161 POW ADD
+10091 STO LOD LIT LOD
+10090 POW ADD STO
+10073 LIT LTE
+10073 LIT LTE JPC
+10073 LOD LIT LTE
+10073 LOD LIT LTE JPC
+10025 LOD STO LOD STO
+10019 LIT SUB POW ADD
+10019 SUB POW ADD
+10019 SUB POW ADD STO
+10002 INT LOD STO LOD
+5012 LIT STO LOD
+5011 ADD STO CAL
+5010 STO LIT STO LOD
+5008 ADD LOD ADD
+5008 ADD LOD ADD STO
+5005 ADD STO LIT STO
+5004 LOD STO RET
+5003 STO LOD LIT MUL
+5001 LIT MUL LIT
+5000 DIV LIT ADD
+5000 DIV LIT ADD STO
+5000 INT LOD STO LIT
+5000 LIT ADD STO CAL
+5000 LIT DIV LIT ADD
+5000 LIT MUL LIT ADD
+5000 LIT STO LOD STO
+5000 LOD ADD LOD
+5000 LOD ADD LOD ADD
+5000 LOD LIT MUL LIT
+5000 LOD LOD ADD LOD
+5000 STO LOD STO LIT
+2999 LOD GT
+2999 LOD GT JPC
+2999 LOD LOD GT
+2999 LOD LOD GT JPC
+471 ADD LOD LOD
+405 LIT SUB LIT
+405 SUB LIT
+401 DIV ADD
+400 ADD LOD LOD MUL
+400 DIV ADD STO
+400 DIV ADD STO LOD
+400 LIT DIV ADD
+400 LIT DIV ADD STO
+400 LIT SUB LIT DIV
+400 LOD LIT SUB LIT
+400 LOD LOD MUL SUB
+400 LOD MUL SUB
+400 LOD MUL SUB LOD
+400 MUL ADD LOD LOD
+400 MUL SUB LOD
+400 MUL SUB LOD LIT
+400 SUB LIT DIV
+400 SUB LIT DIV ADD
+400 SUB LOD
+400 SUB LOD LIT
+400 SUB LOD LIT SUB
+318 INT LIT STO LIT
+216 LIT LOD POW
+216 LOD POW
+154 MUL ADD STO
+149 LIT POW
+147 ADD STO LOD LOD
+144 LOD LIT LOD POW
+143 MUL ADD STO LOD
+143 STO LOD LOD LIT
+142 LIT POW ADD
+122 ADD LIT
+81 LOD MUL ADD STO
+78 POW STO
+73 LIT LOD POW MUL
+73 LOD POW MUL
+72 LIT LOD POW STO
+72 LOD LIT POW
+72 LOD POW STO
+71 ADD LIT POW
+71 ADD LIT POW ADD
+71 ADD LOD LOD ADD
+71 LIT LOD POW LOD
+71 LIT POW ADD LOD
+71 LIT POW ADD STO
+71 LOD ADD LIT
+71 LOD ADD LIT POW
+71 LOD LIT POW ADD
+71 LOD LOD ADD LIT
+71 LOD LOD LIT LOD
+71 LOD LOD LIT POW
+71 LOD POW LOD
+71 LOD POW LOD MUL
+71 LOD POW MUL ADD
+71 LOD POW STO LOD
+71 POW ADD LOD
+71 POW ADD LOD LOD
+71 POW ADD STO LOD
+71 POW LOD
+71 POW LOD MUL
+71 POW LOD MUL ADD
+71 POW MUL ADD
+71 POW MUL ADD STO
+71 POW STO LOD
+71 POW STO LOD LOD
+71 STO LOD LOD ADD
+61 INT LOD LOD
+55 STO LOD LIT GT
+53 LIT SUB STO LOD
+53 STO LOD STO LOD
+50 ADD LIT ADD
+50 ADD LIT ADD STO
+50 INT LOD LOD ADD
+50 LOD MUL ADD LIT
+50 MUL ADD LIT
+50 MUL ADD LIT ADD
+34 LIT LIT
+16 STO LIT LIT
+15 STO LIT STO LIT
+11 LIT STO LOD LIT
+11 MUL ADD STO CAL
+9 INT LOD LOD LIT
+9 LIT LIT EQ
+9 LIT LIT EQ JPC
+8 DIV STO LIT
+8 LIT LIT SUB
+8 LIT MUL STO
+8 MUL ADD LOD ADD
+7 DIV STO LIT STO
+7 LOD LIT MUL STO
+7 POW STO LIT
+6 LIT POW STO
+6 LIT POW STO LIT
+6 LIT STO LIT LIT
+6 LOD DIV STO
+6 LOD DIV STO LIT
+6 LOD LOD DIV STO
+6 POW STO LIT LIT
+6 STO LIT LIT SUB
+5 LIT LIT MUL
+5 LOD ADD STO LIT
+5 STO LOD LOD DIV
+4 ADD LOD LIT MUL
+4 INT LOD LIT MUL
+4 LIT LIT NEQ
+4 LIT LIT NEQ JPC
+4 LIT LIT POW
+4 LIT LIT POW STO
+4 LIT LIT SUB LIT
+4 LIT MUL STO LOD
+4 MUL STO RET
+4 STO LIT LIT EQ
+3 LIT LIT ADD
+3 LIT MUL STO RET
+3 LIT STO RET
+3 STO LIT LIT POW
+3 STO LIT STO RET
+2 INT LIT LIT
+2 INT LOD LOD DIV
+2 LIT LIT SUB DIV
+2 LIT LIT SUB STO
+2 LIT MUL ADD STO
+2 LIT SUB DIV
+2 LIT SUB LIT POW
+2 LIT SUB LIT SUB
+2 LOD LIT LIT
+2 LOD POW MUL STO
+2 POW MUL STO RET
+2 STO LIT LIT MUL
+2 STO LOD STO RET
+2 SUB DIV
+2 SUB LIT POW
+2 SUB LIT POW STO
+2 SUB LIT SUB
+2 SUB STO RET
+1 ADD LIT LIT
+1 ADD LIT LIT LIT
+1 ADD LOD DIV
+1 ADD LOD DIV ADD
+1 ADD LOD LIT LIT
+1 ADD STO LIT LIT
+1 DIV ADD LOD
+1 DIV ADD LOD LIT
+1 DIV LOD LOD
+1 DIV LOD LOD POW
+1 DIV STO LIT LIT
+1 DIV SUB STO RET
+1 INT LIT LIT ADD
+1 INT LIT LIT POW
+1 INT LIT STO CAL
+1 INT LIT STO LOD
+1 INT LOD STO RET
+1 LIT ADD LIT
+1 LIT ADD LIT LIT
+1 LIT ADD LOD
+1 LIT ADD LOD DIV
+1 LIT DIV STO LIT
+1 LIT LIT ADD LIT
+1 LIT LIT ADD LOD
+1 LIT LIT ADD STO
+1 LIT LIT LIT
+1 LIT LIT LIT MUL
+1 LIT LIT MUL LIT
+1 LIT LIT MUL MUL
+1 LIT LIT MUL ODD
+1 LIT LIT MUL STO
+1 LIT LIT MUL SUB
+1 LIT MUL LIT EQ
+1 LIT MUL MUL
+1 LIT MUL MUL LIT
+1 LIT MUL ODD
+1 LIT MUL ODD JPC
+1 LIT MUL STO LIT
+1 LIT MUL SUB MUL
+1 LIT POW LIT
+1 LIT POW LIT LOD
+1 LIT STO LOD LOD
+1 LIT SUB DIV STO
+1 LIT SUB DIV SUB
+1 LIT SUB LIT LIT
+1 LIT SUB STO LIT
+1 LOD DIV ADD
+1 LOD DIV ADD LOD
+1 LOD DIV LOD LOD
+1 LOD LIT LIT MUL
+1 LOD LIT LIT SUB
+1 LOD LIT POW LIT
+1 LOD LOD MUL STO
+1 LOD MUL STO CAL
+1 LOD POW STO LIT
+1 LOD SUB STO RET
+1 MUL LIT DIV
+1 MUL LIT DIV STO
+1 MUL LIT EQ
+1 MUL LIT EQ JPC
+1 MUL LIT LIT
+1 MUL LIT LIT ADD
+1 MUL MUL
+1 MUL MUL LIT
+1 MUL MUL LIT LIT
+1 MUL ODD
+1 MUL ODD JPC
+1 MUL STO CAL
+1 MUL STO LIT
+1 MUL STO LIT LIT
+1 MUL SUB MUL
+1 MUL SUB MUL LIT
+1 POW LIT
+1 POW LIT LOD
+1 POW LIT LOD LIT
+1 POW STO LIT STO
+1 STO LIT LIT ADD
+1 STO LOD LIT LIT
+1 STO LOD LIT POW
+1 STO LOD LOD MUL
+1 SUB DIV STO
+1 SUB DIV STO LIT
+1 SUB DIV SUB
+1 SUB DIV SUB STO
+1 SUB LIT LIT
+1 SUB LIT LIT SUB
+1 SUB LIT SUB LIT
+1 SUB LIT SUB STO
+1 SUB MUL
+1 SUB MUL LIT
+1 SUB MUL LIT DIV
+1 SUB STO LIT
+1 SUB STO LIT LIT
+1 SUB STO LOD LOD
@@ -0,0 +1,391 @@
+// 超级指令生成器: 从操作码序列剖析中挑选收益最高的序列，生成融合的处理例程和匹配表
+// 用法: pl0_superinstructions <剖析文件> <输出目录> [超级指令数]
+//
+// 剖析文件由PL0 --profile生成。一个长度为n、执行了c次的序列融合后每次少分派n-1次，
+// 按c*(n-1)取前若干个。构建时运行，输出两个文件:
+//   Superinstructions.h           匹配表(按长度降序)和处理例程标签的列表
+//   SuperinstructionHandlers.inc  在VM::run内展开的处理例程
+// 处理例程把序列中的中间值保存在局部变量里，只有序列结束时仍在栈上的值才写回数据栈
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <filesystem>
+#include <string_view>
+
+namespace
+{
+    constexpr size_t MAX_LENGTH = 4;
+    constexpr size_t DEFAULT_COUNT = 24;
+
+    enum class Kind
+    {
+        Push,   // 压入expr
+        Store,  // 弹出并存入变量
+        Unary,  // 弹出a，压入expr
+        Binary, // 弹出b、a，压入expr
+        Branch, // 弹出，为0时跳转(只能在末尾)
+        Jump    // 无条件跳转(只能在末尾)
+    };
+
+    // 原语的语义，expr中{k}为序列内的下标，{a}、{b}为操作数
+    struct Primitive
+    {
+        std::string_view name;
+        std::string_view opcode;
+        std::string_view opr;
+        Kind kind;
+        std::string_view expr;
+        std::string_view trap = {};    // 对{b}的运行时检查，成立时报错
+        std::string_view message = {}; // 与VM中的错误信息相同
+    };
+
+    const Primitive PRIMITIVES[] = {
+        {"LIT", "LIT", "RET", Kind::Push, "cur[{k}].argument"},
+        {"LOD", "LOD", "RET", Kind::Push, "frameAt(bp, cur[{k}].level)[cur[{k}].argument]"},
+        {"STO", "STO", "RET", Kind::Store, "frameAt(bp, cur[{k}].level)[cur[{k}].argument]"},
+        {"JPC", "JPC", "RET", Kind::Branch, "tcode + cur[{k}].argument"},
+        {"JMP", "JMP", "RET", Kind::Jump, "tcode + cur[{k}].argument"},
+        {"NEG", "OPR", "NEG", Kind::Unary, "arith::sub(0, {a})"},
+        {"NOT", "OPR", "NOT", Kind::Unary, "{a} == 0"},
+        {"ODD", "OPR", "ODD", Kind::Unary, "{a} % 2 != 0"},
+        {"ADD", "OPR", "ADD", Kind::Binary, "arith::add({a}, {b})"},
+        {"SUB", "OPR", "SUB", Kind::Binary, "arith::sub({a}, {b})"},
+        {"MUL", "OPR", "MUL", Kind::Binary, "arith::mul({a}, {b})"},
+        {"DIV", "OPR", "DIV", Kind::Binary, "arith::div({a}, {b})", "{b} == 0", "运行时错误: 除数为零"},
+        {"POW", "OPR", "POW", Kind::Binary, "arith::pow({a}, {b})", "{b} < 0", "运行时错误: 负指数"},
+        {"SHL", "OPR", "SHL", Kind::Binary, "arith::shl({a}, {b})", "{b} < 0", "运行时错误: 负指数"},
+        {"EQ", "OPR", "EQ", Kind::Binary, "{a} == {b}"},
+        {"NEQ", "OPR", "NEQ", Kind::Binary, "{a} != {b}"},
+        {"LT", "OPR", "LT", Kind::Binary, "{a} < {b}"},
+        {"LTE", "OPR", "LTE", Kind::Binary, "{a} <= {b}"},
+        {"GT", "OPR", "GT", Kind::Binary, "{a} > {b}"},
+        {"GTE", "OPR", "GTE", Kind::Binary, "{a} >= {b}"},
+    };
+
+    const Primitive *findPrimitive(std::string_view name)
+    {
+        for (const auto &primitive : PRIMITIVES)
+        {
+            if (primitive.name == name)
+            {
+                return &primitive;
+            }
+        }
+        return nullptr;
+    }
+
+    struct Candidate
+    {
+        std::string text;
+        std::vector<const Primitive *> steps;
+        uint64_t count = 0;
+
+        [[nodiscard]] uint64_t saved() const noexcept { return count * (steps.size() - 1); }
+    };
+
+    // 可融合的序列: 长度2到MAX_LENGTH，只含已知原语，跳转只出现在末尾
+    // CAL、RET和INT会改变帧或需要栈检查，不参与融合
+    bool parseCandidate(const std::string &line, Candidate &candidate)
+    {
+        std::istringstream in(line);
+        if (!(in >> candidate.count))
+        {
+            return false;
+        }
+        std::string name;
+        while (in >> name)
+        {
+            const Primitive *primitive = findPrimitive(name);
+            if (!primitive || candidate.steps.size() == MAX_LENGTH)
+            {
+                return false;
+            }
+            if (!candidate.steps.empty())
+            {
+                Kind last = candidate.steps.back()->kind;
+                if (last == Kind::Branch || last == Kind::Jump)
+                {
+                    return false;
+                }
+                candidate.text += ' ';
+            }
+            candidate.text += name;
+            candidate.steps.push_back(primitive);
+        }
+        return candidate.steps.size() >= 2;
+    }
+
+    std::string substitute(std::string_view pattern, size_t k, const std::string &a = {}, const std::string &b = {})
+    {
+        std::string out;
+        for (size_t i = 0; i < pattern.size(); ++i)
+        {
+            if (pattern.substr(i).starts_with("{k}"))
+            {
+                out += std::to_string(k);
+            }
+            else if (pattern.substr(i).starts_with("{a}"))
+            {
+                out += a;
+            }
+            else if (pattern.substr(i).starts_with("{b}"))
+            {
+                out += b;
+            }
+            else
+            {
+                out += pattern[i];
+                continue;
+            }
+            i += 2;
+        }
+        return out;
+    }
+
+    // 生成一个处理例程: 用局部变量模拟操作数栈，不足时从数据栈弹出
+    std::string emitHandler(const Candidate &candidate, size_t index)
+    {
+        const std::string indent(8, ' ');
+        std::string body;
+        std::vector<std::string> stack;
+        size_t temps = 0;
+
+        auto line = [&body, &indent](const std::string &text)
+        { body += indent + text + '\n'; };
+        auto define = [&line, &temps](const std::string &expr)
+        {
+            std::string name = "t" + std::to_string(temps++);
+            line("const int64_t " + name + " = " + expr + ";");
+            return name;
+        };
+        auto pop = [&stack, &define]()
+        {
+            if (stack.empty())
+            {
+                return define("*--sp");
+            }
+            std::string top = stack.back();
+            stack.pop_back();
+            return top;
+        };
+        auto flush = [&stack, &line]()
+        {
+            for (const auto &value : stack)
+            {
+                line("*sp++ = " + value + ";");
+            }
+            stack.clear();
+        };
+
+        const size_t length = candidate.steps.size();
+        std::string next = "cur + " + std::to_string(length);
+        bool jumped = false;
+        for (size_t k = 0; k < length; ++k)
+        {
+            const Primitive &step = *candidate.steps[k];
+            switch (step.kind)
+            {
+            case Kind::Push:
+                stack.push_back(define(substitute(step.expr, k)));
+                break;
+            case Kind::Store:
+            {
+                std::string value = pop();
+                line(substitute(step.expr, k) + " = " + value + ";");
+                break;
+            }
+            case Kind::Unary:
+            {
+                std::string a = pop();
+                stack.push_back(define(substitute(step.expr, k, a)));
+                break;
+            }
+            case Kind::Binary:
+            {
+                std::string b = pop();
+                std::string a = pop();
+                if (!step.trap.empty())
+                {
+                    // 报错时cur指向出错的那条指令，地址与逐条执行时相同
+                    line("if (" + substitute(step.trap, k, a, b) + ")");
+                    line("{");
+                    line("    cur += " + std::to_string(k) + ";");
+                    line("    result.error = \"" + std::string(step.message) + "\";");
+                    line("    goto fail;");
+                    line("}");
+                }
+                stack.push_back(define(substitute(step.expr, k, a, b)));
+                break;
+            }
+            case Kind::Branch:
+            {
+                std::string value = pop();
+                flush();
+                line("ip = " + value + " == 0 ? " + substitute(step.expr, k) + " : " + next + ";");
+                jumped = true;
+                break;
+            }
+            case Kind::Jump:
+                flush();
+                line("ip = " + substitute(step.expr, k) + ";");
+                jumped = true;
+                break;
+            }
+        }
+        flush();
+        if (!jumped)
+        {
+            line("ip = " + next + ";");
+        }
+        line("DISPATCH();");
+
+        return "    si_" + std::to_string(index) + ": // " + candidate.text + "\n    {\n" + body + "    }\n\n";
+    }
+
+    std::string header(const std::filesystem::path &profile)
+    {
+        return "// 由pl0_superinstructions根据" + profile.filename().string() + "生成，请勿手工修改\n";
+    }
+
+    // 内容不变时不改写，避免无谓地重新编译VM.cpp
+    void writeIfChanged(const std::filesystem::path &path, const std::string &content)
+    {
+        std::ifstream existing(path, std::ios::binary);
+        if (existing)
+        {
+            std::ostringstream old;
+            old << existing.rdbuf();
+            if (old.str() == content)
+            {
+                return;
+            }
+        }
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << content;
+        if (!file)
+        {
+            throw std::runtime_error("无法写入: " + path.string());
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3 && argc != 4)
+    {
+        std::cerr << "用法: " << argv[0] << " <剖析文件> <输出目录> [超级指令数]\n";
+        return 1;
+    }
+    const std::filesystem::path profile = argv[1];
+    const std::filesystem::path output = argv[2];
+    const size_t limit = argc == 4 ? std::stoul(argv[3]) : DEFAULT_COUNT;
+
+    try
+    {
+        std::ifstream in(profile);
+        if (!in)
+        {
+            std::cerr << "无法打开剖析文件: " << profile.string() << '\n';
+            return 1;
+        }
+
+        // 同一序列可能出现多次(例如合并了多份剖析)，先按序列累加
+        std::map<std::string, Candidate> merged;
+        std::string line;
+        while (std::getline(in, line))
+        {
+            Candidate candidate;
+            if (line.empty() || line[0] == '#' || !parseCandidate(line, candidate))
+            {
+                continue;
+            }
+            auto [it, inserted] = merged.try_emplace(candidate.text, candidate);
+            if (!inserted)
+            {
+                it->second.count += candidate.count;
+            }
+        }
+
+        std::vector<Candidate> selected;
+        for (auto &[text, candidate] : merged)
+        {
+            selected.push_back(std::move(candidate));
+        }
+        std::sort(selected.begin(), selected.end(), [](const Candidate &a, const Candidate &b)
+                  { return a.saved() != b.saved() ? a.saved() > b.saved() : a.text < b.text; });
+        if (selected.size() > limit)
+        {
+            selected.resize(limit);
+        }
+        // 融合时按表顺序取第一个匹配，较长的序列优先
+        std::stable_sort(selected.begin(), selected.end(), [](const Candidate &a, const Candidate &b)
+                         { return a.steps.size() > b.steps.size(); });
+
+        std::string patterns;
+        std::string labels;
+        std::string handlers = header(profile) +
+                               "// 超级指令的处理例程，在VM::run内展开。cur指向序列的第一条指令，"
+                               "其余各条的操作数仍在原位\n\n";
+        for (size_t i = 0; i < selected.size(); ++i)
+        {
+            const auto &candidate = selected[i];
+            patterns += "        {" + std::to_string(candidate.steps.size()) + ", {";
+            for (size_t k = 0; k < candidate.steps.size(); ++k)
+            {
+                patterns += std::string(k ? ", " : "") + "{OpCode::" + std::string(candidate.steps[k]->opcode) +
+                            ", Opr::" + std::string(candidate.steps[k]->opr) + "}";
+            }
+            patterns += "}}, // " + candidate.text + ": " + std::to_string(candidate.count) + " 次\n";
+            labels += std::string(i ? ", " : "") + "&&si_" + std::to_string(i);
+            handlers += emitHandler(candidate, i);
+        }
+
+        std::string declarations =
+            header(profile) +
+            "#pragma once\n\n"
+            "#include \"PCode.h\"\n\n"
+            "#include <array>\n"
+            "#include <cstdint>\n\n"
+            "namespace pl0::superinstructions\n"
+            "{\n"
+            "    inline constexpr size_t MAX_LENGTH = " +
+            std::to_string(MAX_LENGTH) +
+            ";\n\n"
+            "    // 序列中的一条原语，非OPR指令的opr不参与匹配\n"
+            "    struct Step\n"
+            "    {\n"
+            "        OpCode op;\n"
+            "        Opr opr;\n"
+            "    };\n\n"
+            "    struct Pattern\n"
+            "    {\n"
+            "        uint32_t length;\n"
+            "        Step steps[MAX_LENGTH];\n"
+            "    };\n\n"
+            "    // 按长度降序，融合时取第一个匹配的模式\n"
+            "    inline constexpr std::array<Pattern, " +
+            std::to_string(selected.size()) + "> PATTERNS{{\n" + patterns +
+            "    }};\n\n"
+            "} // namespace pl0::superinstructions\n\n"
+            "// 与PATTERNS一一对应的处理例程标签，在VM::run内展开\n"
+            "#define PL0_SUPERINSTRUCTION_LABELS " +
+            labels + "\n";
+
+        std::filesystem::create_directories(output);
+        writeIfChanged(output / "Superinstructions.h", declarations);
+        writeIfChanged(output / "SuperinstructionHandlers.inc", handlers);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "错误：" << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}